@@ -0,0 +1,302 @@
+#include "cache/compile_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <unistd.h>
+
+#include "ir/ir_serializer.h"
+#include "utils/byte_stream.h"
+#include "utils/file_utils.h"
+
+namespace {
+
+// Меняется вместе с форматом записей или с генерируемым кодом
+constexpr const char* CACHE_FORMAT = "minicompiler-cache-3";
+
+// ---------------------------------------------------------------
+// Объявление верхнего уровня — диапазон токенов [begin, end).
+// Интерфейс — то, что видят другие функции: у функции с телом это
+// сигнатура до '{', у extern, struct и глобальных переменных —
+// объявление целиком.
+// ---------------------------------------------------------------
+struct Decl {
+    std::string name;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    std::size_t interface_end = 0;
+    bool has_body = false;
+};
+
+std::vector<Decl> split_declarations(const std::vector<Token>& tokens) {
+    std::vector<Decl> decls;
+    std::size_t i = 0;
+    auto at_end = [&](std::size_t k) { return k >= tokens.size() || tokens[k].type == TokenType::END_OF_FILE; };
+    while (!at_end(i)) {
+        Decl decl;
+        decl.begin = i;
+        std::size_t body = 0;
+        int depth = 0;
+        for (; !at_end(i); ++i) {
+            TokenType t = tokens[i].type;
+            if (t == TokenType::LBRACE) {
+                if (depth++ == 0 && body == 0) body = i;
+            } else if (t == TokenType::RBRACE) {
+                if (--depth <= 0) {
+                    ++i;
+                    break;
+                }
+            } else if (t == TokenType::SEMICOLON && depth == 0) {
+                ++i;
+                break;
+            }
+        }
+        const TokenType first = tokens[decl.begin].type;
+        if (first == TokenType::KW_STRUCT && !at_end(i) && tokens[i].type == TokenType::SEMICOLON) ++i;
+        decl.end = i;
+        decl.has_body = first == TokenType::KW_FN && body != 0;
+        decl.interface_end = decl.has_body ? body : decl.end;
+
+        // fn f / extern fn f / struct S — первый идентификатор;
+        // глобальная переменная "int x" / "Point p" — второй токен
+        if (first == TokenType::KW_FN || first == TokenType::KW_EXTERN || first == TokenType::KW_STRUCT) {
+            for (std::size_t k = decl.begin; k < decl.end; ++k) {
+                if (tokens[k].type == TokenType::IDENTIFIER) {
+                    decl.name = tokens[k].lexeme;
+                    break;
+                }
+            }
+        } else if (decl.begin + 1 < decl.end) {
+            decl.name = tokens[decl.begin + 1].lexeme;
+        }
+        decls.push_back(std::move(decl));
+    }
+    return decls;
+}
+
+void write_tokens(utils::ByteWriter& out, const std::vector<Token>& tokens, std::size_t begin, std::size_t end,
+                  bool lines, int base_line) {
+    out.u64(end - begin);
+    for (std::size_t k = begin; k < end; ++k) {
+        out.u8(static_cast<std::uint8_t>(tokens[k].type));
+        out.str(tokens[k].lexeme);
+        if (lines) out.i64(tokens[k].line - base_line);
+    }
+}
+
+std::uint64_t fnv1a(const std::string& data) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+CompileCache::CompileCache(std::string dir, std::string ir_options, std::string code_options)
+    : dir_(std::move(dir)), ir_options_(std::move(ir_options)), code_options_(std::move(code_options)) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    dir_ready_ = !ec;
+    if (ec) {
+        errors_.push_back("cannot create cache directory " + dir_ + ": " + ec.message());
+    }
+    unit_cache_.load = [this](const std::string& func, std::string& data, int& line_delta) {
+        return load_code(func, data, line_delta);
+    };
+    unit_cache_.store = [this](const std::string& func, const std::string& data) {
+        store_code(func, data);
+    };
+}
+
+// ---------------------------------------------------------------
+// plan — ключи функций и загрузка их IR
+// ---------------------------------------------------------------
+const std::unordered_set<std::string>& CompileCache::plan(const std::vector<Token>& tokens, bool whole_program,
+                                                          const std::string& imports) {
+    entries_.clear();
+    cached_.clear();
+    const std::vector<Decl> decls = split_declarations(tokens);
+    std::unordered_map<std::string_view, std::vector<std::size_t>> by_name;    // ключи — имена из decls
+    for (std::size_t d = 0; d < decls.size(); ++d) {
+        by_name[decls[d].name].push_back(d);
+    }
+
+    for (std::size_t d = 0; d < decls.size(); ++d) {
+        const Decl& decl = decls[d];
+        if (!decl.has_body || entries_.count(decl.name)) continue;
+        const int start_line = tokens[decl.begin].line;
+
+        utils::ByteWriter key;
+        key.str(CACHE_FORMAT);
+        key.str(ir_options_);
+        if (!imports.empty()) key.str(imports);
+        write_tokens(key, tokens, decl.begin, decl.end, true, start_line);
+
+        // Интерфейсы всего, на что функция ссылается по имени
+        // (транзитивно: структура в сигнатуре тянет свою запись)
+        std::vector<bool> seen(decls.size(), false);
+        seen[d] = true;
+        std::vector<std::pair<std::size_t, std::size_t>> work = {{decl.begin, decl.end}};
+        std::vector<std::string> interfaces;
+        while (!work.empty()) {
+            auto range = work.back();
+            work.pop_back();
+            for (std::size_t k = range.first; k < range.second; ++k) {
+                if (tokens[k].type != TokenType::IDENTIFIER) continue;
+                auto it = by_name.find(tokens[k].lexeme);
+                if (it == by_name.end()) continue;
+                for (std::size_t dep : it->second) {
+                    if (seen[dep]) continue;
+                    seen[dep] = true;
+                    utils::ByteWriter iface;
+                    iface.str(decls[dep].name);
+                    write_tokens(iface, tokens, decls[dep].begin, decls[dep].interface_end, false, 0);
+                    interfaces.push_back(iface.data());
+                    work.push_back({decls[dep].begin, decls[dep].interface_end});
+                }
+            }
+        }
+        std::sort(interfaces.begin(), interfaces.end());
+        key.u64(interfaces.size());
+        for (const auto& iface : interfaces) key.str(iface);
+
+        // --inline: ключ — весь файл вместе с номерами строк
+        if (whole_program) {
+            write_tokens(key, tokens, 0, tokens.size(), true, 0);
+        }
+
+        Entry& entry = entries_[decl.name];
+        entry.key = key.data();
+        entry.start_line = start_line;
+
+        std::string payload;
+        int stored_line = 0;
+        if (load(entry.key, "ir", payload, stored_line)) {
+            utils::ByteReader in(payload);
+            if (read_ir_function(in, entry.ir) && in.at_end() && entry.ir.name == decl.name) {
+                shift_source_lines(entry.ir, start_line - stored_line);
+                cached_.insert(decl.name);
+            }
+        }
+    }
+
+    // С --inline функции зависят друг от друга через счётчик копий:
+    // либо все из кэша, либо все заново
+    if (whole_program && cached_.size() != entries_.size()) {
+        cached_.clear();
+    }
+    ir_hits_ = static_cast<int>(cached_.size());
+    ir_misses_ = static_cast<int>(entries_.size() - cached_.size());
+    return cached_;
+}
+
+// ---------------------------------------------------------------
+// complete_program — IR из кэша на место заглушек, новый IR — в кэш
+// ---------------------------------------------------------------
+void CompileCache::complete_program(IRProgram& program) {
+    for (auto& func : program.functions) {
+        auto it = entries_.find(func.name);
+        if (it == entries_.end()) continue;
+        Entry& entry = it->second;
+        if (cached_.count(func.name)) {
+            func = std::move(entry.ir);
+        } else if (!func.blocks.empty()) {
+            utils::ByteWriter out;
+            write_ir_function(out, func);
+            store(entry.key, "ir", out.data(), entry.start_line);
+        }
+    }
+}
+
+bool CompileCache::load_code(const std::string& func, std::string& data, int& line_delta) {
+    auto it = entries_.find(func);
+    int stored_line = 0;
+    if (it == entries_.end() || !load(it->second.key + code_options_, "code", data, stored_line)) {
+        ++code_misses_;
+        return false;
+    }
+    line_delta = it->second.start_line - stored_line;
+    ++code_hits_;
+    return true;
+}
+
+void CompileCache::store_code(const std::string& func, const std::string& data) {
+    auto it = entries_.find(func);
+    if (it == entries_.end()) return;
+    store(it->second.key + code_options_, "code", data, it->second.start_line);
+}
+
+// ---------------------------------------------------------------
+// Записи: <hex FNV-1a ключа>.<kind>
+//   формат, полный ключ, первая строка функции, данные
+// ---------------------------------------------------------------
+std::string CompileCache::path_for(const std::string& key, const char* kind) const {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.", static_cast<unsigned long long>(fnv1a(key)));
+    return (std::filesystem::path(dir_) / (name + std::string(kind))).string();
+}
+
+bool CompileCache::load(const std::string& key, const char* kind, std::string& payload, int& start_line) const {
+    if (!dir_ready_) return false;
+    const std::string data = utils::read_file(path_for(key, kind));
+    if (data.empty()) return false;
+    utils::ByteReader in(data);
+    if (in.str() != CACHE_FORMAT || in.str() != key) return false;
+    start_line = static_cast<int>(in.i64());
+    payload = in.str();
+    return in.ok() && in.at_end();
+}
+
+void CompileCache::store(const std::string& key, const char* kind, const std::string& payload, int start_line) {
+    if (!dir_ready_) return;
+    utils::ByteWriter out;
+    out.str(CACHE_FORMAT);
+    out.str(key);
+    out.i64(start_line);
+    out.str(payload);
+
+    // Запись через временный файл: параллельный компилятор не
+    // прочитает наполовину записанную запись.  В имени — и поток:
+    // запросы compiler serve пишут в один каталог из одного процесса
+    const std::string path = path_for(key, kind);
+    std::ostringstream tmp;
+    tmp << path << ".tmp" << getpid() << "." << std::this_thread::get_id() << "."
+        << std::hash<std::string>{}(key);
+    std::error_code ec;
+    if (!utils::write_file(tmp.str(), out.data())) {
+        ec = std::make_error_code(std::errc::io_error);
+    } else {
+        std::filesystem::rename(tmp.str(), path, ec);
+    }
+    if (ec) {
+        std::filesystem::remove(tmp.str(), ec);
+        std::lock_guard<std::mutex> lock(errors_mutex_);
+        errors_.push_back("cannot write cache entry " + path);
+        return;
+    }
+    ++written_;
+}
+
+std::string CompileCache::statistics() const {
+    std::ostringstream out;
+    out << "=== Compilation Cache ===\n";
+    out << "IR hits:         " << ir_hits_ << "\n";
+    out << "IR misses:       " << ir_misses_ << "\n";
+    out << "Code hits:       " << code_hits_ << "\n";
+    out << "Code misses:     " << code_misses_ << "\n";
+    out << "Entries written: " << written_ << "\n";
+    return out.str();
+}
+
+std::vector<std::string> CompileCache::errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return errors_;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "codegen/x86_generator.h"
+#include "ir/basic_block.h"
+#include "lexer/token.h"
+
+// ---------------------------------------------------------------
+// CompileCache — пофункциональный кэш компиляции на диске (--cache-dir)
+//
+// Ключ функции — её токены (тип, текст, строка относительно
+// начала объявления) плюс сигнатуры всего, на что она ссылается по
+// имени: вызываемых функций, extern-объявлений, структур
+// (транзитивно — структуры в сигнатурах).  Поэтому изменение тела
+// пересобирает только саму функцию, а изменение сигнатуры — и её
+// пользователей.  Сдвиг функции в файле ключа не меняет: номера
+// строк в IR и в машинном коде поправляются при загрузке.
+//
+// С --inline копии тел подставляются между функциями и нумеруются
+// сквозным счётчиком, поэтому ключ — весь файл целиком: кэш
+// срабатывает, только если исходник не менялся.
+//
+// Записи двух уровней:
+//   <ключ>.ir   — IR функции после оптимизаций и выхода из SSA;
+//   <ключ>.code — машинный код (блок X86Generator), ключ
+//                 дополнен настройками кодогенерации.
+// Смена --regalloc переиспользует IR, но генерирует код заново.
+// В записи хранится полный материал ключа, так что коллизия хеша
+// даёт промах, а не чужой код.
+// ---------------------------------------------------------------
+class CompileCache {
+public:
+    /// ir_options / code_options — настройки, влияющие на IR и на код.
+    CompileCache(std::string dir, std::string ir_options, std::string code_options);
+
+    /// Разбить токены на объявления, посчитать ключи функций и
+    /// загрузить их IR.  Возвращает функции, взятые из кэша: их
+    /// тела не нужно проверять и переводить в IR.  imports —
+    /// закодированные интерфейсы импортированных модулей.
+    const std::unordered_set<std::string>& plan(const std::vector<Token>& tokens, bool whole_program,
+                                                const std::string& imports = "");
+
+    /// Подставить IR из кэша вместо пустых заглушек и сохранить IR
+    /// остальных функций (программа — после destruct_ssa).
+    void complete_program(IRProgram& program);
+
+    /// Кэш машинного кода для X86Generator::set_unit_cache.
+    const X86Generator::UnitCache& unit_cache() const { return unit_cache_; }
+
+    /// Сводка попаданий и промахов.
+    std::string statistics() const;
+
+    /// Ошибки записи (кэш при этом просто не пополняется).
+    std::vector<std::string> errors() const;
+
+private:
+    struct Entry {
+        std::string key;            // материал ключа IR
+        int start_line = 0;         // первая строка объявления сейчас
+        IRFunction ir;              // IR из кэша
+    };
+
+    std::string dir_;
+    std::string ir_options_;
+    std::string code_options_;
+    bool dir_ready_ = false;
+    std::unordered_map<std::string, Entry> entries_;   // функция → запись
+    std::unordered_set<std::string> cached_;
+    X86Generator::UnitCache unit_cache_;
+
+    int ir_hits_ = 0;
+    int ir_misses_ = 0;
+    std::atomic<int> code_hits_{0};
+    std::atomic<int> code_misses_{0};
+    std::atomic<int> written_{0};
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> errors_;
+
+    bool load(const std::string& key, const char* kind, std::string& payload, int& start_line) const;
+    void store(const std::string& key, const char* kind, const std::string& payload, int start_line);
+    std::string path_for(const std::string& key, const char* kind) const;
+    bool load_code(const std::string& func, std::string& data, int& line_delta);
+    void store_code(const std::string& func, const std::string& data);
+};
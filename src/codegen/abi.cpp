@@ -10,6 +10,10 @@ const char* const ARG_REGS_32[MAX_REG_ARGS] = {
     "edi", "esi", "edx", "ecx", "r8d", "r9d"
 };
 
+const char* const XMM_ARG_REGS[MAX_XMM_ARGS] = {
+    "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
+};
+
 // Caller-saved: вызывающая сторона должна считать эти регистры
 // затёртыми после call
 const char* const CALLER_SAVED[] = {
@@ -31,6 +35,28 @@ const char* arg_reg_32(int index) {
     return ARG_REGS_32[index];
 }
 
+std::vector<ArgLocation> classify_args(const std::vector<bool>& is_float) {
+    std::vector<ArgLocation> locs(is_float.size());
+    int gpr = 0, xmm = 0, stack = 0;
+    for (size_t i = 0; i < is_float.size(); ++i) {
+        if (is_float[i] && xmm < MAX_XMM_ARGS) {
+            locs[i] = {ArgLocation::Kind::Xmm, xmm++};
+        } else if (!is_float[i] && gpr < MAX_REG_ARGS) {
+            locs[i] = {ArgLocation::Kind::Gpr, gpr++};
+        } else {
+            locs[i] = {ArgLocation::Kind::Stack, stack++};
+        }
+    }
+    return locs;
+}
+
+bool is_arg_reg_64(const std::string& reg) {
+    for (const char* arg : ARG_REGS_64) {
+        if (reg == arg) return true;
+    }
+    return false;
+}
+
 int align_to(int size, int alignment) {
     // (size + alignment - 1) & ~(alignment - 1)
     // Пример: align_to(12, 16) = 16; align_to(32, 16) = 32
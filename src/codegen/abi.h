@@ -8,6 +8,9 @@
 //   System V ABI AMD64 §3.2.3 — Parameter Passing
 // ---------------------------------------------------------------
 
+#include <string>
+#include <vector>
+
 namespace x86abi {
 
 // Регистры для передачи целочисленных аргументов (в порядке ABI)
@@ -18,6 +21,25 @@ constexpr int MAX_REG_ARGS = 6;
 extern const char* const ARG_REGS_64[MAX_REG_ARGS];   // rdi, rsi, ...
 extern const char* const ARG_REGS_32[MAX_REG_ARGS];   // edi, esi, ...
 
+// Регистры для передачи float-аргументов (double, класс SSE)
+//   1-й float-аргумент → xmm0, ..., 8-й → xmm7, далее — через стек.
+//   Целочисленные и float-аргументы нумеруются независимо:
+//   f(int a, float x, int b) → a: rdi, x: xmm0, b: rsi
+constexpr int MAX_XMM_ARGS = 8;
+
+extern const char* const XMM_ARG_REGS[MAX_XMM_ARGS];  // xmm0 .. xmm7
+
+// Где передаётся аргумент по классификации System V (§3.2.3)
+struct ArgLocation {
+    enum class Kind { Gpr, Xmm, Stack };
+    Kind kind = Kind::Gpr;
+    int index = 0;      // номер регистра своего класса / номер stack-слота
+};
+
+// Классифицировать аргументы вызова: is_float[i] — i-й аргумент double.
+// Stack-слот 0 лежит по [rsp] в момент call (ближе всего к адресу возврата).
+std::vector<ArgLocation> classify_args(const std::vector<bool>& is_float);
+
 // Caller-saved (volatile) — вызываемая функция может затереть
 extern const char* const CALLER_SAVED[];
 constexpr int NUM_CALLER_SAVED = 9;   // rax rcx rdx rsi rdi r8-r11
@@ -26,9 +48,10 @@ constexpr int NUM_CALLER_SAVED = 9;   // rax rcx rdx rsi rdi r8-r11
 extern const char* const CALLEE_SAVED[];
 constexpr int NUM_CALLEE_SAVED = 5;   // rbx r12-r15
 
-// Возвращаемое значение
+// Возвращаемое значение (float — в xmm0)
 constexpr const char* RET_REG_64 = "rax";
 constexpr const char* RET_REG_32 = "eax";
+constexpr const char* RET_REG_XMM = "xmm0";
 
 // Указатели стека/фрейма
 constexpr const char* STACK_PTR = "rsp";
@@ -46,6 +69,8 @@ constexpr const char* SCRATCH_D_32 = "edx";
 
 // Выравнивание и размеры
 constexpr int STACK_ALIGNMENT = 16;
+// Красная зона: 128 байт под rsp, которые не портят обработчики сигналов
+constexpr int RED_ZONE_SIZE = 128;
 constexpr int QWORD_SIZE = 8;
 constexpr int DWORD_SIZE = 4;
 
@@ -59,6 +84,9 @@ constexpr int SYS_EXIT  = 60;
 const char* arg_reg_64(int index);
 const char* arg_reg_32(int index);
 
+// Является ли регистр (64-bit имя) регистром передачи аргументов
+bool is_arg_reg_64(const std::string& reg);
+
 // Выровнять size вверх до кратного alignment
 int align_to(int size, int alignment);
 
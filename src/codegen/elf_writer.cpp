@@ -0,0 +1,237 @@
+#include "codegen/elf_writer.h"
+
+namespace elf {
+
+namespace {
+
+// Значения из спецификации ELF (gABI)
+constexpr std::uint16_t ET_REL = 1;
+constexpr std::uint16_t EM_X86_64 = 62;
+
+constexpr std::uint32_t SHT_PROGBITS = 1;
+constexpr std::uint32_t SHT_SYMTAB = 2;
+constexpr std::uint32_t SHT_STRTAB = 3;
+constexpr std::uint32_t SHT_RELA = 4;
+constexpr std::uint32_t SHT_NOBITS = 8;
+
+constexpr std::uint64_t SHF_WRITE = 0x1;
+constexpr std::uint64_t SHF_ALLOC = 0x2;
+constexpr std::uint64_t SHF_EXECINSTR = 0x4;
+constexpr std::uint64_t SHF_INFO_LINK = 0x40;
+
+constexpr std::uint8_t STB_LOCAL = 0;
+constexpr std::uint8_t STB_GLOBAL = 1;
+constexpr std::uint8_t STT_NOTYPE = 0;
+constexpr std::uint8_t STT_FUNC = 2;
+constexpr std::uint8_t STT_SECTION = 3;
+constexpr std::uint8_t STT_FILE = 4;
+constexpr std::uint16_t SHN_ABS = 0xFFF1;
+
+constexpr std::size_t EHDR_SIZE = 64;
+constexpr std::size_t SHDR_SIZE = 64;
+constexpr std::size_t SYM_SIZE = 24;
+constexpr std::size_t RELA_SIZE = 24;
+
+// Индексы секций в таблице заголовков.  .bss — последняя и есть
+// только в объекте со счётчиками профиля, чтобы остальные объекты
+// не менялись
+enum : std::uint16_t {
+    SEC_NULL, SEC_TEXT, SEC_DATA, SEC_RODATA, SEC_RELA_TEXT,
+    SEC_SYMTAB, SEC_STRTAB, SEC_SHSTRTAB, SEC_NOTE_STACK, SEC_BSS, SEC_COUNT
+};
+
+// Little-endian буфер
+class Buffer {
+public:
+    std::string bytes;
+
+    void u8(std::uint8_t v) { bytes.push_back(static_cast<char>(v)); }
+    void u16(std::uint16_t v) { put(v, 2); }
+    void u32(std::uint32_t v) { put(v, 4); }
+    void u64(std::uint64_t v) { put(v, 8); }
+    void raw(const std::vector<std::uint8_t>& data) { bytes.append(data.begin(), data.end()); }
+    void raw(const std::string& data) { bytes += data; }
+    void align(std::size_t a) {
+        while (bytes.size() % a != 0) bytes.push_back('\0');
+    }
+
+private:
+    void put(std::uint64_t v, int size) {
+        for (int i = 0; i < size; ++i) bytes.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+};
+
+// Таблица строк: нулевой байт в начале, имена через '\0'
+class StringTable {
+public:
+    std::string data = std::string(1, '\0');
+
+    std::uint32_t add(const std::string& s) {
+        if (s.empty()) return 0;
+        auto offset = static_cast<std::uint32_t>(data.size());
+        data += s;
+        data.push_back('\0');
+        return offset;
+    }
+};
+
+struct SectionHeader {
+    std::uint32_t name = 0;
+    std::uint32_t type = 0;
+    std::uint64_t flags = 0;
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    std::uint32_t link = 0;
+    std::uint32_t info = 0;
+    std::uint64_t align = 1;
+    std::uint64_t entsize = 0;
+};
+
+std::uint16_t section_index(Section s) {
+    switch (s) {
+        case Section::Text:   return SEC_TEXT;
+        case Section::Data:   return SEC_DATA;
+        case Section::Rodata: return SEC_RODATA;
+        case Section::Bss:    return SEC_BSS;
+        case Section::Undef:  break;
+    }
+    return 0;
+}
+
+void write_symbol(Buffer& out, std::uint32_t name, std::uint8_t bind, std::uint8_t type,
+                  std::uint16_t shndx, std::uint64_t value, std::uint64_t size) {
+    out.u32(name);
+    out.u8(static_cast<std::uint8_t>((bind << 4) | type));
+    out.u8(0);
+    out.u16(shndx);
+    out.u64(value);
+    out.u64(size);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------
+// write_object — сериализация
+//
+// .symtab: нулевой символ, STT_FILE, символы секций, затем
+// локальные символы и глобальные (gABI требует локальные раньше
+// глобальных; sh_info — индекс первого глобального).
+// ---------------------------------------------------------------
+std::string write_object(const Object& obj) {
+    // ---- таблица символов ----
+    StringTable strtab;
+    Buffer symtab;
+    write_symbol(symtab, 0, STB_LOCAL, STT_NOTYPE, 0, 0, 0);
+    write_symbol(symtab, strtab.add(obj.source_name), STB_LOCAL, STT_FILE, SHN_ABS, 0, 0);
+    for (std::uint16_t sec : {SEC_TEXT, SEC_DATA, SEC_RODATA}) {
+        write_symbol(symtab, 0, STB_LOCAL, STT_SECTION, sec, 0, 0);
+    }
+    std::uint32_t next_index = 5;
+    const bool has_bss = obj.bss_size != 0;
+    if (has_bss) {
+        write_symbol(symtab, 0, STB_LOCAL, STT_SECTION, SEC_BSS, 0, 0);
+        ++next_index;
+    }
+    const std::uint16_t section_count = has_bss ? SEC_COUNT : SEC_BSS;
+
+    std::vector<std::uint32_t> new_index(obj.symbols.size());
+    std::uint32_t first_global = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool globals = pass == 1;
+        if (globals) first_global = next_index;
+        for (std::size_t i = 0; i < obj.symbols.size(); ++i) {
+            const Symbol& sym = obj.symbols[i];
+            if (sym.global != globals) continue;
+            new_index[i] = next_index++;
+            write_symbol(symtab, strtab.add(sym.name), globals ? STB_GLOBAL : STB_LOCAL,
+                         sym.function ? STT_FUNC : STT_NOTYPE, section_index(sym.section),
+                         sym.value, sym.size);
+        }
+    }
+
+    // ---- релокации ----
+    Buffer rela;
+    for (const auto& r : obj.text_relocations) {
+        rela.u64(r.offset);
+        rela.u64((static_cast<std::uint64_t>(new_index[r.symbol]) << 32) | r.type);
+        rela.u64(static_cast<std::uint64_t>(r.addend));
+    }
+
+    // ---- заголовки секций ----
+    StringTable shstrtab;
+    SectionHeader sh[SEC_COUNT];
+    sh[SEC_TEXT] = {shstrtab.add(".text"), SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 0, obj.text.size(), 0, 0, 16, 0};
+    sh[SEC_DATA] = {shstrtab.add(".data"), SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, 0, obj.data.size(), 0, 0, 8, 0};
+    sh[SEC_RODATA] = {shstrtab.add(".rodata"), SHT_PROGBITS, SHF_ALLOC, 0, obj.rodata.size(), 0, 0,
+                      obj.rodata_align, 0};
+    sh[SEC_RELA_TEXT] = {shstrtab.add(".rela.text"), SHT_RELA, SHF_INFO_LINK, 0, rela.bytes.size(),
+                         SEC_SYMTAB, SEC_TEXT, 8, RELA_SIZE};
+    sh[SEC_SYMTAB] = {shstrtab.add(".symtab"), SHT_SYMTAB, 0, 0, symtab.bytes.size(),
+                      SEC_STRTAB, first_global, 8, SYM_SIZE};
+    sh[SEC_STRTAB] = {shstrtab.add(".strtab"), SHT_STRTAB, 0, 0, strtab.data.size(), 0, 0, 1, 0};
+    sh[SEC_NOTE_STACK] = {shstrtab.add(".note.GNU-stack"), SHT_PROGBITS, 0, 0, 0, 0, 0, 1, 0};
+    if (has_bss) {
+        sh[SEC_BSS] = {shstrtab.add(".bss"), SHT_NOBITS, SHF_ALLOC | SHF_WRITE, 0, obj.bss_size, 0, 0, 8, 0};
+    }
+    sh[SEC_SHSTRTAB] = {shstrtab.add(".shstrtab"), SHT_STRTAB, 0, 0, 0, 0, 0, 1, 0};
+    sh[SEC_SHSTRTAB].size = shstrtab.data.size();
+
+    // ---- файл: заголовок, данные секций, заголовки секций ----
+    Buffer body;
+    body.bytes.assign(EHDR_SIZE, '\0');
+    auto place = [&](std::uint16_t sec, auto&& data) {
+        body.align(static_cast<std::size_t>(sh[sec].align));
+        sh[sec].offset = body.bytes.size();
+        body.raw(data);
+    };
+    place(SEC_TEXT, obj.text);
+    place(SEC_DATA, obj.data);
+    place(SEC_RODATA, obj.rodata);
+    place(SEC_RELA_TEXT, rela.bytes);
+    place(SEC_SYMTAB, symtab.bytes);
+    place(SEC_STRTAB, strtab.data);
+    place(SEC_SHSTRTAB, shstrtab.data);
+    sh[SEC_NOTE_STACK].offset = body.bytes.size();
+    sh[SEC_BSS].offset = body.bytes.size();
+    body.align(8);
+    const std::uint64_t shoff = body.bytes.size();
+
+    for (std::uint16_t i = 0; i < section_count; ++i) {
+        const SectionHeader& h = sh[i];
+        body.u32(h.name);
+        body.u32(h.type);
+        body.u64(h.flags);
+        body.u64(0);            // sh_addr
+        body.u64(h.offset);
+        body.u64(h.size);
+        body.u32(h.link);
+        body.u32(h.info);
+        body.u64(h.align);
+        body.u64(h.entsize);
+    }
+
+    Buffer ehdr;
+    ehdr.raw(std::string("\x7f" "ELF", 4));
+    ehdr.u8(2);                 // ELFCLASS64
+    ehdr.u8(1);                 // ELFDATA2LSB
+    ehdr.u8(1);                 // EV_CURRENT
+    ehdr.u8(0);                 // ELFOSABI_SYSV
+    ehdr.bytes.resize(16, '\0');
+    ehdr.u16(ET_REL);
+    ehdr.u16(EM_X86_64);
+    ehdr.u32(1);                // e_version
+    ehdr.u64(0);                // e_entry
+    ehdr.u64(0);                // e_phoff
+    ehdr.u64(shoff);
+    ehdr.u32(0);                // e_flags
+    ehdr.u16(EHDR_SIZE);
+    ehdr.u16(0);                // e_phentsize
+    ehdr.u16(0);                // e_phnum
+    ehdr.u16(SHDR_SIZE);
+    ehdr.u16(section_count);
+    ehdr.u16(SEC_SHSTRTAB);
+    body.bytes.replace(0, EHDR_SIZE, ehdr.bytes);
+    return std::move(body.bytes);
+}
+
+} // namespace elf
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------
+// elf::Object — перемещаемый объектный файл ELF64 для x86-64
+//
+// Секции .text, .data, .rodata, .bss (если bss_size != 0), таблица
+// символов (.symtab / .strtab) и релокации .rela.text.  write_object раскладывает
+// их в файл: заголовок ELF, данные секций, таблица заголовков секций.
+//
+// Ссылки: System V ABI gABI §4 (Object Files), AMD64 psABI §4.4
+// (Relocation Types).
+// ---------------------------------------------------------------
+namespace elf {
+
+// Типы релокаций x86-64
+constexpr std::uint32_t R_X86_64_PC32 = 2;     // S + A - P
+constexpr std::uint32_t R_X86_64_PLT32 = 4;    // L + A - P
+
+enum class Section : std::uint8_t { Undef, Text, Data, Rodata, Bss };
+
+struct Symbol {
+    std::string name;
+    Section section = Section::Undef;
+    std::uint64_t value = 0;        // смещение в секции
+    std::uint64_t size = 0;
+    bool global = false;
+    bool function = false;
+};
+
+struct Relocation {
+    std::uint64_t offset = 0;       // смещение в .text
+    std::size_t symbol = 0;         // индекс в Object::symbols
+    std::uint32_t type = R_X86_64_PC32;
+    std::int64_t addend = 0;
+};
+
+struct Object {
+    std::string source_name;        // символ STT_FILE
+    std::vector<std::uint8_t> text;
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint8_t> rodata;
+    std::uint64_t rodata_align = 1;
+    std::uint64_t bss_size = 0;     // нули: места в файле не занимает
+    std::vector<Symbol> symbols;    // порядок произвольный: локальные
+                                    // выносятся вперёд при записи
+    std::vector<Relocation> text_relocations;
+};
+
+/// Сериализовать объектный файл (little-endian ELF64, ET_REL, EM_X86_64).
+std::string write_object(const Object& obj);
+
+} // namespace elf
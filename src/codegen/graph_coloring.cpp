@@ -0,0 +1,549 @@
+#include "codegen/graph_coloring.h"
+#include "codegen/abi.h"
+#include "codegen/liveness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using utils::BitVector;
+
+namespace {
+
+// Векторы в регистры не распределяются: они живут в своих слотах
+bool is_value(const Operand& op) {
+    return (op.kind == OperandKind::Temp || op.kind == OperandKind::Variable) && !is_vector(op.type);
+}
+
+bool is_call(IROpcode op) {
+    return op == IROpcode::CALL || op == IROpcode::ALLOCA;
+}
+
+// Грубая оценка вложенности циклов: блок лежит внутри цикла, если он
+// находится между целью обратного перехода и самим переходом.
+std::vector<int> loop_depths(const BlockLiveness& lv) {
+    std::vector<int> depth(lv.succs.size(), 0);
+    for (size_t b = 0; b < lv.succs.size(); ++b) {
+        for (int s : lv.succs[b]) {
+            if (s > static_cast<int>(b)) continue;
+            for (size_t k = s; k <= b; ++k) depth[k]++;
+        }
+    }
+    return depth;
+}
+
+} // namespace
+
+void InterferenceGraph::add_edge(int a, int b) {
+    if (a == b) return;
+    if (!adj_set_.insert(key(a, b)).second) return;
+    adj_list[a].push_back(b);
+    adj_list[b].push_back(a);
+}
+
+bool InterferenceGraph::interferes(int a, int b) const {
+    return adj_set_.count(key(a, b)) != 0;
+}
+
+// ---------------------------------------------------------------
+// build_interference_graph
+//
+// Обратный проход по каждому блоку от live_out:
+//   1) PHI-пересылки исходящих рёбер (в обратном порядке);
+//   2) инструкции блока: определение интерферирует со всем, что живо
+//      после него (кроме источника MOVE), затем использования
+//      добавляются в живое множество.
+// Операнды PARAM читаются генератором только в момент CALL, поэтому
+// они считаются использованными в CALL, а не в PARAM.
+// ---------------------------------------------------------------
+InterferenceGraph build_interference_graph(const IRFunction& func,
+                                           const std::vector<std::uint64_t>& block_counts) {
+    BlockLiveness lv = compute_block_liveness(func);
+    const size_t n = lv.values.size();
+
+    InterferenceGraph g;
+    g.nodes = lv.values;
+    g.adj_list.assign(n, {});
+    g.spill_cost.assign(n, 0.0);
+    g.crosses_call.assign(n, 0);
+    g.abi_arg.assign(n, -1);
+    if (n == 0) return g;
+
+    // Параметры определяются одновременно в прологе; подсказка —
+    // целочисленный ABI-регистр (float-параметры приходят в xmm)
+    std::vector<int> params;
+    std::vector<bool> param_is_float;
+    for (const auto& param : func.params) {
+        param_is_float.push_back(ir_type_from_name(param.second) == IRType::Float);
+    }
+    const auto param_locs = x86abi::classify_args(param_is_float);
+    for (size_t i = 0; i < func.params.size(); ++i) {
+        params.push_back(lv.value_index[intern_symbol(func.params[i].first)]);
+        if (param_locs[i].kind == x86abi::ArgLocation::Kind::Gpr)
+            g.abi_arg[params.back()] = param_locs[i].index;
+    }
+    for (size_t i = 0; i < params.size(); ++i) {
+        for (size_t j = i + 1; j < params.size(); ++j) g.add_edge(params[i], params[j]);
+        if (!lv.live_in.empty()) {
+            lv.live_in[0].for_each([&](size_t v) { g.add_edge(params[i], static_cast<int>(v)); });
+        }
+    }
+
+    std::vector<int> depth = loop_depths(lv);
+    BitVector live(n);
+    for (size_t b = 0; b < func.blocks.size(); ++b) {
+        const auto& instrs = func.blocks[b].instructions;
+        const double weight = block_counts.size() == func.blocks.size()
+                                  ? 1.0 + static_cast<double>(block_counts[b])
+                                  : std::pow(10.0, std::min(depth[b], 4));
+
+        // PARAM -> CALL, к которому он относится
+        std::vector<std::vector<int>> call_args(instrs.size());
+        std::vector<char> deferred(instrs.size(), 0);
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            if (instrs[i].opcode == IROpcode::PARAM) {
+                pending.push_back(i);
+            } else if (instrs[i].opcode == IROpcode::CALL) {
+                std::vector<bool> arg_is_float;
+                for (size_t p : pending) {
+                    size_t index = static_cast<size_t>(instrs[p].dest.int_val);
+                    if (index >= arg_is_float.size()) arg_is_float.resize(index + 1, false);
+                    arg_is_float[index] = instrs[p].srcs[0].type == IRType::Float;
+                }
+                const auto arg_locs = x86abi::classify_args(arg_is_float);
+                for (size_t p : pending) {
+                    deferred[p] = 1;
+                    const Operand& arg = instrs[p].srcs[0];
+                    if (!is_value(arg)) continue;
+                    int v = lv.value_index[arg.id];
+                    call_args[i].push_back(v);
+                    const auto& loc = arg_locs[instrs[p].dest.int_val];
+                    if (g.abi_arg[v] < 0 && loc.kind == x86abi::ArgLocation::Kind::Gpr)
+                        g.abi_arg[v] = loc.index;
+                }
+                pending.clear();
+            }
+        }
+
+        // 1. PHI-пересылки на исходящих рёбрах
+        for (size_t k = 0; k < lv.succs[b].size(); ++k) {
+            const auto& copies = lv.edge_copies[b][k];
+            if (copies.empty()) continue;
+            live = lv.live_in[lv.succs[b][k]];
+            for (auto it = copies.rbegin(); it != copies.rend(); ++it) {
+                live.for_each([&](size_t v) {
+                    if (static_cast<int>(v) != it->src) g.add_edge(it->dest, static_cast<int>(v));
+                });
+                live.reset(it->dest);
+                g.spill_cost[it->dest] += weight;
+                if (it->src >= 0) {
+                    live.set(it->src);
+                    g.spill_cost[it->src] += weight;
+                    if (it->src != it->dest) g.moves.push_back({it->dest, it->src});
+                }
+            }
+        }
+
+        // 2. Инструкции блока
+        live = lv.live_out[b];
+        for (size_t i = instrs.size(); i-- > 0;) {
+            const IRInstruction& instr = instrs[i];
+            if (instr.opcode == IROpcode::PHI) continue;
+
+            const bool defines = is_value(instr.dest) && !dest_is_read(instr.opcode);
+            const int dest = is_value(instr.dest) ? lv.value_index[instr.dest.id] : -1;
+
+            if (is_call(instr.opcode)) {
+                InterferenceGraph::CallSite site;
+                site.instr = &instr;
+                live.for_each([&](size_t v) {
+                    if (static_cast<int>(v) == dest) return;
+                    site.live_across.push_back(static_cast<int>(v));
+                    g.crosses_call[v] = 1;
+                });
+                g.calls.push_back(std::move(site));
+            }
+
+            if (defines) {
+                int move_src = -1;
+                if (instr.opcode == IROpcode::MOVE && is_value(instr.srcs[0])) {
+                    move_src = lv.value_index[instr.srcs[0].id];
+                }
+                live.for_each([&](size_t v) {
+                    if (static_cast<int>(v) != move_src) g.add_edge(dest, static_cast<int>(v));
+                });
+                live.reset(dest);
+                g.spill_cost[dest] += weight;
+                if (move_src >= 0 && move_src != dest) g.moves.push_back({dest, move_src});
+            }
+
+            if (instr.opcode == IROpcode::PARAM && deferred[i]) {
+                if (is_value(instr.srcs[0])) g.spill_cost[lv.value_index[instr.srcs[0].id]] += weight;
+                continue;
+            }
+            for (const auto& src : instr.srcs) {
+                if (!is_value(src)) continue;
+                int v = lv.value_index[src.id];
+                live.set(v);
+                g.spill_cost[v] += weight;
+            }
+            if (dest >= 0 && !defines) {
+                live.set(dest);
+                g.spill_cost[dest] += weight;
+            }
+            for (int v : call_args[i]) live.set(v);
+        }
+    }
+    return g;
+}
+
+namespace {
+
+// ---------------------------------------------------------------
+// IteratedCoalescing — алгоритм из Appel, "Modern Compiler
+// Implementation", гл. 11.  Предраскрашенных узлов нет: scratch-
+// регистры генератора (eax, ecx, edx, r8) в пул не входят, поэтому
+// для слияния достаточно критерия Бриггса.
+//
+// Spill не требует перезапуска: спиллированное значение остаётся
+// в своём слоте StackFrame и загружается в scratch-регистр.
+// ---------------------------------------------------------------
+class IteratedCoalescing {
+public:
+    IteratedCoalescing(const InterferenceGraph& graph, const std::vector<bool>& caller_saved,
+                       const std::vector<int>& arg_colors)
+        : g_(graph), caller_saved_(caller_saved), arg_colors_(arg_colors),
+          k_(static_cast<int>(caller_saved.size())) {}
+
+    ColoringResult run();
+
+private:
+    enum class NodeState { Initial, Simplify, Freeze, Spill, OnStack, Coalesced, Colored, Spilled };
+    enum class MoveState { Worklist, Active, Coalesced, Constrained, Frozen };
+
+    InterferenceGraph g_;                 // рабочая копия: Combine добавляет рёбра
+    const std::vector<bool>& caller_saved_;
+    const std::vector<int>& arg_colors_;
+    const int k_;
+
+    std::vector<NodeState> state_;
+    std::vector<int> degree_;
+    std::vector<int> alias_;
+    std::vector<int> color_;
+    std::vector<std::vector<int>> move_list_;
+    std::vector<MoveState> move_state_;
+
+    std::set<int> simplify_wl_, freeze_wl_, spill_wl_;
+    std::set<int> worklist_moves_;
+    std::vector<int> select_stack_;
+
+    template <typename Fn>
+    void for_each_adjacent(int n, Fn&& fn) const {
+        for (int m : g_.adj_list[n]) {
+            if (state_[m] != NodeState::OnStack && state_[m] != NodeState::Coalesced) fn(m);
+        }
+    }
+
+    bool move_related(int n) const {
+        for (int m : move_list_[n]) {
+            if (move_state_[m] == MoveState::Worklist || move_state_[m] == MoveState::Active) return true;
+        }
+        return false;
+    }
+
+    // Цвет ABI-регистра, с которым связан узел, или -1
+    int arg_color(int n) const {
+        int arg = g_.abi_arg[n];
+        if (arg < 0 || arg >= static_cast<int>(arg_colors_.size())) return -1;
+        return arg_colors_[arg];
+    }
+
+    int get_alias(int n) const {
+        while (state_[n] == NodeState::Coalesced) n = alias_[n];
+        return n;
+    }
+
+    void push_worklist(int n, NodeState s);
+    void remove_worklist(int n);
+    void make_worklists();
+    void enable_moves(int n);
+    void decrement_degree(int m);
+    void add_edge(int u, int v);
+    void add_worklist(int u);
+    bool conservative(int u, int v) const;
+    void combine(int u, int v);
+    void simplify();
+    void coalesce();
+    void freeze_moves(int u);
+    void freeze();
+    void select_spill();
+    int choose_color(int n, const std::vector<char>& ok) const;
+    void assign_colors();
+};
+
+void IteratedCoalescing::push_worklist(int n, NodeState s) {
+    state_[n] = s;
+    if (s == NodeState::Simplify) simplify_wl_.insert(n);
+    if (s == NodeState::Freeze)   freeze_wl_.insert(n);
+    if (s == NodeState::Spill)    spill_wl_.insert(n);
+}
+
+void IteratedCoalescing::remove_worklist(int n) {
+    simplify_wl_.erase(n);
+    freeze_wl_.erase(n);
+    spill_wl_.erase(n);
+}
+
+void IteratedCoalescing::make_worklists() {
+    for (int n = 0; n < static_cast<int>(g_.nodes.size()); ++n) {
+        if (degree_[n] >= k_) {
+            push_worklist(n, NodeState::Spill);
+        } else if (move_related(n)) {
+            push_worklist(n, NodeState::Freeze);
+        } else {
+            push_worklist(n, NodeState::Simplify);
+        }
+    }
+}
+
+void IteratedCoalescing::enable_moves(int n) {
+    auto enable = [&](int node) {
+        for (int m : move_list_[node]) {
+            if (move_state_[m] == MoveState::Active) {
+                move_state_[m] = MoveState::Worklist;
+                worklist_moves_.insert(m);
+            }
+        }
+    };
+    enable(n);
+    for_each_adjacent(n, enable);
+}
+
+void IteratedCoalescing::decrement_degree(int m) {
+    int d = degree_[m]--;
+    if (d != k_) return;
+    enable_moves(m);
+    spill_wl_.erase(m);
+    push_worklist(m, move_related(m) ? NodeState::Freeze : NodeState::Simplify);
+}
+
+void IteratedCoalescing::add_edge(int u, int v) {
+    if (u == v || g_.interferes(u, v)) return;
+    g_.add_edge(u, v);
+    degree_[u]++;
+    degree_[v]++;
+}
+
+void IteratedCoalescing::add_worklist(int u) {
+    if (state_[u] == NodeState::Freeze && !move_related(u) && degree_[u] < k_) {
+        freeze_wl_.erase(u);
+        push_worklist(u, NodeState::Simplify);
+    }
+}
+
+// Критерий Бриггса: у объединённого узла меньше K соседей
+// значимой степени (>= K)
+bool IteratedCoalescing::conservative(int u, int v) const {
+    std::set<int> neighbours;
+    for_each_adjacent(u, [&](int t) { neighbours.insert(t); });
+    for_each_adjacent(v, [&](int t) { neighbours.insert(t); });
+    int significant = 0;
+    for (int t : neighbours) {
+        // Общий сосед u и v теряет одно ребро после слияния
+        int d = degree_[t];
+        if (g_.interferes(t, u) && g_.interferes(t, v)) d--;
+        if (d >= k_) significant++;
+    }
+    return significant < k_;
+}
+
+void IteratedCoalescing::combine(int u, int v) {
+    remove_worklist(v);
+    state_[v] = NodeState::Coalesced;
+    alias_[v] = u;
+    move_list_[u].insert(move_list_[u].end(), move_list_[v].begin(), move_list_[v].end());
+    g_.spill_cost[u] += g_.spill_cost[v];
+    g_.crosses_call[u] |= g_.crosses_call[v];
+    if (arg_color(u) < 0) g_.abi_arg[u] = g_.abi_arg[v];
+    enable_moves(v);
+    std::vector<int> adjacent;
+    for_each_adjacent(v, [&](int t) { adjacent.push_back(t); });
+    for (int t : adjacent) {
+        add_edge(t, u);
+        decrement_degree(t);
+    }
+    if (degree_[u] >= k_ && state_[u] == NodeState::Freeze) {
+        freeze_wl_.erase(u);
+        push_worklist(u, NodeState::Spill);
+    }
+}
+
+void IteratedCoalescing::simplify() {
+    int n = *simplify_wl_.begin();
+    simplify_wl_.erase(simplify_wl_.begin());
+    state_[n] = NodeState::OnStack;
+    select_stack_.push_back(n);
+    std::vector<int> adjacent;
+    for_each_adjacent(n, [&](int m) { adjacent.push_back(m); });
+    for (int m : adjacent) decrement_degree(m);
+}
+
+void IteratedCoalescing::coalesce() {
+    int m = *worklist_moves_.begin();
+    worklist_moves_.erase(worklist_moves_.begin());
+    int u = get_alias(g_.moves[m].dst);
+    int v = get_alias(g_.moves[m].src);
+
+    if (u == v) {
+        move_state_[m] = MoveState::Coalesced;
+        add_worklist(u);
+    } else if (g_.interferes(u, v)) {
+        move_state_[m] = MoveState::Constrained;
+        add_worklist(u);
+        add_worklist(v);
+    } else if (conservative(u, v)) {
+        move_state_[m] = MoveState::Coalesced;
+        combine(u, v);
+        add_worklist(u);
+    } else {
+        move_state_[m] = MoveState::Active;
+    }
+}
+
+void IteratedCoalescing::freeze_moves(int u) {
+    for (int m : move_list_[u]) {
+        if (move_state_[m] != MoveState::Worklist && move_state_[m] != MoveState::Active) continue;
+        int x = get_alias(g_.moves[m].dst);
+        int y = get_alias(g_.moves[m].src);
+        int v = (y == get_alias(u)) ? x : y;
+        worklist_moves_.erase(m);
+        move_state_[m] = MoveState::Frozen;
+        if (state_[v] == NodeState::Freeze && !move_related(v) && degree_[v] < k_) {
+            freeze_wl_.erase(v);
+            push_worklist(v, NodeState::Simplify);
+        }
+    }
+}
+
+void IteratedCoalescing::freeze() {
+    int u = *freeze_wl_.begin();
+    freeze_wl_.erase(freeze_wl_.begin());
+    push_worklist(u, NodeState::Simplify);
+    freeze_moves(u);
+}
+
+// Кандидат на spill — минимум стоимость / степень
+void IteratedCoalescing::select_spill() {
+    int best = -1;
+    double best_metric = 0.0;
+    for (int n : spill_wl_) {
+        double metric = g_.spill_cost[n] / std::max(degree_[n], 1);
+        if (best < 0 || metric < best_metric) {
+            best = n;
+            best_metric = metric;
+        }
+    }
+    spill_wl_.erase(best);
+    push_worklist(best, NodeState::Simplify);
+    freeze_moves(best);
+}
+
+// Выбор цвета: сначала цвет партнёра по MOVE (пересылка исчезнет),
+// затем для значений, не живых через вызов, — ABI-регистр аргумента,
+// затем callee-saved для значений, живых через вызов (один push/pop
+// на функцию), иначе caller-saved (не нужен ни push в прологе,
+// ни сохранение вокруг вызовов).
+int IteratedCoalescing::choose_color(int n, const std::vector<char>& ok) const {
+    for (int m : move_list_[n]) {
+        int x = get_alias(g_.moves[m].dst);
+        int y = get_alias(g_.moves[m].src);
+        int other = (x == n) ? y : x;
+        if (state_[other] == NodeState::Colored && ok[color_[other]]) return color_[other];
+    }
+    bool want_caller_saved = !g_.crosses_call[n];
+    int c = arg_color(n);
+    if (want_caller_saved && c >= 0 && ok[c]) return c;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int c = 0; c < k_; ++c) {
+            if (ok[c] && caller_saved_[c] == want_caller_saved) return c;
+        }
+        want_caller_saved = !want_caller_saved;
+    }
+    return -1;
+}
+
+void IteratedCoalescing::assign_colors() {
+    std::vector<char> ok(k_);
+    while (!select_stack_.empty()) {
+        int n = select_stack_.back();
+        select_stack_.pop_back();
+        std::fill(ok.begin(), ok.end(), 1);
+        for (int w : g_.adj_list[n]) {
+            int a = get_alias(w);
+            if (state_[a] == NodeState::Colored) ok[color_[a]] = 0;
+        }
+        int c = choose_color(n, ok);
+        if (c < 0) {
+            state_[n] = NodeState::Spilled;
+        } else {
+            state_[n] = NodeState::Colored;
+            color_[n] = c;
+        }
+    }
+    for (int n = 0; n < static_cast<int>(g_.nodes.size()); ++n) {
+        if (state_[n] == NodeState::Coalesced) color_[n] = color_[get_alias(n)];
+    }
+}
+
+ColoringResult IteratedCoalescing::run() {
+    const size_t n = g_.nodes.size();
+    state_.assign(n, NodeState::Initial);
+    degree_.resize(n);
+    for (size_t i = 0; i < n; ++i) degree_[i] = static_cast<int>(g_.adj_list[i].size());
+    alias_.assign(n, -1);
+    color_.assign(n, -1);
+    move_list_.assign(n, {});
+    move_state_.assign(g_.moves.size(), MoveState::Worklist);
+    for (int m = 0; m < static_cast<int>(g_.moves.size()); ++m) {
+        move_list_[g_.moves[m].dst].push_back(m);
+        move_list_[g_.moves[m].src].push_back(m);
+        worklist_moves_.insert(m);
+    }
+
+    make_worklists();
+    while (true) {
+        if (!simplify_wl_.empty()) {
+            simplify();
+        } else if (!worklist_moves_.empty()) {
+            coalesce();
+        } else if (!freeze_wl_.empty()) {
+            freeze();
+        } else if (!spill_wl_.empty()) {
+            select_spill();
+        } else {
+            break;
+        }
+    }
+    assign_colors();
+
+    ColoringResult result;
+    result.color = color_;
+    for (auto s : move_state_) {
+        if (s == MoveState::Coalesced) result.coalesced_moves++;
+    }
+    return result;
+}
+
+} // namespace
+
+ColoringResult color_interference_graph(const InterferenceGraph& graph,
+                                        const std::vector<bool>& caller_saved,
+                                        const std::vector<int>& arg_colors) {
+    if (caller_saved.empty()) {
+        ColoringResult result;
+        result.color.assign(graph.nodes.size(), -1);
+        return result;
+    }
+    return IteratedCoalescing(graph, caller_saved, arg_colors).run();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir/basic_block.h"
+
+// ---------------------------------------------------------------
+// InterferenceGraph — граф интерференции значений одной функции
+//
+// Узлы — значения (Temp/Variable и параметры) в нумерации
+// compute_block_liveness.  Ребро (a, b) означает, что a определяется
+// в точке, где b живо, и они не могут делить физический регистр.
+// Источник MOVE (и PHI-пересылки) не интерферирует с приёмником —
+// такие пары попадают в moves и являются кандидатами на слияние.
+// ---------------------------------------------------------------
+struct InterferenceGraph {
+    struct Move {
+        int dst = -1;
+        int src = -1;
+    };
+
+    // CALL или ALLOCA (вызов malloc) и значения, живые через него
+    struct CallSite {
+        const IRInstruction* instr = nullptr;
+        std::vector<int> live_across;
+    };
+
+    std::vector<SymbolId> nodes;            // номер узла -> значение
+    std::vector<std::vector<int>> adj_list;
+    std::vector<Move> moves;
+    std::vector<double> spill_cost;         // Σ 10^(глубина цикла) по появлениям,
+                                            // с профилем — Σ (1 + счётчик блока)
+    std::vector<char> crosses_call;         // живо хотя бы через один вызов
+    std::vector<int> abi_arg;               // номер ABI-регистра аргумента, в котором
+                                            // значение приходит (параметр) или
+                                            // передаётся (PARAM); -1 — нет
+    std::vector<CallSite> calls;
+
+    void add_edge(int a, int b);
+    bool interferes(int a, int b) const;
+
+private:
+    std::unordered_set<std::uint64_t> adj_set_;
+
+    static std::uint64_t key(int a, int b) {
+        if (a > b) std::swap(a, b);
+        return (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint32_t>(b);
+    }
+};
+
+/// block_counts — счётчики блоков из профиля (--profile-use); пусто —
+/// вес появления оценивается по глубине цикла.
+InterferenceGraph build_interference_graph(const IRFunction& func,
+                                           const std::vector<std::uint64_t>& block_counts = {});
+
+// ---------------------------------------------------------------
+// color_interference_graph — раскраска в K = caller_saved.size() цветов
+//
+// Iterated Register Coalescing (George & Appel, 1996): чередует
+// simplify, консервативное слияние MOVE по критерию Бриггса, freeze
+// и оптимистичный выбор кандидата на spill (Chaitin-Briggs).
+// Значения, живые через вызов, предпочитают callee-saved цвета,
+// остальные — caller-saved; arg_colors[i] — цвет i-го ABI-регистра
+// аргумента (-1, если его нет в пуле), он предпочитается для abi_arg.
+// ---------------------------------------------------------------
+struct ColoringResult {
+    std::vector<int> color;      // цвет узла, -1 = spill
+    int coalesced_moves = 0;
+};
+
+ColoringResult color_interference_graph(const InterferenceGraph& graph,
+                                        const std::vector<bool>& caller_saved,
+                                        const std::vector<int>& arg_colors);
@@ -0,0 +1,162 @@
+#include "codegen/jit.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// ---------------------------------------------------------------
+// Встроенный runtime: то же, что runtime.asm, но через stdio
+// процесса, чтобы вывод не перемешивался с printf программы
+// ---------------------------------------------------------------
+void rt_print_int(int value) {
+    std::printf("%d", value);
+}
+
+void rt_print_string(const char* s) {
+    std::fputs(s, stdout);
+}
+
+int rt_read_int() {
+    int value = 0;
+    if (std::scanf("%d", &value) != 1) return 0;
+    return value;
+}
+
+void rt_exit_program(int code) {
+    std::fflush(stdout);
+    std::exit(code);
+}
+
+struct Builtin {
+    const char* name;
+    void* address;
+};
+
+const Builtin BUILTINS[] = {
+    {"print_int", reinterpret_cast<void*>(&rt_print_int)},
+    {"print_string", reinterpret_cast<void*>(&rt_print_string)},
+    {"read_int", reinterpret_cast<void*>(&rt_read_int)},
+    {"exit_program", reinterpret_cast<void*>(&rt_exit_program)},
+};
+
+// Переходник: jmp qword [rip+0]; dq адрес; int3-заполнение до 16 байт
+constexpr std::size_t STUB_SIZE = 16;
+
+std::size_t align_up(std::size_t value, std::size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+} // namespace
+
+JitModule::~JitModule() {
+    if (memory_) munmap(memory_, size_);
+}
+
+void* JitModule::resolve_external(const std::string& name) const {
+    for (const auto& builtin : BUILTINS) {
+        if (name == builtin.name) return builtin.address;
+    }
+    return dlsym(RTLD_DEFAULT, name.c_str());
+}
+
+// ---------------------------------------------------------------
+// load — раскладка, разрешение символов, релокации, защита страниц
+//
+//   [.text][переходники]  R+X
+//   [.rodata]             R      (с границы страницы)
+//   [.data][.bss]         R+W    (с границы страницы; .bss — нули mmap)
+// ---------------------------------------------------------------
+bool JitModule::load(const elf::Object& obj) {
+    const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    std::vector<std::size_t> stub_index(obj.symbols.size(), 0);
+    std::size_t stubs = 0;
+    for (std::size_t i = 0; i < obj.symbols.size(); ++i) {
+        if (obj.symbols[i].section == elf::Section::Undef) stub_index[i] = stubs++;
+    }
+
+    const std::size_t stub_off = align_up(obj.text.size(), STUB_SIZE);
+    const std::size_t rodata_off = align_up(stub_off + stubs * STUB_SIZE, page);
+    const std::size_t data_off = align_up(rodata_off + obj.rodata.size(), page);
+    const std::size_t bss_off = align_up(data_off + obj.data.size(), 8);
+    size_ = std::max(align_up(bss_off + obj.bss_size, page), page);
+
+    void* mem = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        error_ = "mmap failed";
+        return false;
+    }
+    memory_ = mem;
+    auto* base = static_cast<std::uint8_t*>(memory_);
+    auto copy = [&](std::size_t offset, const std::vector<std::uint8_t>& bytes) {
+        if (!bytes.empty()) std::memcpy(base + offset, bytes.data(), bytes.size());
+    };
+    copy(0, obj.text);
+    copy(rodata_off, obj.rodata);
+    copy(data_off, obj.data);
+
+    // ---- адреса символов ----
+    std::vector<std::uint8_t*> address(obj.symbols.size(), nullptr);
+    for (std::size_t i = 0; i < obj.symbols.size(); ++i) {
+        const auto& sym = obj.symbols[i];
+        switch (sym.section) {
+            case elf::Section::Text:   address[i] = base + sym.value; break;
+            case elf::Section::Rodata: address[i] = base + rodata_off + sym.value; break;
+            case elf::Section::Data:   address[i] = base + data_off + sym.value; break;
+            case elf::Section::Bss:    address[i] = base + bss_off + sym.value; break;
+            case elf::Section::Undef: {
+                void* target = resolve_external(sym.name);
+                if (!target) {
+                    error_ = "undefined symbol " + sym.name;
+                    return false;
+                }
+                std::uint8_t* stub = base + stub_off + stub_index[i] * STUB_SIZE;
+                const std::uint8_t jmp[6] = {0xFF, 0x25, 0, 0, 0, 0};
+                std::memcpy(stub, jmp, sizeof jmp);
+                std::memcpy(stub + 6, &target, sizeof target);
+                std::memset(stub + 14, 0xCC, STUB_SIZE - 14);
+                address[i] = stub;
+                break;
+            }
+        }
+        if (sym.global && sym.section != elf::Section::Undef) {
+            symbols_[sym.name] = address[i];
+        }
+    }
+
+    // ---- релокации: S + A - P (PLT32 — на переходник) ----
+    for (const auto& r : obj.text_relocations) {
+        const auto place = reinterpret_cast<std::intptr_t>(base + r.offset);
+        const auto target = reinterpret_cast<std::intptr_t>(address[r.symbol]);
+        const std::int64_t value = target + r.addend - place;
+        if (value < std::numeric_limits<std::int32_t>::min() ||
+            value > std::numeric_limits<std::int32_t>::max()) {
+            error_ = "relocation out of range for " + obj.symbols[r.symbol].name;
+            return false;
+        }
+        const auto rel32 = static_cast<std::int32_t>(value);
+        std::memcpy(base + r.offset, &rel32, sizeof rel32);
+    }
+
+    if (mprotect(base, rodata_off, PROT_READ | PROT_EXEC) != 0 ||
+        (data_off > rodata_off && mprotect(base + rodata_off, data_off - rodata_off, PROT_READ) != 0)) {
+        error_ = "mprotect failed";
+        return false;
+    }
+    return true;
+}
+
+void* JitModule::symbol(const std::string& name) const {
+    auto it = symbols_.find(name);
+    return it == symbols_.end() ? nullptr : it->second;
+}
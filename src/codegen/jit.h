@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "codegen/elf_writer.h"
+
+// ---------------------------------------------------------------
+// JitModule — программа, загруженная в память процесса (compiler run)
+//
+// Делает с elf::Object то же, что компоновщик: .text, .rodata и
+// .data копируются в одно отображение mmap, внешние символы
+// (printf, malloc) находятся через dlsym, а runtime-функции
+// (print_int, read_int, ...) подставляются встроенными.  Внешние
+// вызовы идут через таблицу переходников jmp [rip+0]: libc может
+// лежать дальше ±2 ГБ от кода.  После релокаций код становится
+// R+X, .rodata — R (mprotect).
+// ---------------------------------------------------------------
+class JitModule {
+public:
+    JitModule() = default;
+    ~JitModule();
+    JitModule(const JitModule&) = delete;
+    JitModule& operator=(const JitModule&) = delete;
+
+    /// Загрузить объект; false — ошибка (описание в error()).
+    bool load(const elf::Object& obj);
+
+    /// Адрес определённого в модуле символа (nullptr — нет такого).
+    void* symbol(const std::string& name) const;
+
+    const std::string& error() const { return error_; }
+
+private:
+    void* memory_ = nullptr;
+    std::size_t size_ = 0;
+    std::unordered_map<std::string, void*> symbols_;
+    std::string error_;
+
+    void* resolve_external(const std::string& name) const;
+};
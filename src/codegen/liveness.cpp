@@ -2,157 +2,278 @@
 
 #include <algorithm>
 #include <unordered_map>
-#include <set>
+
+#include "utils/bit_vector.h"
+
+using utils::BitVector;
+
+namespace {
+
+// Векторы в регистры не распределяются: они живут в своих слотах
+bool is_value(const Operand& op) {
+    return (op.kind == OperandKind::Temp || op.kind == OperandKind::Variable) && !is_vector(op.type);
+}
+
+// Обратный порядок обхода в глубину (post-order) от входного блока.
+// Для обратной задачи это reverse post-order обращённого CFG: блок
+// обрабатывается после своих преемников.  Недостижимые блоки идут
+// в конце, чтобы их множества тоже были вычислены.
+std::vector<int> backward_order(const BlockLiveness& lp, int num_blocks) {
+    std::vector<int> order;
+    order.reserve(num_blocks);
+    std::vector<char> visited(num_blocks, 0);
+
+    // Итеративный DFS: (блок, индекс следующего преемника)
+    std::vector<std::pair<int, size_t>> stack;
+    auto dfs = [&](int root) {
+        visited[root] = 1;
+        stack.push_back({root, 0});
+        while (!stack.empty()) {
+            auto& [b, next] = stack.back();
+            if (next < lp.succs[b].size()) {
+                int s = lp.succs[b][next++];
+                if (!visited[s]) {
+                    visited[s] = 1;
+                    stack.push_back({s, 0});
+                }
+            } else {
+                order.push_back(b);
+                stack.pop_back();
+            }
+        }
+    };
+
+    for (int b = 0; b < num_blocks; ++b) {
+        if (!visited[b]) dfs(b);
+    }
+    return order;
+}
 
 // ---------------------------------------------------------------
-// compute_live_intervals
+// solve — общая часть compute_live_intervals и compute_block_liveness
 //
-// Вычисляет интервалы жизни виртуальных регистров (Temp/Variable)
-// с использованием классического итеративного алгоритма dataflow.
+// Классический итеративный dataflow на битовых векторах:
+//   live_out[B] = ∪ live_in[S],  S ∈ succ(B)
+//   live_in[B]  = use[B] ∪ (live_out[B] − def[B])
+// Блоки обходятся worklist-ом в порядке post-order, объединение и
+// разность выполняются сразу над 64-битными словами.
+//
+// При phis_on_edges PHI переносятся на рёбра: live_in[S] проходит
+// через пересылки ребра B -> S в обратном порядке, прежде чем попасть
+// в live_out[B].
 // ---------------------------------------------------------------
-std::vector<LiveInterval> compute_live_intervals(const IRFunction& func) {
-    struct Range {
-        int first_def = -1;
-        int last_use  = -1;
-    };
-    std::unordered_map<std::string, Range> ranges;
+void solve(const IRFunction& func, BlockLiveness& lp, bool phis_on_edges) {
+    const int num_blocks = static_cast<int>(func.blocks.size());
 
-    // 1. Строим карту преемников (successors) на основе актуальных инструкций перехода.
-    // Это необходимо, так как оптимизационные проходы (inlining, jump chaining)
-    // могут менять переходы, не обновляя block.successors.
-    std::unordered_map<std::string, std::vector<std::string>> successors;
+    // 1. Нумеруем значения: сначала параметры, затем операнды.
+    for (const auto& param : func.params) {
+        lp.number_value(intern_symbol(param.first));
+    }
     for (const auto& block : func.blocks) {
-        auto& succs = successors[block.label];
         for (const auto& instr : block.instructions) {
-            if (instr.opcode == IROpcode::JUMP ||
-                instr.opcode == IROpcode::JUMP_IF ||
-                instr.opcode == IROpcode::JUMP_IF_NOT) {
-                std::string target = instr.dest.name;
-                if (std::find(succs.begin(), succs.end(), target) == succs.end()) {
-                    succs.push_back(target);
+            for (const auto& src : instr.srcs) {
+                if (is_value(src)) lp.number_value(src.id);
+            }
+            if (is_value(instr.dest)) lp.number_value(instr.dest.id);
+        }
+    }
+    const size_t num_values = lp.values.size();
+
+    // 2. Строим преемников по актуальным инструкциям перехода.
+    // Это необходимо, так как оптимизационные проходы (inlining, jump chaining)
+    // могут менять переходы, не обновляя block.successors.
+    std::unordered_map<SymbolId, int> block_index;
+    for (int b = 0; b < num_blocks; ++b) {
+        block_index.emplace(intern_symbol(func.blocks[b].label), b);
+    }
+    lp.succs.assign(num_blocks, {});
+    lp.preds.assign(num_blocks, {});
+    std::vector<int> seen_from(num_blocks, -1);
+    for (int b = 0; b < num_blocks; ++b) {
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (instr.opcode != IROpcode::JUMP &&
+                instr.opcode != IROpcode::JUMP_IF &&
+                instr.opcode != IROpcode::JUMP_IF_NOT) {
+                continue;
+            }
+            auto it = block_index.find(instr.dest.id);
+            if (it == block_index.end()) continue;
+            int s = it->second;
+            if (seen_from[s] == b) continue;   // уже добавлен
+            seen_from[s] = b;
+            lp.succs[b].push_back(s);
+            lp.preds[s].push_back(b);
+        }
+    }
+
+    // PHI-пересылки на рёбрах (pred, val) -> dest
+    lp.edge_copies.assign(num_blocks, {});
+    if (phis_on_edges) {
+        for (int b = 0; b < num_blocks; ++b) {
+            lp.edge_copies[b].resize(lp.succs[b].size());
+        }
+        for (int s = 0; s < num_blocks; ++s) {
+            for (const auto& instr : func.blocks[s].instructions) {
+                if (instr.opcode != IROpcode::PHI || !is_value(instr.dest)) continue;
+                int dest = lp.value_index[instr.dest.id];
+                for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+                    const Operand& val  = instr.srcs[i];
+                    const Operand& pred = instr.srcs[i + 1];
+                    if (val.is_none() || pred.is_none()) continue;
+                    auto it = block_index.find(pred.id);
+                    if (it == block_index.end()) continue;
+                    int p = it->second;
+                    auto& succs = lp.succs[p];
+                    auto k = std::find(succs.begin(), succs.end(), s) - succs.begin();
+                    if (k == static_cast<std::ptrdiff_t>(succs.size())) continue;
+                    EdgeCopy copy;
+                    copy.dest = dest;
+                    copy.src  = is_value(val) ? lp.value_index[val.id] : -1;
+                    lp.edge_copies[p][k].push_back(copy);
                 }
             }
         }
     }
 
-    // 2. Вычисляем множества Use и Def для каждого базового блока
-    std::unordered_map<std::string, std::set<std::string>> use;
-    std::unordered_map<std::string, std::set<std::string>> def;
-    for (const auto& block : func.blocks) {
-        std::set<std::string>& use_B = use[block.label];
-        std::set<std::string>& def_B = def[block.label];
-        for (const auto& instr : block.instructions) {
+    // 3. Множества Use и Def для каждого базового блока
+    lp.use.assign(num_blocks, BitVector(num_values));
+    lp.def.assign(num_blocks, BitVector(num_values));
+    lp.live_in.assign(num_blocks, BitVector(num_values));
+    lp.live_out.assign(num_blocks, BitVector(num_values));
+    for (int b = 0; b < num_blocks; ++b) {
+        BitVector& use_B = lp.use[b];
+        BitVector& def_B = lp.def[b];
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (phis_on_edges && instr.opcode == IROpcode::PHI) continue;
             for (const auto& src : instr.srcs) {
-                if (src.kind == OperandKind::Temp || src.kind == OperandKind::Variable) {
-                    if (def_B.find(src.name) == def_B.end()) {
-                        use_B.insert(src.name);
-                    }
-                }
+                if (!is_value(src)) continue;
+                int v = lp.value_index[src.id];
+                if (!def_B.test(v)) use_B.set(v);
             }
-            if (instr.dest.kind == OperandKind::Temp || instr.dest.kind == OperandKind::Variable) {
-                if (use_B.find(instr.dest.name) == use_B.end()) {
-                    def_B.insert(instr.dest.name);
+            if (is_value(instr.dest)) {
+                int v = lp.value_index[instr.dest.id];
+                if (dest_is_read(instr.opcode)) {
+                    if (!def_B.test(v)) use_B.set(v);
+                } else if (!use_B.test(v)) {
+                    def_B.set(v);
                 }
             }
         }
     }
 
-    // 3. Итеративный dataflow-решатель для LiveIn и LiveOut
-    std::unordered_map<std::string, std::set<std::string>> live_in;
-    std::unordered_map<std::string, std::set<std::string>> live_out;
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto it = func.blocks.rbegin(); it != func.blocks.rend(); ++it) {
-            const auto& B = *it;
-
-            std::set<std::string> out_B;
-            for (const auto& succ_label : successors[B.label]) {
-                const auto& in_succ = live_in[succ_label];
-                out_B.insert(in_succ.begin(), in_succ.end());
-            }
+    // 4. Worklist-решатель для LiveIn и LiveOut
+    std::vector<int> order = backward_order(lp, num_blocks);
+    std::vector<char> dirty(num_blocks, 1);
+    BitVector edge_live(num_values);
+    bool pending = num_blocks > 0;
+    while (pending) {
+        pending = false;
+        for (int b : order) {
+            if (!dirty[b]) continue;
+            dirty[b] = 0;
 
-            std::set<std::string> in_B = use[B.label];
-            for (const auto& v : out_B) {
-                if (def[B.label].find(v) == def[B.label].end()) {
-                    in_B.insert(v);
+            BitVector& out_B = lp.live_out[b];
+            for (size_t k = 0; k < lp.succs[b].size(); ++k) {
+                int s = lp.succs[b][k];
+                if (lp.edge_copies[b].empty() || lp.edge_copies[b][k].empty()) {
+                    out_B.union_with(lp.live_in[s]);
+                    continue;
                 }
+                edge_live = lp.live_in[s];
+                const auto& copies = lp.edge_copies[b][k];
+                for (auto it = copies.rbegin(); it != copies.rend(); ++it) {
+                    edge_live.reset(it->dest);
+                    if (it->src >= 0) edge_live.set(it->src);
+                }
+                out_B.union_with(edge_live);
             }
-
-            if (in_B != live_in[B.label] || out_B != live_out[B.label]) {
-                live_in[B.label] = in_B;
-                live_out[B.label] = out_B;
-                changed = true;
+            if (lp.live_in[b].assign_union_diff(lp.use[b], out_B, lp.def[b])) {
+                for (int p : lp.preds[b]) {
+                    dirty[p] = 1;
+                    pending = true;
+                }
             }
         }
     }
+}
 
-    // 4. Вычисляем границы блоков и точки программы
-    std::unordered_map<std::string, int> start_idx;
-    std::unordered_map<std::string, int> end_idx;
-    int point = 1;
+} // namespace
+
+// ---------------------------------------------------------------
+// compute_live_intervals
+//
+// Вычисляет интервалы жизни виртуальных регистров (Temp/Variable)
+// по поблочной живости (solve), затем растягивает каждый интервал
+// на все точки, где значение появляется или живо на границе блока.
+// ---------------------------------------------------------------
+std::vector<LiveInterval> compute_live_intervals(const IRFunction& func) {
+    BlockLiveness lp;
+    solve(func, lp, /*phis_on_edges=*/false);
+    const int num_blocks = static_cast<int>(func.blocks.size());
+    const size_t num_values = lp.values.size();
+
+    // 5. Границы блоков и точки программы
+    struct Range {
+        int first_def = -1;
+        int last_use  = -1;
+    };
+    std::vector<Range> ranges(num_values);
 
     // Вспомогательная функция расширения диапазона
-    auto update_range = [&](const std::string& name, int p) {
-        auto it = ranges.find(name);
-        if (it != ranges.end()) {
-            if (it->second.first_def == -1 || p < it->second.first_def) {
-                it->second.first_def = p;
-            }
-            if (it->second.last_use == -1 || p > it->second.last_use) {
-                it->second.last_use = p;
-            }
-        } else {
-            ranges[name] = {p, p};
-        }
+    auto update_range = [&](size_t v, int p) {
+        Range& r = ranges[v];
+        if (r.first_def == -1 || p < r.first_def) r.first_def = p;
+        if (r.last_use == -1 || p > r.last_use) r.last_use = p;
     };
 
     // Параметры функции изначально определены в точке 0
     for (const auto& param : func.params) {
-        ranges[param.first] = {0, 0};
+        update_range(lp.value_index[intern_symbol(param.first)], 0);
     }
 
     // Проход по инструкциям для фиксации локальных появлений
-    for (const auto& block : func.blocks) {
-        start_idx[block.label] = point;
-        for (const auto& instr : block.instructions) {
+    std::vector<int> start_idx(num_blocks), end_idx(num_blocks);
+    int point = 1;
+    for (int b = 0; b < num_blocks; ++b) {
+        start_idx[b] = point;
+        for (const auto& instr : func.blocks[b].instructions) {
             for (const auto& src : instr.srcs) {
-                if (src.kind == OperandKind::Temp || src.kind == OperandKind::Variable) {
-                    update_range(src.name, point);
-                }
+                if (is_value(src)) update_range(lp.value_index[src.id], point);
             }
-            if (instr.dest.kind == OperandKind::Temp || instr.dest.kind == OperandKind::Variable) {
-                update_range(instr.dest.name, point);
+            if (is_value(instr.dest)) {
+                update_range(lp.value_index[instr.dest.id], point);
             }
             point++;
         }
-        end_idx[block.label] = point - 1;
+        end_idx[b] = point - 1;
     }
 
     // Расширяем диапазоны с учетом LiveIn и LiveOut базовых блоков
-    for (const auto& block : func.blocks) {
-        int start = start_idx[block.label];
-        int end = end_idx[block.label];
-
-        for (const auto& v : live_in[block.label]) {
-            update_range(v, start);
-        }
-        for (const auto& v : live_out[block.label]) {
-            update_range(v, end);
-        }
+    for (int b = 0; b < num_blocks; ++b) {
+        lp.live_in[b].for_each([&](size_t v) { update_range(v, start_idx[b]); });
+        lp.live_out[b].for_each([&](size_t v) { update_range(v, end_idx[b]); });
     }
 
-    // 5. Формируем итоговый список интервалов
+    // 6. Формируем итоговый список интервалов
     std::vector<LiveInterval> intervals;
-    intervals.reserve(ranges.size());
-    for (const auto& [name, range] : ranges) {
+    intervals.reserve(num_values);
+    for (size_t v = 0; v < num_values; ++v) {
         LiveInterval li;
-        li.name  = name;
-        li.start = range.first_def;
-        li.end   = range.last_use;
+        li.id    = lp.values[v];
+        li.start = ranges[v].first_def;
+        li.end   = ranges[v].last_use;
         intervals.push_back(li);
     }
 
     std::sort(intervals.begin(), intervals.end());
     return intervals;
 }
+
+// ---------------------------------------------------------------
+// compute_block_liveness — поблочная живость с PHI на рёбрах
+// ---------------------------------------------------------------
+BlockLiveness compute_block_liveness(const IRFunction& func) {
+    BlockLiveness lp;
+    solve(func, lp, /*phis_on_edges=*/true);
+    return lp;
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "ir/basic_block.h"
+#include "utils/bit_vector.h"
 
 // ---------------------------------------------------------------
 // LiveInterval — интервал жизни одного виртуального регистра (temp)
@@ -12,13 +14,18 @@
 // end   — номер program point, в котором temp последний раз используется
 // ---------------------------------------------------------------
 struct LiveInterval {
-    std::string name;       // имя temp-а (t0, t1, ...)
+    SymbolId id = kNoSymbol; // интернированное имя temp-а (t0, t1, ...)
     int start = 0;          // первая точка определения
     int end   = 0;          // последняя точка использования
 
-    // Сортировка по start (для LSRA)
+    // Имя для отладочной печати
+    const std::string& name() const { return symbol_name(id); }
+
+    // Сортировка по start (для LSRA), при равенстве — по id,
+    // чтобы порядок не зависел от обхода хеш-таблиц
     bool operator<(const LiveInterval& other) const {
-        return start < other.start;
+        if (start != other.start) return start < other.start;
+        return id < other.id;
     }
 };
 
@@ -28,6 +35,49 @@ struct LiveInterval {
 //
 // Каждой IR-инструкции присваивается линейный номер (program point).
 // Для каждого temp определяется [первое определение, последнее
-// использование]. Результат отсортирован по start.
+// использование]. Результат отсортирован по (start, id).
 // ---------------------------------------------------------------
 std::vector<LiveInterval> compute_live_intervals(const IRFunction& func);
+
+// ---------------------------------------------------------------
+// BlockLiveness — живость на уровне базовых блоков
+//
+// Значения (Temp/Variable и параметры) пронумерованы плотно, множества
+// хранятся битовыми векторами по этим номерам.  Используется графовым
+// аллокатором, которому нужна точная живость в каждой точке:
+//   - PHI не считаются инструкциями блока-приёмника: это пересылки
+//     на рёбрах, выполняемые в предшественнике после терминатора
+//     (именно так их генерирует emit_phi_moves), по одной, в порядке
+//     PHI в блоке;
+//   - dest у STORE_ELEM/STORE/VEC_STORE — это читаемый указатель, а не определение.
+// live_out[B] уже учитывает пересылки на всех исходящих рёбрах.
+// ---------------------------------------------------------------
+struct EdgeCopy {
+    int dest = -1;   // номер значения-приёмника PHI
+    int src  = -1;   // номер значения-источника, -1 для констант
+};
+
+struct BlockLiveness {
+    std::unordered_map<SymbolId, int> value_index;
+    std::vector<SymbolId> values;
+
+    std::vector<std::vector<int>> succs;
+    std::vector<std::vector<int>> preds;
+    // edge_copies[B][k] — PHI-пересылки на ребре B -> succs[B][k]
+    std::vector<std::vector<std::vector<EdgeCopy>>> edge_copies;
+
+    std::vector<utils::BitVector> use, def, live_in, live_out;
+
+    int number_value(SymbolId id) {
+        auto [it, inserted] = value_index.emplace(id, static_cast<int>(values.size()));
+        if (inserted) values.push_back(id);
+        return it->second;
+    }
+};
+
+// Читает ли инструкция свой dest (вместо того чтобы определять его)
+inline bool dest_is_read(IROpcode op) {
+    return op == IROpcode::STORE_ELEM || op == IROpcode::STORE || op == IROpcode::VEC_STORE;
+}
+
+BlockLiveness compute_block_liveness(const IRFunction& func);
@@ -0,0 +1,468 @@
+#include "codegen/machine_ir.h"
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace mir {
+
+namespace {
+
+const char* const NAMES_64[] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+const char* const NAMES_32[] = {
+    "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+    "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+const char* const NAMES_8[] = {
+    "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+    "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+const char* const NAMES_XMM[] = {
+    "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+    "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"
+};
+const char* const NAMES_YMM[] = {
+    "ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
+    "ymm8", "ymm9", "ymm10", "ymm11", "ymm12", "ymm13", "ymm14", "ymm15"
+};
+
+const char* cond_suffix(Cond c, bool jump) {
+    switch (c) {
+        case Cond::B:  return "b";
+        case Cond::AE: return "ae";
+        case Cond::E:  return jump ? "z" : "e";
+        case Cond::NE: return jump ? "nz" : "ne";
+        case Cond::BE: return "be";
+        case Cond::A:  return "a";
+        case Cond::P:  return "p";
+        case Cond::NP: return "np";
+        case Cond::L:  return "l";
+        case Cond::GE: return "ge";
+        case Cond::LE: return "le";
+        case Cond::G:  return "g";
+    }
+    return "?";
+}
+
+std::string hex64(std::uint64_t bits) {
+    std::ostringstream out;
+    out << "0x" << std::hex << std::uppercase << std::setw(16) << std::setfill('0') << bits;
+    return out.str();
+}
+
+std::string symbol_text(const Symbol& sym, Syntax syntax, const std::string& func) {
+    switch (sym.kind) {
+        case Symbol::Kind::Block:
+            return syntax == Syntax::Gas ? ".L_" + func + "_" + sym.name : "." + sym.name;
+        case Symbol::Kind::Aux:
+            return ".Laux_" + sym.name + "_" + std::to_string(sym.num);
+        case Symbol::Kind::Global:
+            return sym.name;
+        case Symbol::Kind::String:
+            return "Lstr_" + std::to_string(sym.num);
+        case Symbol::Kind::Float:
+            return "Lflt_" + std::to_string(sym.num);
+        case Symbol::Kind::Counter:
+            return "Lprof_" + std::to_string(sym.num);
+    }
+    return sym.name;
+}
+
+} // namespace
+
+bool is_xmm(Reg r) {
+    return r >= Reg::XMM0 && r <= Reg::XMM15;
+}
+
+int hw_index(Reg r) {
+    return static_cast<int>(r) & 15;
+}
+
+const char* reg_name(Reg r, int bits) {
+    if (r == Reg::NONE) return "?";
+    if (is_xmm(r)) return bits == 256 ? NAMES_YMM[hw_index(r)] : NAMES_XMM[hw_index(r)];
+    if (bits == 8) return NAMES_8[hw_index(r)];
+    if (bits == 32) return NAMES_32[hw_index(r)];
+    return NAMES_64[hw_index(r)];
+}
+
+Reg parse_reg(const std::string& name, int* bits) {
+    for (int i = 0; i < 16; ++i) {
+        const std::pair<const char*, int> candidates[] = {
+            {NAMES_64[i], 64}, {NAMES_32[i], 32}, {NAMES_8[i], 8}, {NAMES_XMM[i], 64},
+            {NAMES_YMM[i], 256}
+        };
+        for (size_t k = 0; k < 5; ++k) {
+            if (name == candidates[k].first) {
+                if (bits) *bits = candidates[k].second;
+                return static_cast<Reg>(k >= 3 ? i + 16 : i);
+            }
+        }
+    }
+    return Reg::NONE;
+}
+
+Cond invert(Cond c) {
+    // В кодировке x86 противоположные условия отличаются младшим битом
+    return static_cast<Cond>(static_cast<std::uint8_t>(c) ^ 1);
+}
+
+std::string op_name(Op op, Cond cond) {
+    switch (op) {
+        case Op::MOV:       return "mov";
+        case Op::MOVSXD:    return "movsxd";
+        case Op::MOVZX:     return "movzx";
+        case Op::LEA:       return "lea";
+        case Op::ADD:       return "add";
+        case Op::SUB:       return "sub";
+        case Op::IMUL:      return "imul";
+        case Op::AND:       return "and";
+        case Op::OR:        return "or";
+        case Op::XOR:       return "xor";
+        case Op::NEG:       return "neg";
+        case Op::BTC:       return "btc";
+        case Op::CDQ:       return "cdq";
+        case Op::IDIV:      return "idiv";
+        case Op::CMP:       return "cmp";
+        case Op::TEST:      return "test";
+        case Op::SETCC:     return std::string("set") + cond_suffix(cond, false);
+        case Op::JMP:       return "jmp";
+        case Op::JCC:       return std::string("j") + cond_suffix(cond, true);
+        case Op::CALL:      return "call";
+        case Op::RET:       return "ret";
+        case Op::LEAVE:     return "leave";
+        case Op::PUSH:      return "push";
+        case Op::POP:       return "pop";
+        case Op::MOVSD:     return "movsd";
+        case Op::MOVQ:      return "movq";
+        case Op::XORPD:     return "xorpd";
+        case Op::ADDSD:     return "addsd";
+        case Op::SUBSD:     return "subsd";
+        case Op::MULSD:     return "mulsd";
+        case Op::DIVSD:     return "divsd";
+        case Op::UCOMISD:   return "ucomisd";
+        case Op::CVTSI2SD:  return "cvtsi2sd";
+        case Op::CVTTSD2SI: return "cvttsd2si";
+        case Op::MOVDQU:    return "movdqu";
+        case Op::MOVD:      return "movd";
+        case Op::PUNPCKLDQ: return "punpckldq";
+        case Op::PUNPCKLQDQ: return "punpcklqdq";
+        case Op::PADDD:     return "paddd";
+        case Op::PSUBD:     return "psubd";
+        case Op::PMULLD:    return "pmulld";
+        case Op::VMOVDQU:   return "vmovdqu";
+        case Op::VMOVD:     return "vmovd";
+        case Op::VPBROADCASTD: return "vpbroadcastd";
+        case Op::VPADDD:    return "vpaddd";
+        case Op::VPSUBD:    return "vpsubd";
+        case Op::VPMULLD:   return "vpmulld";
+        case Op::VZEROUPPER: return "vzeroupper";
+    }
+    return "?";
+}
+
+bool is_vex_nds(Op op) {
+    return op == Op::VPADDD || op == Op::VPSUBD || op == Op::VPMULLD;
+}
+
+// ---------------------------------------------------------------
+// Operand
+// ---------------------------------------------------------------
+bool Operand::operator==(const Operand& o) const {
+    if (kind != o.kind) return false;
+    switch (kind) {
+        case Kind::None:  return true;
+        case Kind::Reg:   return reg == o.reg && bits == o.bits;
+        case Kind::Imm:   return value == o.value;
+        case Kind::Mem:
+            return bits == o.bits && reg == o.reg && index == o.index &&
+                   scale == o.scale && value == o.value &&
+                   (reg != Reg::NONE || sym == o.sym);
+        case Kind::Label: return sym == o.sym;
+    }
+    return false;
+}
+
+Operand reg(Reg r, int bits) {
+    Operand op;
+    op.kind = Operand::Kind::Reg;
+    op.reg = r;
+    op.bits = static_cast<std::uint16_t>(bits);
+    return op;
+}
+
+Operand imm(std::int64_t value) {
+    Operand op;
+    op.kind = Operand::Kind::Imm;
+    op.value = value;
+    return op;
+}
+
+Operand imm_hex(std::uint64_t bits) {
+    Operand op;
+    op.kind = Operand::Kind::Imm;
+    op.value = static_cast<std::int64_t>(bits);
+    op.hex = true;
+    return op;
+}
+
+Operand mem(Reg base, std::int64_t disp, int bits) {
+    return mem(base, Reg::NONE, 1, disp, bits);
+}
+
+Operand mem(Reg base, Reg index, int scale, std::int64_t disp, int bits) {
+    Operand op;
+    op.kind = Operand::Kind::Mem;
+    op.reg = base;
+    op.index = index;
+    op.scale = static_cast<std::uint8_t>(scale);
+    op.value = disp;
+    op.bits = static_cast<std::uint16_t>(bits);
+    return op;
+}
+
+Operand mem_rel(const Symbol& sym, int bits) {
+    Operand op;
+    op.kind = Operand::Kind::Mem;
+    op.sym = sym;
+    op.bits = static_cast<std::uint16_t>(bits);
+    return op;
+}
+
+Operand label(const Symbol& sym) {
+    Operand op;
+    op.kind = Operand::Kind::Label;
+    op.sym = sym;
+    return op;
+}
+
+// ---------------------------------------------------------------
+// Instr
+// ---------------------------------------------------------------
+Instr make(Op op, Operand dst, Operand src, std::string comment) {
+    Instr in;
+    in.op = op;
+    in.dst = std::move(dst);
+    in.src = std::move(src);
+    in.comment = std::move(comment);
+    return in;
+}
+
+Instr make_cc(Op op, Cond cond, Operand dst) {
+    Instr in = make(op, std::move(dst));
+    in.cond = cond;
+    return in;
+}
+
+Instr make_comment(std::string text) {
+    Instr in;
+    in.kind = Instr::Kind::Comment;
+    in.comment = std::move(text);
+    return in;
+}
+
+Instr make_loc(int line) {
+    Instr in;
+    in.kind = Instr::Kind::Loc;
+    in.line = line;
+    return in;
+}
+
+// ---------------------------------------------------------------
+// Печать
+//
+// NASM:  mov rax, qword [rbp-8]      lea rax, [rel Lstr_0]
+// GAS:   mov rax, qword ptr [rbp-8]  lea rax, [rip + Lstr_0]
+// 128/256 бит: oword / yword в NASM, xmmword / ymmword в GAS.
+// ---------------------------------------------------------------
+std::string format_operand(const Operand& op, Syntax syntax, const std::string& func) {
+    switch (op.kind) {
+        case Operand::Kind::None:
+            return {};
+        case Operand::Kind::Reg:
+            return reg_name(op.reg, op.bits);
+        case Operand::Kind::Imm:
+            return op.hex ? hex64(static_cast<std::uint64_t>(op.value)) : std::to_string(op.value);
+        case Operand::Kind::Label:
+            return symbol_text(op.sym, syntax, func);
+        case Operand::Kind::Mem: {
+            std::string s;
+            if (op.bits == 8)  s = "byte ";
+            if (op.bits == 32) s = "dword ";
+            if (op.bits == 64) s = "qword ";
+            if (op.bits == 128) s = syntax == Syntax::Gas ? "xmmword " : "oword ";
+            if (op.bits == 256) s = syntax == Syntax::Gas ? "ymmword " : "yword ";
+            if (!s.empty() && syntax == Syntax::Gas) s += "ptr ";
+            s += "[";
+            if (op.reg == Reg::NONE) {
+                s += (syntax == Syntax::Gas ? "rip + " : "rel ") + symbol_text(op.sym, syntax, func);
+            } else {
+                s += reg_name(op.reg, 64);
+                if (op.index != Reg::NONE) {
+                    s += "+";
+                    s += reg_name(op.index, 64);
+                    s += "*" + std::to_string(op.scale);
+                }
+                if (op.value > 0) s += "+" + std::to_string(op.value);
+                if (op.value < 0) s += std::to_string(op.value);
+            }
+            return s + "]";
+        }
+    }
+    return {};
+}
+
+std::string format_instr(const Instr& instr, Syntax syntax, const std::string& func) {
+    const char* cmt = syntax == Syntax::Gas ? "#" : ";";
+    switch (instr.kind) {
+        case Instr::Kind::Comment:
+            return std::string("    ") + cmt + " " + instr.comment;
+        case Instr::Kind::Loc:
+            return "    .loc 1 " + std::to_string(instr.line) + " 0";
+        case Instr::Kind::Op:
+            break;
+    }
+    std::string s = std::string("    ") + op_name(instr.op, instr.cond);
+    if (instr.dst.kind != Operand::Kind::None) {
+        s += " " + format_operand(instr.dst, syntax, func);
+        if (is_vex_nds(instr.op)) s += ", " + format_operand(instr.dst, syntax, func);
+        if (instr.src.kind != Operand::Kind::None) {
+            s += ", " + format_operand(instr.src, syntax, func);
+        }
+    }
+    if (!instr.comment.empty()) {
+        s += std::string("    ") + cmt + " " + instr.comment;
+    }
+    return s;
+}
+
+void print_function(const Function& fn, Syntax syntax, std::ostream& out) {
+    out << (syntax == Syntax::Gas ? "# " : "; ") << "---- function " << fn.name << " ----\n";
+    for (const auto& block : fn.blocks) {
+        out << symbol_text(block.label, syntax, fn.name) << ":\n";
+        for (const auto& instr : block.code) {
+            out << format_instr(instr, syntax, fn.name) << "\n";
+        }
+    }
+    out << "\n";
+}
+
+// ---------------------------------------------------------------
+// Сериализация (кэш компиляции): поля подряд, без выравнивания
+// ---------------------------------------------------------------
+namespace {
+
+void write_symbol(utils::ByteWriter& out, const Symbol& sym) {
+    out.u8(static_cast<std::uint8_t>(sym.kind));
+    out.str(sym.name);
+    out.i64(sym.num);
+}
+
+bool read_symbol(utils::ByteReader& in, Symbol& sym) {
+    std::uint8_t kind = in.u8();
+    if (kind > static_cast<std::uint8_t>(Symbol::Kind::Counter)) return false;
+    sym.kind = static_cast<Symbol::Kind>(kind);
+    sym.name = in.str();
+    sym.num = static_cast<int>(in.i64());
+    return in.ok();
+}
+
+void write_operand(utils::ByteWriter& out, const Operand& op) {
+    out.u8(static_cast<std::uint8_t>(op.kind));
+    if (op.kind == Operand::Kind::None) return;
+    out.u64(op.bits);           // varint: до 64 бит — один байт
+    out.u8(static_cast<std::uint8_t>(op.reg));
+    out.u8(static_cast<std::uint8_t>(op.index));
+    out.u8(op.scale);
+    out.u8(op.hex);
+    out.i64(op.value);
+    write_symbol(out, op.sym);
+}
+
+bool read_operand(utils::ByteReader& in, Operand& op) {
+    std::uint8_t kind = in.u8();
+    if (kind > static_cast<std::uint8_t>(Operand::Kind::Label)) return false;
+    op = Operand{};
+    op.kind = static_cast<Operand::Kind>(kind);
+    if (op.kind == Operand::Kind::None) return in.ok();
+    op.bits = static_cast<std::uint16_t>(in.u64());
+    std::uint8_t base = in.u8();
+    std::uint8_t index = in.u8();
+    if (base > static_cast<std::uint8_t>(Reg::NONE) || index > static_cast<std::uint8_t>(Reg::NONE)) {
+        return false;
+    }
+    op.reg = static_cast<Reg>(base);
+    op.index = static_cast<Reg>(index);
+    op.scale = in.u8();
+    op.hex = in.u8() != 0;
+    op.value = in.i64();
+    return read_symbol(in, op.sym);
+}
+
+} // namespace
+
+void write_function(utils::ByteWriter& out, const Function& fn) {
+    out.str(fn.name);
+    out.u64(fn.blocks.size());
+    for (const auto& block : fn.blocks) {
+        write_symbol(out, block.label);
+        out.u64(block.code.size());
+        for (const auto& instr : block.code) {
+            out.u8(static_cast<std::uint8_t>(instr.kind));
+            out.u8(static_cast<std::uint8_t>(instr.op));
+            out.u8(static_cast<std::uint8_t>(instr.cond));
+            write_operand(out, instr.dst);
+            write_operand(out, instr.src);
+            out.str(instr.comment);
+            out.i64(instr.line);
+        }
+    }
+}
+
+bool read_function(utils::ByteReader& in, Function& fn) {
+    fn = Function{};
+    fn.name = in.str();
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) {
+        Block block;
+        if (!read_symbol(in, block.label)) return false;
+        for (std::uint64_t k = in.u64(); k > 0 && in.ok(); --k) {
+            Instr instr;
+            std::uint8_t kind = in.u8();
+            std::uint8_t op = in.u8();
+            if (kind > static_cast<std::uint8_t>(Instr::Kind::Loc) ||
+                op > static_cast<std::uint8_t>(Op::VZEROUPPER)) {
+                return false;
+            }
+            instr.kind = static_cast<Instr::Kind>(kind);
+            instr.op = static_cast<Op>(op);
+            instr.cond = static_cast<Cond>(in.u8() & 0xF);
+            if (!read_operand(in, instr.dst) || !read_operand(in, instr.src)) return false;
+            instr.comment = in.str();
+            instr.line = static_cast<int>(in.i64());
+            block.code.push_back(std::move(instr));
+        }
+        fn.blocks.push_back(std::move(block));
+    }
+    return in.ok();
+}
+
+void shift_source_lines(Function& fn, int delta) {
+    if (delta == 0) return;
+    for (auto& block : fn.blocks) {
+        for (auto& instr : block.code) {
+            if (instr.line <= 0 || instr.kind == Instr::Kind::Op) continue;
+            if (instr.kind == Instr::Kind::Comment) {
+                // "line N" или "line N: комментарий IR"
+                const std::string old_prefix = "line " + std::to_string(instr.line);
+                if (instr.comment.compare(0, old_prefix.size(), old_prefix) != 0) continue;
+                instr.comment.replace(0, old_prefix.size(), "line " + std::to_string(instr.line + delta));
+            }
+            instr.line += delta;
+        }
+    }
+}
+
+} // namespace mir
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "utils/byte_stream.h"
+
+// ---------------------------------------------------------------
+// Машинный IR x86-64
+//
+// X86Generator строит не текст, а список инструкций с типизированными
+// операндами: регистр (с шириной), память [base + index*scale + disp]
+// или [rel symbol], непосредственное значение, метка.  Функция
+// разбита на блоки — по метке в начале каждого.  Оконная
+// оптимизация (X86Peephole) работает с этой структурой, а текст
+// NASM или GAS получается только при печати (print_function).
+// ---------------------------------------------------------------
+namespace mir {
+
+// Порядок совпадает с аппаратной нумерацией (ModRM / REX):
+// rax = 0, ..., r15 = 15; xmm0..xmm15 — отдельный класс
+enum class Reg : std::uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+    XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
+    XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15,
+    NONE
+};
+
+bool is_xmm(Reg r);
+
+/// Номер регистра в своём классе (0..15).
+int hw_index(Reg r);
+
+/// Имя регистра заданной ширины (8/32/64 бит), например (RAX, 32) → "eax";
+/// xmm-регистр шириной 256 бит — ymm.
+const char* reg_name(Reg r, int bits);
+
+/// Разобрать имя регистра ("rbx", "r12d", "xmm3"); NONE — не регистр.
+Reg parse_reg(const std::string& name, int* bits = nullptr);
+
+// Условия — в кодировке x86 (младшие 4 бита Jcc / SETcc)
+enum class Cond : std::uint8_t {
+    B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, BE = 0x6, A = 0x7,
+    P = 0xA, NP = 0xB, L = 0xC, GE = 0xD, LE = 0xE, G = 0xF
+};
+
+/// Противоположное условие: L ↔ GE, E ↔ NE, ...
+Cond invert(Cond c);
+
+enum class Op : std::uint8_t {
+    MOV, MOVSXD, MOVZX, LEA,
+    ADD, SUB, IMUL, AND, OR, XOR, NEG, BTC, CDQ, IDIV,
+    CMP, TEST, SETCC,
+    JMP, JCC, CALL, RET, LEAVE, PUSH, POP,
+    MOVSD, MOVQ, XORPD, ADDSD, SUBSD, MULSD, DIVSD, UCOMISD,
+    CVTSI2SD, CVTTSD2SI,
+    // Векторы int: SSE4.1 (xmm, 4 int) и AVX2 (ymm, 8 int, кодировка VEX)
+    MOVDQU, MOVD, PUNPCKLDQ, PUNPCKLQDQ, PADDD, PSUBD, PMULLD,
+    VMOVDQU, VMOVD, VPBROADCASTD, VPADDD, VPSUBD, VPMULLD, VZEROUPPER
+};
+
+/// VEX-операция вида dst = dst op src: печатается с тремя операндами
+/// (vpaddd ymm0, ymm0, ymm1), в Instr хранит два.
+bool is_vex_nds(Op op);
+
+std::string op_name(Op op, Cond cond);
+
+// ---------------------------------------------------------------
+// Symbol — метка или символ
+//
+// Номер (num) у локальных меток и литералов назначается дочерним
+// генератором функции, а при склейке перенумеровывается глобально,
+// поэтому хранится отдельно от имени.
+// ---------------------------------------------------------------
+struct Symbol {
+    enum class Kind : std::uint8_t {
+        Block,      // метка базового блока: NASM ".name", GAS ".L_func_name"
+        Aux,        // вспомогательная метка ".Laux_<name>_<num>"
+        Global,     // функция или внешний символ
+        String,     // строковый литерал "Lstr_<num>"
+        Float,      // float-константа "Lflt_<num>"
+        Counter     // счётчик профиля в .bss "Lprof_<num>"
+    };
+    Kind kind = Kind::Global;
+    std::string name;
+    int num = 0;
+
+    bool operator==(const Symbol& o) const {
+        return kind == o.kind && num == o.num && name == o.name;
+    }
+};
+
+// ---------------------------------------------------------------
+// Operand — операнд машинной инструкции
+// ---------------------------------------------------------------
+struct Operand {
+    enum class Kind : std::uint8_t { None, Reg, Imm, Mem, Label };
+    Kind kind = Kind::None;
+    std::uint16_t bits = 0;     // ширина регистра / размер обращения (0 — без указания)
+    Reg reg = Reg::NONE;        // Reg: регистр; Mem: база (NONE — [rel sym])
+    Reg index = Reg::NONE;      // Mem: индекс
+    std::uint8_t scale = 1;     // Mem: множитель индекса
+    bool hex = false;           // Imm: печатать в hex (битовый образ double)
+    std::int64_t value = 0;     // Imm: значение; Mem: смещение
+    Symbol sym;                 // Label; Mem с базой NONE
+
+    bool is_reg() const { return kind == Kind::Reg; }
+    bool is_mem() const { return kind == Kind::Mem; }
+    bool is_imm() const { return kind == Kind::Imm; }
+    bool is_reg(Reg r) const { return kind == Kind::Reg && reg == r; }
+
+    bool operator==(const Operand& o) const;
+    bool operator!=(const Operand& o) const { return !(*this == o); }
+};
+
+Operand reg(Reg r, int bits = 64);
+Operand imm(std::int64_t value);
+Operand imm_hex(std::uint64_t bits);
+Operand mem(Reg base, std::int64_t disp, int bits = 0);
+Operand mem(Reg base, Reg index, int scale, std::int64_t disp, int bits = 0);
+Operand mem_rel(const Symbol& sym, int bits = 0);
+Operand label(const Symbol& sym);
+
+// ---------------------------------------------------------------
+// Instr — инструкция или псевдо-строка листинга
+// ---------------------------------------------------------------
+struct Instr {
+    enum class Kind : std::uint8_t {
+        Op,         // машинная инструкция
+        Comment,    // строка-комментарий
+        Loc         // DWARF .loc (только GAS)
+    };
+    Kind kind = Kind::Op;
+    Op op = Op::MOV;
+    Cond cond = Cond::E;        // JCC / SETCC
+    Operand dst;                // первый операнд (JMP/JCC/CALL — метка)
+    Operand src;                // второй операнд
+    std::string comment;        // хвостовой комментарий / текст Comment
+    int line = 0;               // Loc; Comment "line N: ..." — N
+
+    bool is_op(Op o) const { return kind == Kind::Op && op == o; }
+};
+
+Instr make(Op op, Operand dst = {}, Operand src = {}, std::string comment = {});
+Instr make_cc(Op op, Cond cond, Operand dst);
+Instr make_comment(std::string text);
+Instr make_loc(int line);
+
+struct Block {
+    Symbol label;               // блок 0 — метка функции (Global)
+    std::vector<Instr> code;
+};
+
+struct Function {
+    std::string name;
+    std::vector<Block> blocks;
+};
+
+enum class Syntax { Nasm, Gas };
+
+/// Напечатать операнд (func — имя функции для GAS-меток блоков).
+std::string format_operand(const Operand& op, Syntax syntax, const std::string& func);
+
+/// Напечатать инструкцию одной строкой (без перевода строки).
+std::string format_instr(const Instr& instr, Syntax syntax, const std::string& func);
+
+/// Напечатать функцию: заголовок-комментарий, метки блоков, код и
+/// пустую строку в конце.
+void print_function(const Function& fn, Syntax syntax, std::ostream& out);
+
+/// Записать функцию в двоичный поток (кэш компиляции).
+void write_function(utils::ByteWriter& out, const Function& fn);
+
+/// Прочитать функцию, записанную write_function; false — данные испорчены.
+bool read_function(utils::ByteReader& in, Function& fn);
+
+/// Сдвинуть строки исходника на delta: .loc и комментарии "line N".
+void shift_source_lines(Function& fn, int delta);
+
+} // namespace mir
@@ -1,12 +1,14 @@
 #include "codegen/register_allocator.h"
 #include "codegen/liveness.h"
+#include "codegen/graph_coloring.h"
+#include "codegen/abi.h"
 
 #include <algorithm>
 #include <set>
 #include <sstream>
 
 // ---------------------------------------------------------------
-// Пул callee-saved регистров для LSRA
+// Пул callee-saved регистров
 // Эти регистры сохраняются вызываемой функцией (callee-saved),
 // поэтому мы должны push/pop их в прологе/эпилоге если используем.
 // ---------------------------------------------------------------
@@ -21,6 +23,23 @@ const std::vector<RegisterAllocator::PhysReg>& RegisterAllocator::reg_pool() {
     return pool;
 }
 
+// ---------------------------------------------------------------
+// Caller-saved регистры (LSRA и графовый аллокатор)
+// rax, rcx, rdx и r8 заняты генератором как scratch, поэтому в пул
+// не входят.  rsi, rdi, r9 — регистры аргументов: пролог и gen_call
+// пересылают их как параллельное копирование.
+// ---------------------------------------------------------------
+const std::vector<RegisterAllocator::PhysReg>& RegisterAllocator::caller_saved_pool() {
+    static const std::vector<PhysReg> pool = {
+        {"esi",  "rsi"},
+        {"edi",  "rdi"},
+        {"r9d",  "r9"},
+        {"r10d", "r10"},
+        {"r11d", "r11"}
+    };
+    return pool;
+}
+
 // ---------------------------------------------------------------
 // reset — сброс состояния
 // ---------------------------------------------------------------
@@ -30,8 +49,31 @@ void RegisterAllocator::reset() {
     total_instructions = 0;
     reg_allocated = 0;
     spilled = 0;
+    coalesced = 0;
+    call_saves = 0;
     allocations_.clear();
     used_callee_saved_.clear();
+    used_caller_saved_ = 0;
+    call_saves_.clear();
+}
+
+void RegisterAllocator::write_stats(utils::ByteWriter& out) const {
+    for (int value : {loads, stores, total_instructions, reg_allocated, spilled, coalesced, call_saves,
+                      used_caller_saved_}) {
+        out.i64(value);
+    }
+    out.u64(used_callee_saved_.size());
+    for (const auto& name : used_callee_saved_) out.str(name);
+}
+
+bool RegisterAllocator::read_stats(utils::ByteReader& in) {
+    for (int* value : {&loads, &stores, &total_instructions, &reg_allocated, &spilled, &coalesced, &call_saves,
+                       &used_caller_saved_}) {
+        *value = static_cast<int>(in.i64());
+    }
+    used_callee_saved_.clear();
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) used_callee_saved_.push_back(in.str());
+    return in.ok();
 }
 
 // ---------------------------------------------------------------
@@ -40,16 +82,65 @@ void RegisterAllocator::reset() {
 void RegisterAllocator::allocate(const IRFunction& func, StackFrame& /* frame */) {
     allocations_.clear();
     used_callee_saved_.clear();
+    used_caller_saved_ = 0;
+    call_saves_.clear();
     reg_allocated = 0;
     spilled = 0;
+    coalesced = 0;
+    call_saves = 0;
 
     if (strategy_ == RegAllocStrategy::LinearScan) {
         run_linear_scan(func);
+    } else if (strategy_ == RegAllocStrategy::GraphColoring) {
+        run_graph_coloring(func);
     }
     // При StackOnly — allocations_ остаётся пустым,
     // get_allocation() вернёт {in_register=false} для всех temps
 }
 
+// ---------------------------------------------------------------
+// Точки вызовов для LSRA
+//
+// Нумерация точек та же, что в compute_live_intervals (с 1, подряд
+// по блокам).  CALL и ALLOCA (malloc) портят caller-saved регистры.
+// Операнды PARAM генератор читает только в момент CALL, поэтому их
+// интервалы дотягиваются до точки вызова: иначе регистр аргумента
+// мог бы достаться значению, определённому между PARAM и CALL.
+// ---------------------------------------------------------------
+struct CallPoint {
+    int point;
+    const IRInstruction* instr;
+    bool operator<(int p) const { return point < p; }
+};
+
+static std::vector<CallPoint> collect_call_points(const IRFunction& func, std::vector<LiveInterval>& intervals) {
+    std::unordered_map<SymbolId, size_t> index;
+    for (size_t i = 0; i < intervals.size(); ++i) index.emplace(intervals[i].id, i);
+
+    std::vector<CallPoint> calls;
+    std::vector<SymbolId> pending;
+    int point = 1;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::PARAM) {
+                const Operand& arg = instr.srcs[0];
+                if (arg.is_temp() || arg.kind == OperandKind::Variable) pending.push_back(arg.id);
+            } else if (instr.opcode == IROpcode::CALL || instr.opcode == IROpcode::ALLOCA) {
+                calls.push_back({point, &instr});
+                for (SymbolId id : pending) {
+                    auto it = index.find(id);
+                    if (it != index.end()) {
+                        intervals[it->second].end = std::max(intervals[it->second].end, point);
+                    }
+                }
+                pending.clear();
+            }
+            point++;
+        }
+    }
+    return calls;
+}
+
 // ---------------------------------------------------------------
 // run_linear_scan — алгоритм Полетто-Сарнака (Linear Scan, 1999)
 //
@@ -61,14 +152,53 @@ void RegisterAllocator::allocate(const IRFunction& func, StackFrame& /* frame */
 //    - если нет → spill: выбрать из active интервал с наибольшим end
 //      * если его end > текущего end → спиллим его, назначаем текущему
 //      * иначе → спиллим текущий
+//      С профилем (set_block_counts) спиллится тот из active и
+//      текущего, к кому программа обращалась реже всего
+//
+// Пул — callee-saved плюс caller-saved регистры.  Интервал, не
+// пересекающий вызов (в листовой функции — любой), сначала берёт
+// caller-saved: его не нужно сохранять ни в прологе, ни у вызова.
+// Живущий через вызов предпочитает callee-saved; если их нет,
+// получает caller-saved, и gen_call сохраняет его push/pop вокруг
+// каждого пересечённого вызова — это дешевле, чем спилл.
 // ---------------------------------------------------------------
 void RegisterAllocator::run_linear_scan(const IRFunction& func) {
     auto intervals = compute_live_intervals(func);
 
     if (intervals.empty()) return;
 
-    const auto& pool = reg_pool();
+    const std::vector<CallPoint> calls = collect_call_points(func, intervals);
+    // Первый вызов строго внутри интервала (значение живо через него)
+    auto first_crossed = [&](const LiveInterval& iv) {
+        return std::lower_bound(calls.begin(), calls.end(), iv.start + 1);
+    };
+    auto crosses_call = [&](const LiveInterval& iv) {
+        auto it = first_crossed(iv);
+        return it != calls.end() && it->point < iv.end;
+    };
+
+    std::vector<PhysReg> pool = reg_pool();
+    const int num_callee = static_cast<int>(pool.size());
+    for (const auto& reg : caller_saved_pool()) pool.push_back(reg);
     int num_regs = static_cast<int>(pool.size());
+    auto is_caller_saved = [&](int reg_idx) { return reg_idx >= num_callee; };
+
+    // Параметр лучше оставить в его ABI-регистре, если тот в пуле:
+    // тогда пролог обходится без пересылок
+    std::unordered_map<SymbolId, int> abi_hint;
+    std::vector<bool> is_float;
+    for (const auto& param : func.params) {
+        is_float.push_back(ir_type_from_name(param.second) == IRType::Float);
+    }
+    const auto locs = x86abi::classify_args(is_float);
+    for (size_t i = 0; i < func.params.size(); ++i) {
+        if (locs[i].kind != x86abi::ArgLocation::Kind::Gpr) continue;
+        for (int r = num_callee; r < num_regs; ++r) {
+            if (pool[r].name_64 == x86abi::ARG_REGS_64[locs[i].index]) {
+                abi_hint[intern_symbol(func.params[i].first)] = r;
+            }
+        }
+    }
 
     // Множество свободных регистров (по индексу в pool)
     std::set<int> free_regs;
@@ -90,6 +220,27 @@ void RegisterAllocator::run_linear_scan(const IRFunction& func) {
     // Результат: interval_index -> reg_index (-1 = spilled)
     std::vector<int> assignment(intervals.size(), -1);
 
+    // Вес спилла по профилю: сколько раз исполнялись определения и
+    // использования значения
+    std::vector<std::uint64_t> weight;
+    if (block_counts_.size() == func.blocks.size()) {
+        std::unordered_map<SymbolId, std::uint64_t> uses;
+        for (const auto& param : func.params) {
+            uses[intern_symbol(param.first)] += block_counts_.empty() ? 0 : block_counts_[0];
+        }
+        for (size_t b = 0; b < func.blocks.size(); ++b) {
+            for (const auto& instr : func.blocks[b].instructions) {
+                if (instr.dest.is_temp() || instr.dest.kind == OperandKind::Variable) {
+                    uses[instr.dest.id] += block_counts_[b];
+                }
+                for (const auto& src : instr.srcs) {
+                    if (src.is_temp() || src.kind == OperandKind::Variable) uses[src.id] += block_counts_[b];
+                }
+            }
+        }
+        for (const auto& iv : intervals) weight.push_back(uses[iv.id]);
+    }
+
     // Множество использованных регистров (для callee-saved push/pop)
     std::set<int> used_regs;
 
@@ -109,9 +260,15 @@ void RegisterAllocator::run_linear_scan(const IRFunction& func) {
         }
 
         if (!free_regs.empty()) {
-            // Назначаем свободный регистр
-            int reg_idx = *free_regs.begin();
-            free_regs.erase(free_regs.begin());
+            // Назначаем свободный регистр нужного класса, если он есть
+            auto pick = free_regs.lower_bound(num_callee);
+            if (crosses_call(cur) ? *free_regs.begin() < num_callee : pick == free_regs.end()) {
+                pick = free_regs.begin();
+            } else if (auto hint = abi_hint.find(cur.id); hint != abi_hint.end() && free_regs.count(hint->second)) {
+                pick = free_regs.find(hint->second);
+            }
+            int reg_idx = *pick;
+            free_regs.erase(pick);
 
             assignment[i] = reg_idx;
             used_regs.insert(reg_idx);
@@ -131,10 +288,24 @@ void RegisterAllocator::run_linear_scan(const IRFunction& func) {
         } else {
             // Все регистры заняты — нужен spill
             // Находим active с наибольшим end_point (последний в списке)
-            if (!active.empty() && active.back().end_point > cur.end) {
-                // Спиллим того, кто живёт дольше, назначаем его регистр текущему
-                ActiveEntry victim = active.back();
-                active.pop_back();
+            int victim_pos = !active.empty() && active.back().end_point > cur.end
+                                 ? static_cast<int>(active.size()) - 1
+                                 : -1;
+            if (!weight.empty()) {
+                // С профилем — самый холодный; при равенстве — как без него
+                std::uint64_t best = victim_pos < 0 ? weight[i] : weight[active[victim_pos].interval_idx];
+                for (int k = static_cast<int>(active.size()) - 1; k >= 0; --k) {
+                    if (weight[active[k].interval_idx] < best) {
+                        best = weight[active[k].interval_idx];
+                        victim_pos = k;
+                    }
+                }
+                if (weight[i] < best) victim_pos = -1;
+            }
+            if (victim_pos >= 0) {
+                // Спиллим того, кто живёт дольше (реже нужен), назначаем его регистр текущему
+                ActiveEntry victim = active[victim_pos];
+                active.erase(active.begin() + victim_pos);
 
                 // Отнимаем регистр у victim
                 assignment[victim.interval_idx] = -1;  // spilled
@@ -173,21 +344,115 @@ void RegisterAllocator::run_linear_scan(const IRFunction& func) {
         } else {
             alloc.in_register = false;
         }
-        allocations_[intervals[i].name] = alloc;
+        allocations_[intervals[i].id] = alloc;
     }
 
     // Собираем список использованных callee-saved (64-bit)
     used_callee_saved_.clear();
     for (int idx : used_regs) {
-        used_callee_saved_.push_back(pool[idx].name_64);
+        if (is_caller_saved(idx)) {
+            used_caller_saved_++;
+        } else {
+            used_callee_saved_.push_back(pool[idx].name_64);
+        }
+    }
+
+    // Caller-saved регистры значений, живых через вызов
+    std::vector<std::set<int>> live_across(calls.size());
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        if (assignment[i] < 0 || !is_caller_saved(assignment[i])) continue;
+        for (auto it = first_crossed(intervals[i]); it != calls.end() && it->point < intervals[i].end; ++it) {
+            live_across[it - calls.begin()].insert(assignment[i]);
+        }
+    }
+    for (size_t c = 0; c < calls.size(); ++c) {
+        if (live_across[c].empty()) continue;
+        auto& saves = call_saves_[calls[c].instr];
+        for (int idx : live_across[c]) saves.push_back(pool[idx].name_64);
+        call_saves += static_cast<int>(live_across[c].size());
     }
 }
 
+// ---------------------------------------------------------------
+// run_graph_coloring — Chaitin-Briggs / Iterated Register Coalescing
+//
+// 1. Построить граф интерференции по точной живости (PHI на рёбрах)
+// 2. Раскрасить его в K = |callee-saved| + |caller-saved| цветов,
+//    сливая MOVE консервативно (критерий Бриггса)
+// 3. Для каждого вызова запомнить caller-saved регистры значений,
+//    живых через него, — их сохранит gen_call
+// ---------------------------------------------------------------
+void RegisterAllocator::run_graph_coloring(const IRFunction& func) {
+    InterferenceGraph graph = build_interference_graph(func, block_counts_);
+    if (graph.nodes.empty()) return;
+
+    std::vector<PhysReg> pool = reg_pool();
+    std::vector<bool> caller_saved(pool.size(), false);
+    for (const auto& reg : caller_saved_pool()) {
+        pool.push_back(reg);
+        caller_saved.push_back(true);
+    }
+
+    // Цвета ABI-регистров аргументов (rsi, rdi, r9 входят в пул)
+    std::vector<int> arg_colors(x86abi::MAX_REG_ARGS, -1);
+    for (int i = 0; i < x86abi::MAX_REG_ARGS; ++i) {
+        for (size_t c = 0; c < pool.size(); ++c) {
+            if (pool[c].name_64 == x86abi::ARG_REGS_64[i]) arg_colors[i] = static_cast<int>(c);
+        }
+    }
+
+    ColoringResult result = color_interference_graph(graph, caller_saved, arg_colors);
+    coalesced = result.coalesced_moves;
+
+    std::set<int> used_regs;
+    for (size_t n = 0; n < graph.nodes.size(); ++n) {
+        Allocation alloc;
+        int c = result.color[n];
+        if (c >= 0) {
+            alloc.in_register = true;
+            alloc.phys_reg = pool[c].name_32;
+            alloc.phys_reg_64 = pool[c].name_64;
+            used_regs.insert(c);
+            reg_allocated++;
+        } else {
+            spilled++;
+        }
+        allocations_[graph.nodes[n]] = alloc;
+    }
+
+    for (int idx : used_regs) {
+        if (caller_saved[idx]) {
+            used_caller_saved_++;
+        } else {
+            used_callee_saved_.push_back(pool[idx].name_64);
+        }
+    }
+
+    // Живые через вызов значения в caller-saved регистрах
+    for (const auto& site : graph.calls) {
+        std::set<int> regs;
+        for (int v : site.live_across) {
+            int c = result.color[v];
+            if (c >= 0 && caller_saved[c]) regs.insert(c);
+        }
+        if (regs.empty()) continue;
+        auto& saves = call_saves_[site.instr];
+        for (int idx : regs) saves.push_back(pool[idx].name_64);
+        call_saves += static_cast<int>(regs.size());
+    }
+}
+
+const std::vector<std::string>& RegisterAllocator::caller_saved_live_across(const IRInstruction& call) const {
+    static const std::vector<std::string> none;
+    auto it = call_saves_.find(&call);
+    return it != call_saves_.end() ? it->second : none;
+}
+
 // ---------------------------------------------------------------
 // get_allocation — запрос результата для конкретного temp
 // ---------------------------------------------------------------
-Allocation RegisterAllocator::get_allocation(const std::string& temp_name) const {
-    auto it = allocations_.find(temp_name);
+Allocation RegisterAllocator::get_allocation(SymbolId id) const {
+    auto it = allocations_.find(id);
     if (it != allocations_.end()) {
         return it->second;
     }
@@ -209,6 +474,16 @@ std::string RegisterAllocator::stats_report() const {
         out << "Reg allocated:   " << reg_allocated << "\n";
         out << "Spilled:         " << spilled << "\n";
         out << "Callee-saved:    " << used_callee_saved_.size() << " registers\n";
+        out << "Caller-saved:    " << used_caller_saved_ << " registers\n";
+        out << "Call saves:      " << call_saves << "\n";
+    } else if (strategy_ == RegAllocStrategy::GraphColoring) {
+        out << "Strategy:        Graph coloring (IRC)\n";
+        out << "Reg allocated:   " << reg_allocated << "\n";
+        out << "Spilled:         " << spilled << "\n";
+        out << "Coalesced moves: " << coalesced << "\n";
+        out << "Callee-saved:    " << used_callee_saved_.size() << " registers\n";
+        out << "Caller-saved:    " << used_caller_saved_ << " registers\n";
+        out << "Call saves:      " << call_saves << "\n";
     } else {
         out << "Strategy:        stack-based (all values on stack)\n";
     }
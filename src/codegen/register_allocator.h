@@ -1,19 +1,23 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "ir/basic_block.h"
 #include "codegen/stack_frame.h"
 #include "codegen/liveness.h"
+#include "utils/byte_stream.h"
 
 // ---------------------------------------------------------------
 // RegAllocStrategy — выбор стратегии распределения регистров
 // ---------------------------------------------------------------
 enum class RegAllocStrategy {
     StackOnly,      // Все значения на стеке (как в Sprint 5)
-    LinearScan      // LSRA — Полетто-Сарнак (1999)
+    LinearScan,     // LSRA — Полетто-Сарнак (1999), с caller-saved регистрами
+    GraphColoring   // IRC — Джордж-Аппель (1996), с caller-saved регистрами
 };
 
 // ---------------------------------------------------------------
@@ -29,13 +33,20 @@ struct Allocation {
 // ---------------------------------------------------------------
 // RegisterAllocator — распределитель регистров
 //
-// Поддерживает две стратегии:
+// Поддерживает три стратегии:
 //   1) StackOnly — все значения на стеке, eax/ecx = scratch
-//   2) LinearScan — LSRA: долгоживущие temps назначаются в
-//      callee-saved регистры (ebx, r12d-r15d), остальные спиллятся
+//   2) LinearScan — LSRA: значения, не живущие через вызов (в
+//      листовой функции — все), получают сначала caller-saved
+//      регистры, живущие через вызов — callee-saved; не хватило
+//      регистров — спилл
+//   3) GraphColoring — раскраска графа интерференции со слиянием
+//      MOVE; пул дополнен caller-saved регистрами, которые генератор
+//      сохраняет вокруг вызовов, если значение живо через вызов
 //
-// Пул регистров для LSRA (callee-saved по System V AMD64 ABI):
+// Пул регистров (callee-saved по System V AMD64 ABI):
 //   ebx (rbx), r12d (r12), r13d (r13), r14d (r14), r15d (r15)
+// плюс caller-saved, которые генератор сохраняет вокруг вызовов:
+//   esi (rsi), edi (rdi), r9d (r9), r10d (r10), r11d (r11)
 //
 // eax, ecx, edx остаются scratch для промежуточных вычислений.
 // ---------------------------------------------------------------
@@ -59,32 +70,52 @@ public:
     // Запуск аллокации для функции (вызывается перед генерацией кода)
     void allocate(const IRFunction& func, StackFrame& frame);
 
+    // Счётчики исполнения блоков функции из профиля (--profile-use),
+    // по порядку func.blocks; пусто — без профиля.  С ними вес спилла
+    // — число обращений по профилю, а не оценка по глубине циклов.
+    void set_block_counts(std::vector<std::uint64_t> counts) { block_counts_ = std::move(counts); }
+
     // Запрос: где живёт данный temp?
     // Возвращает Allocation (in_register + phys_reg или stack)
-    Allocation get_allocation(const std::string& temp_name) const;
+    Allocation get_allocation(SymbolId id) const;
 
     // Список callee-saved регистров, которые реально были использованы
     // (нужны для push/pop в прологе/эпилоге)
     const std::vector<std::string>& used_callee_saved_64() const { return used_callee_saved_; }
 
+    // Caller-saved регистры (64-bit), значения в которых живы через
+    // данный CALL/ALLOCA — генератор делает push/pop вокруг вызова
+    const std::vector<std::string>& caller_saved_live_across(const IRInstruction& call) const;
+
     // Статистика
     int loads  = 0;
     int stores = 0;
     int total_instructions = 0;
     int reg_allocated = 0;   // сколько temps получили регистр
     int spilled = 0;         // сколько temps спиллились на стек
+    int coalesced = 0;       // сколько MOVE слито (GraphColoring)
+    int call_saves = 0;      // сколько push/pop caller-saved вокруг вызовов
 
     void reset();
     std::string stats_report() const;
 
+    // Кэш компиляции: статистика функции (без самих назначений)
+    void write_stats(utils::ByteWriter& out) const;
+    bool read_stats(utils::ByteReader& in);
+
 private:
     RegAllocStrategy strategy_ = RegAllocStrategy::StackOnly;
+    std::vector<std::uint64_t> block_counts_;
 
-    // Результат LSRA: temp_name -> Allocation
-    std::unordered_map<std::string, Allocation> allocations_;
+    // Результат LSRA: SymbolId temp-а -> Allocation
+    std::unordered_map<SymbolId, Allocation> allocations_;
 
     // Какие callee-saved регистры реально использованы (64-bit имена для push/pop)
     std::vector<std::string> used_callee_saved_;
+    int used_caller_saved_ = 0;
+
+    // Сохранения caller-saved регистров вокруг вызовов
+    std::unordered_map<const IRInstruction*, std::vector<std::string>> call_saves_;
 
     // Пул доступных регистров
     struct PhysReg {
@@ -92,7 +123,11 @@ private:
         std::string name_64;  // "rbx", "r12", ...
     };
     static const std::vector<PhysReg>& reg_pool();
+    static const std::vector<PhysReg>& caller_saved_pool();
 
     // Внутренний метод: запуск линейного сканирования
     void run_linear_scan(const IRFunction& func);
+
+    // Внутренний метод: раскраска графа интерференции
+    void run_graph_coloring(const IRFunction& func);
 };
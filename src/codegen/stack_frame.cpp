@@ -1,107 +1,257 @@
 #include "codegen/stack_frame.h"
 #include "codegen/abi.h"
+#include "codegen/liveness.h"
+#include "ir/dominators.h"
+#include "ir/loops.h"
 
-// ---------------------------------------------------------------
-// alloc_slot — выделяет DWORD-слот на стеке
-//
-// Слоты растут вниз от rbp:
-//   первый  → [rbp - 4]
-//   второй  → [rbp - 8]
-//   ...
-// ---------------------------------------------------------------
-int StackFrame::alloc_slot(const std::string& name, int size) {
-    next_offset_ += size;
-    int offset = -next_offset_;   // отрицательное смещение от rbp
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <sstream>
+#include <unordered_set>
 
-    StackSlot slot;
-    slot.offset = offset;
-    slot.size   = size;
-    slot.name   = name;
-    slots_[name] = slot;
+namespace {
+
+// Вектор (IntX4 / IntX8) занимает 16 / 32 байта, int и bool — DWORD,
+// остальное (float, указатели на массивы, Long) — QWORD
+int slot_size(IRType type) {
+    if (is_vector(type)) return vector_lanes(type) * 4;
+    if (type == IRType::Int || type == IRType::Bool) return x86abi::DWORD_SIZE;
+    return x86abi::QWORD_SIZE;
+}
 
-    return offset;
+bool is_value(const Operand& op) {
+    return op.is_temp() || op.kind == OperandKind::Variable;
+}
+
+// Значения, хранящие адрес из ALLOCA.  Копия `t1 = MOVE t0 # int arr`
+// типизирована элементом массива (Int), но держит 64-битный указатель,
+// поэтому размер слота берётся по содержимому, а не по типу
+std::unordered_set<SymbolId> array_pointers(const IRFunction& func) {
+    std::unordered_set<SymbolId> pointers;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::ALLOCA) pointers.insert(instr.dest.id);
+        }
+    }
+    bool changed = !pointers.empty();
+    while (changed) {
+        changed = false;
+        for (const auto& block : func.blocks) {
+            for (const auto& instr : block.instructions) {
+                if (instr.opcode != IROpcode::MOVE && instr.opcode != IROpcode::PHI) continue;
+                if (!is_value(instr.dest) || pointers.count(instr.dest.id)) continue;
+                for (const auto& src : instr.srcs) {
+                    if (is_value(src) && pointers.count(src.id)) {
+                        pointers.insert(instr.dest.id);
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return pointers;
 }
 
+} // namespace
+
 // ---------------------------------------------------------------
-// build — сканирует IRFunction и назначает слоты
-//
-// Порядок:
-//   1) Параметры (по порядку объявления): a, b, ... → [rbp-4], [rbp-8], ...
-//   2) Все Temp-операнды, встреченные в инструкциях: t0, t1, ...
-//   3) Variable-операнды, не являющиеся параметрами (fallback)
-//   4) Выравнивание общего размера до 16 байт
+// build — назначает слоты значениям, живущим в памяти
 // ---------------------------------------------------------------
-void StackFrame::build(const IRFunction& func) {
+void StackFrame::build(const IRFunction& func, const std::function<bool(SymbolId)>& in_register) {
     slots_.clear();
-    next_offset_ = 0;
-    param_names_.clear();
+    param_ids_.clear();
     callee_saved_shift_ = 0;
+    rsp_depth_ = 0;
+    stats_ = FrameStats{};
+
+    // 1. Значения: размер (наибольший по всем вхождениям) и вес
+    struct Value {
+        SymbolId id;
+        int size = 0;
+        long weight = 0;
+        int start = 0;
+        int end = INT_MAX;
+        int slot = -1;
+    };
+    std::vector<Value> values;
+    std::unordered_map<SymbolId, size_t> index;
+    auto note = [&](SymbolId id, int size, long weight) {
+        auto [it, inserted] = index.emplace(id, values.size());
+        if (inserted) values.push_back({id});
+        Value& v = values[it->second];
+        v.size = std::max(v.size, size);
+        v.weight += weight;
+    };
 
-    // 1. Параметры
     for (const auto& param : func.params) {
-        alloc_slot(param.first, x86abi::QWORD_SIZE);
-        param_names_.push_back(param.first);
+        SymbolId id = intern_symbol(param.first);
+        note(id, slot_size(ir_type_from_name(param.second)), 1);
+        param_ids_.push_back(id);
     }
     param_count_ = static_cast<int>(func.params.size());
 
-    // 2–3. Сканируем все инструкции: ищем Temp и Variable-операнды
-    for (const auto& block : func.blocks) {
-        for (const auto& instr : block.instructions) {
-            // Destination
-            if (instr.opcode == IROpcode::ALLOCA) {
-                if (!has_slot(instr.dest.name)) {
-                    alloc_slot(instr.dest.name, x86abi::QWORD_SIZE);
-                }
-            } else if (instr.dest.is_temp() && !has_slot(instr.dest.name)) {
-                alloc_slot(instr.dest.name, x86abi::QWORD_SIZE);
-            }
-            // Sources
+    std::vector<long> block_weight(func.blocks.size(), 1);
+    {
+        DominatorTree dom(func);
+        LoopInfo loops(dom);
+        for (size_t b = 0; b < func.blocks.size(); ++b) {
+            int loop = loops.loop_of(static_cast<int>(b));
+            int depth = loop < 0 ? 0 : std::min(loops.loops()[loop].depth, 4);
+            block_weight[b] = 1L << (3 * depth);
+        }
+    }
+    const auto pointers = array_pointers(func);
+    auto value_size = [&](const Operand& op) {
+        return pointers.count(op.id) ? x86abi::QWORD_SIZE : slot_size(op.type);
+    };
+    for (size_t b = 0; b < func.blocks.size(); ++b) {
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (is_value(instr.dest)) note(instr.dest.id, value_size(instr.dest), block_weight[b]);
             for (const auto& src : instr.srcs) {
-                if (src.is_temp() && !has_slot(src.name)) {
-                    alloc_slot(src.name, x86abi::QWORD_SIZE);
-                }
-                if (src.kind == OperandKind::Variable && !has_slot(src.name)) {
-                    alloc_slot(src.name, x86abi::QWORD_SIZE);
-                }
+                if (is_value(src)) note(src.id, value_size(src), block_weight[b]);
             }
         }
     }
 
+    // Значениям в регистрах слот не нужен
+    if (in_register) {
+        values.erase(std::remove_if(values.begin(), values.end(),
+                                    [&](const Value& v) { return in_register(v.id); }),
+                     values.end());
+    }
+
+    // База для отчёта: тем же значениям в памяти — по собственному слоту
+    int naive = 0;
+    for (const auto& v : values) naive += std::max(v.size, x86abi::QWORD_SIZE);
+    stats_.naive_bytes = naive > 0 ? x86abi::align_to(naive, x86abi::STACK_ALIGNMENT) : 0;
+
+    // 2. Раскраска: слот освобождается после конца интервала
+    std::unordered_map<SymbolId, Value*> by_id;
+    for (auto& v : values) by_id[v.id] = &v;
+    for (const auto& li : compute_live_intervals(func)) {
+        auto it = by_id.find(li.id);
+        if (it == by_id.end()) continue;
+        it->second->start = li.start;
+        it->second->end = li.end;
+    }
+    std::sort(values.begin(), values.end(), [](const Value& a, const Value& b) {
+        if (a.start != b.start) return a.start < b.start;
+        return a.id < b.id;
+    });
+
+    std::vector<StackSlot> slots;
+    std::vector<long> slot_weight;
+    std::multimap<int, int> active;                   // конец интервала → слот
+    std::map<int, std::vector<int>> free_slots;       // размер → свободные слоты
+    for (auto& v : values) {
+        while (!active.empty() && active.begin()->first < v.start) {
+            int s = active.begin()->second;
+            free_slots[slots[s].size].push_back(s);
+            active.erase(active.begin());
+        }
+        auto& pool = free_slots[v.size];
+        if (!pool.empty()) {
+            v.slot = pool.back();
+            pool.pop_back();
+        } else {
+            v.slot = static_cast<int>(slots.size());
+            slots.push_back({0, v.size});
+            slot_weight.push_back(0);
+        }
+        slot_weight[v.slot] += v.weight;
+        active.emplace(v.end, v.slot);
+    }
+
+    // 3. Раскладка: горячие слоты первыми (ближе к rbp)
+    std::vector<int> order(slots.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return slot_weight[a] > slot_weight[b]; });
+    if (rsp_based_) std::reverse(order.begin(), order.end());
+
+    int next_offset = 0;
+    int hole = 0;                                     // свободный DWORD после выравнивания
+    for (int s : order) {
+        const int size = slots[s].size;
+        if (size == x86abi::DWORD_SIZE && hole != 0) {
+            slots[s].offset = hole;
+            hole = 0;
+            continue;
+        }
+        const int align = std::min(size, x86abi::STACK_ALIGNMENT);
+        int end = x86abi::align_to(next_offset + size, align);
+        if (end - size - next_offset >= x86abi::DWORD_SIZE && hole == 0) {
+            hole = -(next_offset + x86abi::DWORD_SIZE);
+        }
+        next_offset = end;
+        slots[s].offset = -next_offset;
+    }
+    for (const auto& v : values) slots_[v.id] = slots[v.slot];
+
     // 4. Выравнивание до 16 байт
     //    Если слотов 0, размер фрейма = 0 (sub rsp не нужен)
-    if (next_offset_ > 0) {
-        frame_size_ = x86abi::align_to(next_offset_, x86abi::STACK_ALIGNMENT);
-    } else {
-        frame_size_ = 0;
-    }
+    frame_size_ = next_offset > 0 ? x86abi::align_to(next_offset, x86abi::STACK_ALIGNMENT) : 0;
+
+    stats_.values = static_cast<int>(values.size());
+    stats_.slots = static_cast<int>(slots.size());
+    stats_.frame_bytes = frame_size_;
 }
 
 // ---------------------------------------------------------------
-// slot_ref_32 — NASM-ссылка на слот, например "dword [rbp-8]"
+// slot — операнд-слот, например qword [rbp-8] или dword [rsp+24]
 // ---------------------------------------------------------------
-std::string StackFrame::slot_ref_32(const std::string& name) const {
-    auto it = slots_.find(name);
-    if (it == slots_.end()) return "dword [UNKNOWN_SLOT_" + name + "]";
-    int offset = it->second.offset - callee_saved_shift_;
-    return "dword [rbp" + std::to_string(offset) + "]";
+mir::Operand StackFrame::slot(SymbolId id, int bits) const {
+    if (bits == 0) bits = slot_bits(id);
+    if (rsp_based_) {
+        return mir::mem(mir::Reg::RSP, rsp_depth_ + get_slot_offset(id), bits);
+    }
+    return mir::mem(mir::Reg::RBP, get_slot_offset(id), bits);
 }
 
-// ---------------------------------------------------------------
-// slot_ref_64 — NASM-ссылка на слот, например "qword [rbp-8]"
-// ---------------------------------------------------------------
-std::string StackFrame::slot_ref_64(const std::string& name) const {
-    auto it = slots_.find(name);
-    if (it == slots_.end()) return "qword [UNKNOWN_SLOT_" + name + "]";
-    int offset = it->second.offset - callee_saved_shift_;
-    return "qword [rbp" + std::to_string(offset) + "]";
+int StackFrame::slot_bits(SymbolId id) const {
+    auto it = slots_.find(id);
+    return it != slots_.end() && it->second.size == x86abi::DWORD_SIZE ? 32 : 64;
 }
 
-int StackFrame::get_slot_offset(const std::string& name) const {
-    auto it = slots_.find(name);
+int StackFrame::get_slot_offset(SymbolId id) const {
+    auto it = slots_.find(id);
     if (it == slots_.end()) return 0;
     return it->second.offset - callee_saved_shift_;
 }
 
-bool StackFrame::has_slot(const std::string& name) const {
-    return slots_.find(name) != slots_.end();
+bool StackFrame::has_slot(SymbolId id) const {
+    return slots_.find(id) != slots_.end();
+}
+
+// ---------------------------------------------------------------
+// FrameStats
+// ---------------------------------------------------------------
+void FrameStats::merge(const FrameStats& other) {
+    values      += other.values;
+    slots       += other.slots;
+    frame_bytes += other.frame_bytes;
+    naive_bytes += other.naive_bytes;
+}
+
+void FrameStats::write(utils::ByteWriter& out) const {
+    for (int value : {values, slots, frame_bytes, naive_bytes}) out.i64(value);
+}
+
+bool FrameStats::read(utils::ByteReader& in) {
+    for (int* value : {&values, &slots, &frame_bytes, &naive_bytes}) *value = static_cast<int>(in.i64());
+    return in.ok();
+}
+
+std::string FrameStats::report() const {
+    std::ostringstream out;
+    out << "=== Stack Frame Layout ===\n";
+    out << "Values in memory: " << values << "\n";
+    out << "Slots:            " << slots << "\n";
+    out << "Frame bytes:      " << frame_bytes << " (one slot per value: " << naive_bytes << ")\n";
+    if (naive_bytes > 0) {
+        out << "Frame reduction:  " << (naive_bytes - frame_bytes) * 100 / naive_bytes << "%\n";
+    }
+    return out.str();
 }
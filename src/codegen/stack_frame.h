@@ -1,49 +1,88 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "ir/basic_block.h"
+#include "codegen/machine_ir.h"
+#include "utils/byte_stream.h"
 
 // ---------------------------------------------------------------
-// StackSlot — один слот на стеке функции
+// StackSlot — место значения на стеке функции
+//
+// Значения с непересекающимися интервалами жизни делят один слот,
+// поэтому у нескольких SymbolId может быть одно смещение.
 // ---------------------------------------------------------------
 struct StackSlot {
     int    offset;   // смещение от rbp (отрицательное для локалов)
-    int    size;     // размер в байтах (4 для int)
-    std::string name;   // отладочное имя (имя переменной или t0, t1, ...)
+    int    size;     // размер в байтах: 4 (int, bool), 8, 16/32 (векторы)
+};
+
+// ---------------------------------------------------------------
+// FrameStats — счётчики раскладки фреймов для отчёта кодогенерации
+//
+// naive_bytes — сколько заняли бы фреймы, если бы каждое значение
+// в памяти получало собственный QWORD-слот (без разделения слотов).
+// ---------------------------------------------------------------
+struct FrameStats {
+    int values = 0;         // значений в памяти
+    int slots = 0;          // слотов после раскраски
+    int frame_bytes = 0;
+    int naive_bytes = 0;
+
+    void merge(const FrameStats& other);
+    std::string report() const;
+
+    // Кэш компиляции: счётчики функции
+    void write(utils::ByteWriter& out) const;
+    bool read(utils::ByteReader& in);
 };
 
 // ---------------------------------------------------------------
 // StackFrame — управление стековым фреймом функции
 //
-// Все IR-temporary и параметры получают фиксированный слот
-// вида [rbp - N].  Размер фрейма выравнивается до 16 байт
-// (ABI-требование: стек должен быть выровнен по 16 перед call).
+// Слот получают значения, которым аллокатор не дал регистр (в
+// стековом режиме и векторы — все).  Слоты индексируются
+// SymbolId операнда и адресуются [rbp - N].  Размер фрейма
+// выравнивается до 16 байт (ABI-требование: стек должен быть выровнен
+// по 16 перед call).
+//
+// Без указателя фрейма (--omit-frame-pointer) смещения отсчитываются
+// от rsp на входе в функцию, а слот адресуется [rsp + depth - N]:
+// depth — сколько байт стек вырос с входа (push, sub rsp).  Его
+// ведёт генератор по мере выдачи инструкций.
 //
 // Последовательность build():
-//   1) Выделить слоты для формальных параметров
-//   2) Просканировать все инструкции, выделить слоты для каждого
-//      уникального Temp-операнда
-//   3) Выровнять общий размер до 16
+//   1) Собрать значения в памяти, их размер по типу и вес —
+//      число обращений, умноженное на 8 за каждый уровень цикла
+//   2) Раскрасить слоты: линейным проходом по интервалам
+//      compute_live_intervals значение занимает освободившийся слот
+//      того же размера, если интервалы не пересекаются
+//   3) Разложить слоты по убыванию суммарного веса: горячие ближе к
+//      rbp (короткое disp8), а без указателя фрейма — ближе к rsp;
+//      4-байтовые слоты заполняют дыры выравнивания
+//   4) Выровнять общий размер до 16
 // ---------------------------------------------------------------
 class StackFrame {
 public:
-    /// Построить раскладку фрейма по IR-функции.
-    void build(const IRFunction& func);
+    /// Построить раскладку фрейма по IR-функции; in_register — значения,
+    /// которым аллокатор дал регистр (им слот не нужен).
+    void build(const IRFunction& func, const std::function<bool(SymbolId)>& in_register = {});
 
-    /// Получить NASM-ссылку на слот (32-bit): "dword [rbp-8]"
-    std::string slot_ref_32(const std::string& name) const;
+    /// Операнд-слот машинного IR: qword [rbp-8] (bits — размер обращения,
+    /// 0 — по размеру слота)
+    mir::Operand slot(SymbolId id, int bits = 0) const;
 
-    /// Получить NASM-ссылку на слот (64-bit): "qword [rbp-8]"
-    std::string slot_ref_64(const std::string& name) const;
+    /// Ширина скалярного слота в битах: 32 или 64.
+    int slot_bits(SymbolId id) const;
 
     /// Получить числовое смещение слота
-    int get_slot_offset(const std::string& name) const;
+    int get_slot_offset(SymbolId id) const;
 
     /// Есть ли слот с таким именем?
-    bool has_slot(const std::string& name) const;
+    bool has_slot(SymbolId id) const;
 
     /// Общий размер фрейма (уже выровнен до 16).
     int frame_size() const { return frame_size_; }
@@ -51,20 +90,30 @@ public:
     /// Установить смещение для callee-saved регистров.
     void set_callee_saved_shift(int shift) { callee_saved_shift_ = shift; }
 
+    /// Адресовать слоты от rsp вместо rbp (--omit-frame-pointer).
+    void set_rsp_based(bool enable) { rsp_based_ = enable; }
+    bool rsp_based() const { return rsp_based_; }
+
+    /// На сколько байт rsp ниже, чем на входе в функцию.
+    int rsp_depth() const { return rsp_depth_; }
+    void set_rsp_depth(int depth) { rsp_depth_ = depth; }
+
     /// Количество параметров функции.
     int param_count() const { return param_count_; }
 
     /// Имена параметров (в порядке объявления).
-    const std::vector<std::string>& param_names() const { return param_names_; }
+    const std::vector<SymbolId>& param_ids() const { return param_ids_; }
+
+    /// Счётчики раскладки последней функции.
+    const FrameStats& stats() const { return stats_; }
 
 private:
-    std::unordered_map<std::string, StackSlot> slots_;
+    std::unordered_map<SymbolId, StackSlot> slots_;
     int frame_size_  = 0;
-    int next_offset_ = 0;    // текущий конец занятого пространства
     int param_count_ = 0;
-    std::vector<std::string> param_names_;
+    std::vector<SymbolId> param_ids_;
     int callee_saved_shift_ = 0;
-
-    /// Выделить новый слот. Возвращает смещение от rbp.
-    int alloc_slot(const std::string& name, int size = 4);
+    bool rsp_based_ = false;
+    int rsp_depth_ = 0;
+    FrameStats stats_;
 };
@@ -0,0 +1,683 @@
+#include "codegen/x86_encoder.h"
+
+#include <limits>
+
+using mir::Instr;
+using mir::Op;
+using mir::Operand;
+using mir::Reg;
+
+namespace {
+
+bool fits_i8(std::int64_t v) {
+    return v >= -128 && v <= 127;
+}
+
+bool fits_i32(std::int64_t v) {
+    return v >= std::numeric_limits<std::int32_t>::min() &&
+           v <= std::numeric_limits<std::int32_t>::max();
+}
+
+// imm32 для 32-битной операции: знаковое или беззнаковое 32-битное
+bool fits_u32_or_i32(std::int64_t v) {
+    return fits_i32(v) || (v >= 0 && v <= std::numeric_limits<std::uint32_t>::max());
+}
+
+bool is_gpr(const Operand& op) {
+    return op.is_reg() && !mir::is_xmm(op.reg);
+}
+
+bool is_xmm_reg(const Operand& op) {
+    return op.is_reg() && mir::is_xmm(op.reg);
+}
+
+// Операнд r/m: регистр общего назначения или память
+bool is_rm(const Operand& op) {
+    return is_gpr(op) || op.is_mem();
+}
+
+int hw(const Operand& op) {
+    return mir::hw_index(op.reg);
+}
+
+// Ключ метки: имена блоков уникальны только внутри функции
+std::string label_key(const mir::Symbol& sym, const std::string& func) {
+    return mir::format_operand(mir::label(sym), mir::Syntax::Gas, func);
+}
+
+// Арифметика с общей схемой кодирования: opcode r/m,r = base + 1,
+// r,r/m = base + 3, r/m,imm = 81/83 /ext
+struct AluCode {
+    std::uint8_t base;
+    int ext;
+};
+
+bool alu_code(Op op, AluCode& code) {
+    switch (op) {
+        case Op::ADD: code = {0x00, 0}; return true;
+        case Op::OR:  code = {0x08, 1}; return true;
+        case Op::AND: code = {0x20, 4}; return true;
+        case Op::SUB: code = {0x28, 5}; return true;
+        case Op::XOR: code = {0x30, 6}; return true;
+        case Op::CMP: code = {0x38, 7}; return true;
+        default: return false;
+    }
+}
+
+// SSE2: префикс и второй байт опкода для xmm, xmm/m64
+bool sse_code(Op op, std::uint8_t& prefix, std::uint8_t& opcode) {
+    switch (op) {
+        case Op::XORPD:   prefix = 0x66; opcode = 0x57; return true;
+        case Op::ADDSD:   prefix = 0xF2; opcode = 0x58; return true;
+        case Op::MULSD:   prefix = 0xF2; opcode = 0x59; return true;
+        case Op::SUBSD:   prefix = 0xF2; opcode = 0x5C; return true;
+        case Op::DIVSD:   prefix = 0xF2; opcode = 0x5E; return true;
+        case Op::UCOMISD: prefix = 0x66; opcode = 0x2E; return true;
+        default: return false;
+    }
+}
+
+void put32(std::vector<std::uint8_t>& out, std::size_t pos, std::int64_t value) {
+    auto v = static_cast<std::uint32_t>(value);
+    for (int i = 0; i < 4; ++i) out[pos + i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------
+// Метки и фрагменты
+// ---------------------------------------------------------------
+int X86Encoder::label_id(const std::string& key) {
+    auto it = label_ids_.find(key);
+    if (it != label_ids_.end()) return it->second;
+    int id = static_cast<int>(label_frag_.size());
+    label_ids_.emplace(key, id);
+    label_frag_.push_back(-1);
+    label_names_.push_back(key);
+    return id;
+}
+
+void X86Encoder::start_fragment() {
+    if (!frags_.empty()) {
+        Fragment& cur = frags_.back();
+        if (cur.begin == bytes_.size() && cur.target < 0) return;   // пустой — переиспользуем
+        cur.end = bytes_.size();
+    }
+    Fragment frag;
+    frag.begin = frag.end = bytes_.size();
+    frags_.push_back(frag);
+}
+
+bool X86Encoder::define_label(const std::string& key) {
+    int id = label_id(key);
+    if (label_frag_[id] >= 0) {
+        error_ = "duplicate label " + key;
+        return false;
+    }
+    start_fragment();
+    label_frag_[id] = static_cast<int>(frags_.size()) - 1;
+    return true;
+}
+
+bool X86Encoder::fail(const Instr& in, const std::string& func) {
+    error_ = "cannot encode '" + mir::format_instr(in, mir::Syntax::Nasm, func).substr(4) +
+             "' in function " + func;
+    return false;
+}
+
+// ---------------------------------------------------------------
+// add_function — закодировать функцию блок за блоком
+// ---------------------------------------------------------------
+bool X86Encoder::add_function(const mir::Function& fn) {
+    PendingFunction range;
+    range.name = fn.name;
+    start_fragment();
+    range.first = static_cast<int>(frags_.size()) - 1;
+
+    for (const auto& block : fn.blocks) {
+        if (!define_label(label_key(block.label, fn.name))) return false;
+        for (const auto& in : block.code) {
+            if (!encode(in, fn.name)) return false;
+        }
+    }
+
+    start_fragment();
+    range.last = static_cast<int>(frags_.size()) - 1;
+    pending_.push_back(std::move(range));
+    return true;
+}
+
+// ---------------------------------------------------------------
+// emit_rm — префикс, REX, опкод и адресная часть ModRM
+//
+// REX нужен для 64-битной операции (W), регистров r8..r15 (R/X/B)
+// и байтовых spl/bpl/sil/dil (иначе это ah/ch/dh/bh).
+// Память: [base + index*scale + disp8/disp32] или [rip + disp32]
+// с релокацией на литерал.
+// ---------------------------------------------------------------
+void X86Encoder::emit_rm(std::uint8_t prefix, bool wide, std::initializer_list<std::uint8_t> opcode,
+                         int reg, bool reg_is_byte, const Operand& rm, int imm_size) {
+    if (prefix) bytes_.push_back(prefix);
+
+    std::uint8_t rex = wide ? 0x48 : 0x40;
+    bool force_rex = reg_is_byte && reg >= 4 && reg < 8;
+    if (reg & 8) rex |= 0x04;
+    if (rm.is_reg()) {
+        int r = hw(rm);
+        if (r & 8) rex |= 0x01;
+        if (rm.bits == 8 && !mir::is_xmm(rm.reg) && r >= 4 && r < 8) force_rex = true;
+    } else {
+        if (rm.reg != Reg::NONE && (mir::hw_index(rm.reg) & 8)) rex |= 0x01;
+        if (rm.index != Reg::NONE && (mir::hw_index(rm.index) & 8)) rex |= 0x02;
+    }
+    if (rex != 0x40 || force_rex) bytes_.push_back(rex);
+    bytes_.insert(bytes_.end(), opcode.begin(), opcode.end());
+    emit_modrm(reg, rm, imm_size);
+}
+
+// ---------------------------------------------------------------
+// emit_vex — VEX-префикс (AVX), опкод и адресная часть ModRM
+//
+// Двухбайтовый C5 годится для карты 0F без W и без старших индекса
+// и базы, иначе нужен трёхбайтовый C4.  Биты R/X/B и номер vvvv
+// хранятся инвертированными; L = 1 — 256-битная операция.
+// ---------------------------------------------------------------
+void X86Encoder::emit_vex(int pp, int map, bool wide, bool l256, std::uint8_t opcode,
+                          int reg, int vvvv, const Operand& rm) {
+    bool b = false, x = false;
+    if (rm.is_reg()) {
+        b = (hw(rm) & 8) != 0;
+    } else {
+        b = rm.reg != Reg::NONE && (mir::hw_index(rm.reg) & 8);
+        x = rm.index != Reg::NONE && (mir::hw_index(rm.index) & 8);
+    }
+    const int r = (reg & 8) ? 0 : 0x80;
+    const int tail = ((~vvvv & 15) << 3) | (l256 ? 4 : 0) | pp;
+    if (map == 1 && !wide && !x && !b) {
+        bytes_.push_back(0xC5);
+        bytes_.push_back(static_cast<std::uint8_t>(r | tail));
+    } else {
+        bytes_.push_back(0xC4);
+        bytes_.push_back(static_cast<std::uint8_t>(r | (x ? 0 : 0x40) | (b ? 0 : 0x20) | map));
+        bytes_.push_back(static_cast<std::uint8_t>((wide ? 0x80 : 0) | tail));
+    }
+    bytes_.push_back(opcode);
+    emit_modrm(reg, rm, 0);
+}
+
+// ModRM, SIB и смещение (общая часть emit_rm и emit_vex)
+void X86Encoder::emit_modrm(int reg, const Operand& rm, int imm_size) {
+    const int r3 = (reg & 7) << 3;
+    if (rm.is_reg()) {
+        bytes_.push_back(static_cast<std::uint8_t>(0xC0 | r3 | (hw(rm) & 7)));
+        return;
+    }
+
+    if (rm.reg == Reg::NONE) {
+        // [rip + disp32]: disp отсчитывается от конца инструкции
+        bytes_.push_back(static_cast<std::uint8_t>(0x05 | r3));
+        Fixup fixup;
+        fixup.pos = bytes_.size();
+        fixup.fragment = static_cast<int>(frags_.size()) - 1;
+        fixup.sym = rm.sym;
+        fixup.addend = -4 - imm_size;
+        fixups_.push_back(std::move(fixup));
+        bytes_.insert(bytes_.end(), 4, 0);
+        return;
+    }
+
+    const int base = mir::hw_index(rm.reg);
+    const std::int64_t disp = rm.value;
+    // rbp/r13 без смещения кодируются как [rip]/[disp32] — нужен disp8 = 0
+    int mod = (disp == 0 && (base & 7) != 5) ? 0 : fits_i8(disp) ? 1 : 2;
+    bool sib = rm.index != Reg::NONE || (base & 7) == 4;
+    bytes_.push_back(static_cast<std::uint8_t>((mod << 6) | r3 | (sib ? 4 : (base & 7))));
+    if (sib) {
+        int ss = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+        int index = rm.index != Reg::NONE ? (mir::hw_index(rm.index) & 7) : 4;
+        bytes_.push_back(static_cast<std::uint8_t>((ss << 6) | (index << 3) | (base & 7)));
+    }
+    if (mod == 1) emit_imm(disp, 1);
+    if (mod == 2) emit_imm(disp, 4);
+}
+
+void X86Encoder::emit_imm(std::int64_t value, int size) {
+    auto v = static_cast<std::uint64_t>(value);
+    for (int i = 0; i < size; ++i) {
+        bytes_.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+    }
+}
+
+// ---------------------------------------------------------------
+// encode — одна инструкция машинного IR
+// ---------------------------------------------------------------
+bool X86Encoder::encode(const Instr& in, const std::string& func) {
+    if (in.kind != Instr::Kind::Op) return true;   // комментарии и .loc
+    const Operand& d = in.dst;
+    const Operand& s = in.src;
+
+    AluCode alu{};
+    if (alu_code(in.op, alu)) {
+        if (is_rm(d) && is_gpr(s)) {
+            emit_rm(0, s.bits == 64, {static_cast<std::uint8_t>(alu.base + (s.bits == 8 ? 0 : 1))},
+                    hw(s), s.bits == 8, d, 0);
+            return true;
+        }
+        if (is_gpr(d) && s.is_mem()) {
+            emit_rm(0, d.bits == 64, {static_cast<std::uint8_t>(alu.base + (d.bits == 8 ? 2 : 3))},
+                    hw(d), d.bits == 8, s, 0);
+            return true;
+        }
+        if (is_rm(d) && s.is_imm() && d.bits != 0) {
+            if (d.bits == 8 && (fits_i8(s.value) || (s.value >= 0 && s.value <= 255))) {
+                emit_rm(0, false, {0x80}, alu.ext, false, d, 1);
+                emit_imm(s.value, 1);
+                return true;
+            }
+            if (d.bits != 8 && fits_i8(s.value)) {
+                emit_rm(0, d.bits == 64, {0x83}, alu.ext, false, d, 1);
+                emit_imm(s.value, 1);
+                return true;
+            }
+            if (d.bits != 8 && (d.bits == 64 ? fits_i32(s.value) : fits_u32_or_i32(s.value))) {
+                emit_rm(0, d.bits == 64, {0x81}, alu.ext, false, d, 4);
+                emit_imm(s.value, 4);
+                return true;
+            }
+        }
+        return fail(in, func);
+    }
+
+    std::uint8_t prefix = 0, sse = 0;
+    if (sse_code(in.op, prefix, sse)) {
+        if (!is_xmm_reg(d) || !(is_xmm_reg(s) || s.is_mem())) return fail(in, func);
+        emit_rm(prefix, false, {0x0F, sse}, hw(d), false, s, 0);
+        return true;
+    }
+
+    switch (in.op) {
+        case Op::MOV:
+            if (is_rm(d) && is_gpr(s)) {
+                emit_rm(0, s.bits == 64, {static_cast<std::uint8_t>(s.bits == 8 ? 0x88 : 0x89)},
+                        hw(s), s.bits == 8, d, 0);
+                return true;
+            }
+            if (is_gpr(d) && s.is_mem()) {
+                emit_rm(0, d.bits == 64, {static_cast<std::uint8_t>(d.bits == 8 ? 0x8A : 0x8B)},
+                        hw(d), d.bits == 8, s, 0);
+                return true;
+            }
+            if (is_gpr(d) && s.is_imm()) {
+                const int r = hw(d);
+                if (d.bits == 8) {
+                    if (r >= 4) bytes_.push_back(static_cast<std::uint8_t>(0x40 | (r >> 3)));
+                    bytes_.push_back(static_cast<std::uint8_t>(0xB0 | (r & 7)));
+                    emit_imm(s.value, 1);
+                    return true;
+                }
+                // mov r32, imm32 обнуляет старшую половину — короче для
+                // неотрицательных 64-битных значений
+                if ((d.bits == 32 && fits_u32_or_i32(s.value)) ||
+                    (d.bits == 64 && s.value >= 0 && s.value <= std::numeric_limits<std::uint32_t>::max())) {
+                    if (r & 8) bytes_.push_back(0x41);
+                    bytes_.push_back(static_cast<std::uint8_t>(0xB8 | (r & 7)));
+                    emit_imm(s.value, 4);
+                    return true;
+                }
+                if (d.bits == 64 && fits_i32(s.value)) {
+                    emit_rm(0, true, {0xC7}, 0, false, d, 4);
+                    emit_imm(s.value, 4);
+                    return true;
+                }
+                if (d.bits == 64) {
+                    bytes_.push_back(static_cast<std::uint8_t>(0x48 | (r >> 3)));
+                    bytes_.push_back(static_cast<std::uint8_t>(0xB8 | (r & 7)));
+                    emit_imm(s.value, 8);
+                    return true;
+                }
+            }
+            if (d.is_mem() && s.is_imm()) {
+                if (d.bits == 8) {
+                    emit_rm(0, false, {0xC6}, 0, false, d, 1);
+                    emit_imm(s.value, 1);
+                    return true;
+                }
+                if ((d.bits == 32 && fits_u32_or_i32(s.value)) || (d.bits == 64 && fits_i32(s.value))) {
+                    emit_rm(0, d.bits == 64, {0xC7}, 0, false, d, 4);
+                    emit_imm(s.value, 4);
+                    return true;
+                }
+            }
+            return fail(in, func);
+
+        case Op::MOVSXD:
+            if (!is_gpr(d) || !is_rm(s)) return fail(in, func);
+            emit_rm(0, true, {0x63}, hw(d), false, s, 0);
+            return true;
+
+        case Op::MOVZX:
+            if (!is_gpr(d) || !is_rm(s) || s.bits != 8) return fail(in, func);
+            emit_rm(0, d.bits == 64, {0x0F, 0xB6}, hw(d), false, s, 0);
+            return true;
+
+        case Op::LEA:
+            if (!is_gpr(d) || !s.is_mem()) return fail(in, func);
+            emit_rm(0, d.bits == 64, {0x8D}, hw(d), false, s, 0);
+            return true;
+
+        case Op::IMUL:
+            if (is_gpr(d) && is_rm(s)) {
+                emit_rm(0, d.bits == 64, {0x0F, 0xAF}, hw(d), false, s, 0);
+                return true;
+            }
+            if (is_gpr(d) && s.is_imm() && fits_i32(s.value)) {
+                const bool short_imm = fits_i8(s.value);
+                emit_rm(0, d.bits == 64, {static_cast<std::uint8_t>(short_imm ? 0x6B : 0x69)},
+                        hw(d), false, d, short_imm ? 1 : 4);
+                emit_imm(s.value, short_imm ? 1 : 4);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::NEG:
+        case Op::IDIV:
+            if (!is_rm(d) || d.bits == 0) return fail(in, func);
+            emit_rm(0, d.bits == 64, {static_cast<std::uint8_t>(d.bits == 8 ? 0xF6 : 0xF7)},
+                    in.op == Op::NEG ? 3 : 7, false, d, 0);
+            return true;
+
+        case Op::BTC:
+            if (!is_rm(d) || !s.is_imm() || d.bits == 0) return fail(in, func);
+            emit_rm(0, d.bits == 64, {0x0F, 0xBA}, 7, false, d, 1);
+            emit_imm(s.value, 1);
+            return true;
+
+        case Op::CDQ:
+            bytes_.push_back(0x99);
+            return true;
+
+        case Op::TEST:
+            if (is_rm(d) && is_gpr(s)) {
+                emit_rm(0, s.bits == 64, {static_cast<std::uint8_t>(s.bits == 8 ? 0x84 : 0x85)},
+                        hw(s), s.bits == 8, d, 0);
+                return true;
+            }
+            if (is_rm(d) && s.is_imm() && d.bits != 0) {
+                const int size = d.bits == 8 ? 1 : 4;
+                emit_rm(0, d.bits == 64, {static_cast<std::uint8_t>(d.bits == 8 ? 0xF6 : 0xF7)},
+                        0, false, d, size);
+                emit_imm(s.value, size);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::SETCC:
+            if (!is_rm(d) || (d.is_reg() && d.bits != 8)) return fail(in, func);
+            emit_rm(0, false, {0x0F, static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(in.cond))},
+                    0, false, d, 0);
+            return true;
+
+        case Op::JMP:
+        case Op::JCC: {
+            if (d.kind != Operand::Kind::Label) return fail(in, func);
+            Fragment& frag = frags_.back();
+            frag.target = label_id(label_key(d.sym, func));
+            frag.conditional = in.op == Op::JCC;
+            frag.cond = in.cond;
+            frag.end = bytes_.size();
+            start_fragment();
+            return true;
+        }
+
+        case Op::CALL:
+            if (d.kind == Operand::Kind::Label) {
+                bytes_.push_back(0xE8);
+                Fixup fixup;
+                fixup.pos = bytes_.size();
+                fixup.fragment = static_cast<int>(frags_.size()) - 1;
+                fixup.label = label_id(label_key(d.sym, func));
+                fixups_.push_back(std::move(fixup));
+                bytes_.insert(bytes_.end(), 4, 0);
+                return true;
+            }
+            if (!is_rm(d)) return fail(in, func);
+            emit_rm(0, false, {0xFF}, 2, false, d, 0);
+            return true;
+
+        case Op::RET:
+            bytes_.push_back(0xC3);
+            return true;
+
+        case Op::LEAVE:
+            bytes_.push_back(0xC9);
+            return true;
+
+        case Op::PUSH:
+        case Op::POP:
+            if (is_gpr(d)) {
+                if (hw(d) & 8) bytes_.push_back(0x41);
+                bytes_.push_back(static_cast<std::uint8_t>((in.op == Op::PUSH ? 0x50 : 0x58) | (hw(d) & 7)));
+                return true;
+            }
+            if (d.is_mem()) {
+                if (in.op == Op::PUSH) emit_rm(0, false, {0xFF}, 6, false, d, 0);
+                else emit_rm(0, false, {0x8F}, 0, false, d, 0);
+                return true;
+            }
+            if (in.op == Op::PUSH && d.is_imm() && fits_i32(d.value)) {
+                bytes_.push_back(fits_i8(d.value) ? 0x6A : 0x68);
+                emit_imm(d.value, fits_i8(d.value) ? 1 : 4);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::MOVSD:
+            if (is_xmm_reg(d) && (is_xmm_reg(s) || s.is_mem())) {
+                emit_rm(0xF2, false, {0x0F, 0x10}, hw(d), false, s, 0);
+                return true;
+            }
+            if (d.is_mem() && is_xmm_reg(s)) {
+                emit_rm(0xF2, false, {0x0F, 0x11}, hw(s), false, d, 0);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::MOVQ:
+            if (is_xmm_reg(d) && is_xmm_reg(s)) {
+                emit_rm(0xF3, false, {0x0F, 0x7E}, hw(d), false, s, 0);
+                return true;
+            }
+            if (is_xmm_reg(d) && is_rm(s)) {
+                emit_rm(0x66, true, {0x0F, 0x6E}, hw(d), false, s, 0);
+                return true;
+            }
+            if (is_rm(d) && is_xmm_reg(s)) {
+                emit_rm(0x66, true, {0x0F, 0x7E}, hw(s), false, d, 0);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::CVTSI2SD:
+            if (!is_xmm_reg(d) || !is_rm(s)) return fail(in, func);
+            emit_rm(0xF2, s.bits == 64, {0x0F, 0x2A}, hw(d), false, s, 0);
+            return true;
+
+        case Op::CVTTSD2SI:
+            if (!is_gpr(d) || !(is_xmm_reg(s) || s.is_mem())) return fail(in, func);
+            emit_rm(0xF2, d.bits == 64, {0x0F, 0x2C}, hw(d), false, s, 0);
+            return true;
+
+        // ---- векторы int: SSE4.1 ----
+        case Op::MOVDQU:
+            if (is_xmm_reg(d) && (is_xmm_reg(s) || s.is_mem())) {
+                emit_rm(0xF3, false, {0x0F, 0x6F}, hw(d), false, s, 0);
+                return true;
+            }
+            if (d.is_mem() && is_xmm_reg(s)) {
+                emit_rm(0xF3, false, {0x0F, 0x7F}, hw(s), false, d, 0);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::MOVD:
+            if (!is_xmm_reg(d) || !is_rm(s)) return fail(in, func);
+            emit_rm(0x66, false, {0x0F, 0x6E}, hw(d), false, s, 0);
+            return true;
+
+        case Op::PUNPCKLDQ: case Op::PUNPCKLQDQ:
+        case Op::PADDD: case Op::PSUBD: case Op::PMULLD: {
+            if (!is_xmm_reg(d) || !(is_xmm_reg(s) || s.is_mem())) return fail(in, func);
+            switch (in.op) {
+                case Op::PUNPCKLDQ:  emit_rm(0x66, false, {0x0F, 0x62}, hw(d), false, s, 0); break;
+                case Op::PUNPCKLQDQ: emit_rm(0x66, false, {0x0F, 0x6C}, hw(d), false, s, 0); break;
+                case Op::PADDD:      emit_rm(0x66, false, {0x0F, 0xFE}, hw(d), false, s, 0); break;
+                case Op::PSUBD:      emit_rm(0x66, false, {0x0F, 0xFA}, hw(d), false, s, 0); break;
+                default:             emit_rm(0x66, false, {0x0F, 0x38, 0x40}, hw(d), false, s, 0); break;
+            }
+            return true;
+        }
+
+        // ---- векторы int: AVX2 (VEX) ----
+        case Op::VMOVDQU:
+            if (is_xmm_reg(d) && (is_xmm_reg(s) || s.is_mem())) {
+                emit_vex(2, 1, false, d.bits == 256, 0x6F, hw(d), 0, s);
+                return true;
+            }
+            if (d.is_mem() && is_xmm_reg(s)) {
+                emit_vex(2, 1, false, s.bits == 256, 0x7F, hw(s), 0, d);
+                return true;
+            }
+            return fail(in, func);
+
+        case Op::VMOVD:
+            if (!is_xmm_reg(d) || !is_rm(s)) return fail(in, func);
+            emit_vex(1, 1, false, false, 0x6E, hw(d), 0, s);
+            return true;
+
+        case Op::VPBROADCASTD:
+            if (!is_xmm_reg(d) || !(is_xmm_reg(s) || s.is_mem())) return fail(in, func);
+            emit_vex(1, 2, false, d.bits == 256, 0x58, hw(d), 0, s);
+            return true;
+
+        case Op::VPADDD: case Op::VPSUBD: case Op::VPMULLD: {
+            if (!is_xmm_reg(d) || !(is_xmm_reg(s) || s.is_mem())) return fail(in, func);
+            const bool l256 = d.bits == 256;
+            if (in.op == Op::VPMULLD) emit_vex(1, 2, false, l256, 0x40, hw(d), hw(d), s);
+            else emit_vex(1, 1, false, l256, in.op == Op::VPADDD ? 0xFE : 0xFA, hw(d), hw(d), s);
+            return true;
+        }
+
+        case Op::VZEROUPPER:
+            bytes_.insert(bytes_.end(), {0xC5, 0xF8, 0x77});
+            return true;
+
+        default:
+            return fail(in, func);
+    }
+}
+
+// ---------------------------------------------------------------
+// finish — раскладка .text и релаксация переходов
+//
+// Все переходы начинают короткими (jmp rel8 — 2 байта, jcc rel8 —
+// 2 байта).  Переход, не дотягивающийся до цели, становится близким
+// (jmp rel32 — 5 байт, jcc rel32 — 6 байт); это сдвигает код после
+// него, поэтому проход повторяется.  Переходы только удлиняются,
+// так что процесс сходится.
+// ---------------------------------------------------------------
+bool X86Encoder::finish() {
+    start_fragment();
+    frags_.back().end = bytes_.size();
+
+    for (const auto& frag : frags_) {
+        if (frag.target >= 0 && label_frag_[frag.target] < 0) {
+            error_ = "undefined label " + label_names_[frag.target];
+            return false;
+        }
+    }
+
+    auto branch_size = [](const Fragment& f) -> std::uint64_t {
+        if (f.target < 0) return 0;
+        if (!f.near) return 2;
+        return f.conditional ? 6 : 5;
+    };
+
+    std::uint64_t total = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        total = 0;
+        for (auto& frag : frags_) {
+            frag.offset = total;
+            total += (frag.end - frag.begin) + branch_size(frag);
+        }
+        for (auto& frag : frags_) {
+            if (frag.target < 0 || frag.near) continue;
+            auto from = static_cast<std::int64_t>(frag.offset + (frag.end - frag.begin) + 2);
+            auto to = static_cast<std::int64_t>(frags_[label_frag_[frag.target]].offset);
+            if (!fits_i8(to - from)) {
+                frag.near = true;
+                changed = true;
+            }
+        }
+    }
+
+    code_.clear();
+    code_.reserve(total);
+    for (const auto& frag : frags_) {
+        code_.insert(code_.end(), bytes_.begin() + static_cast<std::ptrdiff_t>(frag.begin),
+                     bytes_.begin() + static_cast<std::ptrdiff_t>(frag.end));
+        if (frag.target < 0) continue;
+
+        const std::uint64_t size = branch_size(frag);
+        const auto to = static_cast<std::int64_t>(frags_[label_frag_[frag.target]].offset);
+        const auto rel = to - static_cast<std::int64_t>(code_.size() + size);
+        const auto cc = static_cast<std::uint8_t>(frag.cond);
+        if (!frag.near) {
+            code_.push_back(frag.conditional ? static_cast<std::uint8_t>(0x70 | cc) : 0xEB);
+            code_.push_back(static_cast<std::uint8_t>(rel));
+            short_branches_++;
+        } else {
+            if (frag.conditional) {
+                code_.push_back(0x0F);
+                code_.push_back(static_cast<std::uint8_t>(0x80 | cc));
+            } else {
+                code_.push_back(0xE9);
+            }
+            code_.insert(code_.end(), 4, 0);
+            put32(code_, code_.size() - 4, rel);
+            near_branches_++;
+        }
+    }
+
+    for (const auto& fixup : fixups_) {
+        const Fragment& frag = frags_[fixup.fragment];
+        const std::uint64_t offset = frag.offset + (fixup.pos - frag.begin);
+        if (fixup.label >= 0 && label_frag_[fixup.label] >= 0) {
+            // call функции из этого же файла
+            auto to = static_cast<std::int64_t>(frags_[label_frag_[fixup.label]].offset);
+            put32(code_, offset, to - static_cast<std::int64_t>(offset + 4));
+            continue;
+        }
+        Relocation reloc;
+        reloc.offset = offset;
+        if (fixup.label >= 0) {
+            reloc.type = Relocation::Type::PLT32;
+            reloc.sym = {mir::Symbol::Kind::Global, label_names_[fixup.label], 0};
+            reloc.addend = -4;
+        } else {
+            reloc.type = Relocation::Type::PC32;
+            reloc.sym = fixup.sym;
+            reloc.addend = fixup.addend;
+        }
+        relocs_.push_back(std::move(reloc));
+    }
+
+    for (const auto& range : pending_) {
+        FunctionRange fn;
+        fn.name = range.name;
+        fn.offset = frags_[range.first].offset;
+        fn.size = frags_[range.last].offset - fn.offset;
+        funcs_.push_back(std::move(fn));
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "codegen/machine_ir.h"
+
+// ---------------------------------------------------------------
+// X86Encoder — кодирование машинного IR в байты x86-64
+//
+// Функции добавляются по одной (add_function) в общую секцию .text.
+// Инструкции кодируются сразу, кроме переходов на метки: jmp/jcc
+// сначала считаются короткими (rel8), а finish() удлиняет до rel32
+// те, что не дотягиваются, пока раскладка не перестанет меняться.
+//
+// call функции из того же файла разрешается в finish(); call
+// внешнего символа и обращения [rel Lstr_N] / [rel Lflt_N]
+// остаются релокациями для компоновщика.
+// ---------------------------------------------------------------
+class X86Encoder {
+public:
+    struct Relocation {
+        enum class Type : std::uint8_t {
+            PC32,       // R_X86_64_PC32: S + A - P (данные в .rodata)
+            PLT32       // R_X86_64_PLT32: L + A - P (внешняя функция)
+        };
+        Type type = Type::PC32;
+        std::uint64_t offset = 0;   // смещение поля rel32 в .text
+        mir::Symbol sym;            // Global — функция; String / Float — литерал
+        std::int64_t addend = 0;
+    };
+
+    struct FunctionRange {
+        std::string name;
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+    /// Закодировать функцию; false — неподдерживаемая форма инструкции
+    /// (описание в error()).
+    bool add_function(const mir::Function& fn);
+
+    /// Разрешить метки и переходы, собрать .text.
+    bool finish();
+
+    const std::vector<std::uint8_t>& code() const { return code_; }
+    const std::vector<Relocation>& relocations() const { return relocs_; }
+    const std::vector<FunctionRange>& functions() const { return funcs_; }
+    const std::string& error() const { return error_; }
+
+    int short_branches() const { return short_branches_; }
+    int near_branches()  const { return near_branches_; }
+
+private:
+    // Фрагмент — непрерывный код bytes_[begin, end) и, возможно,
+    // переход в конце.  Метка указывает на начало фрагмента.
+    struct Fragment {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        int target = -1;            // метка перехода (-1 — нет перехода)
+        bool conditional = false;
+        mir::Cond cond = mir::Cond::E;
+        bool near = false;          // rel32 вместо rel8
+        std::uint64_t offset = 0;   // смещение в .text после раскладки
+    };
+
+    // Поле rel32 внутри фрагмента: call метки или RIP-относительный адрес
+    struct Fixup {
+        std::size_t pos = 0;        // позиция поля в bytes_
+        int fragment = 0;
+        int label = -1;             // call: метка функции
+        mir::Symbol sym;            // RIP: литерал
+        std::int64_t addend = 0;
+    };
+
+    struct PendingFunction {
+        std::string name;
+        int first = 0;              // первый фрагмент
+        int last = 0;               // фрагмент за последним
+    };
+
+    std::vector<std::uint8_t> bytes_;
+    std::vector<Fragment> frags_;
+    std::vector<Fixup> fixups_;
+    std::unordered_map<std::string, int> label_ids_;
+    std::vector<int> label_frag_;   // фрагмент метки (-1 — не определена)
+    std::vector<std::string> label_names_;
+    std::vector<PendingFunction> pending_;
+
+    std::vector<std::uint8_t> code_;
+    std::vector<Relocation> relocs_;
+    std::vector<FunctionRange> funcs_;
+    std::string error_;
+    int short_branches_ = 0;
+    int near_branches_ = 0;
+
+    int label_id(const std::string& key);
+    void start_fragment();
+    bool define_label(const std::string& key);
+    bool encode(const mir::Instr& in, const std::string& func);
+    bool fail(const mir::Instr& in, const std::string& func);
+
+    // [prefix] [REX] opcode ModRM [SIB] [disp]; imm_size — число байт
+    // непосредственного значения после disp (для RIP-относительной
+    // адресации)
+    void emit_rm(std::uint8_t prefix, bool wide, std::initializer_list<std::uint8_t> opcode,
+                 int reg, bool reg_is_byte, const mir::Operand& rm, int imm_size);
+    // VEX opcode ModRM [SIB] [disp]: pp — 0/66/F3/F2 как 0..3, map —
+    // 1 (0F) или 2 (0F38), vvvv — второй источник (0 — не нужен)
+    void emit_vex(int pp, int map, bool wide, bool l256, std::uint8_t opcode,
+                  int reg, int vvvv, const mir::Operand& rm);
+    void emit_modrm(int reg, const mir::Operand& rm, int imm_size);
+    void emit_imm(std::int64_t value, int size);
+};
@@ -1,10 +1,49 @@
 #include "codegen/x86_generator.h"
 #include "codegen/abi.h"
+#include "codegen/x86_encoder.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <iomanip>
 #include <sstream>
 
+namespace {
+
+// Битовый образ double как 64-битная hex-константа: 1.5 → 0x3FF8000000000000
+std::uint64_t double_bits(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+std::string hex64(std::uint64_t bits) {
+    std::ostringstream out;
+    out << "0x" << std::hex << std::uppercase << std::setw(16) << std::setfill('0') << bits;
+    return out.str();
+}
+
+double bits_double(std::uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+// Физический регистр по имени из аллокатора / ABI
+mir::Operand gpr(const std::string& name) {
+    return mir::reg(mir::parse_reg(name), 64);
+}
+
+mir::Operand r64(mir::Reg r) { return mir::reg(r, 64); }
+mir::Operand r32(mir::Reg r) { return mir::reg(r, 32); }
+mir::Operand r8(mir::Reg r)  { return mir::reg(r, 8); }
+mir::Operand xmm(mir::Reg r) { return mir::reg(r, 64); }
+
+// Функция, записывающая счётчики профиля (--profile-generate)
+const char* const kProfileDump = "__mc_profile_dump";
+
+} // namespace
+
 // ---------------------------------------------------------------
 // Runtime-функции, предоставляемые runtime.asm
 // ---------------------------------------------------------------
@@ -18,37 +57,37 @@ const std::set<std::string>& X86Generator::runtime_functions() {
 // ---------------------------------------------------------------
 // Вспомогательные методы вывода
 // ---------------------------------------------------------------
-void X86Generator::emit(const std::string& line) {
-    std::string l = line;
-    if (emit_dwarf_) {
-        size_t pos = l.find(';');
-        if (pos != std::string::npos) {
-            l[pos] = '#';
-        }
-        size_t rel_pos = l.find("rel ");
-        if (rel_pos != std::string::npos) {
-            l.replace(rel_pos, 4, "rip + ");
-        }
-        auto is_block_label = [](const std::string& s, size_t dot_pos) {
-            if (dot_pos + 1 >= s.length()) return false;
-            std::string sub = s.substr(dot_pos, 5);
-            if (sub == ".glob" || sub == ".sect" || sub == ".inte" || sub == ".text" || 
-                sub == ".file" || sub == ".loc " || sub == ".asci" || sub == ".exte" || sub == ".note") return false;
-            if (sub == ".Lstr" || sub == ".Laux") return false;
-            return true;
-        };
-        size_t dot_pos = l.find('.');
-        while (dot_pos != std::string::npos) {
-            if ((dot_pos == 0 || l[dot_pos - 1] == ' ' || l[dot_pos - 1] == '\t') && is_block_label(l, dot_pos)) {
-                l.replace(dot_pos, 1, ".L_" + cur_func_name_ + "_");
-                dot_pos += cur_func_name_.length() + 3;
-            } else {
-                dot_pos++;
-            }
-            dot_pos = l.find('.', dot_pos);
+void X86Generator::emit(mir::Instr instr) {
+    // Без указателя фрейма слоты адресуются от rsp: следим, на сколько
+    // стек опустился с входа в функцию (rsp меняют только push/pop и
+    // sub/add с константой)
+    if (frame_.rsp_based() && instr.kind == mir::Instr::Kind::Op) {
+        int depth = frame_.rsp_depth();
+        if (instr.op == mir::Op::PUSH) {
+            depth += x86abi::QWORD_SIZE;
+        } else if (instr.op == mir::Op::POP) {
+            depth -= x86abi::QWORD_SIZE;
+        } else if (instr.dst.is_reg(mir::Reg::RSP) && instr.src.is_imm()) {
+            if (instr.op == mir::Op::SUB) depth += static_cast<int>(instr.src.value);
+            if (instr.op == mir::Op::ADD) depth -= static_cast<int>(instr.src.value);
         }
+        frame_.set_rsp_depth(depth);
     }
-    out_ << l << "\n";
+    fn_.blocks.back().code.push_back(std::move(instr));
+    regalloc_.total_instructions++;
+}
+
+void X86Generator::emit(mir::Op op, mir::Operand dst, mir::Operand src, std::string comment) {
+    emit(mir::make(op, std::move(dst), std::move(src), std::move(comment)));
+}
+
+void X86Generator::emit_label(const mir::Symbol& label) {
+    fn_.blocks.push_back({label, {}});
+    regalloc_.total_instructions++;
+}
+
+void X86Generator::emit_line(const std::string& line) {
+    out_ << line << "\n";
     regalloc_.total_instructions++;
 }
 
@@ -56,136 +95,668 @@ void X86Generator::emit_blank() {
     out_ << "\n";
 }
 
-std::string X86Generator::new_aux_label(const std::string& hint) {
-    return ".Laux_" + hint + "_" + std::to_string(aux_label_counter_++);
+mir::Symbol X86Generator::block_label(const std::string& name) const {
+    return {mir::Symbol::Kind::Block, name, 0};
 }
 
-std::string X86Generator::intern_string(const std::string& value) {
+mir::Symbol X86Generator::new_aux_label(const std::string& hint) {
+    return {mir::Symbol::Kind::Aux, hint, aux_label_counter_++};
+}
+
+mir::Symbol X86Generator::intern_string(const std::string& value) {
     // Проверяем, не была ли строка уже интернирована
-    for (const auto& pair : string_literals_) {
-        if (pair.second == value) return pair.first;
-    }
-    std::string label = "Lstr_" + std::to_string(string_counter_++);
-    string_literals_.push_back({label, value});
-    return label;
+    auto it = std::find(string_literals_.begin(), string_literals_.end(), value);
+    int num = static_cast<int>(it - string_literals_.begin());
+    if (it == string_literals_.end()) string_literals_.push_back(value);
+    return {mir::Symbol::Kind::String, {}, num};
+}
+
+mir::Symbol X86Generator::intern_float(double value) {
+    // Константы сравниваются по битам: 0.0 и -0.0 — разные
+    std::uint64_t bits = double_bits(value);
+    auto it = std::find(float_literals_.begin(), float_literals_.end(), bits);
+    int num = static_cast<int>(it - float_literals_.begin());
+    if (it == float_literals_.end()) float_literals_.push_back(bits);
+    return {mir::Symbol::Kind::Float, {}, num};
 }
 
 // ---------------------------------------------------------------
 // generate — точка входа: генерирует весь NASM-файл
 // ---------------------------------------------------------------
 std::string X86Generator::generate(const IRProgram& program) {
+    if (emit_object_) {
+        elf::Object obj = generate_object(program);
+        return errors_.empty() ? elf::write_object(obj) : std::string{};
+    }
+
+    gen_program(program, true);
+    const auto syntax = emit_dwarf_ ? mir::Syntax::Gas : mir::Syntax::Nasm;
+    for (const auto& fn : functions_) {
+        mir::print_function(fn, syntax, out_);
+    }
+
+    // ---- Секция .rodata (float-константы и строковые литералы) ----
+    if (!string_literals_.empty() || !float_literals_.empty()) {
+        emit_blank();
+        emit_line(emit_dwarf_ ? ".section .rodata" : "section .rodata");
+    }
+    if (!float_literals_.empty()) {
+        // movsd читает 8 байт — константы выровнены по 8
+        emit_line(emit_dwarf_ ? "    .balign 8" : "    align 8");
+        for (size_t i = 0; i < float_literals_.size(); ++i) {
+            std::ostringstream value;
+            value << bits_double(float_literals_[i]);
+            emit_line("Lflt_" + std::to_string(i) + ":");
+            emit_line(std::string(emit_dwarf_ ? "    .quad " : "    dq ") + hex64(float_literals_[i]) +
+                      (emit_dwarf_ ? "    # " : "    ; ") + value.str());
+        }
+    }
+    for (size_t i = 0; i < string_literals_.size(); ++i) {
+        std::string escaped = string_literals_[i];
+        // Всегда экранируем реальные переносы строк в \n
+        size_t pos = 0;
+        while ((pos = escaped.find('\n', pos)) != std::string::npos) {
+            escaped.replace(pos, 1, "\\n");
+            pos += 2;
+        }
+        emit_line("Lstr_" + std::to_string(i) + ":");
+        if (emit_dwarf_) {
+            emit_line("    .asciz \"" + escaped + "\"");
+        } else {
+            emit_line("    db `" + escaped + "`, 0");
+        }
+    }
+
+    // ---- Секция .bss (счётчики профиля) ----
+    if (!counters_.empty()) {
+        emit_blank();
+        emit_line(emit_dwarf_ ? ".bss" : "section .bss");
+        emit_line(emit_dwarf_ ? "    .balign 8" : "    alignb 8");
+        for (size_t i = 0; i < counters_.size(); ++i) {
+            emit_line("Lprof_" + std::to_string(i) + ":");
+            emit_line(emit_dwarf_ ? "    .zero 8" : "    resq 1");
+        }
+    }
+
+    // DWARF: метка неисполняемого стека
+    if (emit_dwarf_) {
+        emit_blank();
+        emit_line(".section .note.GNU-stack,\"\",@progbits");
+    }
+
+    // ---- extern-объявления (вставляем в начало) ----
+    std::ostringstream result;
+
+    // Собираем extern для нерезолвленных символов
+    for (const auto& sym : extern_symbols_) {
+        if (defined_functions_.find(sym) == defined_functions_.end()) {
+            result << (emit_dwarf_ ? ".extern " : "extern ") << sym << "\n";
+        }
+    }
+    if (!extern_symbols_.empty()) {
+        result << "\n";
+    }
+
+    result << out_.str();
+    return result.str();
+}
+
+// ---------------------------------------------------------------
+// generate_object — объектный модуль в памяти (--emit obj, JIT)
+// ---------------------------------------------------------------
+elf::Object X86Generator::generate_object(const IRProgram& program) {
+    gen_program(program, false);
+    elf::Object obj;
+    build_object(obj);
+    return obj;
+}
+
+// ---------------------------------------------------------------
+// gen_program — сгенерировать машинный IR всех функций в functions_
+// (text — текстовый вывод: заголовок и global пишутся в out_)
+// ---------------------------------------------------------------
+void X86Generator::gen_program(const IRProgram& program, bool text) {
     out_.str("");
     out_.clear();
     string_literals_.clear();
-    string_counter_ = 0;
+    float_literals_.clear();
     aux_label_counter_ = 0;
     extern_symbols_.clear();
     defined_functions_.clear();
     regalloc_.reset();
+    peephole_ = X86Peephole{};
+    frame_stats_ = FrameStats{};
     last_emitted_line_ = 0;
+    functions_.clear();
+    errors_.clear();
+    counters_.clear();
+    profiled_functions_ = 0;
+    defined_count_ = 0;
 
     // Предварительно собираем список определенных в файле функций
     for (const auto& func : program.functions) {
         if (!func.blocks.empty()) {
             defined_functions_.insert(func.name);
+            defined_count_++;
+            if (profile_ && profile_->function(func)) profiled_functions_++;
+        }
+    }
+
+    // Заголовок текстового вывода (объектный файл собирает build_object)
+    if (text) {
+        emit_header(program);
+    }
+
+    // Генерируем код каждой функции (параллельно, если задан пул)
+    std::vector<FunctionAsm> units(program.functions.size());
+    auto gen_unit = [&](size_t i) {
+        const IRFunction& func = program.functions[i];
+        if (unit_cache_ && !func.blocks.empty()) {
+            std::string data;
+            int line_delta = 0;
+            if (unit_cache_->load(func.name, data, line_delta) && decode_unit(data, line_delta, units[i])) {
+                units[i].regalloc.set_strategy(regalloc_.strategy());
+                return;
+            }
+        }
+        units[i] = gen_function_unit(func);
+        if (unit_cache_ && units[i].has_code) {
+            unit_cache_->store(func.name, encode_unit(units[i]));
         }
+    };
+    if (pool_) {
+        pool_->parallel_for(units.size(), gen_unit);
+    } else {
+        for (size_t i = 0; i < units.size(); ++i) gen_unit(i);
     }
+    merge_units(units);
+    if (!counters_.empty()) gen_profile_dump();
+}
 
+// ---------------------------------------------------------------
+// emit_header — заголовок NASM/GAS-файла и объявления global
+// ---------------------------------------------------------------
+void X86Generator::emit_header(const IRProgram& program) {
     // ---- Заголовок ----
     if (emit_dwarf_) {
         // GAS-синтаксис с DWARF debug info
-        emit("# ============================================================");
-        emit("# MiniCompiler — x86-64 GAS output (Intel syntax, DWARF debug)");
-        emit("# Target: Linux x86-64, System V AMD64 ABI");
-        emit("# ============================================================");
+        emit_line("# ============================================================");
+        emit_line("# MiniCompiler — x86-64 GAS output (Intel syntax, DWARF debug)");
+        emit_line("# Target: Linux x86-64, System V AMD64 ABI");
+        emit_line("# ============================================================");
         emit_blank();
-        emit(".intel_syntax noprefix");
+        emit_line(".intel_syntax noprefix");
         // DWARF .file директива
         std::string fname = source_filename_.empty() ? "input.src" : source_filename_;
-        emit(".file 1 \"" + fname + "\"");
+        emit_line(".file 1 \"" + fname + "\"");
         emit_blank();
-        emit(".text");
+        emit_line(".text");
     } else {
         // NASM-синтаксис (как раньше)
-        emit("; ============================================================");
-        emit("; MiniCompiler — x86-64 NASM output");
-        emit("; Target: Linux x86-64, System V AMD64 ABI");
-        emit("; ============================================================");
+        emit_line("; ============================================================");
+        emit_line("; MiniCompiler — x86-64 NASM output");
+        emit_line("; Target: Linux x86-64, System V AMD64 ABI");
+        emit_line("; ============================================================");
         emit_blank();
-        emit("section .text");
+        emit_line("section .text");
     }
     emit_blank();
 
     // ---- Глобальные символы ----
     for (const auto& func : program.functions) {
         if (!func.blocks.empty()) {
-            emit((emit_dwarf_ ? ".globl " : "global ") + func.name);
+            emit_line((emit_dwarf_ ? ".globl " : "global ") + func.name);
         }
     }
     emit_blank();
+}
 
-    // Генерируем код каждой функции
-    for (const auto& func : program.functions) {
-        gen_function(func);
+std::string X86Generator::statistics() const {
+    std::string s = regalloc_.stats_report();
+    s += frame_stats_.report();
+    if (peephole_enabled_) {
+        s += peephole_.report();
+    }
+    if (!profile_path_.empty() || profile_) {
+        std::ostringstream out;
+        out << "=== Profile ===\n";
+        if (!profile_path_.empty()) out << "Counters:           " << counters_.size() << "\n";
+        if (profile_) {
+            out << "Profiled functions: " << profiled_functions_ << " of " << defined_count_ << "\n";
+        }
+        s += out.str();
     }
+    return s;
+}
 
-    // ---- Секция .data / .rodata (строковые литералы) ----
-    if (!string_literals_.empty()) {
-        emit_blank();
-        emit(emit_dwarf_ ? ".section .rodata" : "section .rodata");
-        for (const auto& pair : string_literals_) {
-            std::string escaped = pair.second;
-            // Всегда экранируем реальные переносы строк в \n
-            size_t pos = 0;
-            while ((pos = escaped.find('\n', pos)) != std::string::npos) {
-                escaped.replace(pos, 1, "\\n");
-                pos += 2;
+// ---------------------------------------------------------------
+// gen_function_unit — сгенерировать одну функцию дочерним генератором
+//
+// Дочерний генератор получает те же настройки и собственные
+// StackFrame/RegisterAllocator, поэтому функции можно генерировать
+// из разных потоков одновременно.  x86 peephole работает здесь же,
+// над машинным IR одной функции.
+// ---------------------------------------------------------------
+X86Generator::FunctionAsm X86Generator::gen_function_unit(const IRFunction& func) const {
+    FunctionAsm unit;
+    if (func.blocks.empty()) return unit;   // extern function
+
+    X86Generator child;
+    child.program_functions_ = &defined_functions_;
+    child.emit_dwarf_ = emit_dwarf_;
+    child.source_filename_ = source_filename_;
+    child.regalloc_.set_strategy(regalloc_.strategy());
+    child.omit_frame_pointer_ = omit_frame_pointer_;
+    child.instrument_ = !profile_path_.empty() && defined_functions_.count("main");
+    child.profile_header_ = profile_function_header(func);
+
+    // Профиль ведётся по исходному порядку блоков; раскладка
+    // переставляет блоки вместе с их счётчиками
+    std::vector<std::uint64_t> counts;
+    if (profile_) counts = profile_->block_counts(func);
+    if (!counts.empty()) {
+        IRFunction laid_out = profile_layout(func, counts);
+        child.regalloc_.set_block_counts(counts);
+        child.gen_function(laid_out);
+    } else {
+        child.gen_function(func);
+    }
+    if (peephole_enabled_) {
+        unit.peephole.optimize(child.fn_);
+    }
+
+    unit.has_code = true;
+    unit.code = std::move(child.fn_);
+    unit.strings = std::move(child.string_literals_);
+    unit.floats = std::move(child.float_literals_);
+    unit.aux_labels = child.aux_label_counter_;
+    unit.externs = std::move(child.extern_symbols_);
+    unit.last_loc_line = child.last_emitted_line_;
+    unit.regalloc = std::move(child.regalloc_);
+    unit.frame = child.frame_stats_;
+    unit.counters = std::move(child.counters_);
+    return unit;
+}
+
+// ---------------------------------------------------------------
+// encode_unit / decode_unit — блок функции для кэша компиляции
+//
+// Номера литералов и .Laux-меток остаются локальными: merge_units
+// перенумерует их так же, как у только что сгенерированного блока.
+// От аллокатора и peephole сохраняется только статистика.
+// ---------------------------------------------------------------
+std::string X86Generator::encode_unit(const FunctionAsm& unit) {
+    utils::ByteWriter out;
+    mir::write_function(out, unit.code);
+    out.u64(unit.strings.size());
+    for (const auto& value : unit.strings) out.str(value);
+    out.u64(unit.floats.size());
+    for (std::uint64_t bits : unit.floats) out.u64(bits);
+    out.i64(unit.aux_labels);
+    out.u64(unit.externs.size());
+    for (const auto& name : unit.externs) out.str(name);
+    out.i64(unit.last_loc_line);
+    unit.regalloc.write_stats(out);
+    unit.peephole.write_stats(out);
+    unit.frame.write(out);
+    out.u64(unit.counters.size());
+    for (const auto& format : unit.counters) out.str(format);
+    return out.data();
+}
+
+bool X86Generator::decode_unit(const std::string& data, int line_delta, FunctionAsm& unit) {
+    utils::ByteReader in(data);
+    unit = FunctionAsm{};
+    if (!mir::read_function(in, unit.code)) return false;
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) unit.strings.push_back(in.str());
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) unit.floats.push_back(in.u64());
+    unit.aux_labels = static_cast<int>(in.i64());
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) unit.externs.insert(in.str());
+    unit.last_loc_line = static_cast<int>(in.i64());
+    if (!unit.regalloc.read_stats(in) || !unit.peephole.read_stats(in) || !unit.frame.read(in)) {
+        return false;
+    }
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) unit.counters.push_back(in.str());
+    if (!in.ok() || !in.at_end()) return false;
+
+    mir::shift_source_lines(unit.code, line_delta);
+    if (unit.last_loc_line != 0) unit.last_loc_line += line_delta;
+    unit.has_code = true;
+    return true;
+}
+
+// ---------------------------------------------------------------
+// merge_units — склеить функции в порядке program.functions
+//
+// Восстанавливает глобальное состояние так, как если бы функции
+// генерировались подряд одним генератором:
+//   - строковые литералы и float-константы нумеруются в порядке
+//     первого появления;
+//   - .Laux-метки и счётчики профиля получают сквозную нумерацию;
+//   - первая .loc функции выбрасывается, если совпадает с последней
+//     .loc предыдущей функции (как при подавлении дублей);
+//   - статистика LSRA и cur_func_name_ берутся от последней функции,
+//     счётчики загрузок/сохранений/инструкций и раскладки фреймов
+//     суммируются.
+// Машинный IR функций складывается в functions_ — его печатает
+// generate() или кодирует build_object().
+// ---------------------------------------------------------------
+void X86Generator::merge_units(std::vector<FunctionAsm>& units) {
+    int loads  = regalloc_.loads;
+    int stores = regalloc_.stores;
+    int total  = regalloc_.total_instructions;
+    const FunctionAsm* last = nullptr;
+
+    std::unordered_map<std::string, int> string_nums;
+    std::unordered_map<std::uint64_t, int> float_nums;
+
+    for (auto& unit : units) {
+        if (!unit.has_code) continue;
+
+        // Локальные номера литералов → глобальные
+        std::vector<int> str_numbers;
+        for (const auto& value : unit.strings) {
+            auto it = string_nums.find(value);
+            if (it == string_nums.end()) {
+                it = string_nums.emplace(value, static_cast<int>(string_literals_.size())).first;
+                string_literals_.push_back(value);
             }
-            emit(pair.first + ":");
-            if (emit_dwarf_) {
-                emit("    .asciz \"" + escaped + "\"");
-            } else {
-                emit("    db `" + escaped + "`, 0");
+            str_numbers.push_back(it->second);
+        }
+        std::vector<int> flt_numbers;
+        for (std::uint64_t bits : unit.floats) {
+            auto it = float_nums.find(bits);
+            if (it == float_nums.end()) {
+                it = float_nums.emplace(bits, static_cast<int>(float_literals_.size())).first;
+                float_literals_.push_back(bits);
             }
+            flt_numbers.push_back(it->second);
         }
+        auto renumber = [&](mir::Symbol& sym) {
+            switch (sym.kind) {
+                case mir::Symbol::Kind::String: sym.num = str_numbers[sym.num]; break;
+                case mir::Symbol::Kind::Float:  sym.num = flt_numbers[sym.num]; break;
+                case mir::Symbol::Kind::Aux:    sym.num += aux_label_counter_; break;
+                case mir::Symbol::Kind::Counter:
+                    sym.num += static_cast<int>(counters_.size());
+                    break;
+                default: break;
+            }
+        };
+
+        bool first_loc = true;
+        for (auto& block : unit.code.blocks) {
+            renumber(block.label);
+            for (size_t i = 0; i < block.code.size(); ++i) {
+                auto& instr = block.code[i];
+                if (instr.kind == mir::Instr::Kind::Loc && first_loc) {
+                    first_loc = false;
+                    if (instr.line == last_emitted_line_) {
+                        block.code.erase(block.code.begin() + static_cast<std::ptrdiff_t>(i--));
+                        total--;
+                    }
+                    continue;
+                }
+                renumber(instr.dst.sym);
+                renumber(instr.src.sym);
+            }
+        }
+        if (unit.last_loc_line != 0) {
+            last_emitted_line_ = unit.last_loc_line;
+        }
+
+        cur_func_name_ = unit.code.name;
+        functions_.push_back(std::move(unit.code));
+
+        aux_label_counter_ += unit.aux_labels;
+        counters_.insert(counters_.end(), unit.counters.begin(), unit.counters.end());
+        extern_symbols_.insert(unit.externs.begin(), unit.externs.end());
+        loads  += unit.regalloc.loads;
+        stores += unit.regalloc.stores;
+        total  += unit.regalloc.total_instructions;
+        peephole_.merge(unit.peephole);
+        frame_stats_.merge(unit.frame);
+        last = &unit;
     }
 
-    // DWARF: метка неисполняемого стека
-    if (emit_dwarf_) {
-        emit_blank();
-        emit(".section .note.GNU-stack,\"\",@progbits");
+    if (last) {
+        regalloc_ = last->regalloc;
     }
+    regalloc_.loads = loads;
+    regalloc_.stores = stores;
+    regalloc_.total_instructions = total;
+}
 
-    // ---- extern-объявления (вставляем в начало) ----
-    std::ostringstream result;
+// ---------------------------------------------------------------
+// build_object — объектный файл ELF64 (--emit obj)
+//
+// .text — закодированные функции (глобальные STT_FUNC); .rodata —
+// float-константы (выровнены по 8) и строковые литералы с нулём в
+// конце (локальные Lflt_N / Lstr_N); .data пуста; .bss — счётчики
+// профиля Lprof_N, если они есть.  Внешние функции
+// — неопределённые глобальные символы, на них ссылаются
+// R_X86_64_PLT32-релокации call.
+// ---------------------------------------------------------------
+bool X86Generator::build_object(elf::Object& obj) {
+    X86Encoder encoder;
+    for (const auto& fn : functions_) {
+        if (!encoder.add_function(fn)) {
+            errors_.push_back(encoder.error());
+            return false;
+        }
+    }
+    if (!encoder.finish()) {
+        errors_.push_back(encoder.error());
+        return false;
+    }
 
-    // Собираем extern для нерезолвленных символов
+    obj.source_name = source_filename_.empty() ? "input.src" : source_filename_;
+    obj.text = encoder.code();
+
+    auto add_symbol = [&](elf::Symbol sym) {
+        obj.symbols.push_back(std::move(sym));
+        return obj.symbols.size() - 1;
+    };
+
+    // .rodata: сначала 8-байтовые константы, затем строки
+    std::vector<std::size_t> float_syms, string_syms;
+    if (!float_literals_.empty()) obj.rodata_align = 8;
+    for (size_t i = 0; i < float_literals_.size(); ++i) {
+        float_syms.push_back(add_symbol({"Lflt_" + std::to_string(i), elf::Section::Rodata,
+                                         obj.rodata.size(), 8, false, false}));
+        for (int b = 0; b < 8; ++b) {
+            obj.rodata.push_back(static_cast<std::uint8_t>(float_literals_[i] >> (8 * b)));
+        }
+    }
+    for (size_t i = 0; i < string_literals_.size(); ++i) {
+        const std::string& value = string_literals_[i];
+        string_syms.push_back(add_symbol({"Lstr_" + std::to_string(i), elf::Section::Rodata,
+                                          obj.rodata.size(), value.size() + 1, false, false}));
+        obj.rodata.insert(obj.rodata.end(), value.begin(), value.end());
+        obj.rodata.push_back(0);
+    }
+
+    std::vector<std::size_t> counter_syms;
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        counter_syms.push_back(add_symbol({"Lprof_" + std::to_string(i), elf::Section::Bss,
+                                           obj.bss_size, 8, false, false}));
+        obj.bss_size += 8;
+    }
+
+    for (const auto& fn : encoder.functions()) {
+        add_symbol({fn.name, elf::Section::Text, fn.offset, fn.size, fn.name != kProfileDump, true});
+    }
+    std::unordered_map<std::string, std::size_t> externs;
     for (const auto& sym : extern_symbols_) {
         if (defined_functions_.find(sym) == defined_functions_.end()) {
-            result << (emit_dwarf_ ? ".extern " : "extern ") << sym << "\n";
+            externs[sym] = add_symbol({sym, elf::Section::Undef, 0, 0, true, false});
         }
     }
-    if (!extern_symbols_.empty()) {
-        result << "\n";
+
+    for (const auto& reloc : encoder.relocations()) {
+        elf::Relocation r;
+        r.offset = reloc.offset;
+        r.addend = reloc.addend;
+        r.type = reloc.type == X86Encoder::Relocation::Type::PLT32 ? elf::R_X86_64_PLT32
+                                                                   : elf::R_X86_64_PC32;
+        switch (reloc.sym.kind) {
+            case mir::Symbol::Kind::String: r.symbol = string_syms[reloc.sym.num]; break;
+            case mir::Symbol::Kind::Float:  r.symbol = float_syms[reloc.sym.num]; break;
+            case mir::Symbol::Kind::Counter: r.symbol = counter_syms[reloc.sym.num]; break;
+            default: {
+                auto it = externs.find(reloc.sym.name);
+                if (it == externs.end()) {
+                    it = externs.emplace(reloc.sym.name,
+                                         add_symbol({reloc.sym.name, elf::Section::Undef, 0, 0, true, false}))
+                             .first;
+                }
+                r.symbol = it->second;
+                break;
+            }
+        }
+        obj.text_relocations.push_back(r);
     }
+    return true;
+}
 
-    result << out_.str();
-    std::string final_asm = result.str();
+bool X86Generator::is_defined_function(const std::string& name) const {
+    const auto& defined = program_functions_ ? *program_functions_ : defined_functions_;
+    return defined.find(name) != defined.end();
+}
 
-    // x86 peephole optimization (post-pass)
-    if (peephole_enabled_) {
-        final_asm = peephole_.optimize(final_asm);
+// ---------------------------------------------------------------
+// profile_layout — порядок блоков по профилю (--profile-use)
+//
+// Вход остаётся первым.  Дальше цепочка идёт в самого частого ещё
+// не размещённого преемника (ему достаётся fall-through, и peephole
+// убирает jmp на него); когда таких нет — с самого частого из
+// оставшихся блоков.  Невыполнявшиеся блоки уходят в конец в
+// исходном порядке.  counts переставляется вместе с блоками.
+//
+// Генератор не полагается на порядок блоков: каждый блок кончается
+// явным RETURN, JUMP или JUMP_IF + JUMP.  Функция, где это не так,
+// остаётся как есть.
+// ---------------------------------------------------------------
+IRFunction X86Generator::profile_layout(const IRFunction& func, std::vector<std::uint64_t>& counts) {
+    const size_t n = func.blocks.size();
+    std::unordered_map<std::string, size_t> index;
+    std::vector<std::vector<size_t>> succs(n);
+    for (size_t b = 0; b < n; ++b) index.emplace(func.blocks[b].label, b);
+    for (size_t b = 0; b < n; ++b) {
+        const auto& instrs = func.blocks[b].instructions;
+        size_t ti = 0;
+        while (ti < instrs.size() && !is_terminator(instrs[ti].opcode)) ++ti;
+        if (ti == instrs.size()) return func;
+        const IROpcode op = instrs[ti].opcode;
+        if (op == IROpcode::JUMP_IF || op == IROpcode::JUMP_IF_NOT) {
+            if (ti + 1 == instrs.size() || instrs[ti + 1].opcode != IROpcode::JUMP) return func;
+        } else if (op != IROpcode::JUMP && op != IROpcode::RETURN) {
+            return func;
+        }
+        for (size_t i = ti; i < instrs.size(); ++i) {
+            if (instrs[i].opcode == IROpcode::RETURN) break;
+            auto it = index.find(instrs[i].dest.name());
+            if (it == index.end()) return func;
+            succs[b].push_back(it->second);
+        }
+    }
+
+    std::vector<size_t> order{0};
+    std::vector<char> placed(n, 0);
+    placed[0] = 1;
+    for (size_t cur = 0;;) {
+        size_t next = n;
+        for (size_t s : succs[cur]) {
+            if (!placed[s] && counts[s] > 0 && (next == n || counts[s] > counts[next])) next = s;
+        }
+        if (next == n) {
+            for (size_t b = 0; b < n; ++b) {
+                if (!placed[b] && counts[b] > 0 && (next == n || counts[b] > counts[next])) next = b;
+            }
+        }
+        if (next == n) break;
+        placed[next] = 1;
+        order.push_back(next);
+        cur = next;
+    }
+    for (size_t b = 0; b < n; ++b) {
+        if (!placed[b]) order.push_back(b);
     }
 
-    return final_asm;
+    IRFunction laid_out = func;
+    std::vector<std::uint64_t> laid_counts;
+    for (size_t i = 0; i < n; ++i) {
+        laid_out.blocks[i] = func.blocks[order[i]];
+        laid_counts.push_back(counts[order[i]]);
+    }
+    counts = std::move(laid_counts);
+    return laid_out;
 }
 
-std::string X86Generator::statistics() const {
-    std::string s = regalloc_.stats_report();
-    if (peephole_enabled_) {
-        s += peephole_.report();
+// ---------------------------------------------------------------
+// emit_counter — add qword [rel Lprof_N], 1
+//
+// Флаги между инструкциями IR не живут, так что счётчик можно
+// ставить и в начало блока, и перед вызовом.
+// ---------------------------------------------------------------
+void X86Generator::emit_counter(std::string format) {
+    if (counters_.empty()) format = profile_header_ + format;
+    mir::Symbol counter{mir::Symbol::Kind::Counter, {}, static_cast<int>(counters_.size())};
+    counters_.push_back(std::move(format));
+    emit(mir::Op::ADD, mir::mem_rel(counter, 64), mir::imm(1), "profile");
+}
+
+// ---------------------------------------------------------------
+// gen_profile_dump — функция записи профиля (не глобальная)
+//
+//   push rbp / mov rbp, rsp / push rbx / push rax / and rsp, -16
+//   rbx = fopen(path, "w"); при NULL — сразу выход
+//   fprintf(rbx, format_N, [Lprof_N]) для каждого счётчика
+//   fclose(rbx)
+//   rax и rbx восстанавливаются: результат main не меняется
+//
+// Вызывается из main, так что выравнивание rsp в точке вызова
+// неизвестно (листовой main без фрейма) — функция выравнивает сама.
+// ---------------------------------------------------------------
+void X86Generator::gen_profile_dump() {
+    using mir::Op;
+    using mir::Reg;
+    fn_ = mir::Function{};
+    fn_.name = kProfileDump;
+    fn_.blocks.push_back({{mir::Symbol::Kind::Global, kProfileDump, 0}, {}});
+    auto call = [&](const char* name) {
+        extern_symbols_.insert(name);
+        emit(Op::CALL, mir::label({mir::Symbol::Kind::Global, name, 0}));
+    };
+
+    emit(Op::PUSH, r64(Reg::RBP));
+    emit(Op::MOV, r64(Reg::RBP), r64(Reg::RSP));
+    emit(Op::PUSH, r64(Reg::RBX));
+    emit(Op::PUSH, r64(Reg::RAX), {}, "result of main");
+    emit(Op::AND, r64(Reg::RSP), mir::imm(-16));
+    emit(Op::LEA, r64(Reg::RDI), mir::mem_rel(intern_string(profile_path_)));
+    emit(Op::LEA, r64(Reg::RSI), mir::mem_rel(intern_string("w")));
+    call("fopen");
+    const mir::Symbol done = block_label("profile_done");
+    emit(Op::TEST, r64(Reg::RAX), r64(Reg::RAX));
+    emit(mir::make_cc(Op::JCC, mir::Cond::E, mir::label(done)));
+    emit(Op::MOV, r64(Reg::RBX), r64(Reg::RAX));
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        emit(Op::MOV, r64(Reg::RDI), r64(Reg::RBX));
+        emit(Op::LEA, r64(Reg::RSI), mir::mem_rel(intern_string(counters_[i])));
+        emit(Op::MOV, r64(Reg::RDX),
+             mir::mem_rel({mir::Symbol::Kind::Counter, {}, static_cast<int>(i)}, 64));
+        emit(Op::XOR, r32(Reg::RAX), r32(Reg::RAX));
+        call("fprintf");
     }
-    return s;
+    emit(Op::MOV, r64(Reg::RDI), r64(Reg::RBX));
+    call("fclose");
+    emit_label(done);
+    emit(Op::MOV, r64(Reg::RAX), mir::mem(Reg::RBP, -16, 64));
+    emit(Op::MOV, r64(Reg::RBX), mir::mem(Reg::RBP, -8, 64));
+    emit(Op::LEAVE);
+    emit(Op::RET);
+    functions_.push_back(std::move(fn_));
 }
 
 // ---------------------------------------------------------------
@@ -201,6 +772,10 @@ std::string X86Generator::statistics() const {
 //       ...инструкции...
 //   .L_then_0:
 //       ...
+//
+// С --omit-frame-pointer push rbp/mov rbp, rsp нет, а каждый блок
+// начинается с известной глубиной rsp (frame_depth_, у блоков без
+// фрейма — 0), от которой StackFrame считает адреса слотов.
 // ---------------------------------------------------------------
 void X86Generator::gen_function(const IRFunction& func) {
     if (func.blocks.empty()) return; // extern function
@@ -208,12 +783,14 @@ void X86Generator::gen_function(const IRFunction& func) {
     cur_func_name_ = func.name;
     pending_params_.clear();
 
-    // Построить стековый фрейм
-    frame_.build(func);
-
     // Запустить аллокацию регистров (LSRA или noop для StackOnly)
     regalloc_.allocate(func, frame_);
 
+    // Построить стековый фрейм: слоты — только значениям вне регистров
+    frame_.set_rsp_based(omit_frame_pointer_);
+    frame_.build(func, [this](SymbolId id) { return regalloc_.get_allocation(id).in_register; });
+    frame_stats_.merge(frame_.stats());
+
     // Установить смещение стека для сохраненных регистров
     int shift = static_cast<int>(regalloc_.used_callee_saved_64().size()) * 8;
     frame_.set_callee_saved_shift(shift);
@@ -221,19 +798,38 @@ void X86Generator::gen_function(const IRFunction& func) {
     // Построить карту PHI-разрешений
     build_phi_map(func);
 
-    // Метка функции
-    emit("; ---- function " + func.name + " ----");
-    emit(func.name + ":");
+    frame_alloc_ = 0;
+    frame_depth_ = 0;
+    wrap_framed_.clear();
+    wrap_frameless_.clear();
+    wrap_params_.clear();
+    if (omit_frame_pointer_) {
+        frame_alloc_ = frame_allocation(func);
+        frame_depth_ = shift + frame_alloc_;
+        plan_shrink_wrap(func);
+    }
+
+    // Метка функции (заголовок-комментарий печатает print_function)
+    fn_ = mir::Function{};
+    fn_.name = func.name;
+    fn_.blocks.push_back({{mir::Symbol::Kind::Global, func.name, 0}, {}});
+    regalloc_.total_instructions += 2;
 
     // Пролог
+    frameless_ = !wrap_framed_.empty();
     gen_prologue(func);
 
     // Генерация каждого базового блока
     for (size_t i = 0; i < func.blocks.size(); ++i) {
+        frameless_ = !wrap_framed_.empty() && (i == 0 || func.blocks[i].label == wrap_frameless_);
+        if (omit_frame_pointer_) frame_.set_rsp_depth(frameless_ ? 0 : frame_depth_);
         gen_block(func.blocks[i], func);
+        if (i == 0 && !wrap_framed_.empty()) emit_wrapped_setup(func.blocks[0].label);
     }
-
-    emit_blank();
+    frameless_ = false;
+    wrap_framed_.clear();
+    wrap_frameless_.clear();
+    wrap_params_.clear();
 
     // Очистка
     phi_moves_.clear();
@@ -242,21 +838,29 @@ void X86Generator::gen_function(const IRFunction& func) {
 // ---------------------------------------------------------------
 // gen_prologue — пролог функции + сохранение параметров
 //
-// Пример для add(int a, int b):
+// Пример для add(int a, float x):
 //   push rbp
 //   mov rbp, rsp
 //   sub rsp, 16          ; (2 params + N temps) aligned to 16
-//   mov dword [rbp-4], edi   ; сохранить param a
-//   mov dword [rbp-8], esi   ; сохранить param b
+//   mov qword [rbp-8], rdi    ; сохранить param a
+//   movsd qword [rbp-16], xmm0 ; сохранить param x
 // ---------------------------------------------------------------
-void X86Generator::gen_prologue(const IRFunction& /* func */) {
-    emit("    push rbp");
-    emit("    mov rbp, rsp");
+void X86Generator::gen_prologue(const IRFunction& func) {
+    using mir::Op;
+    using mir::Reg;
+    if (omit_frame_pointer_) {
+        // При shrink-wrap фрейм строит emit_wrapped_setup
+        if (wrap_framed_.empty()) emit_frame_setup();
+        gen_param_moves(func);
+        return;
+    }
+    emit(Op::PUSH, r64(Reg::RBP));
+    emit(Op::MOV, r64(Reg::RBP), r64(Reg::RSP));
 
     // Сохраняем callee-saved регистры, используемые LSRA
     const auto& callee_saved = regalloc_.used_callee_saved_64();
     for (const auto& reg : callee_saved) {
-        emit("    push " + reg + "    ; save callee-saved");
+        emit(Op::PUSH, gpr(reg), {}, "save callee-saved");
     }
 
     // Вычисляем полный размер фрейма:
@@ -273,30 +877,298 @@ void X86Generator::gen_prologue(const IRFunction& /* func */) {
     // После sub rsp, X: stack = 8 + push_bytes + X
     // Нужно: (8 + push_bytes + X) % 16 == 0
     // => X = align_to(frame_size, 16) с учётом push_bytes
-    if (total_frame > 0) {
-        int current_offset = 8 + push_bytes; // return addr + pushes
-        int needed = total_frame;
-        // Если (current_offset + needed) не кратно 16, добавляем 8
-        if ((current_offset + needed) % 16 != 0) {
-            needed += 8;
-        }
-        emit("    sub rsp, " + std::to_string(needed));
+    // Слотов может не быть вовсе (все значения в регистрах), но при
+    // нечётном числе push выравнивание всё равно нужно: sub rsp, 8
+    int current_offset = 8 + push_bytes; // return addr + pushes
+    int needed = total_frame;
+    // Если (current_offset + needed) не кратно 16, добавляем 8
+    if ((current_offset + needed) % 16 != 0) {
+        needed += 8;
     }
+    if (needed > 0) {
+        emit(Op::SUB, r64(Reg::RSP), mir::imm(needed));
+    }
+    gen_param_moves(func);
+}
+
+// ---------------------------------------------------------------
+// gen_param_moves — параметры из ABI-регистров и стека по местам
+// ---------------------------------------------------------------
+void X86Generator::gen_param_moves(const IRFunction& func) {
+    using mir::Op;
+    using mir::Reg;
 
     // Сохраняем параметры из ABI-регистров в стековые слоты.
-    // System V AMD64: первые 6 целочисленных → rdi, rsi, rdx, rcx, r8, r9
-    const auto& pnames = frame_.param_names();
-    for (int i = 0; i < static_cast<int>(pnames.size()) && i < x86abi::MAX_REG_ARGS; ++i) {
-        // Если параметр назначен в регистр LSRA, кладём туда напрямую
-        auto alloc = regalloc_.get_allocation(pnames[i]);
-        if (alloc.in_register) {
-            emit("    mov " + alloc.phys_reg_64 + ", " + x86abi::ARG_REGS_64[i]
-                 + "    ; param " + pnames[i] + " -> " + alloc.phys_reg_64);
-        } else {
-            emit("    mov " + frame_.slot_ref_64(pnames[i]) + ", " + x86abi::ARG_REGS_64[i]
-                 + "    ; param " + pnames[i]);
+    // System V AMD64: целочисленные → rdi, rsi, rdx, rcx, r8, r9,
+    // float → xmm0..xmm7, остальные — на стеке над адресом возврата.
+    const auto& pids = frame_.param_ids();
+    std::vector<bool> is_float;
+    for (const auto& param : func.params) {
+        is_float.push_back(ir_type_from_name(param.second) == IRType::Float);
+    }
+    const auto locs = x86abi::classify_args(is_float);
+    // Параметры, отложенные shrink-wrap, переносит emit_wrapped_setup
+    auto is_gpr = [&](size_t i) {
+        return locs[i].kind == x86abi::ArgLocation::Kind::Gpr && !(frameless_ && wrap_params_.count(pids[i]));
+    };
+    auto param_note = [&](size_t i) { return "param " + symbol_name(pids[i]); };
+
+    // Аллокатор (LSRA или графовый) может назначить параметр в ABI-регистр другого
+    // параметра — тогда сначала сохраняем параметры в слоты, а
+    // регистровые пересылаем параллельным копированием.
+    bool arg_reg_conflict = false;
+    for (size_t i = 0; i < pids.size(); ++i) {
+        if (!is_gpr(i)) continue;
+        auto alloc = allocation(pids[i]);
+        if (alloc.in_register && x86abi::is_arg_reg_64(alloc.phys_reg_64)) arg_reg_conflict = true;
+    }
+    if (arg_reg_conflict) {
+        std::vector<std::pair<Reg, Reg>> moves;
+        for (size_t i = 0; i < pids.size(); ++i) {
+            if (!is_gpr(i)) continue;
+            auto arg = gpr(x86abi::ARG_REGS_64[locs[i].index]);
+            auto alloc = allocation(pids[i]);
+            if (alloc.in_register) {
+                moves.push_back({mir::parse_reg(alloc.phys_reg_64), arg.reg});
+            } else {
+                emit(Op::MOV, frame_.slot(pids[i]), mir::reg(arg.reg, frame_.slot_bits(pids[i])), param_note(i));
+            }
+        }
+        emit_parallel_moves(std::move(moves));
+    } else {
+        for (size_t i = 0; i < pids.size(); ++i) {
+            if (!is_gpr(i)) continue;
+            auto arg = gpr(x86abi::ARG_REGS_64[locs[i].index]);
+            // Если параметр назначен в регистр аллокатором, кладём туда напрямую
+            auto alloc = allocation(pids[i]);
+            if (alloc.in_register) {
+                emit(Op::MOV, gpr(alloc.phys_reg_64), arg, param_note(i) + " -> " + alloc.phys_reg_64);
+            } else {
+                emit(Op::MOV, frame_.slot(pids[i]), mir::reg(arg.reg, frame_.slot_bits(pids[i])), param_note(i));
+            }
         }
     }
+
+    // xmm- и stack-параметры: ABI-регистры целых уже свободны, а
+    // приёмники параметров попарно различны
+    for (size_t i = 0; i < pids.size(); ++i) {
+        auto alloc = allocation(pids[i]);
+        if (locs[i].kind == x86abi::ArgLocation::Kind::Xmm) {
+            auto arg = gpr(x86abi::XMM_ARG_REGS[locs[i].index]);
+            if (alloc.in_register) {
+                emit(Op::MOVQ, gpr(alloc.phys_reg_64), arg, param_note(i) + " -> " + alloc.phys_reg_64);
+            } else {
+                emit(Op::MOVSD, frame_.slot(pids[i]), arg, param_note(i));
+            }
+        } else if (locs[i].kind == x86abi::ArgLocation::Kind::Stack) {
+            // [rbp+8] — адрес возврата, stack-аргументы начинаются с [rbp+16];
+            // без указателя фрейма адрес возврата лежит по [rsp+depth]
+            auto incoming = frame_.rsp_based()
+                                ? mir::mem(Reg::RSP, frame_.rsp_depth() + 8 + 8 * locs[i].index, 64)
+                                : mir::mem(Reg::RBP, 16 + 8 * locs[i].index, 64);
+            if (alloc.in_register) {
+                emit(Op::MOV, gpr(alloc.phys_reg_64), incoming, param_note(i) + " -> " + alloc.phys_reg_64);
+            } else {
+                emit(Op::MOV, r64(Reg::RAX), incoming);
+                emit(Op::MOV, frame_.slot(pids[i]), mir::reg(Reg::RAX, frame_.slot_bits(pids[i])), param_note(i));
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------
+// frame_allocation — sub rsp для фрейма без указателя фрейма
+//
+// Листовой функции (без call и malloc) с фреймом до 128 байт стек
+// не двигают вовсе: слоты лежат в красной зоне System V под rsp.
+// Иначе после адреса возврата и push callee-saved rsp выравнивается
+// по 16, как перед call.
+// ---------------------------------------------------------------
+int X86Generator::frame_allocation(const IRFunction& func) const {
+    bool leaf = true;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::CALL || instr.opcode == IROpcode::ALLOCA) leaf = false;
+        }
+    }
+    const int size = frame_.frame_size();
+    if (leaf && size <= x86abi::RED_ZONE_SIZE) return 0;
+
+    const int pushes = static_cast<int>(regalloc_.used_callee_saved_64().size());
+    int needed = size;
+    if ((x86abi::QWORD_SIZE * (1 + pushes) + needed) % x86abi::STACK_ALIGNMENT != 0) {
+        needed += x86abi::QWORD_SIZE;
+    }
+    return needed;
+}
+
+// ---------------------------------------------------------------
+// plan_shrink_wrap — вынести пролог с пути раннего выхода
+//
+// Типичная рекурсия (if (n < 2) return n; ...) тратит push/pop
+// callee-saved и sub rsp на ветку, которой они не нужны.  Если entry
+// заканчивается ветвлением, одна из целей которого — блок с одним
+// предшественником (entry), без PHI и с RETURN, а ни entry, ни этот
+// блок не вызывают функций и не трогают callee-saved регистры,
+// пролог ставится на второе ребро (emit_wrapped_setup).  Слоты на
+// пути без фрейма допустимы, только пока фрейм целиком в красной
+// зоне.  Заполняет wrap_framed_/wrap_frameless_.
+// ---------------------------------------------------------------
+bool X86Generator::plan_shrink_wrap(const IRFunction& func) {
+    const auto& callee_saved = regalloc_.used_callee_saved_64();
+    if (func.blocks.size() < 2 || (callee_saved.empty() && frame_alloc_ == 0)) return false;
+
+    const BasicBlock& entry = func.blocks[0];
+    std::unordered_map<std::string, int> pred_count;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::JUMP || instr.opcode == IROpcode::JUMP_IF ||
+                instr.opcode == IROpcode::JUMP_IF_NOT) {
+                pred_count[instr.dest.name()]++;
+            }
+        }
+    }
+    if (pred_count.count(entry.label)) return false;
+
+    size_t ti = 0;
+    while (ti < entry.instructions.size() && !is_terminator(entry.instructions[ti].opcode)) ++ti;
+    if (ti + 1 >= entry.instructions.size()) return false;
+    const auto& branch = entry.instructions[ti];
+    if ((branch.opcode != IROpcode::JUMP_IF && branch.opcode != IROpcode::JUMP_IF_NOT) ||
+        entry.instructions[ti + 1].opcode != IROpcode::JUMP) {
+        return false;
+    }
+    const std::string targets[2] = {branch.dest.name(), entry.instructions[ti + 1].dest.name()};
+    if (targets[0] == targets[1]) return false;
+
+    auto find_block = [&](const std::string& label) -> const BasicBlock* {
+        for (const auto& block : func.blocks) {
+            if (block.label == label) return &block;
+        }
+        return nullptr;
+    };
+    auto early_exit = [&](const BasicBlock* block) {
+        if (!block || pred_count[block->label] != 1) return false;
+        for (const auto& instr : block->instructions) {
+            if (instr.opcode == IROpcode::PHI) return false;
+            if (is_terminator(instr.opcode)) return instr.opcode == IROpcode::RETURN;
+        }
+        return false;
+    };
+    int exit = early_exit(find_block(targets[0])) ? 0 : early_exit(find_block(targets[1])) ? 1 : -1;
+    if (exit < 0) return false;
+    const BasicBlock* frameless = find_block(targets[exit]);
+    if (has_phi_moves(entry.label, targets[0]) || has_phi_moves(entry.label, targets[1])) return false;
+
+    // Параметр, который аллокатор держит в callee-saved регистре, на
+    // пути без фрейма читается прямо из ABI-регистра, а в свой регистр
+    // переносится уже в прологе.  Годятся только rdi, rsi и r9: rcx,
+    // rdx и r8 кодогенератор берёт под scratch.
+    auto is_callee_saved = [&](const std::string& reg) {
+        return std::find(callee_saved.begin(), callee_saved.end(), reg) != callee_saved.end();
+    };
+    const auto& pids = frame_.param_ids();
+    std::vector<bool> is_float;
+    for (const auto& param : func.params) {
+        is_float.push_back(ir_type_from_name(param.second) == IRType::Float);
+    }
+    const auto locs = x86abi::classify_args(is_float);
+    std::unordered_map<SymbolId, std::string> homes;
+    for (size_t i = 0; i < pids.size(); ++i) {
+        auto alloc = allocation(pids[i]);
+        if (!alloc.in_register || !is_callee_saved(alloc.phys_reg_64)) continue;
+        if (locs[i].kind != x86abi::ArgLocation::Kind::Gpr) return false;
+        std::string arg = x86abi::ARG_REGS_64[locs[i].index];
+        if (arg != "rdi" && arg != "rsi" && arg != "r9") return false;
+        homes[pids[i]] = arg;
+    }
+    // ABI-регистр не должен быть ничьим местом на пути без фрейма
+    auto taken = [&](SymbolId id, const std::string& reg) {
+        for (const auto& home : homes) {
+            if (home.first != id && home.second == reg) return true;
+        }
+        return false;
+    };
+    for (SymbolId id : pids) {
+        auto alloc = allocation(id);
+        if (!homes.count(id) && alloc.in_register && taken(id, alloc.phys_reg_64)) return false;
+    }
+
+    // Значение без фрейма: регистр не из callee-saved или слот в красной зоне
+    const bool red_zone = frame_.frame_size() + static_cast<int>(callee_saved.size()) * x86abi::QWORD_SIZE <=
+                          x86abi::RED_ZONE_SIZE;
+    auto frameless_ok = [&](const Operand& op) {
+        if (!op.is_temp() && op.kind != OperandKind::Variable) return true;
+        if (homes.count(op.id)) return true;
+        auto alloc = allocation(op.id);
+        if (alloc.in_register) return !is_callee_saved(alloc.phys_reg_64) && !taken(op.id, alloc.phys_reg_64);
+        return red_zone || !frame_.has_slot(op.id);
+    };
+    for (const BasicBlock* block : {&entry, frameless}) {
+        for (const auto& instr : block->instructions) {
+            if (instr.opcode == IROpcode::CALL || instr.opcode == IROpcode::ALLOCA ||
+                instr.opcode == IROpcode::PARAM) {
+                return false;
+            }
+            const bool value = instr.dest.is_temp() || instr.dest.kind == OperandKind::Variable;
+            if (value && homes.count(instr.dest.id)) return false;
+            if (!frameless_ok(instr.dest)) return false;
+            for (const auto& src : instr.srcs) {
+                if (!frameless_ok(src)) return false;
+            }
+        }
+    }
+    for (SymbolId id : pids) {
+        auto alloc = allocation(id);
+        if (!alloc.in_register && !red_zone) return false;
+    }
+
+    wrap_params_ = std::move(homes);
+    wrap_framed_ = targets[1 - exit];
+    wrap_frameless_ = targets[exit];
+    return true;
+}
+
+// ---------------------------------------------------------------
+// emit_frame_setup — пролог фрейма без указателя фрейма
+//
+//   push rbx             ; callee-saved, занятые аллокатором
+//   sub rsp, N           ; frame_alloc_ (0 — красная зона)
+// ---------------------------------------------------------------
+void X86Generator::emit_frame_setup() {
+    for (const auto& reg : regalloc_.used_callee_saved_64()) {
+        emit(mir::Op::PUSH, gpr(reg), {}, "save callee-saved");
+    }
+    if (frame_alloc_ > 0) {
+        emit(mir::Op::SUB, r64(mir::Reg::RSP), mir::imm(frame_alloc_));
+    }
+}
+
+// ---------------------------------------------------------------
+// emit_wrapped_setup — пролог на ребре entry → wrap_framed_
+//
+// Переходы entry на wrap_framed_ перенаправляются на новую метку,
+// за которой идут push callee-saved, sub rsp и jmp в сам блок
+// (peephole убирает jmp, если блок следующий).
+// ---------------------------------------------------------------
+void X86Generator::emit_wrapped_setup(const std::string& entry_label) {
+    const mir::Symbol target = block_label(wrap_framed_);
+    const mir::Symbol setup = new_aux_label("frame");
+    for (auto it = fn_.blocks.rbegin(); it != fn_.blocks.rend(); ++it) {
+        for (auto& in : it->code) {
+            if (in.dst.kind == mir::Operand::Kind::Label && in.dst.sym == target) in.dst.sym = setup;
+        }
+        if (it->label == block_label(entry_label)) break;
+    }
+    emit_label(setup);
+    frameless_ = false;
+    frame_.set_rsp_depth(0);
+    emit_frame_setup();
+    for (const auto& param : wrap_params_) {
+        auto home = allocation(param.first).phys_reg_64;
+        emit(mir::Op::MOV, gpr(home), gpr(param.second), "param " + symbol_name(param.first) + " -> " + home);
+    }
+    emit(mir::Op::JMP, mir::label(target));
 }
 
 // ---------------------------------------------------------------
@@ -304,7 +1176,8 @@ void X86Generator::gen_prologue(const IRFunction& /* func */) {
 // ---------------------------------------------------------------
 void X86Generator::gen_block(const BasicBlock& block, const IRFunction& /* func */) {
     // Метка блока (NASM local label)
-    emit("." + block.label + ":");
+    emit_label(block_label(block.label));
+    if (instrument_) emit_counter(profile_block_format(cur_func_name_, block.label));
 
     // Находим индекс первого терминатора
     size_t term_start = block.instructions.size();
@@ -324,18 +1197,26 @@ void X86Generator::gen_block(const BasicBlock& block, const IRFunction& /* func
         // DWARF: .loc директива для отладки
         if (instr.source_line > 0) {
             if (emit_dwarf_ && instr.source_line != last_emitted_line_) {
-                emit("    .loc 1 " + std::to_string(instr.source_line) + " 0");
+                emit(mir::make_loc(instr.source_line));
                 last_emitted_line_ = instr.source_line;
             }
-            std::string cmt_prefix = emit_dwarf_ ? "    # line " : "    ; line ";
-            std::string cmt = cmt_prefix + std::to_string(instr.source_line);
+            std::string cmt = "line " + std::to_string(instr.source_line);
             if (!instr.comment.empty()) cmt += ": " + instr.comment;
-            emit(cmt);
+            auto note = mir::make_comment(cmt);
+            note.line = instr.source_line;
+            emit(std::move(note));
         }
 
         gen_instruction(instr);
     }
 
+    // Верхние половины ymm грязные — без vzeroupper SSE-код дальше
+    // (и в вызываемых функциях) платит за смену состояния AVX
+    if (ymm_dirty_) {
+        emit(mir::Op::VZEROUPPER);
+        ymm_dirty_ = false;
+    }
+
     // Генерируем терминатор (JUMP / JUMP_IF / RETURN)
     if (term_start < block.instructions.size()) {
         // Сбрасываем pending_params перед терминатором
@@ -365,6 +1246,10 @@ void X86Generator::gen_instruction(const IRInstruction& instr) {
             gen_comparison(instr);
             break;
 
+        case IROpcode::INT_TO_FLOAT: case IROpcode::FLOAT_TO_INT:
+            gen_conversion(instr);
+            break;
+
         case IROpcode::MOVE:
             gen_move(instr);
             break;
@@ -392,38 +1277,129 @@ void X86Generator::gen_instruction(const IRInstruction& instr) {
 
         case IROpcode::LOAD:
         case IROpcode::STORE:
-            emit("    ; TODO: " + opcode_to_string(instr.opcode));
+            emit(mir::make_comment("TODO: " + opcode_to_string(instr.opcode)));
+            break;
+
+        case IROpcode::VEC_LOAD: case IROpcode::VEC_STORE: case IROpcode::VEC_SPLAT:
+        case IROpcode::VEC_ADD:  case IROpcode::VEC_SUB:   case IROpcode::VEC_MUL:
+            gen_vector(instr);
             break;
 
         case IROpcode::ALLOCA: {
+            using mir::Op;
             int size = instr.srcs[0].int_val;
             extern_symbols_.insert("malloc");
-            emit("    mov rdi, " + std::to_string(size));
-            emit("    call malloc");
-            store_to_dest(instr.dest, "eax");
+            // malloc портит caller-saved регистры аллокатора
+            const auto& saves = regalloc_.caller_saved_live_across(instr);
+            for (const auto& reg : saves) {
+                emit(Op::PUSH, gpr(reg), {}, "save caller-saved");
+            }
+            if (saves.size() % 2 != 0) emit(Op::SUB, r64(mir::Reg::RSP), mir::imm(8));
+            emit(Op::MOV, r64(mir::Reg::RDI), mir::imm(size));
+            emit(Op::CALL, mir::label({mir::Symbol::Kind::Global, "malloc", 0}));
+            if (saves.size() % 2 != 0) emit(Op::ADD, r64(mir::Reg::RSP), mir::imm(8));
+            for (auto it = saves.rbegin(); it != saves.rend(); ++it) {
+                emit(Op::POP, gpr(*it));
+            }
+            store_to_dest(instr.dest, mir::Reg::RAX);
             break;
         }
 
+        // float-элементы — 8 байт (битовый образ double целиком)
         case IROpcode::LOAD_ELEM: {
-            load_operand_64(instr.srcs[0], "r8");
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    movsxd rcx, ecx"); // Sign-extend index
-            emit("    mov eax, dword [r8 + rcx * 4]");
-            store_to_dest(instr.dest, "eax");
+            int size = element_size(instr);
+            mir::Operand addr = element_address(instr.srcs[0], instr.srcs[1], size);
+            addr.bits = static_cast<std::uint8_t>(size * 8);
+            emit(mir::Op::MOV, mir::reg(mir::Reg::RAX, size * 8), addr);
+            store_to_dest(instr.dest, mir::Reg::RAX);
             break;
         }
 
         case IROpcode::STORE_ELEM: {
-            load_operand_64(instr.dest, "r8");
-            load_operand(instr.srcs[0], "ecx", "rcx");
-            emit("    movsxd rcx, ecx"); // Sign-extend index
-            load_operand(instr.srcs[1], "eax", "rax");
-            emit("    mov dword [r8 + rcx * 4], eax");
+            int size = element_size(instr);
+            mir::Operand addr = element_address(instr.dest, instr.srcs[0], size);
+            addr.bits = static_cast<std::uint8_t>(size * 8);
+            load_operand(instr.srcs[1], mir::Reg::RAX);
+            emit(mir::Op::MOV, addr, mir::reg(mir::Reg::RAX, size * 8));
             break;
         }
     }
 }
 
+// ---------------------------------------------------------------
+// gen_vector — векторные инструкции (intx4 → SSE4.1, intx8 → AVX2)
+//
+// Векторные значения всегда живут в слотах кадра (lanes * 4 байт):
+// аллокаторы раздают только GPR, поэтому операнды читаются в
+// xmm0/xmm1 (ymm0/ymm1), а результат пишется обратно в слот.
+// Размножение скаляра: movd + punpckldq + punpcklqdq для SSE,
+// vmovd + vpbroadcastd для AVX2.
+// ---------------------------------------------------------------
+void X86Generator::gen_vector(const IRInstruction& instr) {
+    using mir::Op;
+    using mir::Reg;
+    // У VEC_STORE dest — база массива, тип вектора у сохраняемого значения
+    const IRType type = instr.opcode == IROpcode::VEC_STORE ? instr.srcs[1].type : instr.dest.type;
+    const bool avx = vector_lanes(type) == 8;
+    const int width = vector_lanes(type) * 32;
+    const auto vreg = [width](Reg r) { return mir::reg(r, width); };
+    const Op move = avx ? Op::VMOVDQU : Op::MOVDQU;
+
+    auto load_vector = [&](const Operand& op, Reg reg) {
+        emit(move, vreg(reg), frame_.slot(op.id, width));
+        regalloc_.loads++;
+    };
+    auto store_vector = [&](Reg reg) {
+        emit(move, frame_.slot(instr.dest.id, width), vreg(reg));
+        regalloc_.stores++;
+    };
+
+    switch (instr.opcode) {
+        case IROpcode::VEC_LOAD: {
+            mir::Operand addr = element_address(instr.srcs[0], instr.srcs[1], 4);
+            addr.bits = static_cast<std::uint16_t>(width);
+            emit(move, vreg(Reg::XMM0), addr);
+            store_vector(Reg::XMM0);
+            break;
+        }
+
+        case IROpcode::VEC_STORE: {
+            load_vector(instr.srcs[1], Reg::XMM0);
+            mir::Operand addr = element_address(instr.dest, instr.srcs[0], 4);
+            addr.bits = static_cast<std::uint16_t>(width);
+            emit(move, addr, vreg(Reg::XMM0));
+            break;
+        }
+
+        case IROpcode::VEC_SPLAT:
+            load_operand(instr.srcs[0], Reg::RAX);
+            if (avx) {
+                emit(Op::VMOVD, mir::reg(Reg::XMM0, 128), r32(Reg::RAX));
+                emit(Op::VPBROADCASTD, vreg(Reg::XMM0), mir::reg(Reg::XMM0, 128));
+            } else {
+                emit(Op::MOVD, vreg(Reg::XMM0), r32(Reg::RAX));
+                emit(Op::PUNPCKLDQ, vreg(Reg::XMM0), vreg(Reg::XMM0));
+                emit(Op::PUNPCKLQDQ, vreg(Reg::XMM0), vreg(Reg::XMM0));
+            }
+            store_vector(Reg::XMM0);
+            break;
+
+        default: {
+            load_vector(instr.srcs[0], Reg::XMM0);
+            load_vector(instr.srcs[1], Reg::XMM1);
+            Op op = instr.opcode == IROpcode::VEC_ADD ? Op::PADDD
+                  : instr.opcode == IROpcode::VEC_SUB ? Op::PSUBD : Op::PMULLD;
+            if (avx) {
+                op = op == Op::PADDD ? Op::VPADDD : op == Op::PSUBD ? Op::VPSUBD : Op::VPMULLD;
+            }
+            emit(op, vreg(Reg::XMM0), vreg(Reg::XMM1));
+            store_vector(Reg::XMM0);
+            break;
+        }
+    }
+    if (avx) ymm_dirty_ = true;
+}
+
 // ===============================================================
 //  Загрузка / сохранение операндов
 // ===============================================================
@@ -431,75 +1407,81 @@ void X86Generator::gen_instruction(const IRInstruction& instr) {
 // ---------------------------------------------------------------
 // load_operand — загрузить значение операнда в указанный регистр
 //
-// Temp / Variable → mov reg32, dword [rbp-N]
+// Temp / Variable → mov reg32, dword [rbp-N] (int, bool)
+//                   mov reg64, qword [rbp-N] (остальное)
 // IntLiteral      → mov reg32, imm
 // BoolLiteral     → mov reg32, 0/1
-// StringLiteral   → lea reg64, [rel .Lstr_N]
+// FloatLiteral    → mov reg64, <битовый образ double>
+// StringLiteral   → lea reg64, [rel Lstr_N]
 // ---------------------------------------------------------------
-void X86Generator::load_operand(const Operand& op,
-                                const char* reg32,
-                                const char* reg64) {
+void X86Generator::load_operand(const Operand& op, mir::Reg reg) {
+    using mir::Op;
     switch (op.kind) {
         case OperandKind::Temp: {
             // LSRA: проверяем, есть ли temp в регистре
-            auto alloc = regalloc_.get_allocation(op.name);
+            auto alloc = allocation(op.id);
             if (alloc.in_register) {
                 // Temp уже в физическом регистре (64-bit)
-                if (alloc.phys_reg_64 != std::string(reg64)) {
-                    emit("    mov " + std::string(reg64) + ", " + alloc.phys_reg_64);
+                auto phys = gpr(alloc.phys_reg_64);
+                if (phys.reg != reg) {
+                    emit(Op::MOV, r64(reg), phys);
                 }
                 // Если совпадают — mov не нужен
             } else {
-                // Загружаем 64-bit, чтобы не обрезать указатели
-                emit("    mov " + std::string(reg64) + ", " + frame_.slot_ref_64(op.name));
+                // Ширина — по слоту: int грузится в reg32 (с обнулением
+                // старшей половины), указатели — целиком
+                emit(Op::MOV, mir::reg(reg, frame_.slot_bits(op.id)), frame_.slot(op.id));
                 regalloc_.loads++;
             }
             break;
         }
 
         case OperandKind::Variable: {
-            auto alloc = regalloc_.get_allocation(op.name);
+            auto alloc = allocation(op.id);
             if (alloc.in_register) {
-                if (alloc.phys_reg_64 != std::string(reg64)) {
-                    emit("    mov " + std::string(reg64) + ", " + alloc.phys_reg_64);
+                auto phys = gpr(alloc.phys_reg_64);
+                if (phys.reg != reg) {
+                    emit(Op::MOV, r64(reg), phys);
                 }
-            } else if (frame_.has_slot(op.name)) {
-                // Загружаем 64-bit, чтобы не обрезать указатели
-                emit("    mov " + std::string(reg64) + ", " + frame_.slot_ref_64(op.name));
+            } else if (frame_.has_slot(op.id)) {
+                emit(Op::MOV, mir::reg(reg, frame_.slot_bits(op.id)), frame_.slot(op.id));
                 regalloc_.loads++;
             } else {
-                emit("    ; WARNING: unknown variable " + op.name);
-                emit("    xor " + std::string(reg64) + ", " + std::string(reg64));
+                emit(mir::make_comment("WARNING: unknown variable " + op.name()));
+                emit(Op::XOR, r64(reg), r64(reg));
             }
             break;
         }
 
         case OperandKind::IntLiteral:
             if (op.int_val == 0) {
-                emit("    xor " + std::string(reg32) + ", " + std::string(reg32));
+                emit(Op::XOR, r32(reg), r32(reg));
             } else {
-                emit("    mov " + std::string(reg32) + ", " + std::to_string(op.int_val));
+                emit(Op::MOV, r32(reg), mir::imm(op.int_val));
             }
             break;
 
         case OperandKind::BoolLiteral:
             if (op.int_val == 0) {
-                emit("    xor " + std::string(reg32) + ", " + std::string(reg32));
+                emit(Op::XOR, r32(reg), r32(reg));
             } else {
-                emit("    mov " + std::string(reg32) + ", 1");
+                emit(Op::MOV, r32(reg), mir::imm(1));
             }
             break;
 
-        case OperandKind::FloatLiteral:
-            emit("    ; TODO: float operand (SSE)");
-            emit("    xor " + std::string(reg32) + ", " + std::string(reg32));
+        case OperandKind::FloatLiteral: {
+            std::uint64_t bits = double_bits(op.float_val);
+            if (bits == 0) {
+                emit(Op::XOR, r32(reg), r32(reg));
+            } else {
+                emit(Op::MOV, r64(reg), mir::imm_hex(bits));
+            }
             break;
+        }
 
-        case OperandKind::StringLiteral: {
-            std::string label = intern_string(op.name);
-            emit("    lea " + std::string(reg64) + ", [rel " + label + "]");
+        case OperandKind::StringLiteral:
+            emit(Op::LEA, r64(reg), mir::mem_rel(intern_string(op.name())));
             break;
-        }
 
         case OperandKind::Label:
         case OperandKind::None:
@@ -507,47 +1489,141 @@ void X86Generator::load_operand(const Operand& op,
     }
 }
 
-void X86Generator::load_operand_64(const Operand& op, const char* reg64) {
+// ---------------------------------------------------------------
+// load_operand_wide — 64-битное значение операнда
+//
+// Long / Array (расширенные индуктивные переменные, указатели)
+// загружаются целиком; int знаково расширяется (movsxd); литерал
+// загружается как imm64, чтобы отрицательные шаги не обнулили
+// старшую половину.
+// ---------------------------------------------------------------
+void X86Generator::load_operand_wide(const Operand& op, mir::Reg reg) {
+    if (op.kind == OperandKind::IntLiteral || op.kind == OperandKind::BoolLiteral) {
+        if (op.int_val == 0) {
+            emit(mir::Op::XOR, r32(reg), r32(reg));
+        } else {
+            emit(mir::Op::MOV, r64(reg), mir::imm(op.int_val));
+        }
+    } else if (is_wide(op.type)) {
+        load_operand_64(op, reg);
+    } else {
+        load_operand(op, reg);
+        emit(mir::Op::MOVSXD, r64(reg), r32(reg));
+    }
+}
+
+// ---------------------------------------------------------------
+// element_address — адрес элемента массива для LOAD/STORE_ELEM
+//
+// scale — размер элемента (4 для int, 8 для float).
+// База в регистре используется напрямую, иначе грузится в r8.
+// Литеральный индекс становится смещением, 64-битный индекс (Long)
+// адресуется без movsxd; int-индекс расширяется в rcx.
+// ---------------------------------------------------------------
+mir::Operand X86Generator::element_address(const Operand& array, const Operand& index, int scale) {
+    mir::Reg base = value_register(array);
+    if (base == mir::Reg::NONE) {
+        base = mir::Reg::R8;
+        load_operand_64(array, base);
+    }
+
+    if (index.kind == OperandKind::IntLiteral) {
+        return mir::mem(base, static_cast<std::int64_t>(index.int_val) * scale);
+    }
+
+    mir::Reg reg = value_register(index);
+    if (!is_wide(index.type) || reg == mir::Reg::NONE) {
+        reg = mir::Reg::RCX;
+        load_operand_wide(index, reg);
+    }
+    return mir::mem(base, reg, scale, 0);
+}
+
+void X86Generator::load_operand_64(const Operand& op, mir::Reg reg) {
     if (op.is_temp() || op.kind == OperandKind::Variable) {
-        auto alloc = regalloc_.get_allocation(op.name);
+        auto alloc = allocation(op.id);
         if (alloc.in_register) {
-            if (alloc.phys_reg_64 != std::string(reg64)) {
-                emit("    mov " + std::string(reg64) + ", " + alloc.phys_reg_64);
+            auto phys = gpr(alloc.phys_reg_64);
+            if (phys.reg != reg) {
+                emit(mir::Op::MOV, r64(reg), phys);
             }
         } else {
-            emit("    mov " + std::string(reg64) + ", " + frame_.slot_ref_64(op.name));
+            emit(mir::Op::MOV, mir::reg(reg, frame_.slot_bits(op.id)), frame_.slot(op.id));
             regalloc_.loads++;
         }
+    } else if (op.kind == OperandKind::FloatLiteral) {
+        emit(mir::Op::MOV, r64(reg), mir::imm_hex(double_bits(op.float_val)));
     } else {
-        load_operand(op, "eax", "rax");
-        emit("    movsxd " + std::string(reg64) + ", eax");
+        load_operand(op, mir::Reg::RAX);
+        emit(mir::Op::MOVSXD, r64(reg), r32(mir::Reg::RAX));
     }
 }
 
 // ---------------------------------------------------------------
 // store_to_dest — сохранить значение из регистра в слот dest
 // ---------------------------------------------------------------
-void X86Generator::store_to_dest(const Operand& dest, const char* reg32) {
-    std::string reg64 = "rax";
-    if (std::string(reg32) == "ecx") reg64 = "rcx";
-    if (std::string(reg32) == "edx") reg64 = "rdx";
-
+void X86Generator::store_to_dest(const Operand& dest, mir::Reg reg) {
     if (dest.is_temp() || dest.kind == OperandKind::Variable) {
-        auto alloc = regalloc_.get_allocation(dest.name);
+        auto alloc = allocation(dest.id);
         if (alloc.in_register) {
             // Записываем в физический регистр (64-bit)
-            if (alloc.phys_reg_64 != reg64) {
-                emit("    mov " + alloc.phys_reg_64 + ", " + reg64);
+            auto phys = gpr(alloc.phys_reg_64);
+            if (phys.reg != reg) {
+                emit(mir::Op::MOV, phys, r64(reg));
             }
             // Если совпадают — mov не нужен
-        } else if (frame_.has_slot(dest.name)) {
-            // Записываем 64-bit, чтобы не обрезать указатели
-            emit("    mov " + frame_.slot_ref_64(dest.name) + ", " + reg64);
+        } else if (frame_.has_slot(dest.id)) {
+            // int — DWORD-слот, указатели и long — QWORD
+            emit(mir::Op::MOV, frame_.slot(dest.id), mir::reg(reg, frame_.slot_bits(dest.id)));
             regalloc_.stores++;
         }
     }
 }
 
+// ---------------------------------------------------------------
+// load_float — загрузить double в xmm-регистр
+//
+// 0.0            → xorpd xmm, xmm
+// FloatLiteral   → movsd xmm, qword [rel Lflt_N]   (пул констант)
+// значение в GPR → movq xmm, reg64
+// значение в слоте → movsd xmm, qword [rbp-N]
+// ---------------------------------------------------------------
+void X86Generator::load_float(const Operand& op, mir::Reg reg) {
+    using mir::Op;
+    if (op.kind == OperandKind::FloatLiteral || op.kind == OperandKind::IntLiteral) {
+        double value = op.kind == OperandKind::FloatLiteral ? op.float_val : op.int_val;
+        if (double_bits(value) == 0) {
+            emit(Op::XORPD, xmm(reg), xmm(reg));
+        } else {
+            emit(Op::MOVSD, xmm(reg), mir::mem_rel(intern_float(value), 64));
+        }
+        return;
+    }
+    mir::Reg phys = value_register(op);
+    if (phys != mir::Reg::NONE) {
+        emit(Op::MOVQ, xmm(reg), r64(phys));
+    } else if (frame_.has_slot(op.id)) {
+        emit(Op::MOVSD, xmm(reg), frame_.slot(op.id));
+        regalloc_.loads++;
+    } else {
+        emit(Op::XORPD, xmm(reg), xmm(reg));
+    }
+}
+
+// ---------------------------------------------------------------
+// store_float — сохранить double из xmm-регистра в dest
+// ---------------------------------------------------------------
+void X86Generator::store_float(const Operand& dest, mir::Reg reg) {
+    if (!dest.is_temp() && dest.kind != OperandKind::Variable) return;
+    auto alloc = allocation(dest.id);
+    if (alloc.in_register) {
+        emit(mir::Op::MOVQ, gpr(alloc.phys_reg_64), xmm(reg));
+    } else if (frame_.has_slot(dest.id)) {
+        emit(mir::Op::MOVSD, frame_.slot(dest.id), xmm(reg));
+        regalloc_.stores++;
+    }
+}
+
 // ===============================================================
 //  Генерация инструкций
 // ===============================================================
@@ -567,89 +1643,128 @@ void X86Generator::store_to_dest(const Operand& dest, const char* reg32) {
 //   idiv ecx             ; eax = частное, edx = остаток
 // ---------------------------------------------------------------
 void X86Generator::gen_binary(const IRInstruction& instr) {
-    load_operand(instr.srcs[0], "eax", "rax");
+    using mir::Op;
+    using mir::Reg;
+
+    // Арифметика double: xmm0 = xmm0 OP xmm1
+    if (instr.dest.type == IRType::Float) {
+        load_float(instr.srcs[0], Reg::XMM0);
+        load_float(instr.srcs[1], Reg::XMM1);
+        Op op = Op::ADDSD;
+        switch (instr.opcode) {
+            case IROpcode::SUB: op = Op::SUBSD; break;
+            case IROpcode::MUL: op = Op::MULSD; break;
+            case IROpcode::DIV: op = Op::DIVSD; break;
+            default: break;
+        }
+        emit(op, xmm(Reg::XMM0), xmm(Reg::XMM1));
+        store_float(instr.dest, Reg::XMM0);
+        return;
+    }
+
+    // 64-битная арифметика: индуктивные переменные и указатели
+    if (is_wide(instr.dest.type) &&
+        (instr.opcode == IROpcode::ADD || instr.opcode == IROpcode::SUB ||
+         instr.opcode == IROpcode::MUL)) {
+        load_operand_wide(instr.srcs[0], Reg::RAX);
+        load_operand_wide(instr.srcs[1], Reg::RCX);
+        Op op = instr.opcode == IROpcode::ADD ? Op::ADD
+              : instr.opcode == IROpcode::SUB ? Op::SUB : Op::IMUL;
+        emit(op, r64(Reg::RAX), r64(Reg::RCX));
+        store_to_dest(instr.dest, Reg::RAX);
+        return;
+    }
+
+    load_operand(instr.srcs[0], Reg::RAX);
 
     switch (instr.opcode) {
         case IROpcode::ADD:
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    add eax, ecx");
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::ADD, r32(Reg::RAX), r32(Reg::RCX));
             break;
 
         case IROpcode::SUB:
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    sub eax, ecx");
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::SUB, r32(Reg::RAX), r32(Reg::RCX));
             break;
 
         case IROpcode::MUL:
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    imul eax, ecx");
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::IMUL, r32(Reg::RAX), r32(Reg::RCX));
             break;
 
         case IROpcode::DIV:
             // cdq ПЕРЕД загрузкой src2 в ecx — не затирает eax/edx
-            emit("    cdq");
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    idiv ecx");
+            emit(Op::CDQ);
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::IDIV, r32(Reg::RCX));
             // Результат (частное) уже в eax
             break;
 
         case IROpcode::MOD:
-            emit("    cdq");
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    idiv ecx");
+            emit(Op::CDQ);
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::IDIV, r32(Reg::RCX));
             // Остаток в edx → переносим в eax
-            emit("    mov eax, edx");
+            emit(Op::MOV, r32(Reg::RAX), r32(Reg::RDX));
             break;
 
         case IROpcode::AND:
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    and eax, ecx");
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::AND, r32(Reg::RAX), r32(Reg::RCX));
             break;
 
         case IROpcode::OR:
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    or eax, ecx");
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::OR, r32(Reg::RAX), r32(Reg::RCX));
             break;
 
         case IROpcode::XOR:
-            load_operand(instr.srcs[1], "ecx", "rcx");
-            emit("    xor eax, ecx");
+            load_operand(instr.srcs[1], Reg::RCX);
+            emit(Op::XOR, r32(Reg::RAX), r32(Reg::RCX));
             break;
 
         default:
             break;
     }
 
-    store_to_dest(instr.dest, "eax");
+    store_to_dest(instr.dest, Reg::RAX);
 }
 
 // ---------------------------------------------------------------
 // gen_unary — NEG / NOT
 //
-// NEG: арифметическое отрицание (neg eax)
+// NEG: арифметическое отрицание (neg eax); для float — инверсия
+//      знакового бита битового образа (btc rax, 63)
 // NOT: логическое отрицание  (test + sete + movzx)
 //      0 → 1, nonzero → 0
 // ---------------------------------------------------------------
 void X86Generator::gen_unary(const IRInstruction& instr) {
-    load_operand(instr.srcs[0], "eax", "rax");
+    using mir::Op;
+    using mir::Reg;
+    load_operand(instr.srcs[0], Reg::RAX);
 
     switch (instr.opcode) {
         case IROpcode::NEG:
-            emit("    neg eax");
+            if (instr.dest.type == IRType::Float) {
+                emit(Op::BTC, r64(Reg::RAX), mir::imm(63));
+            } else {
+                emit(Op::NEG, r32(Reg::RAX));
+            }
             break;
 
         case IROpcode::NOT:
             // Логическое NOT: результат 0 или 1
-            emit("    test eax, eax");
-            emit("    sete al");
-            emit("    movzx eax, al");
+            emit(Op::TEST, r32(Reg::RAX), r32(Reg::RAX));
+            emit(mir::make_cc(Op::SETCC, mir::Cond::E, r8(Reg::RAX)));
+            emit(Op::MOVZX, r32(Reg::RAX), r8(Reg::RAX));
             break;
 
         default:
             break;
     }
 
-    store_to_dest(instr.dest, "eax");
+    store_to_dest(instr.dest, Reg::RAX);
 }
 
 // ---------------------------------------------------------------
@@ -662,50 +1777,243 @@ void X86Generator::gen_unary(const IRInstruction& instr) {
 //   mov <dest>, eax
 // ---------------------------------------------------------------
 void X86Generator::gen_comparison(const IRInstruction& instr) {
-    load_operand(instr.srcs[0], "eax", "rax");
-    load_operand(instr.srcs[1], "ecx", "rcx");
-    emit("    cmp eax, ecx");
+    using mir::Cond;
+    using mir::Op;
+    using mir::Reg;
+    if (instr.srcs[0].type == IRType::Float || instr.srcs[1].type == IRType::Float) {
+        gen_float_comparison(instr);
+        return;
+    }
+    if (is_wide(instr.srcs[0].type) || is_wide(instr.srcs[1].type)) {
+        load_operand_wide(instr.srcs[0], Reg::RAX);
+        load_operand_wide(instr.srcs[1], Reg::RCX);
+        emit(Op::CMP, r64(Reg::RAX), r64(Reg::RCX));
+    } else {
+        load_operand(instr.srcs[0], Reg::RAX);
+        load_operand(instr.srcs[1], Reg::RCX);
+        emit(Op::CMP, r32(Reg::RAX), r32(Reg::RCX));
+    }
 
-    const char* setcc = "sete";
+    Cond cc = Cond::E;
     switch (instr.opcode) {
-        case IROpcode::CMP_EQ: setcc = "sete";  break;
-        case IROpcode::CMP_NE: setcc = "setne"; break;
-        case IROpcode::CMP_LT: setcc = "setl";  break;
-        case IROpcode::CMP_LE: setcc = "setle"; break;
-        case IROpcode::CMP_GT: setcc = "setg";  break;
-        case IROpcode::CMP_GE: setcc = "setge"; break;
+        case IROpcode::CMP_EQ: cc = Cond::E;  break;
+        case IROpcode::CMP_NE: cc = Cond::NE; break;
+        case IROpcode::CMP_LT: cc = Cond::L;  break;
+        case IROpcode::CMP_LE: cc = Cond::LE; break;
+        case IROpcode::CMP_GT: cc = Cond::G;  break;
+        case IROpcode::CMP_GE: cc = Cond::GE; break;
         default: break;
     }
 
-    emit(std::string("    ") + setcc + " al");
-    emit("    movzx eax, al");
-    store_to_dest(instr.dest, "eax");
+    emit(mir::make_cc(Op::SETCC, cc, r8(Reg::RAX)));
+    emit(Op::MOVZX, r32(Reg::RAX), r8(Reg::RAX));
+    store_to_dest(instr.dest, Reg::RAX);
+}
+
+// ---------------------------------------------------------------
+// gen_float_comparison — сравнение double через ucomisd
+//
+// ucomisd выставляет флаги как беззнаковое сравнение, а для NaN
+// (unordered) — ZF = PF = CF = 1.  Поэтому < и <= записываются как
+// > и >= с переставленными операндами (seta/setae ложны для NaN),
+// == проверяет ещё и PF = 0, а != истинно и для NaN:
+//   a < b   →  ucomisd b, a;  seta
+//   a == b  →  ucomisd a, b;  sete + setnp
+//   a != b  →  ucomisd a, b;  setne | setp
+// ---------------------------------------------------------------
+void X86Generator::gen_float_comparison(const IRInstruction& instr) {
+    using mir::Cond;
+    using mir::Op;
+    using mir::Reg;
+    load_float(instr.srcs[0], Reg::XMM0);
+    load_float(instr.srcs[1], Reg::XMM1);
+
+    const bool strict = instr.opcode == IROpcode::CMP_LT || instr.opcode == IROpcode::CMP_GT;
+    switch (instr.opcode) {
+        case IROpcode::CMP_LT:
+        case IROpcode::CMP_LE:
+            emit(Op::UCOMISD, xmm(Reg::XMM1), xmm(Reg::XMM0));
+            emit(mir::make_cc(Op::SETCC, strict ? Cond::A : Cond::AE, r8(Reg::RAX)));
+            break;
+        case IROpcode::CMP_GT:
+        case IROpcode::CMP_GE:
+            emit(Op::UCOMISD, xmm(Reg::XMM0), xmm(Reg::XMM1));
+            emit(mir::make_cc(Op::SETCC, strict ? Cond::A : Cond::AE, r8(Reg::RAX)));
+            break;
+        case IROpcode::CMP_EQ:
+            emit(Op::UCOMISD, xmm(Reg::XMM0), xmm(Reg::XMM1));
+            emit(mir::make_cc(Op::SETCC, Cond::E, r8(Reg::RAX)));
+            emit(mir::make_cc(Op::SETCC, Cond::NP, r8(Reg::RCX)));
+            emit(Op::AND, r8(Reg::RAX), r8(Reg::RCX));
+            break;
+        case IROpcode::CMP_NE:
+            emit(Op::UCOMISD, xmm(Reg::XMM0), xmm(Reg::XMM1));
+            emit(mir::make_cc(Op::SETCC, Cond::NE, r8(Reg::RAX)));
+            emit(mir::make_cc(Op::SETCC, Cond::P, r8(Reg::RCX)));
+            emit(Op::OR, r8(Reg::RAX), r8(Reg::RCX));
+            break;
+        default:
+            break;
+    }
+
+    emit(Op::MOVZX, r32(Reg::RAX), r8(Reg::RAX));
+    store_to_dest(instr.dest, Reg::RAX);
+}
+
+// ---------------------------------------------------------------
+// gen_conversion — INT_TO_FLOAT / FLOAT_TO_INT
+//
+//   INT_TO_FLOAT:  cvtsi2sd xmm0, eax (rax для Long)
+//   FLOAT_TO_INT:  cvttsd2si eax, xmm0 (усечение к нулю)
+// ---------------------------------------------------------------
+void X86Generator::gen_conversion(const IRInstruction& instr) {
+    using mir::Reg;
+    if (instr.opcode == IROpcode::INT_TO_FLOAT) {
+        load_operand(instr.srcs[0], Reg::RAX);
+        emit(mir::Op::CVTSI2SD, xmm(Reg::XMM0),
+             mir::reg(Reg::RAX, is_wide(instr.srcs[0].type) ? 64 : 32));
+        store_float(instr.dest, Reg::XMM0);
+    } else {
+        load_float(instr.srcs[0], Reg::XMM0);
+        emit(mir::Op::CVTTSD2SI, r32(Reg::RAX), xmm(Reg::XMM0));
+        store_to_dest(instr.dest, Reg::RAX);
+    }
 }
 
 // ---------------------------------------------------------------
 // gen_move — MOVE dest, src
 // ---------------------------------------------------------------
 void X86Generator::gen_move(const IRInstruction& instr) {
-    load_operand(instr.srcs[0], "eax", "rax");
-    store_to_dest(instr.dest, "eax");
+    // int → Long: знаковое расширение, а не копия регистра
+    if (is_wide(instr.dest.type) && !is_wide(instr.srcs[0].type)) {
+        load_operand_wide(instr.srcs[0], mir::Reg::RAX);
+        store_to_dest(instr.dest, mir::Reg::RAX);
+        return;
+    }
+    emit_value_move(instr.dest, instr.srcs[0]);
+}
+
+// ---------------------------------------------------------------
+// emit_value_move — dest = src
+//
+// Если оба значения в регистрах, пересылаем напрямую (без eax);
+// после слияния регистров аллокатором пересылка исчезает совсем.
+// ---------------------------------------------------------------
+void X86Generator::emit_value_move(const Operand& dest, const Operand& src) {
+    mir::Reg dst_reg = value_register(dest);
+    mir::Reg src_reg = value_register(src);
+    if (dst_reg != mir::Reg::NONE && src_reg != mir::Reg::NONE) {
+        if (dst_reg != src_reg) {
+            emit(mir::Op::MOV, r64(dst_reg), r64(src_reg));
+        }
+        return;
+    }
+    load_operand(src, mir::Reg::RAX);
+    store_to_dest(dest, mir::Reg::RAX);
+}
+
+Allocation X86Generator::value_allocation(const Operand& op) const {
+    if (op.is_temp() || op.kind == OperandKind::Variable) {
+        return allocation(op.id);
+    }
+    return Allocation{};
+}
+
+// Место значения; на пути без фрейма (shrink-wrap) параметры из
+// callee-saved регистров ещё лежат в ABI-регистрах
+Allocation X86Generator::allocation(SymbolId id) const {
+    if (frameless_) {
+        auto it = wrap_params_.find(id);
+        if (it != wrap_params_.end()) {
+            Allocation alloc;
+            alloc.in_register = true;
+            alloc.phys_reg = mir::reg_name(mir::parse_reg(it->second), 32);
+            alloc.phys_reg_64 = it->second;
+            return alloc;
+        }
+    }
+    return regalloc_.get_allocation(id);
+}
+
+mir::Reg X86Generator::value_register(const Operand& op) const {
+    auto alloc = value_allocation(op);
+    return alloc.in_register ? mir::parse_reg(alloc.phys_reg_64) : mir::Reg::NONE;
+}
+
+// ---------------------------------------------------------------
+// emit_parallel_moves — последовательная запись параллельной пересылки
+//
+// Пересылка выполняется, когда её приёмник больше никем не читается.
+// Если таких нет — остались только циклы: приёмник первой пересылки
+// копируется в rax, и его читатели переключаются на rax.
+// ---------------------------------------------------------------
+void X86Generator::emit_parallel_moves(std::vector<std::pair<mir::Reg, mir::Reg>> moves) {
+    moves.erase(std::remove_if(moves.begin(), moves.end(),
+                               [](const auto& m) { return m.first == m.second; }),
+                moves.end());
+    while (!moves.empty()) {
+        bool progress = false;
+        for (size_t i = 0; i < moves.size(); ++i) {
+            const mir::Reg dst = moves[i].first;
+            bool blocked = std::any_of(moves.begin(), moves.end(),
+                                       [&](const auto& m) { return m.second == dst; });
+            if (blocked) continue;
+            emit(mir::Op::MOV, r64(dst), r64(moves[i].second));
+            moves.erase(moves.begin() + static_cast<std::ptrdiff_t>(i));
+            progress = true;
+            break;
+        }
+        if (progress) continue;
+
+        const mir::Reg dst = moves.front().first;
+        emit(mir::Op::MOV, r64(mir::Reg::RAX), r64(dst));
+        for (auto& m : moves) {
+            if (m.second == dst) m.second = mir::Reg::RAX;
+        }
+    }
 }
 
 // ---------------------------------------------------------------
 // gen_return — RETURN [value]
 //
-//   mov eax, <value>     ; (только если есть значение)
+//   mov eax, <value>     ; (только если есть значение; float — в xmm0)
 //   leave                ; mov rsp, rbp; pop rbp
 //   ret
+//
+// В инструментированном main перед выходом вызывается
+// __mc_profile_dump (он сохраняет rax).
+//
+// Без указателя фрейма: add rsp, N; pop callee-saved; ret.
 // ---------------------------------------------------------------
 void X86Generator::gen_return(const IRInstruction& instr) {
+    using mir::Op;
     if (!instr.srcs.empty()) {
-        load_operand(instr.srcs[0], "eax", "rax");
+        if (instr.srcs[0].type == IRType::Float) {
+            load_float(instr.srcs[0], mir::parse_reg(x86abi::RET_REG_XMM));
+        } else {
+            load_operand(instr.srcs[0], mir::parse_reg(x86abi::RET_REG_64));
+        }
+    }
+    if (instrument_ && cur_func_name_ == "main") {
+        emit(Op::CALL, mir::label({mir::Symbol::Kind::Global, kProfileDump, 0}), {}, "write profile");
     }
     // Восстанавливаем callee-saved регистры перед выходом
     const auto& callee_saved = regalloc_.used_callee_saved_64();
+    if (omit_frame_pointer_) {
+        // Блок без фрейма (shrink-wrap) выходит сразу
+        bool frameless = frame_.rsp_depth() == 0;
+        if (!frameless) {
+            if (frame_alloc_ > 0) emit(Op::ADD, r64(mir::Reg::RSP), mir::imm(frame_alloc_));
+            for (auto it = callee_saved.rbegin(); it != callee_saved.rend(); ++it) {
+                emit(Op::POP, gpr(*it));
+            }
+        }
+        emit(Op::RET);
+        return;
+    }
     if (!callee_saved.empty()) {
         // Восстанавливаем rsp до позиции callee-saved pushes
-        emit("    mov rsp, rbp");
+        emit(Op::MOV, r64(mir::Reg::RSP), r64(mir::Reg::RBP));
         // pop callee-saved в обратном порядке
         // Но callee-saved были push сразу после push rbp,
         // поэтому они находятся по [rbp-8], [rbp-16], ...
@@ -717,13 +2025,13 @@ void X86Generator::gen_return(const IRInstruction& instr) {
         //   pop r15; pop r14; ...; pop rbx
         //   leave; ret
         int n = static_cast<int>(callee_saved.size());
-        emit("    lea rsp, [rbp-" + std::to_string(n * 8) + "]");
+        emit(Op::LEA, r64(mir::Reg::RSP), mir::mem(mir::Reg::RBP, -n * 8));
         for (int i = n - 1; i >= 0; --i) {
-            emit("    pop " + callee_saved[i]);
+            emit(Op::POP, gpr(callee_saved[i]));
         }
     }
-    emit("    leave");
-    emit("    ret");
+    emit(Op::LEAVE);
+    emit(Op::RET);
 }
 
 // ---------------------------------------------------------------
@@ -744,64 +2052,125 @@ void X86Generator::gen_param(const IRInstruction& instr) {
 // gen_call — dest = CALL func, arg_count
 //
 // Последовательность:
-//   1) Загрузить аргументы в ABI-регистры (edi, esi, edx, ecx, r8d, r9d)
-//   2) call func
-//   3) Сохранить eax в слот dest (если dest не None)
+//   1) Аргументы, не попавшие в регистры, — push на стек
+//   2) float-аргументы — в xmm0..xmm7, целые — в rdi, rsi, rdx,
+//      rcx, r8, r9 (классы нумеруются независимо, x86abi::classify_args)
+//   3) eax = число xmm-аргументов (нужно variadic-функциям вроде printf)
+//   4) call func
+//   5) Сохранить eax (float — xmm0) в dest (если dest не None)
 //
 // Примечание: аргументы загружаются из стековых слотов, поэтому
 // порядок загрузки в регистры не вызывает конфликтов (mov edi, [rbp-N]
-// не затирает esi, и наоборот).
+// не затирает esi, и наоборот).  Графовый аллокатор может держать
+// аргумент в ABI-регистре — тогда регистровые аргументы пересылаются
+// параллельным копированием, а caller-saved регистры значений, живых
+// через вызов, сохраняются push/pop вокруг него.  xmm-аргументы
+// загружаются до пересылок, пока исходные регистры не затёрты.
 // ---------------------------------------------------------------
 void X86Generator::gen_call(const IRInstruction& instr) {
-    std::string func_name = instr.srcs[0].name;   // имя функции
+    using mir::Op;
+    using mir::Reg;
+    std::string func_name = instr.srcs[0].name();   // имя функции
     int arg_count = instr.srcs[1].int_val;
 
     // Отмечаем extern, если функция не определена в программе
-    if (defined_functions_.find(func_name) == defined_functions_.end()) {
+    if (!is_defined_function(func_name)) {
         extern_symbols_.insert(func_name);
+    } else if (instrument_) {
+        emit_counter(profile_call_format(cur_func_name_, func_name));
     }
 
-    // Загружаем аргументы 0..5 в регистры ABI
-    for (int i = 0; i < arg_count && i < x86abi::MAX_REG_ARGS; ++i) {
-        const char* r32 = x86abi::arg_reg_32(i);
-        const char* r64 = x86abi::arg_reg_64(i);
-        if (r32 && r64) {
-            load_operand(pending_params_[i], r32, r64);
-        }
+    std::vector<bool> is_float(arg_count);
+    for (int i = 0; i < arg_count; ++i) {
+        is_float[i] = pending_params_[i].type == IRType::Float;
+    }
+    const auto locs = x86abi::classify_args(is_float);
+    using Kind = x86abi::ArgLocation::Kind;
+
+    // Сохраняем caller-saved регистры, живые через вызов
+    const auto& saves = regalloc_.caller_saved_live_across(instr);
+    for (const auto& reg : saves) {
+        emit(Op::PUSH, gpr(reg), {}, "save caller-saved");
     }
 
-    // Аргументы 6+ — через стек (push справа налево)
-    if (arg_count > x86abi::MAX_REG_ARGS) {
-        int stack_args = arg_count - x86abi::MAX_REG_ARGS;
-        // Выравнивание: если нечётное число stack-аргументов,
-        // нужен дополнительный sub rsp, 8 чтобы стек остался aligned
-        bool need_pad = (stack_args % 2 != 0);
-        if (need_pad) {
-            emit("    sub rsp, 8");
+    // Stack-аргументы — через стек (push справа налево), до загрузки
+    // ABI-регистров, чтобы не читать уже перезаписанные регистры.
+    // Выравнивание: если нечётное число push-ей (сохранения +
+    // stack-аргументы), нужен дополнительный sub rsp, 8
+    int stack_args = 0;
+    int xmm_args = 0;
+    for (const auto& loc : locs) {
+        if (loc.kind == Kind::Stack) stack_args++;
+        if (loc.kind == Kind::Xmm) xmm_args++;
+    }
+    bool need_pad = ((static_cast<int>(saves.size()) + stack_args) % 2 != 0);
+    if (need_pad) {
+        emit(Op::SUB, r64(Reg::RSP), mir::imm(8));
+    }
+    for (int i = arg_count - 1; i >= 0; --i) {
+        if (locs[i].kind != Kind::Stack) continue;
+        load_operand_64(pending_params_[i], Reg::RAX);
+        emit(Op::PUSH, r64(Reg::RAX));
+    }
+
+    // float-аргументы в xmm0..xmm7
+    for (int i = 0; i < arg_count; ++i) {
+        if (locs[i].kind == Kind::Xmm) {
+            load_float(pending_params_[i], mir::parse_reg(x86abi::XMM_ARG_REGS[locs[i].index]));
         }
-        for (int i = arg_count - 1; i >= x86abi::MAX_REG_ARGS; --i) {
-            load_operand_64(pending_params_[i], "rax");
-            emit("    push rax");
+    }
+
+    // Целые аргументы в регистры ABI
+    bool arg_reg_conflict = false;
+    for (int i = 0; i < arg_count; ++i) {
+        if (locs[i].kind != Kind::Gpr) continue;
+        auto alloc = value_allocation(pending_params_[i]);
+        if (alloc.in_register && x86abi::is_arg_reg_64(alloc.phys_reg_64)) arg_reg_conflict = true;
+    }
+    if (arg_reg_conflict) {
+        std::vector<std::pair<Reg, Reg>> moves;
+        for (int i = 0; i < arg_count; ++i) {
+            if (locs[i].kind != Kind::Gpr) continue;
+            mir::Reg src = value_register(pending_params_[i]);
+            if (src != Reg::NONE) {
+                moves.push_back({mir::parse_reg(x86abi::arg_reg_64(locs[i].index)), src});
+            }
         }
+        emit_parallel_moves(std::move(moves));
+    }
+    for (int i = 0; i < arg_count; ++i) {
+        if (locs[i].kind != Kind::Gpr) continue;
+        if (arg_reg_conflict && value_allocation(pending_params_[i]).in_register) continue;
+        load_operand(pending_params_[i], mir::parse_reg(x86abi::arg_reg_64(locs[i].index)));
     }
 
-    // System V AMD64 ABI: для variadic функций (как printf) регистр AL должен содержать 
-    // количество используемых векторных (XMM) регистров. Так как мы не используем float, AL = 0.
-    emit("    xor eax, eax");
-    emit("    call " + func_name);
+    // System V AMD64 ABI: для variadic функций (как printf) регистр AL
+    // должен содержать верхнюю границу числа используемых xmm-регистров.
+    if (xmm_args > 0) {
+        emit(Op::MOV, r32(Reg::RAX), mir::imm(xmm_args));
+    } else {
+        emit(Op::XOR, r32(Reg::RAX), r32(Reg::RAX));
+    }
+    emit(Op::CALL, mir::label({mir::Symbol::Kind::Global, func_name, 0}));
 
     // Очистка стека после stack-аргументов
-    if (arg_count > x86abi::MAX_REG_ARGS) {
-        int stack_args = arg_count - x86abi::MAX_REG_ARGS;
-        bool need_pad = (stack_args % 2 != 0);
-        int cleanup = stack_args * x86abi::QWORD_SIZE;
-        if (need_pad) cleanup += x86abi::QWORD_SIZE;
-        emit("    add rsp, " + std::to_string(cleanup));
+    int cleanup = stack_args * x86abi::QWORD_SIZE;
+    if (need_pad) cleanup += x86abi::QWORD_SIZE;
+    if (cleanup > 0) {
+        emit(Op::ADD, r64(Reg::RSP), mir::imm(cleanup));
+    }
+
+    for (auto it = saves.rbegin(); it != saves.rend(); ++it) {
+        emit(Op::POP, gpr(*it));
     }
 
-    // Результат в eax → dest
+    // Результат в eax (float — в xmm0) → dest
     if (!instr.dest.is_none()) {
-        store_to_dest(instr.dest, "eax");
+        if (instr.dest.type == IRType::Float) {
+            store_float(instr.dest, mir::parse_reg(x86abi::RET_REG_XMM));
+        } else {
+            store_to_dest(instr.dest, mir::parse_reg(x86abi::RET_REG_64));
+        }
     }
 
     pending_params_.clear();
@@ -838,93 +2207,58 @@ void X86Generator::gen_terminator(const BasicBlock& block) {
 
     // --- JUMP (безусловный) ---
     if (first.opcode == IROpcode::JUMP) {
-        std::string target = first.dest.name;
+        std::string target = first.dest.name();
         emit_phi_moves(block.label, target);
-        emit("    jmp ." + target);
+        emit(mir::Op::JMP, mir::label(block_label(target)));
         return;
     }
 
     // --- JUMP_IF / JUMP_IF_NOT + JUMP ---
     if (first.opcode == IROpcode::JUMP_IF || first.opcode == IROpcode::JUMP_IF_NOT) {
-        std::string true_target = first.dest.name;
+        std::string true_target = first.dest.name();
         std::string false_target;
 
         // Следующий терминатор — JUMP (false path)
         if (ti + 1 < block.instructions.size() &&
             block.instructions[ti + 1].opcode == IROpcode::JUMP) {
-            false_target = block.instructions[ti + 1].dest.name;
+            false_target = block.instructions[ti + 1].dest.name();
         }
 
-        // Для JUMP_IF_NOT инвертируем логику
-        if (first.opcode == IROpcode::JUMP_IF_NOT) {
-            std::swap(true_target, false_target);
-            // Теперь: true_target = куда прыгаем если cond != 0 (оригинальный false)
-            //         false_target = куда прыгаем если cond == 0 (оригинальный true → JUMP_IF_NOT)
-            // Поскольку JUMP_IF_NOT прыгает когда cond == 0, а мы инвертировали targets:
-            // Нет, лучше не инвертировать — обработаем JUMP_IF_NOT напрямую
-            std::swap(true_target, false_target);  // отменяем swap
-
-            // JUMP_IF_NOT cond, target: прыгнуть если cond == 0
-            load_operand(first.srcs[0], "eax", "rax");
-            emit("    test eax, eax");
-
-            bool true_phi = has_phi_moves(block.label, true_target);
-            bool false_phi = has_phi_moves(block.label, false_target);
-
-            if (!true_phi && !false_phi) {
-                emit("    jz ." + true_target);
-                emit("    jmp ." + false_target);
-            } else if (true_phi && !false_phi) {
-                // Нужен trampoline для true path
-                emit("    jnz ." + false_target);
-                emit_phi_moves(block.label, true_target);
-                emit("    jmp ." + true_target);
-            } else if (!true_phi && false_phi) {
-                emit("    jz ." + true_target);
-                emit_phi_moves(block.label, false_target);
-                emit("    jmp ." + false_target);
-            } else {
-                std::string skip = new_aux_label("false");
-                emit("    jnz " + skip);
-                emit_phi_moves(block.label, true_target);
-                emit("    jmp ." + true_target);
-                emit(skip + ":");
-                emit_phi_moves(block.label, false_target);
-                emit("    jmp ." + false_target);
-            }
-            return;
-        }
-
-        // JUMP_IF cond, true_target: прыгнуть если cond != 0
-        gen_cond_branch(block.label, first.srcs[0], true_target, false_target);
+        // JUMP_IF прыгает на true_target при cond != 0, JUMP_IF_NOT — при cond == 0
+        mir::Cond taken = first.opcode == IROpcode::JUMP_IF ? mir::Cond::NE : mir::Cond::E;
+        gen_cond_branch(block.label, first.srcs[0], true_target, false_target, taken);
     }
 }
 
 // ---------------------------------------------------------------
-// gen_cond_branch — условный переход JUMP_IF с PHI-разрешением
+// gen_cond_branch — условный переход с PHI-разрешением
+//
+// taken — условие перехода на true_target по флагам test eax, eax:
+// NE для JUMP_IF (cond != 0), E для JUMP_IF_NOT (cond == 0).
+// Ниже jCC — переход по taken, jNCC — по противоположному.
 //
 // Четыре случая в зависимости от наличия PHI-moves:
 //
 // 1) Нет PHI ни на одном пути:
 //    test eax, eax
-//    jnz .true_target
+//    jCC .true_target
 //    jmp .false_target
 //
 // 2) PHI только на true path (пример: || short-circuit):
 //    test eax, eax
-//    jz .false_target      ; если false — сразу туда
+//    jNCC .false_target    ; если false — сразу туда
 //    <phi moves для true>
 //    jmp .true_target
 //
 // 3) PHI только на false path (пример: && short-circuit):
 //    test eax, eax
-//    jnz .true_target
+//    jCC .true_target
 //    <phi moves для false>
 //    jmp .false_target
 //
 // 4) PHI на обоих путях:
 //    test eax, eax
-//    jz .Laux_false_N
+//    jNCC .Laux_false_N
 //    <phi moves для true>
 //    jmp .true_target
 //    .Laux_false_N:
@@ -934,39 +2268,43 @@ void X86Generator::gen_terminator(const BasicBlock& block) {
 void X86Generator::gen_cond_branch(const std::string& cur_block_label,
                                    const Operand& cond,
                                    const std::string& true_target,
-                                   const std::string& false_target) {
-    load_operand(cond, "eax", "rax");
-    emit("    test eax, eax");
+                                   const std::string& false_target,
+                                   mir::Cond taken) {
+    using mir::Op;
+    load_operand(cond, mir::Reg::RAX);
+    emit(Op::TEST, r32(mir::Reg::RAX), r32(mir::Reg::RAX));
 
     bool true_phi  = has_phi_moves(cur_block_label, true_target);
     bool false_phi = has_phi_moves(cur_block_label, false_target);
+    auto to_true  = mir::label(block_label(true_target));
+    auto to_false = mir::label(block_label(false_target));
 
     if (!true_phi && !false_phi) {
         // Случай 1: простой
-        emit("    jnz ." + true_target);
-        emit("    jmp ." + false_target);
+        emit(mir::make_cc(Op::JCC, taken, to_true));
+        emit(Op::JMP, to_false);
 
     } else if (true_phi && !false_phi) {
         // Случай 2: phi на true. Если false — прыгаем мимо phi-кода
-        emit("    jz ." + false_target);
+        emit(mir::make_cc(Op::JCC, mir::invert(taken), to_false));
         emit_phi_moves(cur_block_label, true_target);
-        emit("    jmp ." + true_target);
+        emit(Op::JMP, to_true);
 
     } else if (!true_phi && false_phi) {
         // Случай 3: phi на false
-        emit("    jnz ." + true_target);
+        emit(mir::make_cc(Op::JCC, taken, to_true));
         emit_phi_moves(cur_block_label, false_target);
-        emit("    jmp ." + false_target);
+        emit(Op::JMP, to_false);
 
     } else {
         // Случай 4: phi на обоих путях — нужна доп. метка
-        std::string false_label = new_aux_label("false");
-        emit("    jz " + false_label);
+        mir::Symbol false_label = new_aux_label("false");
+        emit(mir::make_cc(Op::JCC, mir::invert(taken), mir::label(false_label)));
         emit_phi_moves(cur_block_label, true_target);
-        emit("    jmp ." + true_target);
-        emit(false_label + ":");
+        emit(Op::JMP, to_true);
+        emit_label(false_label);
         emit_phi_moves(cur_block_label, false_target);
-        emit("    jmp ." + false_target);
+        emit(Op::JMP, to_false);
     }
 }
 
@@ -1003,7 +2341,7 @@ void X86Generator::build_phi_map(const IRFunction& func) {
                 pm.dest      = instr.dest;
                 pm.source    = val;
 
-                phi_moves_[block.label][pred.name].push_back(pm);
+                phi_moves_[block.label][pred.name()].push_back(pm);
             }
         }
     }
@@ -1028,10 +2366,9 @@ void X86Generator::emit_phi_moves(const std::string& from_block,
     const auto& moves = it2->second;
     if (moves.empty()) return;
 
-    emit("    ; PHI resolution: " + from_block + " -> " + to_block);
+    emit(mir::make_comment("PHI resolution: " + from_block + " -> " + to_block));
     for (const auto& pm : moves) {
-        load_operand(pm.source, "eax", "rax");
-        store_to_dest(pm.dest, "eax");
+        emit_value_move(pm.dest, pm.source);
     }
 }
 
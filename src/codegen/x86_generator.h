@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -7,22 +9,48 @@
 #include <vector>
 
 #include "ir/basic_block.h"
+#include "ir/profile.h"
+#include "codegen/elf_writer.h"
+#include "codegen/machine_ir.h"
 #include "codegen/stack_frame.h"
 #include "codegen/register_allocator.h"
 #include "codegen/x86_peephole.h"
+#include "utils/thread_pool.h"
 
 // ---------------------------------------------------------------
 // X86Generator — транслирует IRProgram в NASM x86-64 ассемблер
 //
 // Стратегия: stack-based codegen
-//   - Каждый Temp/параметр → слот [rbp-N]
+//   - Каждый Temp/параметр → слот [rbp-N] (с --omit-frame-pointer — [rsp+N])
 //   - eax/ecx — scratch-регистры для вычислений
+//   - float (double) хранится там же, где int — 64-битным битовым
+//     образом в слоте или регистре; арифметика идёт в xmm0/xmm1
 //   - PHI-узлы → move-инструкции в конце предшественника
 //   - Пролог/эпилог по System V AMD64 ABI
+//
+// Код функции строится как машинный IR (mir::Function): x86
+// peephole работает с ним, а текст NASM/GAS печатается в самом
+// конце.  Каждая функция генерируется отдельным дочерним
+// генератором (gen_function_unit), а затем функции склеиваются в
+// порядке program.functions.  С пулом потоков функции генерируются
+// параллельно; результат побайтно совпадает с последовательным.
+//
+// --emit obj: вместо текста машинный IR кодируется X86Encoder и
+// записывается перемещаемым ELF64 (build_object) — внешний
+// ассемблер не нужен.
+//
+// --profile-generate: в модуле с main каждый блок и каждый вызов
+// функции программы увеличивают свой 64-битный счётчик в .bss
+// (Lprof_N), а перед выходом из main __mc_profile_dump пишет их в
+// файл профиля (формат — ir/profile.h).  --profile-use: горячие
+// блоки раскладываются цепочкой переходов по самым частым рёбрам,
+// невыполнявшиеся — в конец функции, а счётчики блоков становятся
+// весами спилла аллокатора.
 // ---------------------------------------------------------------
 class X86Generator {
 public:
-    /// Сгенерировать полный NASM-файл для IR-программы.
+    /// Сгенерировать полный NASM-файл для IR-программы
+    /// (или объектный файл ELF64, см. set_emit_object).
     std::string generate(const IRProgram& program);
 
     /// Получить статистику кодогенерации.
@@ -41,9 +69,47 @@ public:
     /// Установить имя исходного файла для DWARF .file директивы.
     void set_source_file(const std::string& path) { source_filename_ = path; }
 
+    /// Пул потоков для параллельной генерации функций (nullptr — последовательно).
+    void set_thread_pool(utils::ThreadPool* pool) { pool_ = pool; }
+
+    /// Выдавать объектный файл ELF64 вместо ассемблерного текста.
+    void set_emit_object(bool enable) { emit_object_ = enable; }
+
+    /// Не заводить указатель фрейма: слоты адресуются от rsp,
+    /// листовые функции размещаются в красной зоне, а сохранение
+    /// callee-saved переносится с пути раннего выхода (shrink-wrap).
+    void set_omit_frame_pointer(bool enable) { omit_frame_pointer_ = enable; }
+
+    /// Сгенерировать объектный модуль в памяти (секции, символы,
+    /// релокации) — его сериализует --emit obj и загружает JIT.
+    elf::Object generate_object(const IRProgram& program);
+
+    /// Ошибки кодирования (--emit obj); пусто — успех.
+    const std::vector<std::string>& errors() const { return errors_; }
+
+    // Кэш компиляции (--cache-dir): load по имени функции отдаёт
+    // сохранённый машинный код и сдвиг строк исходника (функция
+    // могла переместиться в файле), store получает код только что
+    // сгенерированной функции.  Вызываются из потоков пула.
+    struct UnitCache {
+        std::function<bool(const std::string& func, std::string& data, int& line_delta)> load;
+        std::function<void(const std::string& func, const std::string& data)> store;
+    };
+
+    /// Брать готовый машинный код функций из кэша (nullptr — без кэша).
+    void set_unit_cache(const UnitCache* cache) { unit_cache_ = cache; }
+
+    /// Инструментировать программу: счётчики блоков и вызовов
+    /// пишутся в path при выходе из main (пусто — выключено).
+    void set_profile_generate(const std::string& path) { profile_path_ = path; }
+
+    /// Раскладка блоков и веса спилла по профилю (nullptr — без профиля).
+    void set_profile(const ProfileData* profile) { profile_ = profile; }
+
 private:
     std::ostringstream out_;          // итоговый выходной буфер
     StackFrame frame_;
+    FrameStats frame_stats_;          // раскладка фреймов всех функций
     RegisterAllocator regalloc_;
     bool peephole_enabled_ = false;
     X86Peephole peephole_;
@@ -52,9 +118,19 @@ private:
     std::string source_filename_;
     int last_emitted_line_ = 0;  // для подавления дублирующихся .loc
 
-    // Строковые литералы: label → value
-    std::vector<std::pair<std::string, std::string>> string_literals_;
-    int string_counter_ = 0;
+    // Строковые литералы: номер N метки Lstr_N → value
+    std::vector<std::string> string_literals_;
+
+    // Пул float-констант (.rodata): номер N метки Lflt_N → битовый образ double
+    std::vector<std::uint64_t> float_literals_;
+
+    // Машинный код текущей функции
+    mir::Function fn_;
+
+    // Машинный IR всех функций (merge_units) и ошибки кодирования
+    bool emit_object_ = false;
+    std::vector<mir::Function> functions_;
+    std::vector<std::string> errors_;
 
     // Для PHI-разрешения:
     //   phi_moves_[dest_block][pred_block] = [{dest_name, source_operand}, ...]
@@ -75,6 +151,22 @@ private:
     // Имя текущей функции (для контекста ошибок)
     std::string cur_func_name_;
 
+    // Блок писал в ymm-регистры — перед выходом из него нужен vzeroupper
+    bool ymm_dirty_ = false;
+
+    // --omit-frame-pointer.  frame_alloc_ — sub rsp после push
+    // callee-saved (0 — листовая функция в красной зоне),
+    // frame_depth_ — глубина rsp после пролога.  Shrink-wrap: пролог
+    // ставится на ребро entry → wrap_framed_, а блок wrap_frameless_
+    // исполняется без фрейма и выходит одним ret.
+    bool omit_frame_pointer_ = false;
+    int frame_alloc_ = 0;
+    int frame_depth_ = 0;
+    std::string wrap_framed_;
+    std::string wrap_frameless_;
+    std::unordered_map<SymbolId, std::string> wrap_params_;  // параметр → ABI-регистр
+    bool frameless_ = false;
+
     // Счётчик вспомогательных меток (для условных переходов с PHI)
     int aux_label_counter_ = 0;
 
@@ -84,12 +176,63 @@ private:
     // Множество функций, определённых в программе
     std::set<std::string> defined_functions_;
 
+    // Профиль.  counters_ — форматы строк счётчиков Lprof_N (у первого
+    // счётчика функции впереди строка "fn ..."); instrument_ и
+    // profile_header_ — настройки дочернего генератора.
+    std::string profile_path_;
+    const ProfileData* profile_ = nullptr;
+    bool instrument_ = false;
+    std::string profile_header_;
+    std::vector<std::string> counters_;
+    int profiled_functions_ = 0;        // функций с подошедшим профилем
+    int defined_count_ = 0;
+
     // Известные runtime-функции
     static const std::set<std::string>& runtime_functions();
 
+    // ---- пофункциональная генерация ----
+    //
+    // Дочерний генератор не знает глобальной нумерации строковых
+    // литералов, float-констант и .Laux-меток и нумерует их с нуля;
+    // merge_units переписывает номера в mir::Symbol на глобальные.
+    struct FunctionAsm {
+        bool has_code = false;
+        mir::Function code;
+        std::vector<std::string> strings;   // локальные строковые литералы
+        std::vector<std::uint64_t> floats;  // локальные float-константы
+        int aux_labels = 0;                 // число .Laux-меток
+        std::set<std::string> externs;
+        int last_loc_line = 0;              // последняя .loc (0 — не было)
+        RegisterAllocator regalloc;         // счётчики и итог LSRA
+        X86Peephole peephole;               // счётчики peephole
+        FrameStats frame;                   // раскладка фрейма
+        std::vector<std::string> counters;  // локальные счётчики профиля
+    };
+
+    utils::ThreadPool* pool_ = nullptr;
+    const std::set<std::string>* program_functions_ = nullptr;
+    const UnitCache* unit_cache_ = nullptr;
+
+    FunctionAsm gen_function_unit(const IRFunction& func) const;
+    static std::string encode_unit(const FunctionAsm& unit);
+    static bool decode_unit(const std::string& data, int line_delta, FunctionAsm& unit);
+    void merge_units(std::vector<FunctionAsm>& units);
+    void gen_program(const IRProgram& program, bool text);
+    void emit_header(const IRProgram& program);
+    bool build_object(elf::Object& obj);
+    bool is_defined_function(const std::string& name) const;
+    static IRFunction profile_layout(const IRFunction& func, std::vector<std::uint64_t>& counts);
+    void emit_counter(std::string format);
+    void gen_profile_dump();
+
     // ---- генерация функции ----
     void gen_function(const IRFunction& func);
     void gen_prologue(const IRFunction& func);
+    void gen_param_moves(const IRFunction& func);
+    int frame_allocation(const IRFunction& func) const;
+    bool plan_shrink_wrap(const IRFunction& func);
+    void emit_frame_setup();
+    void emit_wrapped_setup(const std::string& entry_label);
     void gen_block(const BasicBlock& block, const IRFunction& func);
 
     // ---- генерация инструкций ----
@@ -97,17 +240,21 @@ private:
     void gen_binary(const IRInstruction& instr);
     void gen_unary(const IRInstruction& instr);
     void gen_comparison(const IRInstruction& instr);
+    void gen_float_comparison(const IRInstruction& instr);
+    void gen_conversion(const IRInstruction& instr);
     void gen_move(const IRInstruction& instr);
     void gen_return(const IRInstruction& instr);
     void gen_param(const IRInstruction& instr);
     void gen_call(const IRInstruction& instr);
+    void gen_vector(const IRInstruction& instr);
 
     // ---- терминатор блока ----
     void gen_terminator(const BasicBlock& block);
     void gen_cond_branch(const std::string& cur_block_label,
                          const Operand& cond,
                          const std::string& true_target,
-                         const std::string& false_target);
+                         const std::string& false_target,
+                         mir::Cond taken);
 
     // ---- PHI-разрешение ----
     void build_phi_map(const IRFunction& func);
@@ -117,13 +264,30 @@ private:
                        const std::string& to_block) const;
 
     // Вспомогательные методы загрузки/сохранения
-    void load_operand(const Operand& op, const char* reg32, const char* reg64);
-    void load_operand_64(const Operand& op, const char* reg64);
-    void store_to_dest(const Operand& dest, const char* reg32);
+    void load_operand(const Operand& op, mir::Reg reg);
+    void load_operand_64(const Operand& op, mir::Reg reg);
+    void load_operand_wide(const Operand& op, mir::Reg reg);
+    mir::Operand element_address(const Operand& array, const Operand& index, int scale);
+    void store_to_dest(const Operand& dest, mir::Reg reg);
+    void load_float(const Operand& op, mir::Reg xmm);
+    void store_float(const Operand& dest, mir::Reg xmm);
+    void emit_value_move(const Operand& dest, const Operand& src);
+    Allocation value_allocation(const Operand& op) const;
+    Allocation allocation(SymbolId id) const;
+    mir::Reg value_register(const Operand& op) const;   // NONE — не в регистре
+
+    // Параллельная пересылка регистр → регистр (приёмник, источник);
+    // циклы разрываются через rax
+    void emit_parallel_moves(std::vector<std::pair<mir::Reg, mir::Reg>> moves);
 
     // ---- вспомогательные ----
-    void emit(const std::string& line);
+    void emit(mir::Instr instr);
+    void emit(mir::Op op, mir::Operand dst = {}, mir::Operand src = {}, std::string comment = {});
+    void emit_label(const mir::Symbol& label);
+    void emit_line(const std::string& line);    // строка заголовка / секции данных
     void emit_blank();
-    std::string new_aux_label(const std::string& hint);
-    std::string intern_string(const std::string& value);
+    mir::Symbol block_label(const std::string& name) const;
+    mir::Symbol new_aux_label(const std::string& hint);
+    mir::Symbol intern_string(const std::string& value);
+    mir::Symbol intern_float(double value);
 };
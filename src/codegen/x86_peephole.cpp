@@ -1,188 +1,421 @@
 #include "codegen/x86_peephole.h"
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
-#include <algorithm>
+
+using mir::Cond;
+using mir::Instr;
+using mir::Op;
+using mir::Operand;
+using mir::Reg;
 
 // ---------------------------------------------------------------
-// Вспомогательные функции
+// Вспомогательные функции: чтение/запись флагов, регистров, памяти
 // ---------------------------------------------------------------
 
-static std::string trim_ws(const std::string& s) {
-    size_t start = s.find_first_not_of(" \t");
-    if (start == std::string::npos) return "";
-    size_t end = s.find_last_not_of(" \t\r\n");
-    return s.substr(start, end - start + 1);
-}
-
-static bool is_instruction(const std::string& line) {
-    std::string trimmed = trim_ws(line);
-    if (trimmed.empty()) return false;
-    if (trimmed[0] == ';') return false;      // комментарий
-    if (trimmed.back() == ':') return false;   // метка
-    if (trimmed.substr(0, 7) == "section") return false;
-    if (trimmed.substr(0, 6) == "global") return false;
-    if (trimmed.substr(0, 6) == "extern") return false;
-    if (trimmed.substr(0, 2) == "db") return false;
-    return true;
+namespace {
+
+bool writes_flags(const Instr& in) {
+    if (in.kind != Instr::Kind::Op) return false;
+    switch (in.op) {
+        case Op::ADD: case Op::SUB: case Op::IMUL: case Op::AND:
+        case Op::OR:  case Op::XOR: case Op::NEG:  case Op::BTC:
+        case Op::IDIV: case Op::CMP: case Op::TEST: case Op::UCOMISD:
+        case Op::CALL:
+            return true;
+        default:
+            return false;
+    }
 }
 
-// Извлекает мнемонику и операнды из строки вида "    mov eax, ecx"
-static bool parse_instruction(const std::string& line,
-                               std::string& mnemonic,
-                               std::string& op1,
-                               std::string& op2) {
-    std::string trimmed = trim_ws(line);
-    // Убираем trailing comment ("; ...")
-    auto semi = trimmed.find(';');
-    if (semi != std::string::npos) {
-        trimmed = trimmed.substr(0, semi);
-        // re-trim
-        size_t e = trimmed.find_last_not_of(" \t");
-        if (e != std::string::npos) trimmed = trimmed.substr(0, e + 1);
+bool reads_flags(const Instr& in) {
+    return in.is_op(Op::JCC) || in.is_op(Op::SETCC);
+}
+
+// Инструкции, которые не пишут в первый операнд
+bool dst_is_read_only(Op op) {
+    return op == Op::CMP || op == Op::TEST || op == Op::UCOMISD ||
+           op == Op::PUSH || op == Op::JMP || op == Op::JCC || op == Op::CALL;
+}
+
+// Регистры, которые инструкция переписывает (CALL — отдельно)
+int defined_regs(const Instr& in, Reg out[3]) {
+    int n = 0;
+    if (in.kind != Instr::Kind::Op) return 0;
+    if (in.dst.is_reg() && !dst_is_read_only(in.op)) out[n++] = in.dst.reg;
+    switch (in.op) {
+        case Op::CDQ:  out[n++] = Reg::RDX; break;
+        case Op::IDIV: out[n++] = Reg::RAX; out[n++] = Reg::RDX; break;
+        case Op::PUSH: case Op::POP: out[n++] = Reg::RSP; break;
+        case Op::LEAVE: out[n++] = Reg::RSP; out[n++] = Reg::RBP; break;
+        default: break;
     }
+    return n;
+}
 
-    // Найти первый пробел (после мнемоники)
-    auto sp = trimmed.find(' ');
-    if (sp == std::string::npos) {
-        mnemonic = trimmed;
-        op1 = "";
-        op2 = "";
-        return true;
+// Слот стекового фрейма: [rbp±N] без индекса, а без указателя
+// фрейма — [rsp+N]
+bool is_slot(const Operand& op) {
+    return op.is_mem() && (op.reg == Reg::RBP || op.reg == Reg::RSP) && op.index == Reg::NONE;
+}
+
+// Пересекаются ли два слота (bits == 0 — размер неизвестен)
+bool overlaps(const Operand& a, const Operand& b) {
+    if (a.bits == 0 || b.bits == 0) return true;
+    return a.value < b.value + b.bits / 8 && b.value < a.value + a.bits / 8;
+}
+
+// Индекс следующей машинной инструкции после i (комментарии и
+// .loc пропускаются), или code.size()
+size_t next_op(const std::vector<Instr>& code, size_t i) {
+    for (++i; i < code.size(); ++i) {
+        if (code[i].kind == Instr::Kind::Op) return i;
     }
+    return code.size();
+}
 
-    mnemonic = trimmed.substr(0, sp);
-    std::string rest = trim_ws(trimmed.substr(sp + 1));
-
-    // Разделить по запятой
-    auto comma = rest.find(',');
-    if (comma == std::string::npos) {
-        op1 = trim_ws(rest);
-        op2 = "";
-    } else {
-        op1 = trim_ws(rest.substr(0, comma));
-        op2 = trim_ws(rest.substr(comma + 1));
+// Флаги после позиции i не читаются до следующей записи (на
+// границе блока флаги мертвы: кодогенератор не переносит их
+// через метки)
+bool flags_dead_after(const std::vector<Instr>& code, size_t i) {
+    for (size_t j = next_op(code, i); j < code.size(); j = next_op(code, j)) {
+        if (reads_flags(code[j])) return false;
+        if (writes_flags(code[j])) return true;
     }
     return true;
 }
 
-// Проверяет, является ли строка меткой и возвращает её имя
-static bool is_label(const std::string& line, std::string& label_name) {
-    std::string trimmed = trim_ws(line);
-    if (!trimmed.empty() && trimmed.back() == ':') {
-        label_name = trimmed.substr(0, trimmed.size() - 1);
-        return true;
+// mov между GPR и слотом той же ширины: QWORD или DWORD (int)
+bool is_slot_move(const Operand& reg, const Operand& slot) {
+    return reg.is_reg() && !mir::is_xmm(reg.reg) && is_slot(slot) && reg.bits == slot.bits &&
+           (reg.bits == 64 || reg.bits == 32);
+}
+
+void erase_deleted(std::vector<Instr>& code, const std::vector<char>& deleted) {
+    size_t out = 0;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (deleted[i]) continue;
+        if (out != i) code[out] = std::move(code[i]);
+        out++;
     }
-    return false;
+    code.resize(out);
 }
 
+} // namespace
+
 // ---------------------------------------------------------------
 // optimize — главный метод оконной оптимизации
 // ---------------------------------------------------------------
-std::string X86Peephole::optimize(const std::string& asm_text) {
-    removed_  = 0;
-    replaced_ = 0;
-
-    // Разбиваем текст на строки
-    std::vector<std::string> lines;
-    std::istringstream stream(asm_text);
-    std::string line;
-    while (std::getline(stream, line)) {
-        lines.push_back(line);
+void X86Peephole::optimize(mir::Function& fn) {
+    for (auto& block : fn.blocks) {
+        forward_stores(block);
+        simplify(block);
+        remove_compares(block);
     }
+    fold_branches(fn);
+}
 
-    // Маска: true = строка удалена
-    std::vector<bool> deleted(lines.size(), false);
+// ---------------------------------------------------------------
+// forward_stores — store→load forwarding по слотам фрейма
+//
+// Для каждого слота помним регистры, в которых лежит его значение:
+// после mov [slot], r и после mov r, [slot] той же ширины (qword или
+// dword).  Повторная загрузка из слота становится mov из регистра;
+// 64-битная в тот же регистр исчезает, а 32-битная остаётся
+// mov r32, r32 — старшая половина регистра после записи в слот не
+// обязательно нулевая.
+// Запись в регистр или слот снимает соответствующие факты; call и
+// leave снимают все.  Слоты адресуются только через rbp или rsp, а
+// указатели на стек в языке не появляются, поэтому запись по другим
+// базам слоты не затрагивает.  Смещение [rsp+N] верно лишь до
+// следующего изменения rsp (push, pop, sub rsp) — оно снимает
+// такие факты.
+// ---------------------------------------------------------------
+void X86Peephole::forward_stores(mir::Block& block) {
+    struct Fact {
+        Operand slot;
+        Reg reg;
+    };
+    std::vector<Fact> facts;
+    std::vector<char> deleted(block.code.size(), 0);
 
-    for (size_t i = 0; i < lines.size(); ++i) {
-        if (deleted[i]) continue;
-        if (!is_instruction(lines[i])) continue;
+    for (size_t i = 0; i < block.code.size(); ++i) {
+        Instr& in = block.code[i];
+        if (in.kind != Instr::Kind::Op) continue;
 
-        std::string m1, op1a, op1b;
-        if (!parse_instruction(lines[i], m1, op1a, op1b)) continue;
+        // 1. Повторная загрузка слота
+        if (in.op == Op::MOV && is_slot_move(in.dst, in.src)) {
+            Reg known = Reg::NONE;
+            for (const auto& f : facts) {
+                if (f.slot != in.src) continue;
+                if (f.reg == in.dst.reg) {
+                    known = f.reg;
+                    break;
+                }
+                if (known == Reg::NONE) known = f.reg;
+            }
+            if (known == in.dst.reg && in.dst.bits == 64) {
+                deleted[i] = 1;
+                forwarded_++;
+                continue;
+            }
+            if (known != Reg::NONE) {
+                Operand slot = in.src;
+                in.src = mir::reg(known, in.dst.bits);
+                forwarded_++;
+                facts.erase(std::remove_if(facts.begin(), facts.end(),
+                                           [&](const Fact& f) { return f.reg == in.dst.reg; }),
+                            facts.end());
+                facts.push_back({slot, in.dst.reg});
+                continue;
+            }
+        }
 
-        // ----- Паттерн 2: mov X, X (identity) -----
-        if (m1 == "mov" && !op1a.empty() && op1a == op1b) {
-            deleted[i] = true;
-            removed_++;
+        // 2. Снять устаревшие факты
+        if (in.op == Op::CALL || in.op == Op::LEAVE) {
+            facts.clear();
             continue;
         }
+        Reg defs[3];
+        int n = defined_regs(in, defs);
+        const bool writes_slot = is_slot(in.dst) && !dst_is_read_only(in.op) && in.op != Op::LEA;
+        facts.erase(std::remove_if(facts.begin(), facts.end(), [&](const Fact& f) {
+                        if (std::find(defs, defs + n, f.reg) != defs + n) return true;
+                        if (std::find(defs, defs + n, f.slot.reg) != defs + n) return true;
+                        return writes_slot && overlaps(f.slot, in.dst);
+                    }),
+                    facts.end());
 
-        // ----- Паттерн 3: mov reg, 0 → xor reg, reg -----
-        if (m1 == "mov" && op1b == "0" && !op1a.empty()) {
-            // Только для чистых регистров (не memory operands)
-            if (op1a.find('[') == std::string::npos) {
-                // Заменяем на xor
-                std::string indent = lines[i].substr(0, lines[i].find_first_not_of(" \t"));
-                lines[i] = indent + "xor " + op1a + ", " + op1a;
-                replaced_++;
-                continue;
-            }
+        // 3. Новые факты
+        if (in.op == Op::MOV && is_slot_move(in.src, in.dst)) {
+            facts.push_back({in.dst, in.src.reg});
+        } else if (in.op == Op::MOV && is_slot_move(in.dst, in.src)) {
+            facts.push_back({in.src, in.dst.reg});
         }
+    }
+    erase_deleted(block.code, deleted);
+}
 
-        // ----- Паттерн 4: add X, 0 / sub X, 0 → удалить -----
-        if ((m1 == "add" || m1 == "sub") && op1b == "0") {
-            deleted[i] = true;
+// ---------------------------------------------------------------
+// simplify — тождественные инструкции и короткие кодировки
+// ---------------------------------------------------------------
+void X86Peephole::simplify(mir::Block& block) {
+    auto& code = block.code;
+    std::vector<char> deleted(code.size(), 0);
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        Instr& in = code[i];
+        if (in.kind != Instr::Kind::Op || deleted[i]) continue;
+
+        // ----- mov X, X (identity) -----
+        // 32-битный mov обнуляет старшую половину — не тождественен
+        if (in.op == Op::MOV && in.dst == in.src && (in.dst.is_mem() || in.dst.bits == 64)) {
+            deleted[i] = 1;
             removed_++;
             continue;
         }
 
-        // ----- Паттерн 5: imul X, 1 → удалить -----
-        if (m1 == "imul" && op1b == "1") {
-            deleted[i] = true;
+        // ----- mov reg, 0 → xor reg32, reg32 -----
+        if (in.op == Op::MOV && in.dst.is_reg() && in.src.is_imm() && in.src.value == 0 &&
+            !mir::is_xmm(in.dst.reg) && in.dst.bits >= 32 && flags_dead_after(code, i)) {
+            Operand r = mir::reg(in.dst.reg, 32);
+            in.op = Op::XOR;
+            in.dst = r;
+            in.src = r;
+            replaced_++;
+            continue;
+        }
+
+        // ----- add X, 0 / sub X, 0 / imul X, 1 → удалить -----
+        if (in.src.is_imm() && flags_dead_after(code, i) &&
+            (((in.op == Op::ADD || in.op == Op::SUB) && in.src.value == 0) ||
+             (in.op == Op::IMUL && in.src.value == 1 && in.dst.bits == 64))) {
+            deleted[i] = 1;
             removed_++;
             continue;
         }
 
-        // ----- Паттерн 6: jmp .Lnext → удалить если .Lnext = следующая метка -----
-        if (m1 == "jmp" && !op1a.empty()) {
-            // Ищем следующую не-пустую строку
-            for (size_t j = i + 1; j < lines.size(); ++j) {
-                std::string trimmed = trim_ws(lines[j]);
-                if (trimmed.empty() || trimmed[0] == ';') continue;  // пропускаем пустые/комментарии
-
-                std::string lbl;
-                if (is_label(lines[j], lbl)) {
-                    if (op1a == lbl) {
-                        // jmp к следующей метке — избыточен
-                        deleted[i] = true;
-                        removed_++;
+        // ----- mov X, Y; mov Y, X → удалить вторую -----
+        // (только 64-битные регистры: 32-битный mov обнуляет старшую половину)
+        auto whole = [](const Operand& o) { return o.is_mem() || o.bits == 64; };
+        if (in.op == Op::MOV && (in.dst.is_reg() || in.src.is_reg()) && whole(in.dst) && whole(in.src)) {
+            size_t j = next_op(code, i);
+            if (j < code.size() && code[j].op == Op::MOV &&
+                code[j].dst == in.src && code[j].src == in.dst) {
+                deleted[j] = 1;
+                removed_++;
+            }
+        }
+    }
+    erase_deleted(code, deleted);
+}
+
+// ---------------------------------------------------------------
+// remove_compares — избыточные test / cmp
+//
+// Идём по блоку вперёд и помним, что известно о флагах:
+//   zf_of   — ZF == (zf_of == 0): после and/or/xor/add/sub/neg с
+//             регистром-приёмником и после test r, r;
+//   cc_of   — cc_of = cc ? 1 : 0, а флаги всё ещё те, из которых
+//             setcc его вычислил;
+//   last_cmp — флаги выставлены этим cmp, операнды не менялись.
+// movzx r32, r8 переносит знание на расширенный регистр.  test r, r
+// удаляется, если все читатели флагов до следующей записи — je/jne
+// или sete/setne; в случае cc_of они переписываются в jcc / j!cc.
+// ---------------------------------------------------------------
+void X86Peephole::remove_compares(mir::Block& block) {
+    auto& code = block.code;
+    std::vector<char> deleted(code.size(), 0);
+
+    // Что известно о значении регистра (bits — ширина операции:
+    // 32 — старшая половина обнулена, годится и test r64, r64;
+    // 64 и 8 — только test той же ширины)
+    struct Known {
+        Reg reg = Reg::NONE;
+        int bits = 0;
+        bool is_cc = false;     // false — ZF отражает reg == 0
+        Cond cc = Cond::E;
+    };
+    Known known;
+    const Instr* last_cmp = nullptr;
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        Instr& in = code[i];
+        if (in.kind != Instr::Kind::Op) continue;
+
+        // ----- test r, r -----
+        if (in.op == Op::TEST && in.dst.is_reg() && in.dst == in.src &&
+            known.reg == in.dst.reg &&
+            (known.bits == in.dst.bits || (known.bits == 32 && in.dst.bits == 64))) {
+            std::vector<size_t> readers;
+            bool ok = true;
+            for (size_t j = next_op(code, i); j < code.size(); j = next_op(code, j)) {
+                if (writes_flags(code[j])) break;
+                if (!reads_flags(code[j])) continue;
+                if (code[j].cond != Cond::E && code[j].cond != Cond::NE) ok = false;
+                readers.push_back(j);
+            }
+            if (ok) {
+                if (known.is_cc) {
+                    for (size_t j : readers) {
+                        code[j].cond = code[j].cond == Cond::NE ? known.cc : mir::invert(known.cc);
                     }
                 }
-                break;  // Проверяем только первую непустую строку после jmp
+                deleted[i] = 1;
+                compares_++;
+                continue;
             }
-            if (deleted[i]) continue;
         }
 
-        // ----- Паттерн 1: mov X, Y; mov Y, X → удалить вторую -----
-        if (m1 == "mov" && !op1a.empty() && !op1b.empty()) {
-            // Ищем следующую инструкцию
-            for (size_t j = i + 1; j < lines.size(); ++j) {
-                if (deleted[j]) continue;
-                std::string trimmed = trim_ws(lines[j]);
-                if (trimmed.empty() || trimmed[0] == ';') continue;
-                if (!is_instruction(lines[j])) break;
-
-                std::string m2, op2a, op2b;
-                if (parse_instruction(lines[j], m2, op2a, op2b)) {
-                    if (m2 == "mov" && op2a == op1b && op2b == op1a) {
-                        deleted[j] = true;
-                        removed_++;
+        // ----- повторный cmp -----
+        if (in.op == Op::CMP && last_cmp && last_cmp->dst == in.dst && last_cmp->src == in.src) {
+            deleted[i] = 1;
+            compares_++;
+            continue;
+        }
+
+        // Обновляем знание о флагах и регистрах
+        Known next;
+        if (in.op == Op::SETCC && in.dst.is_reg()) {
+            next = {in.dst.reg, 8, true, in.cond};
+        } else if (in.op == Op::MOVZX && in.dst.is_reg() && in.src.is_reg() &&
+                   in.src.reg == known.reg && in.src.bits == known.bits) {
+            next = known;
+            next.reg = in.dst.reg;
+            next.bits = 32;
+        } else if (!writes_flags(in)) {
+            Reg defs[3];
+            int n = defined_regs(in, defs);
+            next = known;
+            if (std::find(defs, defs + n, known.reg) != defs + n) next = Known{};
+        } else if (in.dst.is_reg() && !mir::is_xmm(in.dst.reg) &&
+                   (in.op == Op::AND || in.op == Op::OR || in.op == Op::XOR ||
+                    in.op == Op::ADD || in.op == Op::SUB || in.op == Op::NEG ||
+                    (in.op == Op::TEST && in.dst == in.src))) {
+            next = {in.dst.reg, in.dst.bits, false, Cond::E};
+        }
+        known = next;
+
+        if (writes_flags(in)) {
+            last_cmp = in.op == Op::CMP ? &in : nullptr;
+        } else if (last_cmp) {
+            Reg defs[3];
+            int n = defined_regs(in, defs);
+            bool stale = false;
+            for (int k = 0; k < n; ++k) {
+                for (const Operand* o : {&last_cmp->dst, &last_cmp->src}) {
+                    if ((o->is_reg() && o->reg == defs[k]) ||
+                        (o->is_mem() && (o->reg == defs[k] || o->index == defs[k]))) {
+                        stale = true;
                     }
                 }
-                break;
             }
+            if (in.dst.is_mem() && !dst_is_read_only(in.op) && in.op != Op::LEA &&
+                (last_cmp->dst.is_mem() || last_cmp->src.is_mem())) {
+                stale = true;
+            }
+            if (stale) last_cmp = nullptr;
         }
     }
+    erase_deleted(code, deleted);
+}
+
+// ---------------------------------------------------------------
+// fold_branches — переходы на следующий блок
+//
+//   jmp .next            → удалить
+//   jcc .next; jmp .X    → j!cc .X
+// ---------------------------------------------------------------
+void X86Peephole::fold_branches(mir::Function& fn) {
+    for (size_t b = 0; b + 1 < fn.blocks.size(); ++b) {
+        auto& code = fn.blocks[b].code;
+        const mir::Symbol& next = fn.blocks[b + 1].label;
+
+        size_t last = code.size();
+        for (size_t i = code.size(); i-- > 0;) {
+            if (code[i].kind == Instr::Kind::Op) {
+                last = i;
+                break;
+            }
+        }
+        if (last == code.size() || !code[last].is_op(Op::JMP)) continue;
+        if (code[last].dst.sym == next) {
+            code.erase(code.begin() + static_cast<std::ptrdiff_t>(last));
+            removed_++;
+            continue;
+        }
 
-    // Собираем результат
-    std::ostringstream result;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        if (!deleted[i]) {
-            result << lines[i] << "\n";
+        size_t prev = last;
+        for (size_t i = last; i-- > 0;) {
+            if (code[i].kind == Instr::Kind::Op) {
+                prev = i;
+                break;
+            }
+        }
+        if (prev != last && code[prev].is_op(Op::JCC) && code[prev].dst.sym == next) {
+            code[prev].cond = mir::invert(code[prev].cond);
+            code[prev].dst = code[last].dst;
+            code.erase(code.begin() + static_cast<std::ptrdiff_t>(last));
+            replaced_++;
         }
     }
-    return result.str();
+}
+
+void X86Peephole::merge(const X86Peephole& other) {
+    removed_   += other.removed_;
+    replaced_  += other.replaced_;
+    forwarded_ += other.forwarded_;
+    compares_  += other.compares_;
+}
+
+void X86Peephole::write_stats(utils::ByteWriter& out) const {
+    for (int value : {removed_, replaced_, forwarded_, compares_}) out.i64(value);
+}
+
+bool X86Peephole::read_stats(utils::ByteReader& in) {
+    for (int* value : {&removed_, &replaced_, &forwarded_, &compares_}) *value = static_cast<int>(in.i64());
+    return in.ok();
 }
 
 // ---------------------------------------------------------------
@@ -193,6 +426,8 @@ std::string X86Peephole::report() const {
     out << "=== x86 Peephole Optimization ===\n";
     out << "Instructions removed:  " << removed_  << "\n";
     out << "Instructions replaced: " << replaced_ << "\n";
-    out << "Total optimized:       " << (removed_ + replaced_) << "\n";
+    out << "Loads forwarded:       " << forwarded_ << "\n";
+    out << "Compares removed:      " << compares_ << "\n";
+    out << "Total optimized:       " << (removed_ + replaced_ + forwarded_ + compares_) << "\n";
     return out.str();
 }
@@ -2,33 +2,59 @@
 
 #include <string>
 
+#include "codegen/machine_ir.h"
+#include "utils/byte_stream.h"
+
 // ---------------------------------------------------------------
-// X86Peephole — оконная оптимизация на уровне x86-ассемблера
+// X86Peephole — оконная оптимизация машинного IR x86-64
 //
-// Работает на текстовых строках сгенерированного NASM-кода.
-// Применяет паттерны скользящего окна (размер 2-3 строки)
-// для удаления/замены избыточных инструкций.
+// Работает с mir::Function до печати в текст, поблочно: флаги и
+// значения регистров не переносятся через метки.  Операнды
+// типизированы, поэтому паттерны могут охватывать несколько
+// инструкций, а не 2-3 соседние строки.
 //
 // Паттерны:
-//   1. mov X, Y; mov Y, X     → удалить вторую (redundant store-back)
+//   1. Store→load forwarding: mov [rbp-N], r1 ... mov r2, [rbp-N]
+//      → mov r2, r1 (или удалить, если r2 = r1), пока ни r1, ни
+//      слот не переписаны и не было call
 //   2. mov X, X                → удалить (identity mov)
-//   3. mov reg, 0              → xor reg, reg (shorter encoding)
-//   4. add X, 0 / sub X, 0    → удалить (identity arithmetic)
-//   5. imul X, 1               → удалить (identity multiply)
-//   6. jmp .Lnext (→ следующая метка) → удалить (fall-through)
+//   3. mov X, Y; mov Y, X      → удалить вторую (redundant store-back)
+//   4. mov reg, 0              → xor reg, reg, если флаги мертвы
+//   5. add X, 0 / sub X, 0 / imul X, 1 → удалить, если флаги мертвы
+//   6. Избыточный test/cmp: test r, r после инструкции, уже
+//      выставившей ZF по r, или setcc + movzx + test + jnz → jcc;
+//      повторный cmp с теми же операндами
+//   7. jmp .Lnext (→ следующий блок) → удалить (fall-through);
+//      jcc .Lnext; jmp .X        → j!cc .X
 // ---------------------------------------------------------------
 class X86Peephole {
 public:
-    /// Оптимизировать NASM-текст, вернуть результат.
-    std::string optimize(const std::string& asm_text);
+    /// Оптимизировать функцию на месте.
+    void optimize(mir::Function& fn);
+
+    /// Прибавить счётчики другого экземпляра (пофункциональная генерация).
+    void merge(const X86Peephole& other);
 
     /// Отчёт об оптимизациях.
     std::string report() const;
 
-    int removed()  const { return removed_; }
-    int replaced() const { return replaced_; }
+    /// Кэш компиляции: счётчики функции.
+    void write_stats(utils::ByteWriter& out) const;
+    bool read_stats(utils::ByteReader& in);
+
+    int removed()   const { return removed_; }
+    int replaced()  const { return replaced_; }
+    int forwarded() const { return forwarded_; }
+    int compares()  const { return compares_; }
 
 private:
-    int removed_  = 0;   // удалённых инструкций
-    int replaced_ = 0;   // заменённых инструкций
+    int removed_   = 0;   // удалённых инструкций
+    int replaced_  = 0;   // заменённых инструкций
+    int forwarded_ = 0;   // загрузок из слота, заменённых регистром
+    int compares_  = 0;   // удалённых test/cmp
+
+    void forward_stores(mir::Block& block);
+    void simplify(mir::Block& block);
+    void remove_compares(mir::Block& block);
+    void fold_branches(mir::Function& fn);
 };
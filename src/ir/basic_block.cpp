@@ -21,10 +21,14 @@ const IRInstruction& BasicBlock::terminator() const {
 // ---------------------------------------------------------------
 // IRFunction
 // ---------------------------------------------------------------
-Operand IRFunction::new_temp(const std::string& type) {
+Operand IRFunction::new_temp(IRType type) {
     return Operand::temp(temp_counter++, type);
 }
 
+Operand IRFunction::new_temp(const std::string& type) {
+    return new_temp(ir_type_from_name(type));
+}
+
 std::string IRFunction::new_label(const std::string& prefix) {
     return prefix + "_" + std::to_string(label_counter++);
 }
@@ -39,7 +39,8 @@ struct IRFunction {
     int label_counter = 0;
 
     // ----- helpers -----
-    Operand new_temp(const std::string& type = "");
+    Operand new_temp(IRType type = IRType::None);
+    Operand new_temp(const std::string& type);
     std::string new_label(const std::string& prefix = "L");
     BasicBlock& add_block(const std::string& label);
     BasicBlock* find_block(const std::string& label);
@@ -0,0 +1,148 @@
+#include "ir/dominators.h"
+
+#include <algorithm>
+
+// ---------------------------------------------------------------
+// ControlFlowGraph
+// ---------------------------------------------------------------
+ControlFlowGraph::ControlFlowGraph(const IRFunction& func) {
+    const int n = static_cast<int>(func.blocks.size());
+    for (int b = 0; b < n; ++b) {
+        block_index.emplace(intern_symbol(func.blocks[b].label), b);
+    }
+
+    succs.assign(n, {});
+    preds.assign(n, {});
+    for (int b = 0; b < n; ++b) {
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (instr.opcode != IROpcode::JUMP &&
+                instr.opcode != IROpcode::JUMP_IF &&
+                instr.opcode != IROpcode::JUMP_IF_NOT) {
+                continue;
+            }
+            int s = index_of(instr.dest.id);
+            if (s < 0) continue;
+            if (std::find(succs[b].begin(), succs[b].end(), s) != succs[b].end())
+                continue;
+            succs[b].push_back(s);
+            preds[s].push_back(b);
+        }
+    }
+
+    // Iterative DFS from the entry: (block, next successor index)
+    rpo_index.assign(n, -1);
+    if (n == 0) return;
+    std::vector<char> visited(n, 0);
+    std::vector<int> postorder;
+    std::vector<std::pair<int, size_t>> stack;
+    visited[0] = 1;
+    stack.push_back({0, 0});
+    while (!stack.empty()) {
+        auto& [b, next] = stack.back();
+        if (next < succs[b].size()) {
+            int s = succs[b][next++];
+            if (!visited[s]) {
+                visited[s] = 1;
+                stack.push_back({s, 0});
+            }
+        } else {
+            postorder.push_back(b);
+            stack.pop_back();
+        }
+    }
+    rpo.assign(postorder.rbegin(), postorder.rend());
+    for (int i = 0; i < static_cast<int>(rpo.size()); ++i) {
+        rpo_index[rpo[i]] = i;
+    }
+}
+
+int ControlFlowGraph::index_of(SymbolId label) const {
+    auto it = block_index.find(label);
+    return it == block_index.end() ? -1 : it->second;
+}
+
+// ---------------------------------------------------------------
+// DominatorTree
+// ---------------------------------------------------------------
+DominatorTree::DominatorTree(const IRFunction& func) : cfg_(func) {
+    const int n = cfg_.num_blocks();
+    idom_.assign(n, -1);
+    children_.assign(n, {});
+    pre_num_.assign(n, -1);
+    post_num_.assign(n, -1);
+    frontier_.assign(n, {});
+    if (cfg_.rpo.empty()) return;
+
+    // 1. idom by iterating over the reverse post-order.  The entry is
+    //    temporarily its own idom so that intersect() terminates.
+    const int entry = cfg_.rpo.front();
+    idom_[entry] = entry;
+
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (cfg_.rpo_index[a] > cfg_.rpo_index[b]) a = idom_[a];
+            while (cfg_.rpo_index[b] > cfg_.rpo_index[a]) b = idom_[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < cfg_.rpo.size(); ++i) {
+            int b = cfg_.rpo[i];
+            int new_idom = -1;
+            for (int p : cfg_.preds[b]) {
+                if (idom_[p] < 0) continue;         // unreachable or not yet processed
+                new_idom = (new_idom < 0) ? p : intersect(p, new_idom);
+            }
+            if (new_idom != idom_[b]) {
+                idom_[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    idom_[entry] = -1;
+
+    // 2. Tree children (in layout order) and pre/post numbering
+    for (int b = 0; b < n; ++b) {
+        if (idom_[b] >= 0) children_[idom_[b]].push_back(b);
+    }
+    int pre = 0, post = 0;
+    std::vector<std::pair<int, size_t>> stack;
+    stack.push_back({entry, 0});
+    pre_num_[entry] = pre++;
+    preorder_.push_back(entry);
+    while (!stack.empty()) {
+        auto& [b, next] = stack.back();
+        if (next < children_[b].size()) {
+            int c = children_[b][next++];
+            pre_num_[c] = pre++;
+            preorder_.push_back(c);
+            stack.push_back({c, 0});
+        } else {
+            post_num_[b] = post++;
+            stack.pop_back();
+        }
+    }
+
+    // 3. Dominance frontiers: walk up from each predecessor of a join
+    //    point until reaching the join's immediate dominator.
+    for (int b : cfg_.rpo) {
+        if (cfg_.preds[b].size() < 2) continue;
+        for (int p : cfg_.preds[b]) {
+            if (!cfg_.reachable(p)) continue;
+            int runner = p;
+            while (runner >= 0 && runner != idom_[b]) {
+                auto& df = frontier_[runner];
+                if (df.empty() || df.back() != b) df.push_back(b);
+                runner = idom_[runner];
+            }
+        }
+    }
+}
+
+bool DominatorTree::dominates(int a, int b) const {
+    if (pre_num_[a] < 0 || pre_num_[b] < 0) return false;
+    return pre_num_[a] <= pre_num_[b] && post_num_[b] <= post_num_[a];
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "ir/basic_block.h"
+
+// ---------------------------------------------------------------
+// ControlFlowGraph — block indices, successors and predecessors
+//
+// Edges are read from the actual JUMP / JUMP_IF / JUMP_IF_NOT
+// instructions, not from BasicBlock::successors, because passes
+// such as inlining and jump chaining rewrite jumps without keeping
+// those lists up to date.  Block 0 is the entry.
+// ---------------------------------------------------------------
+struct ControlFlowGraph {
+    std::vector<std::vector<int>> succs;
+    std::vector<std::vector<int>> preds;
+    std::vector<int> rpo;                       // reverse post-order of reachable blocks
+    std::vector<int> rpo_index;                 // block -> position in rpo, -1 = unreachable
+    std::unordered_map<SymbolId, int> block_index;
+
+    explicit ControlFlowGraph(const IRFunction& func);
+
+    int num_blocks() const { return static_cast<int>(succs.size()); }
+    bool reachable(int b) const { return rpo_index[b] >= 0; }
+
+    /// Index of the block labelled `label`, or -1.
+    int index_of(SymbolId label) const;
+};
+
+// ---------------------------------------------------------------
+// DominatorTree — immediate dominators and dominance frontiers
+//
+// Uses the iterative algorithm of Cooper, Harvey & Kennedy ("A
+// Simple, Fast Dominance Algorithm"): idom is refined over the
+// reverse post-order until it stops changing, intersecting along
+// the partially built tree.  Unreachable blocks have idom -1 and
+// are not part of the tree.
+// ---------------------------------------------------------------
+class DominatorTree {
+public:
+    explicit DominatorTree(const IRFunction& func);
+
+    const ControlFlowGraph& cfg() const { return cfg_; }
+
+    /// Immediate dominator of `b` (-1 for the entry and unreachable blocks).
+    int idom(int b) const { return idom_[b]; }
+
+    /// Blocks immediately dominated by `b`, in layout order.
+    const std::vector<int>& children(int b) const { return children_[b]; }
+
+    /// Dominator-tree pre-order (entry first).
+    const std::vector<int>& preorder() const { return preorder_; }
+
+    /// Does `a` dominate `b`?  Every reachable block dominates itself.
+    bool dominates(int a, int b) const;
+
+    /// Dominance frontier of `b`: blocks where b's dominance ends.
+    const std::vector<int>& frontier(int b) const { return frontier_[b]; }
+
+private:
+    ControlFlowGraph cfg_;
+    std::vector<int> idom_;
+    std::vector<std::vector<int>> children_;
+    std::vector<int> preorder_;
+    std::vector<int> pre_num_;      // pre-order number in the tree
+    std::vector<int> post_num_;     // post-order number in the tree
+    std::vector<std::vector<int>> frontier_;
+};
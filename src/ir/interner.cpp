@@ -0,0 +1,43 @@
+#include "ir/interner.h"
+
+#include <mutex>
+
+SymbolInterner& SymbolInterner::instance() {
+    static SymbolInterner interner;
+    return interner;
+}
+
+SymbolId SymbolInterner::intern(std::string_view name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+
+    SymbolId id = static_cast<SymbolId>(names_.size());
+    names_.emplace_back(name);
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+SymbolId SymbolInterner::lookup(std::string_view name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(name);
+    return it == ids_.end() ? kNoSymbol : it->second;
+}
+
+const std::string& SymbolInterner::name(SymbolId id) const {
+    static const std::string empty;
+    if (id < 0) return empty;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (static_cast<std::size_t>(id) >= names_.size()) return empty;
+    return names_[static_cast<std::size_t>(id)];
+}
+
+std::size_t SymbolInterner::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
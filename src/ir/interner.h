@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// ---------------------------------------------------------------
+// SymbolId — compact integer handle for an interned IR name
+//
+// Temps ("t0", "t1", ...), source variables, block labels and
+// string literal payloads are interned once when the operand is
+// created.  Passes compare and hash the integer id; the original
+// spelling is only looked up when printing.
+// ---------------------------------------------------------------
+using SymbolId = std::int32_t;
+
+constexpr SymbolId kNoSymbol = -1;
+
+// ---------------------------------------------------------------
+// SymbolInterner — process-wide string ↔ id table
+//
+// Ids are dense and never reused, so they can index side tables.
+// Interning is thread-safe; returned name references stay valid
+// for the lifetime of the process (storage is a std::deque).  The
+// index is keyed by views into that storage, so looking up a name
+// that is already interned does not allocate.
+// ---------------------------------------------------------------
+class SymbolInterner {
+public:
+    static SymbolInterner& instance();
+
+    /// Return the id for `name`, creating it on first use.
+    SymbolId intern(std::string_view name);
+
+    /// Return the id for `name`, or kNoSymbol if it was never interned.
+    SymbolId lookup(std::string_view name) const;
+
+    /// Spelling of an interned id ("" for kNoSymbol).
+    const std::string& name(SymbolId id) const;
+
+    /// Number of interned symbols.
+    std::size_t size() const;
+
+private:
+    SymbolInterner() = default;
+
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, SymbolId> ids_;
+};
+
+inline SymbolId intern_symbol(std::string_view name) {
+    return SymbolInterner::instance().intern(name);
+}
+
+inline const std::string& symbol_name(SymbolId id) {
+    return SymbolInterner::instance().name(id);
+}
@@ -0,0 +1,968 @@
+#include "ir/interpreter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <map>
+#include <memory>
+
+#include <dlfcn.h>
+
+// Direct threading (computed goto) where the compiler supports it,
+// a switch loop otherwise.
+#if defined(__GNUC__)
+#define IR_INTERP_THREADED 1
+#else
+#define IR_INTERP_THREADED 0
+#endif
+
+namespace {
+
+constexpr int kMaxArgs = 32;                    // PARAM indices per call
+constexpr std::size_t kStackCells = 1u << 20;   // 8 MB of frames
+constexpr int kMaxIntRegs = 6;                  // System V, for dlsym calls
+constexpr int kMaxFloatRegs = 8;
+
+inline std::int32_t as_int(std::int64_t cell) { return static_cast<std::int32_t>(cell); }
+
+// 32-bit results are kept sign-extended in their 64-bit cell
+inline std::int64_t wrap32(std::uint32_t value) { return static_cast<std::int32_t>(value); }
+
+inline double as_float(std::int64_t cell) {
+    double d;
+    std::memcpy(&d, &cell, sizeof d);
+    return d;
+}
+
+inline std::int64_t float_bits(double d) {
+    std::int64_t cell;
+    std::memcpy(&cell, &d, sizeof cell);
+    return cell;
+}
+
+inline char* as_pointer(std::int64_t cell) {
+    return reinterpret_cast<char*>(static_cast<std::intptr_t>(cell));
+}
+
+// cvttsd2si: NaN and out-of-range values give INT_MIN
+inline std::int64_t truncate_float(double d) {
+    if (!(d > -2147483649.0 && d < 2147483648.0)) return INT32_MIN;
+    return static_cast<std::int32_t>(d);
+}
+
+template <typename T>
+void append_formatted(std::string& out, const std::string& spec, T value) {
+    char buffer[128];
+    int n = std::snprintf(buffer, sizeof buffer, spec.c_str(), value);
+    if (n < 0) return;
+    if (static_cast<std::size_t>(n) < sizeof buffer) {
+        out.append(buffer, static_cast<std::size_t>(n));
+        return;
+    }
+    std::vector<char> large(static_cast<std::size_t>(n) + 1);
+    std::snprintf(large.data(), large.size(), spec.c_str(), value);
+    out.append(large.data(), static_cast<std::size_t>(n));
+}
+
+} // namespace
+
+IRInterpreter::IRInterpreter(const IRProgram& program) : program_(program) {}
+
+IRInterpreter::~IRInterpreter() {
+    for (void* p : allocations_) std::free(p);
+}
+
+void IRInterpreter::set_input(const std::string& input) {
+    own_input_ = input;
+    input_ = &own_input_;
+    input_source_ = nullptr;
+    input_pos_ = 0;
+    has_input_ = true;
+}
+
+void IRInterpreter::set_input(std::string* buffer, std::istream* source) {
+    input_ = buffer;
+    input_source_ = source;
+    input_pos_ = 0;
+    has_input_ = true;
+}
+
+bool IRInterpreter::run(const std::string& entry) {
+    errors_.clear();
+    output_.clear();
+    exit_code_ = 0;
+    halted_ = false;
+    branches_ = 0;
+    input_pos_ = 0;
+
+    if (!lower_program()) return false;
+    auto it = function_index_.find(entry);
+    if (it == function_index_.end()) {
+        errors_.push_back("entry function '" + entry + "' is not defined");
+        return false;
+    }
+    bool ok = execute(it->second);
+    for (void* p : allocations_) std::free(p);
+    allocations_.clear();
+    return ok;
+}
+
+// ===============================================================
+//  Lowering
+// ===============================================================
+
+bool IRInterpreter::lower_program() {
+    functions_.clear();
+    function_index_.clear();
+    externs_.clear();
+    extern_index_.clear();
+    copies_.clear();
+
+    for (const auto& func : program_.functions) {
+        if (func.blocks.empty()) continue;
+        function_index_[func.name] = static_cast<int>(functions_.size());
+        functions_.emplace_back();
+    }
+    bool ok = true;
+    for (const auto& func : program_.functions) {
+        if (func.blocks.empty()) continue;
+        ok = lower_function(func, functions_[function_index_[func.name]]) && ok;
+    }
+    return ok;
+}
+
+int IRInterpreter::extern_for(const std::string& name) {
+    auto it = extern_index_.find(name);
+    if (it != extern_index_.end()) return it->second;
+
+    Extern ext;
+    ext.name = name;
+    if (name == "printf")            ext.kind = ExternKind::Printf;
+    else if (name == "print_int")    ext.kind = ExternKind::PrintInt;
+    else if (name == "print_string") ext.kind = ExternKind::PrintString;
+    else if (name == "read_int")     ext.kind = ExternKind::ReadInt;
+    else if (name == "exit_program") ext.kind = ExternKind::ExitProgram;
+    else {
+        ext.address = dlsym(RTLD_DEFAULT, name.c_str());
+        if (!ext.address) return -1;
+    }
+    if (const IRFunction* decl = program_.find_function(name)) {
+        ext.return_type = ir_type_from_name(decl->return_type);
+    }
+
+    int index = static_cast<int>(externs_.size());
+    externs_.push_back(std::move(ext));
+    extern_index_[name] = index;
+    return index;
+}
+
+// ---------------------------------------------------------------
+// lower_function — IRFunction → flat code
+//
+// Slots: parameters first (in declaration order), then every temp
+// and variable of the body, then the constant pool.  Jumps are
+// resolved once all blocks are placed; an edge into a block with
+// PHIs goes through a stub (PCOPY + JMP) appended after the body.
+// ---------------------------------------------------------------
+bool IRInterpreter::lower_function(const IRFunction& func, Function& out) {
+    out = Function{};
+    out.name = func.name;
+    auto fail = [&](const std::string& message) {
+        errors_.push_back("function " + func.name + ": " + message);
+        return false;
+    };
+
+    std::unordered_map<SymbolId, int> temp_slots;
+    std::unordered_map<SymbolId, int> var_slots;
+    int next_slot = 0;
+    for (const auto& param : func.params) {
+        var_slots[intern_symbol(param.first)] = next_slot++;
+    }
+    out.num_params = next_slot;
+
+    auto assign = [&](const Operand& op) {
+        if (op.kind == OperandKind::Temp) {
+            if (temp_slots.emplace(op.id, next_slot).second)
+                next_slot += std::max(1, vector_lanes(op.type));
+        } else if (op.kind == OperandKind::Variable) {
+            if (var_slots.emplace(op.id, next_slot).second) ++next_slot;
+        }
+    };
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            assign(instr.dest);
+            for (const auto& src : instr.srcs) assign(src);
+        }
+    }
+    out.const_base = next_slot;
+
+    std::map<std::int64_t, int> constant_slots;
+    auto constant = [&](std::int64_t value) {
+        auto it = constant_slots.find(value);
+        if (it != constant_slots.end()) return it->second;
+        int slot = out.const_base + static_cast<int>(out.constants.size());
+        out.constants.push_back(value);
+        constant_slots.emplace(value, slot);
+        return slot;
+    };
+    // float_context: int literals are read as doubles (load_float)
+    auto slot = [&](const Operand& op, bool float_context = false) -> std::int32_t {
+        switch (op.kind) {
+            case OperandKind::Temp:         return temp_slots.at(op.id);
+            case OperandKind::Variable:     return var_slots.at(op.id);
+            case OperandKind::IntLiteral:
+            case OperandKind::BoolLiteral:
+                return constant(float_context ? float_bits(op.int_val) : op.int_val);
+            case OperandKind::FloatLiteral: return constant(float_bits(op.float_val));
+            case OperandKind::StringLiteral:
+                return constant(static_cast<std::int64_t>(
+                    reinterpret_cast<std::intptr_t>(op.name().c_str())));
+            case OperandKind::Label:
+            case OperandKind::None:         break;
+        }
+        return constant(0);
+    };
+
+    std::unordered_map<std::string, int> block_index;
+    std::vector<std::vector<const IRInstruction*>> phis(func.blocks.size());
+    for (std::size_t b = 0; b < func.blocks.size(); ++b) {
+        block_index[func.blocks[b].label] = static_cast<int>(b);
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (instr.opcode == IROpcode::PHI) phis[b].push_back(&instr);
+        }
+    }
+
+    struct Fixup { std::size_t insn; int pred; int target; };
+    std::vector<Fixup> fixups;
+    std::vector<std::int32_t> block_pc(func.blocks.size(), 0);
+    auto emit = [&](Op op, std::int32_t a = 0, std::int32_t b = 0, std::int32_t c = 0,
+                    std::int32_t d = 0) {
+        Insn insn;
+        insn.op = op;
+        insn.a = a;
+        insn.b = b;
+        insn.c = c;
+        insn.d = d;
+        out.code.push_back(insn);
+    };
+    auto jump = [&](Op op, int pred, const Operand& label, std::int32_t cond) -> bool {
+        auto it = block_index.find(label.name());
+        if (it == block_index.end()) return fail("jump to unknown label " + label.name());
+        fixups.push_back({out.code.size(), pred, it->second});
+        emit(op, 0, cond);
+        return true;
+    };
+
+    bool float_param[kMaxArgs] = {};
+    for (std::size_t b = 0; b < func.blocks.size(); ++b) {
+        const BasicBlock& block = func.blocks[b];
+        block_pc[b] = static_cast<std::int32_t>(out.code.size());
+        const int pred = static_cast<int>(b);
+
+        for (std::size_t i = 0; i < block.instructions.size(); ++i) {
+            const IRInstruction& instr = block.instructions[i];
+            const auto& s = instr.srcs;
+            switch (instr.opcode) {
+                case IROpcode::ADD: case IROpcode::SUB: case IROpcode::MUL:
+                case IROpcode::DIV: case IROpcode::MOD:
+                case IROpcode::AND: case IROpcode::OR: case IROpcode::XOR: {
+                    Op op;
+                    bool fl = instr.dest.type == IRType::Float;
+                    if (fl) {
+                        op = instr.opcode == IROpcode::SUB ? Op::SUB_F
+                           : instr.opcode == IROpcode::MUL ? Op::MUL_F
+                           : instr.opcode == IROpcode::DIV ? Op::DIV_F : Op::ADD_F;
+                    } else if (is_wide(instr.dest.type) && (instr.opcode == IROpcode::ADD ||
+                               instr.opcode == IROpcode::SUB || instr.opcode == IROpcode::MUL)) {
+                        op = instr.opcode == IROpcode::ADD ? Op::ADD_L
+                           : instr.opcode == IROpcode::SUB ? Op::SUB_L : Op::MUL_L;
+                    } else {
+                        switch (instr.opcode) {
+                            case IROpcode::SUB: op = Op::SUB_I; break;
+                            case IROpcode::MUL: op = Op::MUL_I; break;
+                            case IROpcode::DIV: op = Op::DIV_I; break;
+                            case IROpcode::MOD: op = Op::MOD_I; break;
+                            case IROpcode::AND: op = Op::AND_I; break;
+                            case IROpcode::OR:  op = Op::OR_I;  break;
+                            case IROpcode::XOR: op = Op::XOR_I; break;
+                            default:            op = Op::ADD_I; break;
+                        }
+                    }
+                    emit(op, slot(instr.dest), slot(s[0], fl), slot(s[1], fl));
+                    break;
+                }
+
+                case IROpcode::NEG:
+                    emit(instr.dest.type == IRType::Float ? Op::NEG_F : Op::NEG_I,
+                         slot(instr.dest), slot(s[0]));
+                    break;
+                case IROpcode::NOT:
+                    emit(Op::NOT, slot(instr.dest), slot(s[0]));
+                    break;
+
+                case IROpcode::CMP_EQ: case IROpcode::CMP_NE:
+                case IROpcode::CMP_LT: case IROpcode::CMP_LE:
+                case IROpcode::CMP_GT: case IROpcode::CMP_GE: {
+                    static const Op int_ops[] = {Op::EQ_I, Op::NE_I, Op::LT_I, Op::LE_I, Op::GT_I, Op::GE_I};
+                    static const Op long_ops[] = {Op::EQ_L, Op::NE_L, Op::LT_L, Op::LE_L, Op::GT_L, Op::GE_L};
+                    static const Op float_ops[] = {Op::EQ_F, Op::NE_F, Op::LT_F, Op::LE_F, Op::GT_F, Op::GE_F};
+                    int k = static_cast<int>(instr.opcode) - static_cast<int>(IROpcode::CMP_EQ);
+                    bool fl = s[0].type == IRType::Float || s[1].type == IRType::Float;
+                    Op op = fl ? float_ops[k]
+                          : (is_wide(s[0].type) || is_wide(s[1].type)) ? long_ops[k] : int_ops[k];
+                    emit(op, slot(instr.dest), slot(s[0], fl), slot(s[1], fl));
+                    break;
+                }
+
+                case IROpcode::INT_TO_FLOAT:
+                    emit(is_wide(s[0].type) ? Op::L2F : Op::I2F, slot(instr.dest), slot(s[0]));
+                    break;
+                case IROpcode::FLOAT_TO_INT:
+                    emit(Op::F2I, slot(instr.dest), slot(s[0], true));
+                    break;
+
+                case IROpcode::MOVE:
+                    emit(Op::MOV, slot(instr.dest), slot(s[0]));
+                    break;
+
+                case IROpcode::ALLOCA:
+                    emit(Op::ALLOCA, slot(instr.dest), s[0].int_val);
+                    break;
+
+                case IROpcode::LOAD_ELEM: {
+                    bool wide = element_size(instr) == 8;
+                    Op op = is_wide(s[1].type) ? (wide ? Op::LOAD8_L : Op::LOAD4_L)
+                                               : (wide ? Op::LOAD8 : Op::LOAD4);
+                    emit(op, slot(instr.dest), slot(s[0]), slot(s[1]));
+                    break;
+                }
+                case IROpcode::STORE_ELEM: {
+                    bool wide = element_size(instr) == 8;
+                    Op op = is_wide(s[0].type) ? (wide ? Op::STORE8_L : Op::STORE4_L)
+                                               : (wide ? Op::STORE8 : Op::STORE4);
+                    emit(op, slot(instr.dest), slot(s[0]), slot(s[1]));
+                    break;
+                }
+
+                case IROpcode::VEC_LOAD:
+                case IROpcode::VEC_STORE: {
+                    bool load = instr.opcode == IROpcode::VEC_LOAD;
+                    const Operand& index = load ? s[1] : s[0];
+                    if (is_wide(index.type)) return fail("unsupported 64-bit vector index");
+                    if (load) {
+                        emit(Op::VLOAD, slot(instr.dest), slot(s[0]), slot(s[1]),
+                             vector_lanes(instr.dest.type));
+                    } else {
+                        emit(Op::VSTORE, slot(instr.dest), slot(s[0]), slot(s[1]),
+                             vector_lanes(s[1].type));
+                    }
+                    break;
+                }
+                case IROpcode::VEC_SPLAT:
+                    emit(Op::VSPLAT, slot(instr.dest), slot(s[0]), 0, vector_lanes(instr.dest.type));
+                    break;
+                case IROpcode::VEC_ADD: case IROpcode::VEC_SUB: case IROpcode::VEC_MUL: {
+                    Op op = instr.opcode == IROpcode::VEC_ADD ? Op::VADD
+                          : instr.opcode == IROpcode::VEC_SUB ? Op::VSUB : Op::VMUL;
+                    emit(op, slot(instr.dest), slot(s[0]), slot(s[1]), vector_lanes(instr.dest.type));
+                    break;
+                }
+
+                case IROpcode::PARAM: {
+                    int index = instr.dest.int_val;
+                    if (index < 0 || index >= kMaxArgs) return fail("too many call arguments");
+                    float_param[index] = s[0].type == IRType::Float;
+                    emit(Op::PARAM, index, slot(s[0]));
+                    break;
+                }
+
+                case IROpcode::CALL: {
+                    const std::string& callee = s[0].name();
+                    int argc = s[1].int_val;
+                    if (argc > kMaxArgs) return fail("too many call arguments");
+                    std::int32_t dest = instr.dest.is_none() ? -1 : slot(instr.dest);
+                    auto internal = function_index_.find(callee);
+                    if (internal != function_index_.end()) {
+                        emit(Op::CALL, dest, internal->second, argc);
+                        break;
+                    }
+                    std::uint32_t mask = 0;
+                    int float_args = 0;
+                    for (int k = 0; k < argc; ++k) {
+                        if (!float_param[k]) continue;
+                        mask |= 1u << k;
+                        ++float_args;
+                    }
+                    int index = extern_for(callee);
+                    if (index < 0) return fail("undefined function " + callee);
+                    if (externs_[index].kind == ExternKind::Native &&
+                        (argc - float_args > kMaxIntRegs || float_args > kMaxFloatRegs)) {
+                        return fail("too many register arguments for extern " + callee);
+                    }
+                    emit(Op::CALL_EXT, dest, index, argc, static_cast<std::int32_t>(mask));
+                    break;
+                }
+
+                case IROpcode::RETURN:
+                    if (s.empty()) emit(Op::RET_VOID);
+                    else emit(Op::RET, slot(s[0]));
+                    break;
+
+                case IROpcode::JUMP: {
+                    // Fall through into the next block when nothing is copied
+                    auto it = block_index.find(instr.dest.name());
+                    if (i + 1 == block.instructions.size() && it != block_index.end() &&
+                        it->second == pred + 1 && phis[it->second].empty()) {
+                        break;
+                    }
+                    if (!jump(Op::JMP, pred, instr.dest, 0)) return false;
+                    break;
+                }
+                case IROpcode::JUMP_IF:
+                    if (!jump(Op::JNZ, pred, instr.dest, slot(s[0]))) return false;
+                    break;
+                case IROpcode::JUMP_IF_NOT:
+                    if (!jump(Op::JZ, pred, instr.dest, slot(s[0]))) return false;
+                    break;
+
+                case IROpcode::PHI:     // copied on the incoming edges
+                case IROpcode::LABEL:
+                case IROpcode::NOP:
+                    break;
+
+                case IROpcode::LOAD:
+                case IROpcode::STORE:
+                    return fail("unsupported opcode " + opcode_to_string(instr.opcode));
+            }
+        }
+    }
+    emit(Op::RET_VOID);     // the last block may fall off the end
+
+    // ---- edge stubs and jump targets ----
+    std::map<std::pair<int, int>, std::int32_t> stubs;
+    for (std::size_t f = 0; f < fixups.size(); ++f) {
+        const Fixup fix = fixups[f];
+        std::int32_t target = block_pc[fix.target];
+        if (fix.pred >= 0 && !phis[fix.target].empty()) {
+            auto key = std::make_pair(fix.pred, fix.target);
+            auto it = stubs.find(key);
+            if (it == stubs.end()) {
+                const std::string& pred_label = func.blocks[fix.pred].label;
+                auto first = static_cast<std::int32_t>(copies_.size());
+                for (const IRInstruction* phi : phis[fix.target]) {
+                    for (std::size_t k = 0; k + 1 < phi->srcs.size(); k += 2) {
+                        if (phi->srcs[k + 1].name() != pred_label) continue;
+                        copies_.push_back({slot(phi->dest), slot(phi->srcs[k])});
+                        break;
+                    }
+                }
+                auto stub = static_cast<std::int32_t>(out.code.size());
+                auto count = static_cast<std::int32_t>(copies_.size()) - first;
+                if (count > 0) emit(Op::PCOPY, first, count);
+                fixups.push_back({out.code.size(), -1, fix.target});
+                emit(Op::JMP);
+                it = stubs.emplace(key, stub).first;
+            }
+            target = it->second;
+        }
+        out.code[fix.insn].a = target;
+    }
+
+    out.frame_size = out.const_base + static_cast<int>(out.constants.size());
+    return true;
+}
+
+// ===============================================================
+//  Execution
+// ===============================================================
+
+// ---------------------------------------------------------------
+// execute — the dispatch loop
+//
+// fp points at the current frame; a call places the callee's frame
+// right after it and pushes a return record.  Taken branches and
+// calls count against the branch limit.
+// ---------------------------------------------------------------
+#if IR_INTERP_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+bool IRInterpreter::execute(int entry) {
+#if IR_INTERP_THREADED
+    static const void* const handlers[] = {
+#define IR_INTERP_LABEL(name) &&op_##name,
+        IR_INTERP_OPS(IR_INTERP_LABEL)
+#undef IR_INTERP_LABEL
+    };
+    for (auto& func : functions_) {
+        for (auto& insn : func.code) insn.handler = handlers[static_cast<int>(insn.op)];
+    }
+#define HANDLER(name) op_##name:
+#define DISPATCH() goto *pc->handler
+#else
+#define HANDLER(name) case Op::name:
+#define DISPATCH() goto dispatch
+#endif
+#define NEXT() do { ++pc; DISPATCH(); } while (0)
+
+    std::size_t max_copies = 1;
+    for (const auto& func : functions_) {
+        for (const auto& insn : func.code) {
+            if (insn.op == Op::PCOPY) max_copies = std::max(max_copies, static_cast<std::size_t>(insn.b));
+        }
+    }
+    std::vector<std::int64_t> scratch(max_copies);
+
+    std::unique_ptr<std::int64_t[]> stack(new std::int64_t[kStackCells]);
+    std::int64_t* const stack_end = stack.get() + kStackCells;
+
+    struct Return {
+        const Function* func;
+        const Insn* pc;
+        std::int64_t* fp;
+        std::int32_t dest;
+    };
+    std::vector<Return> frames;
+    std::int64_t args[kMaxArgs] = {};
+    const std::uint64_t fuel_start = branch_limit_ ? branch_limit_ : UINT64_MAX;
+    std::uint64_t fuel = fuel_start;
+    std::string fault;
+
+    auto enter = [&](const Function& f, std::int64_t* frame, int argc) {
+        for (int k = 0; k < f.num_params; ++k) frame[k] = k < argc ? args[k] : 0;
+        std::fill(frame + f.num_params, frame + f.const_base, 0);
+        std::copy(f.constants.begin(), f.constants.end(), frame + f.const_base);
+    };
+
+    const Function* fn = &functions_[entry];
+    std::int64_t* fp = stack.get();
+    if (fp + fn->frame_size > stack_end) {
+        errors_.push_back("runtime error: stack overflow");
+        return false;
+    }
+    enter(*fn, fp, 0);
+    const Insn* pc = fn->code.data();
+    std::int64_t value = 0;
+
+#define BINARY(name, expr)                                                  \
+    HANDLER(name) {                                                         \
+        const std::int64_t x = fp[pc->b], y = fp[pc->c];                    \
+        fp[pc->a] = (expr);                                                 \
+        NEXT();                                                             \
+    }
+#define U32(v) static_cast<std::uint32_t>(v)
+#define U64(v) static_cast<std::uint64_t>(v)
+
+#if !IR_INTERP_THREADED
+dispatch:
+    switch (pc->op) {
+#else
+    DISPATCH();
+#endif
+    HANDLER(MOV) { fp[pc->a] = fp[pc->b]; NEXT(); }
+
+    BINARY(ADD_I, wrap32(U32(x) + U32(y)))
+    BINARY(SUB_I, wrap32(U32(x) - U32(y)))
+    BINARY(MUL_I, wrap32(U32(x) * U32(y)))
+    BINARY(AND_I, wrap32(U32(x) & U32(y)))
+    BINARY(OR_I,  wrap32(U32(x) | U32(y)))
+    BINARY(XOR_I, wrap32(U32(x) ^ U32(y)))
+    HANDLER(DIV_I) HANDLER(MOD_I) {
+        const std::int32_t x = as_int(fp[pc->b]), y = as_int(fp[pc->c]);
+        if (y == 0) { fault = "division by zero"; goto failed; }
+        if (x == INT32_MIN && y == -1) { fault = "integer overflow in division"; goto failed; }
+        fp[pc->a] = pc->op == Op::DIV_I ? x / y : x % y;
+        NEXT();
+    }
+
+    BINARY(ADD_L, static_cast<std::int64_t>(U64(x) + U64(y)))
+    BINARY(SUB_L, static_cast<std::int64_t>(U64(x) - U64(y)))
+    BINARY(MUL_L, static_cast<std::int64_t>(U64(x) * U64(y)))
+
+    BINARY(ADD_F, float_bits(as_float(x) + as_float(y)))
+    BINARY(SUB_F, float_bits(as_float(x) - as_float(y)))
+    BINARY(MUL_F, float_bits(as_float(x) * as_float(y)))
+    BINARY(DIV_F, float_bits(as_float(x) / as_float(y)))
+
+    HANDLER(NEG_I) { fp[pc->a] = wrap32(0u - U32(fp[pc->b])); NEXT(); }
+    HANDLER(NEG_F) { fp[pc->a] = static_cast<std::int64_t>(U64(fp[pc->b]) ^ (U64(1) << 63)); NEXT(); }
+    HANDLER(NOT)   { fp[pc->a] = as_int(fp[pc->b]) == 0; NEXT(); }
+
+    BINARY(EQ_I, as_int(x) == as_int(y))
+    BINARY(NE_I, as_int(x) != as_int(y))
+    BINARY(LT_I, as_int(x) <  as_int(y))
+    BINARY(LE_I, as_int(x) <= as_int(y))
+    BINARY(GT_I, as_int(x) >  as_int(y))
+    BINARY(GE_I, as_int(x) >= as_int(y))
+    BINARY(EQ_L, x == y)
+    BINARY(NE_L, x != y)
+    BINARY(LT_L, x <  y)
+    BINARY(LE_L, x <= y)
+    BINARY(GT_L, x >  y)
+    BINARY(GE_L, x >= y)
+    BINARY(EQ_F, as_float(x) == as_float(y))
+    BINARY(NE_F, as_float(x) != as_float(y))
+    BINARY(LT_F, as_float(x) <  as_float(y))
+    BINARY(LE_F, as_float(x) <= as_float(y))
+    BINARY(GT_F, as_float(x) >  as_float(y))
+    BINARY(GE_F, as_float(x) >= as_float(y))
+
+    HANDLER(I2F) { fp[pc->a] = float_bits(as_int(fp[pc->b])); NEXT(); }
+    HANDLER(L2F) { fp[pc->a] = float_bits(static_cast<double>(fp[pc->b])); NEXT(); }
+    HANDLER(F2I) { fp[pc->a] = truncate_float(as_float(fp[pc->b])); NEXT(); }
+
+    // Element address: base + index * size; a 32-bit index is sign-extended
+    HANDLER(LOAD4) {
+        std::int32_t v;
+        std::memcpy(&v, as_pointer(fp[pc->b]) + as_int(fp[pc->c]) * std::int64_t{4}, 4);
+        fp[pc->a] = v;
+        NEXT();
+    }
+    HANDLER(LOAD8) {
+        std::memcpy(&fp[pc->a], as_pointer(fp[pc->b]) + as_int(fp[pc->c]) * std::int64_t{8}, 8);
+        NEXT();
+    }
+    HANDLER(LOAD4_L) {
+        std::int32_t v;
+        std::memcpy(&v, as_pointer(fp[pc->b]) + fp[pc->c] * 4, 4);
+        fp[pc->a] = v;
+        NEXT();
+    }
+    HANDLER(LOAD8_L) {
+        std::memcpy(&fp[pc->a], as_pointer(fp[pc->b]) + fp[pc->c] * 8, 8);
+        NEXT();
+    }
+    HANDLER(STORE4) {
+        const std::int32_t v = as_int(fp[pc->c]);
+        std::memcpy(as_pointer(fp[pc->a]) + as_int(fp[pc->b]) * std::int64_t{4}, &v, 4);
+        NEXT();
+    }
+    HANDLER(STORE8) {
+        std::memcpy(as_pointer(fp[pc->a]) + as_int(fp[pc->b]) * std::int64_t{8}, &fp[pc->c], 8);
+        NEXT();
+    }
+    HANDLER(STORE4_L) {
+        const std::int32_t v = as_int(fp[pc->c]);
+        std::memcpy(as_pointer(fp[pc->a]) + fp[pc->b] * 4, &v, 4);
+        NEXT();
+    }
+    HANDLER(STORE8_L) {
+        std::memcpy(as_pointer(fp[pc->a]) + fp[pc->b] * 8, &fp[pc->c], 8);
+        NEXT();
+    }
+
+    // Vectors: lane k in cell slot + k; d = lane count
+    HANDLER(VLOAD) {
+        const char* p = as_pointer(fp[pc->b]) + as_int(fp[pc->c]) * std::int64_t{4};
+        for (int k = 0; k < pc->d; ++k) {
+            std::int32_t v;
+            std::memcpy(&v, p + 4 * k, 4);
+            fp[pc->a + k] = v;
+        }
+        NEXT();
+    }
+    HANDLER(VSTORE) {
+        char* p = as_pointer(fp[pc->a]) + as_int(fp[pc->b]) * std::int64_t{4};
+        for (int k = 0; k < pc->d; ++k) {
+            const std::int32_t v = as_int(fp[pc->c + k]);
+            std::memcpy(p + 4 * k, &v, 4);
+        }
+        NEXT();
+    }
+    HANDLER(VSPLAT) {
+        const std::int64_t v = as_int(fp[pc->b]);
+        for (int k = 0; k < pc->d; ++k) fp[pc->a + k] = v;
+        NEXT();
+    }
+    HANDLER(VADD) {
+        for (int k = 0; k < pc->d; ++k) fp[pc->a + k] = wrap32(U32(fp[pc->b + k]) + U32(fp[pc->c + k]));
+        NEXT();
+    }
+    HANDLER(VSUB) {
+        for (int k = 0; k < pc->d; ++k) fp[pc->a + k] = wrap32(U32(fp[pc->b + k]) - U32(fp[pc->c + k]));
+        NEXT();
+    }
+    HANDLER(VMUL) {
+        for (int k = 0; k < pc->d; ++k) fp[pc->a + k] = wrap32(U32(fp[pc->b + k]) * U32(fp[pc->c + k]));
+        NEXT();
+    }
+
+    HANDLER(ALLOCA) {
+        void* p = std::malloc(static_cast<std::size_t>(pc->b));
+        allocations_.push_back(p);
+        fp[pc->a] = static_cast<std::int64_t>(reinterpret_cast<std::intptr_t>(p));
+        NEXT();
+    }
+
+    HANDLER(PARAM) { args[pc->a] = fp[pc->b]; NEXT(); }
+
+    HANDLER(CALL) {
+        if (--fuel == 0) goto out_of_fuel;
+        const Function& callee = functions_[pc->b];
+        std::int64_t* frame = fp + fn->frame_size;
+        if (frame + callee.frame_size > stack_end) { fault = "stack overflow"; goto failed; }
+        enter(callee, frame, pc->c);
+        frames.push_back({fn, pc + 1, fp, pc->a});
+        fn = &callee;
+        fp = frame;
+        pc = callee.code.data();
+        DISPATCH();
+    }
+
+    HANDLER(CALL_EXT) {
+        std::int64_t result = 0;
+        if (!call_extern(externs_[pc->b], args, pc->c, static_cast<std::uint32_t>(pc->d), result)) {
+            fault = "extern call " + externs_[pc->b].name + " failed";
+            goto failed;
+        }
+        if (halted_) goto finished;
+        if (pc->a >= 0) fp[pc->a] = result;
+        NEXT();
+    }
+
+    HANDLER(RET) { value = fp[pc->a]; goto returned; }
+    HANDLER(RET_VOID) { value = 0; goto returned; }
+
+    HANDLER(JMP) {
+        if (--fuel == 0) goto out_of_fuel;
+        pc = fn->code.data() + pc->a;
+        DISPATCH();
+    }
+    HANDLER(JNZ) {
+        if (as_int(fp[pc->b]) == 0) NEXT();
+        if (--fuel == 0) goto out_of_fuel;
+        pc = fn->code.data() + pc->a;
+        DISPATCH();
+    }
+    HANDLER(JZ) {
+        if (as_int(fp[pc->b]) != 0) NEXT();
+        if (--fuel == 0) goto out_of_fuel;
+        pc = fn->code.data() + pc->a;
+        DISPATCH();
+    }
+
+    HANDLER(PCOPY) {
+        const auto* copy = copies_.data() + pc->a;
+        for (std::int32_t k = 0; k < pc->b; ++k) scratch[k] = fp[copy[k].second];
+        for (std::int32_t k = 0; k < pc->b; ++k) fp[copy[k].first] = scratch[k];
+        NEXT();
+    }
+#if !IR_INTERP_THREADED
+    }
+#endif
+
+returned:
+    if (!frames.empty()) {
+        const Return ret = frames.back();
+        frames.pop_back();
+        fn = ret.func;
+        fp = ret.fp;
+        pc = ret.pc;
+        if (ret.dest >= 0) fp[ret.dest] = value;
+        DISPATCH();
+    }
+    exit_code_ = as_int(value);
+
+finished:
+    branches_ = fuel_start - fuel;
+    return true;
+
+out_of_fuel:
+    fault = "branch limit exceeded";
+failed:
+    branches_ = fuel_start - fuel;
+    errors_.push_back("runtime error in " + fn->name + ": " + fault);
+    return false;
+
+#undef U64
+#undef U32
+#undef BINARY
+#undef NEXT
+#undef DISPATCH
+#undef HANDLER
+}
+#if IR_INTERP_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+// ===============================================================
+//  Extern shim
+// ===============================================================
+
+void IRInterpreter::write(const std::string& text) {
+    if (capture_) {
+        output_ += text;
+    } else {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+    }
+}
+
+int IRInterpreter::read_int() {
+    if (!has_input_) {
+        int value = 0;
+        if (std::scanf("%d", &value) != 1) return 0;
+        return value;
+    }
+    std::string& text = *input_;
+    // Buffered text exhausted: pull the next word from the source
+    if (input_source_ && text.find_first_not_of(" \t\r\n", input_pos_) == std::string::npos) {
+        std::string word;
+        if (*input_source_ >> word) {
+            text += ' ';
+            text += word;
+        }
+    }
+    const char* begin = text.c_str() + input_pos_;
+    char* end = nullptr;
+    long value = std::strtol(begin, &end, 10);
+    if (end == begin) return 0;
+    input_pos_ += static_cast<std::size_t>(end - begin);
+    return static_cast<int>(value);
+}
+
+// ---------------------------------------------------------------
+// format_printf — printf with the System V argument classes
+//
+// Integer conversions take the next non-float argument and %f/%e/%g
+// the next float one, exactly as va_arg reads them from the integer
+// and SSE register files in the native program.
+// ---------------------------------------------------------------
+std::string IRInterpreter::format_printf(const std::int64_t* args, int argc,
+                                         std::uint32_t float_mask) {
+    std::string out;
+    if (argc < 1 || !args[0]) return out;
+    const char* fmt = as_pointer(args[0]);
+    int next_int = 1, next_float = 1;
+    auto take = [&](bool fl) -> std::int64_t {
+        int& k = fl ? next_float : next_int;
+        while (k < argc && (((float_mask >> k) & 1u) != 0) != fl) ++k;
+        return k < argc ? args[k++] : 0;
+    };
+
+    for (const char* p = fmt; *p; ++p) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        const char* start = p++;
+        std::string spec = "%";
+        while (*p && std::strchr("-+ #0", *p)) spec += *p++;
+        auto number = [&]() {
+            if (*p == '*') {
+                spec += std::to_string(as_int(take(false)));
+                ++p;
+            }
+            while (*p >= '0' && *p <= '9') spec += *p++;
+        };
+        number();
+        if (*p == '.') {
+            spec += *p++;
+            number();
+        }
+        std::string length;
+        while (*p && std::strchr("hlLqjzt", *p)) length += *p++;
+        const char conv = *p;
+        if (!conv) {
+            out.append(start);
+            break;
+        }
+        const bool long_arg = length.find_first_of("lqjzt") != std::string::npos;
+        switch (conv) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': {
+                std::int64_t v = take(false);
+                if (long_arg) {
+                    append_formatted(out, spec + "ll" + conv, static_cast<long long>(v));
+                } else {
+                    append_formatted(out, spec + length + conv, static_cast<int>(as_int(v)));
+                }
+                break;
+            }
+            case 'c':
+                append_formatted(out, spec + conv, static_cast<int>(as_int(take(false))));
+                break;
+            case 'f': case 'F': case 'e': case 'E':
+            case 'g': case 'G': case 'a': case 'A':
+                append_formatted(out, spec + conv, as_float(take(true)));
+                break;
+            case 's': {
+                const char* s = as_pointer(take(false));
+                append_formatted(out, spec + conv, s ? s : "(null)");
+                break;
+            }
+            case 'p':
+                append_formatted(out, spec + conv, static_cast<void*>(as_pointer(take(false))));
+                break;
+            case '%':
+                out += '%';
+                break;
+            case 'n':
+                take(false);
+                break;
+            default:
+                out.append(start, static_cast<std::size_t>(p - start + 1));
+                break;
+        }
+    }
+    return out;
+}
+
+bool IRInterpreter::call_extern(const Extern& ext, const std::int64_t* args, int argc,
+                                std::uint32_t float_mask, std::int64_t& result) {
+    switch (ext.kind) {
+        case ExternKind::Printf: {
+            std::string text = format_printf(args, argc, float_mask);
+            write(text);
+            result = static_cast<std::int64_t>(text.size());
+            return true;
+        }
+        case ExternKind::PrintInt:
+            write(std::to_string(argc > 0 ? as_int(args[0]) : 0));
+            return true;
+        case ExternKind::PrintString:
+            if (argc > 0 && args[0]) write(as_pointer(args[0]));
+            return true;
+        case ExternKind::ReadInt:
+            result = read_int();
+            return true;
+        case ExternKind::ExitProgram:
+            exit_code_ = argc > 0 ? as_int(args[0]) : 0;
+            halted_ = true;
+            return true;
+        case ExternKind::Native:
+            break;
+    }
+
+    // Any other extern: up to 6 integer and 8 float arguments, passed
+    // to a variadic prototype so the doubles land in xmm0–xmm7
+    std::int64_t ints[kMaxIntRegs] = {};
+    double floats[kMaxFloatRegs] = {};
+    int n_int = 0, n_float = 0;
+    for (int k = 0; k < argc; ++k) {
+        if ((float_mask >> k) & 1u) {
+            if (n_float == kMaxFloatRegs) return false;
+            floats[n_float++] = as_float(args[k]);
+        } else {
+            if (n_int == kMaxIntRegs) return false;
+            ints[n_int++] = args[k];
+        }
+    }
+    std::fflush(stdout);
+    if (ext.return_type == IRType::Float) {
+        using Fn = double (*)(std::int64_t, std::int64_t, std::int64_t, std::int64_t,
+                              std::int64_t, std::int64_t, ...);
+        double r = reinterpret_cast<Fn>(ext.address)(
+            ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], floats[0], floats[1],
+            floats[2], floats[3], floats[4], floats[5], floats[6], floats[7]);
+        result = float_bits(r);
+    } else {
+        using Fn = std::int64_t (*)(std::int64_t, std::int64_t, std::int64_t, std::int64_t,
+                                    std::int64_t, std::int64_t, ...);
+        result = reinterpret_cast<Fn>(ext.address)(
+            ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], floats[0], floats[1],
+            floats[2], floats[3], floats[4], floats[5], floats[6], floats[7]);
+        if (!is_wide(ext.return_type)) result = as_int(result);
+    }
+    return true;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ir/basic_block.h"
+
+// ---------------------------------------------------------------
+// IRInterpreter — runs an IRProgram without an assembler
+//
+// Every function with a body is lowered once into a flat bytecode
+// array.  Operands are resolved to frame slots at lowering time:
+// a frame is [params | temps and variables | constants], and the
+// constants are copied in on each call, so every instruction reads
+// and writes fp[slot] with no operand decoding.  Opcodes are split
+// by value type (ADD_I / ADD_L / ADD_F, ...), following the x86
+// generator: ints are 32-bit, Long and array pointers 64-bit,
+// floats are double bit patterns in the same 64-bit cell.  A vector
+// (IntX4 / IntX8) takes one cell per lane.
+//
+// PHIs become parallel copies on the incoming edges, so the IR can
+// be run in SSA form (between optimizer passes) as well as after
+// destruct_ssa.  Calls use an explicit frame stack; extern calls go
+// to a small shim (printf, print_int, print_string, read_int,
+// exit_program) or, for anything else, through dlsym.
+//
+// Runtime faults (division by zero, stack overflow, branch limit)
+// stop the run and are reported through errors().
+// ---------------------------------------------------------------
+class IRInterpreter {
+public:
+    explicit IRInterpreter(const IRProgram& program);
+    ~IRInterpreter();
+    IRInterpreter(const IRInterpreter&) = delete;
+    IRInterpreter& operator=(const IRInterpreter&) = delete;
+
+    /// Collect program output in output() instead of writing stdout.
+    void set_capture_output(bool enable) { capture_ = enable; }
+
+    /// Serve read_int from `input` instead of stdin.
+    void set_input(const std::string& input);
+
+    /// Serve read_int from `*buffer`, appending the next word of
+    /// `source` when the buffered text runs out.  Interpreters sharing
+    /// one buffer replay the same input, and `source` is read only as
+    /// far as a program asks for it.
+    void set_input(std::string* buffer, std::istream* source);
+
+    /// Stop after `limit` executed branches and calls (0 = no limit).
+    void set_branch_limit(std::uint64_t limit) { branch_limit_ = limit; }
+
+    /// Lower the program and call `entry`; false on a lowering or
+    /// runtime error.
+    bool run(const std::string& entry = "main");
+
+    /// Return value of the entry function (or the exit_program code).
+    int exit_code() const { return exit_code_; }
+
+    const std::string& output() const { return output_; }
+    std::uint64_t branches_executed() const { return branches_; }
+    const std::vector<std::string>& errors() const { return errors_; }
+
+private:
+    // Instruction set of the lowered code (X-macro: enum + dispatch table)
+#define IR_INTERP_OPS(X)                                                   \
+    X(MOV)                                                                 \
+    X(ADD_I) X(SUB_I) X(MUL_I) X(DIV_I) X(MOD_I)                           \
+    X(AND_I) X(OR_I) X(XOR_I)                                              \
+    X(ADD_L) X(SUB_L) X(MUL_L)                                             \
+    X(ADD_F) X(SUB_F) X(MUL_F) X(DIV_F)                                    \
+    X(NEG_I) X(NEG_F) X(NOT)                                               \
+    X(EQ_I) X(NE_I) X(LT_I) X(LE_I) X(GT_I) X(GE_I)                        \
+    X(EQ_L) X(NE_L) X(LT_L) X(LE_L) X(GT_L) X(GE_L)                        \
+    X(EQ_F) X(NE_F) X(LT_F) X(LE_F) X(GT_F) X(GE_F)                        \
+    X(I2F) X(L2F) X(F2I)                                                   \
+    X(LOAD4) X(LOAD8) X(LOAD4_L) X(LOAD8_L)                                \
+    X(STORE4) X(STORE8) X(STORE4_L) X(STORE8_L)                            \
+    X(ALLOCA)                                                              \
+    X(VLOAD) X(VSTORE) X(VSPLAT) X(VADD) X(VSUB) X(VMUL)                   \
+    X(PARAM) X(CALL) X(CALL_EXT) X(RET) X(RET_VOID)                        \
+    X(JMP) X(JNZ) X(JZ) X(PCOPY)
+
+    enum class Op : std::uint8_t {
+#define IR_INTERP_ENUM(name) name,
+        IR_INTERP_OPS(IR_INTERP_ENUM)
+#undef IR_INTERP_ENUM
+    };
+
+    // a = destination slot (or jump target), b/c = source slots,
+    // d = extra immediate (float-argument mask of a call, vector lanes)
+    struct Insn {
+        const void* handler = nullptr;  // threaded dispatch target
+        Op op = Op::MOV;
+        std::int32_t a = 0, b = 0, c = 0, d = 0;
+    };
+
+    struct Function {
+        std::string name;
+        std::vector<Insn> code;
+        std::vector<std::int64_t> constants;    // copied to fp[const_base..]
+        int num_params = 0;
+        int const_base = 0;
+        int frame_size = 0;
+    };
+
+    enum class ExternKind : std::uint8_t {
+        Printf, PrintInt, PrintString, ReadInt, ExitProgram, Native
+    };
+
+    struct Extern {
+        std::string name;
+        ExternKind kind = ExternKind::Native;
+        void* address = nullptr;                // Native: dlsym result
+        IRType return_type = IRType::Int;
+    };
+
+    const IRProgram& program_;
+    std::vector<Function> functions_;
+    std::unordered_map<std::string, int> function_index_;
+    std::vector<Extern> externs_;
+    std::unordered_map<std::string, int> extern_index_;
+    std::vector<std::pair<std::int32_t, std::int32_t>> copies_;    // PCOPY (dst, src)
+
+    bool capture_ = false;
+    bool has_input_ = false;
+    std::string own_input_;
+    std::string* input_ = &own_input_;       // own_input_ or a shared buffer
+    std::istream* input_source_ = nullptr;   // refills *input_ on demand
+    std::size_t input_pos_ = 0;
+    std::uint64_t branch_limit_ = 0;
+
+    int exit_code_ = 0;
+    bool halted_ = false;
+    std::string output_;
+    std::uint64_t branches_ = 0;
+    std::vector<std::string> errors_;
+    std::vector<void*> allocations_;
+
+    bool lower_program();
+    bool lower_function(const IRFunction& func, Function& out);
+    int extern_for(const std::string& name);
+    bool execute(int entry);
+
+    // Extern shim; false on a runtime error
+    bool call_extern(const Extern& ext, const std::int64_t* args, int argc,
+                     std::uint32_t float_mask, std::int64_t& result);
+    void write(const std::string& text);
+    int read_int();
+    std::string format_printf(const std::int64_t* args, int argc, std::uint32_t float_mask);
+};
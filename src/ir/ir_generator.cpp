@@ -1,5 +1,7 @@
 #include "ir/ir_generator.h"
 
+#include "ir/ssa.h"
+
 #include <cassert>
 #include <stdexcept>
 #include <set>
@@ -63,35 +65,6 @@ public:
     }
 };
 
-static bool operands_equal(const Operand& a, const Operand& b) {
-    if (a.kind != b.kind) return false;
-    switch(a.kind) {
-        case OperandKind::Temp:
-        case OperandKind::Variable:
-        case OperandKind::Label:
-        case OperandKind::StringLiteral:
-            return a.name == b.name;
-        case OperandKind::IntLiteral:
-        case OperandKind::BoolLiteral:
-            return a.int_val == b.int_val;
-        case OperandKind::FloatLiteral:
-            return a.float_val == b.float_val;
-        case OperandKind::None:
-            return true;
-    }
-    return false;
-}
-
-static std::unordered_map<std::string, Operand> flatten_scopes(const std::vector<std::unordered_map<std::string, Operand>>& scopes) {
-    std::unordered_map<std::string, Operand> res;
-    for (const auto& s : scopes) {
-        for (const auto& kv : s) {
-            res[kv.first] = kv.second;
-        }
-    }
-    return res;
-}
-
 // ---------------------------------------------------------------
 // Constructor
 // ---------------------------------------------------------------
@@ -108,6 +81,10 @@ const IRFunction* IRGenerator::get_function_ir(const std::string& name) const {
     return program_.find_function(name);
 }
 
+Operand IRGenerator::new_temp(IRType type) {
+    return cur_func_->new_temp(type);
+}
+
 Operand IRGenerator::new_temp(const std::string& type) {
     return cur_func_->new_temp(type);
 }
@@ -170,13 +147,18 @@ void IRGenerator::exit_scope() {
         scope_stack_.pop_back();
 }
 
+Operand IRGenerator::declare_variable(const std::string& name, const std::string& type) {
+    // A name declared again in the same function (sibling or shadowing
+    // scope) is a different variable: spell it "x.1", "x.2", ...
+    int version = var_versions_[name]++;
+    std::string spelling = version == 0 ? name : name + "." + std::to_string(version);
+    Operand var = Operand::var(spelling, type);
+    if (!scope_stack_.empty())
+        scope_stack_.back()[name] = var;
+    return var;
+}
+
 void IRGenerator::bind_variable(const std::string& name, const Operand& operand) {
-    for (int i = static_cast<int>(scope_stack_.size()) - 1; i >= 0; --i) {
-        if (scope_stack_[i].find(name) != scope_stack_[i].end()) {
-            scope_stack_[i][name] = operand;
-            return;
-        }
-    }
     if (!scope_stack_.empty())
         scope_stack_.back()[name] = operand;
 }
@@ -190,11 +172,55 @@ Operand IRGenerator::lookup_variable(const std::string& name) {
     return Operand::var(name); // fallback
 }
 
+Operand IRGenerator::hold(const Operand& value, ASTNode& later) {
+    if (value.kind != OperandKind::Variable) return value;
+
+    AssignedVarCollector collector;
+    later.accept(collector);
+    for (const auto& name : collector.assigned_vars) {
+        if (lookup_variable(name).id != value.id) continue;
+        Operand copy = new_temp(value.type);
+        emit(IRInstruction::make_move(copy, value));
+        return copy;
+    }
+    return value;
+}
+
 std::string IRGenerator::type_string(const std::string& resolved_type) {
     if (resolved_type.empty()) return "int";
     return resolved_type;
 }
 
+Operand IRGenerator::convert(const Operand& value, IRType type) {
+    if (type == IRType::Float && value.type == IRType::Int) {
+        if (value.kind == OperandKind::IntLiteral) return Operand::float_lit(value.int_val);
+        Operand dest = new_temp(IRType::Float);
+        emit(IRInstruction::make_unary(IROpcode::INT_TO_FLOAT, dest, value));
+        return dest;
+    }
+    if (type == IRType::Int && value.type == IRType::Float) {
+        Operand dest = new_temp(IRType::Int);
+        emit(IRInstruction::make_unary(IROpcode::FLOAT_TO_INT, dest, value));
+        return dest;
+    }
+    return value;
+}
+
+void IRGenerator::emit_compound(IROpcode op, const Operand& dest, const Operand& lhs,
+                                const Operand& rhs, int line) {
+    bool in_float = lhs.type == IRType::Float || rhs.type == IRType::Float;
+    IRType type = in_float ? IRType::Float : dest.type;
+    Operand result = (type == dest.type) ? dest : new_temp(type);
+    auto binop = IRInstruction::make_binary(op, result, convert(lhs, type), convert(rhs, type));
+    binop.source_line = line;
+    emit(binop);
+    if (result.id != dest.id) {
+        auto back = IRInstruction::make_unary(IROpcode::FLOAT_TO_INT, dest, result);
+        back.source_line = line;
+        emit(back);
+    }
+}
+
 IROpcode IRGenerator::binary_op_to_opcode(const std::string& op) {
     if (op == "+")  return IROpcode::ADD;
     if (op == "-")  return IROpcode::SUB;
@@ -222,23 +248,22 @@ void IRGenerator::visit(FunctionDeclNode& node) {
     IRFunction& func = program_.add_function(node.name, node.return_type);
     cur_func_ = &func;
 
+    // Array parameters are pointers: typed "int[]" (IRType::Array)
     for (const auto& p : node.parameters)
-        func.params.push_back({p.name, p.type_name});
+        func.params.push_back({p.name, p.is_array ? p.type_name + "[]" : p.type_name});
 
-    if (!node.body) {
+    if (!node.body || (skip_bodies_ && skip_bodies_->count(node.name))) {
         cur_func_ = nullptr;
         return;
     }
 
+    var_versions_.clear();
     enter_scope();
     start_block("entry");
 
-    for (int i = 0; i < static_cast<int>(node.parameters.size()); ++i) {
-        const auto& p = node.parameters[i];
-        Operand param_temp = new_temp(p.type_name);
-        emit(IRInstruction::make_move(param_temp, Operand::var(p.name, p.type_name)));
-        bind_variable(p.name, param_temp);
-    }
+    // Parameters are Variables defined on entry by their incoming value
+    for (const auto& param : func.params)
+        declare_variable(param.first, param.second);
 
     node.body->accept(*this);
 
@@ -246,36 +271,25 @@ void IRGenerator::visit(FunctionDeclNode& node) {
         if (node.return_type == "void")
             finish_block_return_void();
         else
-            finish_block_return(Operand::int_lit(0));
+            finish_block_return(convert(Operand::int_lit(0), ir_type_from_name(node.return_type)));
     }
 
     exit_scope();
+    construct_ssa(func);
     cur_func_ = nullptr;
 }
 
 void IRGenerator::visit(StructDeclNode& /*node*/) {}
 
 void IRGenerator::visit(BlockStmtNode& node) {
-    std::unordered_map<std::string, Operand> pre_block_vars = flatten_scopes(scope_stack_);
     enter_scope();
     for (auto& stmt : node.statements) stmt->accept(*this);
-    
-    // Bubble up modifications to outer scopes before destroying the block
-    auto inner_end_vars = flatten_scopes(scope_stack_);
     exit_scope();
-    for (const auto& kv : inner_end_vars) {
-        if (pre_block_vars.find(kv.first) != pre_block_vars.end()) {
-            if (!operands_equal(pre_block_vars[kv.first], kv.second)) {
-                bind_variable(kv.first, kv.second);
-            }
-        }
-    }
 }
 
 void IRGenerator::visit(VarDeclStmtNode& node) {
     Operand rhs = Operand::int_lit(0);
-    bool is_alloc = false;
-    
+
     if (node.initializer) {
         node.initializer->accept(*this);
         rhs = last_result_;
@@ -287,26 +301,21 @@ void IRGenerator::visit(VarDeclStmtNode& node) {
         for (int sz : node.array_sizes) {
             if (sz > 0) total_elements *= sz;
         }
-        rhs = new_temp(node.type_name);
-        auto instr = IRInstruction::make_alloca(rhs, total_elements * 4); // Default 4-byte elems, handled by backend
+        rhs = new_temp(node.type_name + "[]");
+        int elem_size = ir_type_from_name(node.type_name) == IRType::Float ? 8 : 4;
+        auto instr = IRInstruction::make_alloca(rhs, total_elements * elem_size);
         instr.source_line = node.line;
         emit(instr);
-        is_alloc = true;
+        // The array name stands for the storage itself, no copy needed
+        bind_variable(node.name, rhs);
+        return;
     }
 
-    Operand tmp = new_temp(node.type_name);
-    auto instr = IRInstruction::make_move(tmp, rhs);
-    if (is_alloc) {
-        // Do not make_move if it's already a temp containing pointer from alloca, just use rhs
-        tmp = rhs;
-    } else {
-        instr.source_line = node.line;
-        instr.comment = node.type_name + " " + node.name;
-        emit(instr);
-    }
-    
-    if (!scope_stack_.empty())
-        scope_stack_.back()[node.name] = tmp;
+    Operand var = declare_variable(node.name, node.type_name);
+    auto instr = IRInstruction::make_move(var, convert(rhs, var.type));
+    instr.source_line = node.line;
+    instr.comment = node.type_name + " " + node.name;
+    emit(instr);
 }
 
 void IRGenerator::visit(ExprStmtNode& node) {
@@ -316,7 +325,8 @@ void IRGenerator::visit(ExprStmtNode& node) {
 void IRGenerator::visit(ReturnStmtNode& node) {
     if (node.value) {
         node.value->accept(*this);
-        auto instr = IRInstruction::make_return(last_result_);
+        Operand value = convert(last_result_, ir_type_from_name(cur_func_->return_type));
+        auto instr = IRInstruction::make_return(value);
         instr.source_line = node.line;
         emit(instr);
     } else {
@@ -335,67 +345,21 @@ void IRGenerator::visit(IfStmtNode& node) {
 
     node.condition->accept(*this);
     Operand cond = last_result_;
-    std::string cond_block_label = cur_block_->label;
 
     if (node.else_branch) finish_block_cond(cond, then_label, else_label);
     else finish_block_cond(cond, then_label, end_label);
 
-    auto defs_before = scope_stack_;
-
-    // Then
     start_block(then_label);
     node.then_branch->accept(*this);
-    bool then_reachable = (cur_block_ != nullptr);
-    std::string then_exit_label = cur_block_ ? cur_block_->label : last_finished_block_;
     finish_block_jump(end_label);
-    auto defs_then = scope_stack_;
-
-    // Restore
-    scope_stack_ = defs_before;
 
-    // Else
-    bool else_reachable = false;
-    std::string else_exit_label;
     if (node.else_branch) {
         start_block(else_label);
         node.else_branch->accept(*this);
-        else_reachable = (cur_block_ != nullptr);
-        else_exit_label = cur_block_ ? cur_block_->label : last_finished_block_;
         finish_block_jump(end_label);
-    } else {
-        else_reachable = true;
-        else_exit_label = cond_block_label;
     }
 
-    auto defs_else = scope_stack_;
-
     start_block(end_label);
-
-    auto flat_then = flatten_scopes(defs_then);
-    auto flat_else = flatten_scopes(defs_else);
-    
-    for (int i = 0; i < static_cast<int>(scope_stack_.size()); ++i) {
-        for (auto& kv : scope_stack_[i]) {
-            const std::string& var = kv.first;
-            Operand t_val = flat_then[var];
-            Operand e_val = flat_else[var];
-            
-            if (then_reachable && else_reachable && !operands_equal(t_val, e_val)) {
-                Operand phi_dest = new_temp(t_val.type_annotation.empty() ? e_val.type_annotation : t_val.type_annotation);
-                auto phi_inst = IRInstruction::make_phi(phi_dest);
-                phi_inst.srcs.push_back(t_val);
-                phi_inst.srcs.push_back(Operand::label(then_exit_label));
-                phi_inst.srcs.push_back(e_val);
-                phi_inst.srcs.push_back(Operand::label(else_exit_label));
-                emit(phi_inst);
-                kv.second = phi_dest;
-            } else if (then_reachable) {
-                kv.second = t_val;
-            } else if (else_reachable) {
-                kv.second = e_val;
-            }
-        }
-    }
 }
 
 void IRGenerator::visit(WhileStmtNode& node) {
@@ -403,57 +367,16 @@ void IRGenerator::visit(WhileStmtNode& node) {
     std::string body_label = new_label("L_body");
     std::string end_label = new_label("L_endwhile");
 
-    std::string pre_header_label = cur_block_->label;
     finish_block_jump(header_label);
 
     start_block(header_label);
-
-    AssignedVarCollector collector;
-    node.body->accept(collector);
-    
-    auto flat_before = flatten_scopes(scope_stack_);
-    std::vector<std::pair<std::string, size_t>> phi_nodes;
-
-    for (const std::string& var : collector.assigned_vars) {
-        if (flat_before.find(var) != flat_before.end()) {
-            Operand before_val = flat_before[var];
-            Operand phi_dest = new_temp(before_val.type_annotation);
-            
-            auto phi_inst = IRInstruction::make_phi(phi_dest);
-            phi_inst.srcs.push_back(before_val);
-            phi_inst.srcs.push_back(Operand::label(pre_header_label));
-            phi_inst.srcs.push_back(Operand::none());
-            phi_inst.srcs.push_back(Operand::none());
-            emit(phi_inst);
-            
-            bind_variable(var, phi_dest);
-            phi_nodes.push_back({var, cur_block_->instructions.size() - 1});
-        }
-    }
-
     node.condition->accept(*this);
-    Operand cond = last_result_;
-    finish_block_cond(cond, body_label, end_label);
+    finish_block_cond(last_result_, body_label, end_label);
 
     start_block(body_label);
     node.body->accept(*this);
-    std::string body_exit_label = cur_block_ ? cur_block_->label : last_finished_block_;
-    bool body_reachable = (cur_block_ != nullptr);
     finish_block_jump(header_label);
 
-    auto flat_after_body = flatten_scopes(scope_stack_);
-    BasicBlock* header_block = cur_func_->find_block(header_label);
-    for (auto& pair : phi_nodes) {
-        std::string var = pair.first;
-        IRInstruction& inst = header_block->instructions[pair.second];
-        if (body_reachable) {
-            inst.srcs[2] = flat_after_body[var];
-            inst.srcs[3] = Operand::label(body_exit_label);
-        } else {
-            inst.srcs.pop_back(); inst.srcs.pop_back();
-        }
-    }
-
     start_block(end_label);
 }
 
@@ -465,35 +388,9 @@ void IRGenerator::visit(ForStmtNode& node) {
 
     enter_scope();
     if (node.init) node.init->accept(*this);
-
-    std::string pre_header_label = cur_block_->label;
     finish_block_jump(header_label);
 
     start_block(header_label);
-
-    AssignedVarCollector collector;
-    if (node.update) node.update->accept(collector);
-    if (node.body) node.body->accept(collector);
-
-    auto flat_before = flatten_scopes(scope_stack_);
-    std::vector<std::pair<std::string, size_t>> phi_nodes;
-
-    for (const std::string& var : collector.assigned_vars) {
-        if (flat_before.find(var) != flat_before.end()) {
-            Operand before_val = flat_before[var];
-            Operand phi_dest = new_temp(before_val.type_annotation);
-            auto phi_inst = IRInstruction::make_phi(phi_dest);
-            phi_inst.srcs.push_back(before_val);
-            phi_inst.srcs.push_back(Operand::label(pre_header_label));
-            phi_inst.srcs.push_back(Operand::none());
-            phi_inst.srcs.push_back(Operand::none());
-            emit(phi_inst);
-            
-            bind_variable(var, phi_dest);
-            phi_nodes.push_back({var, cur_block_->instructions.size() - 1});
-        }
-    }
-
     if (node.condition) {
         node.condition->accept(*this);
         finish_block_cond(last_result_, body_label, end_label);
@@ -507,23 +404,8 @@ void IRGenerator::visit(ForStmtNode& node) {
 
     start_block(update_label);
     if (node.update) node.update->accept(*this);
-    std::string update_exit_label = cur_block_ ? cur_block_->label : last_finished_block_;
-    bool update_reachable = (cur_block_ != nullptr);
     finish_block_jump(header_label);
 
-    auto flat_after_body = flatten_scopes(scope_stack_);
-    BasicBlock* header_block = cur_func_->find_block(header_label);
-    for (auto& pair : phi_nodes) {
-        std::string var = pair.first;
-        IRInstruction& inst = header_block->instructions[pair.second];
-        if (update_reachable) {
-            inst.srcs[2] = flat_after_body[var];
-            inst.srcs[3] = Operand::label(update_exit_label);
-        } else {
-            inst.srcs.pop_back(); inst.srcs.pop_back();
-        }
-    }
-
     start_block(end_label);
     exit_scope();
 }
@@ -605,13 +487,19 @@ void IRGenerator::visit(BinaryExprNode& node) {
     }
 
     node.left->accept(*this);
-    Operand lhs = last_result_;
+    Operand lhs = hold(last_result_, *node.right);
     node.right->accept(*this);
     Operand rhs = last_result_;
 
     IROpcode opcode = binary_op_to_opcode(node.op);
     Operand dest = new_temp(type_string(node.resolved_type));
 
+    // Mixed int/float operands are computed in float
+    if (lhs.type == IRType::Float || rhs.type == IRType::Float) {
+        lhs = convert(lhs, IRType::Float);
+        rhs = convert(rhs, IRType::Float);
+    }
+
     auto instr = IRInstruction::make_binary(opcode, dest, lhs, rhs);
     instr.source_line = node.line;
     emit(instr);
@@ -635,9 +523,20 @@ void IRGenerator::visit(UnaryExprNode& node) {
 
 void IRGenerator::visit(CallExprNode& node) {
     std::vector<Operand> arg_operands;
-    for (auto& arg : node.arguments) {
-        arg->accept(*this);
-        arg_operands.push_back(last_result_);
+    for (size_t i = 0; i < node.arguments.size(); ++i) {
+        node.arguments[i]->accept(*this);
+        Operand value = last_result_;
+        for (size_t j = i + 1; j < node.arguments.size(); ++j)
+            value = hold(value, *node.arguments[j]);
+        arg_operands.push_back(value);
+    }
+
+    // int arguments of float parameters (not the variadic tail)
+    if (Symbol* fn = sym_.lookup(node.callee)) {
+        for (size_t i = 0; i < arg_operands.size() && i < fn->params.size(); ++i) {
+            if (fn->params[i].type_name == "...") break;
+            arg_operands[i] = convert(arg_operands[i], ir_type_from_name(fn->params[i].type_name));
+        }
     }
 
     for (int i = 0; i < static_cast<int>(arg_operands.size()); ++i) {
@@ -660,15 +559,17 @@ void IRGenerator::visit(PostfixExprNode& node) {
         return;
     }
 
-    Operand old_val = lookup_variable(ident->name);
+    // The expression yields the value before the update
+    Operand var = lookup_variable(ident->name);
     IROpcode op = (node.op == "++") ? IROpcode::ADD : IROpcode::SUB;
-    Operand new_val = new_temp(type_string(node.resolved_type));
+    Operand old_val = new_temp(type_string(node.resolved_type));
+    emit(IRInstruction::make_move(old_val, var));
 
-    auto instr = IRInstruction::make_binary(op, new_val, old_val, Operand::int_lit(1));
+    Operand one = var.type == IRType::Float ? Operand::float_lit(1.0) : Operand::int_lit(1);
+    auto instr = IRInstruction::make_binary(op, var, old_val, one);
     instr.source_line = node.line;
     emit(instr);
 
-    bind_variable(ident->name, new_val);
     last_result_ = old_val;
 }
 
@@ -677,33 +578,29 @@ void IRGenerator::visit(AssignmentExprNode& node) {
     Operand rhs = last_result_;
 
     if (auto* ident = dynamic_cast<IdentifierExprNode*>(node.target.get())) {
+        Operand var = lookup_variable(ident->name);
         if (node.op == "=") {
-            Operand result = new_temp(type_string(node.resolved_type));
-            auto instr = IRInstruction::make_move(result, rhs);
+            rhs = convert(rhs, var.type);
+            auto instr = IRInstruction::make_move(var, rhs);
             instr.source_line = node.line;
             emit(instr);
-            bind_variable(ident->name, result);
             last_result_ = rhs; // assignment evaluates to assigned value
         } else {
-            Operand old_val = lookup_variable(ident->name);
             std::string base_op = node.op.substr(0, node.op.size() - 1);
             IROpcode opcode = binary_op_to_opcode(base_op);
-            
-            Operand result = new_temp(type_string(node.resolved_type));
-            auto binop = IRInstruction::make_binary(opcode, result, old_val, rhs);
-            binop.source_line = node.line;
-            emit(binop);
-            
-            bind_variable(ident->name, result);
-            last_result_ = result;
+
+            emit_compound(opcode, var, var, rhs, node.line);
+            last_result_ = var;
         }
     } else if (auto* arr_acc = dynamic_cast<ArrayAccessExprNode*>(node.target.get())) {
+        rhs = hold(hold(rhs, *arr_acc->base), *arr_acc->index);
         arr_acc->base->accept(*this);
-        Operand array_op = last_result_;
+        Operand array_op = hold(last_result_, *arr_acc->index);
         arr_acc->index->accept(*this);
         Operand index_op = last_result_;
 
         if (node.op == "=") {
+            rhs = convert(rhs, ir_type_from_name(type_string(node.resolved_type)));
             auto instr = IRInstruction::make_store_elem(array_op, index_op, rhs);
             instr.source_line = node.line;
             emit(instr);
@@ -718,10 +615,8 @@ void IRGenerator::visit(AssignmentExprNode& node) {
             IROpcode opcode = binary_op_to_opcode(base_op);
             
             Operand result = new_temp(type_string(node.resolved_type));
-            auto binop = IRInstruction::make_binary(opcode, result, old_val, rhs);
-            binop.source_line = node.line;
-            emit(binop);
-            
+            emit_compound(opcode, result, old_val, rhs, node.line);
+
             auto store_instr = IRInstruction::make_store_elem(array_op, index_op, result);
             store_instr.source_line = node.line;
             emit(store_instr);
@@ -735,8 +630,8 @@ void IRGenerator::visit(AssignmentExprNode& node) {
 
 void IRGenerator::visit(ArrayAccessExprNode& node) {
     node.base->accept(*this);
-    Operand array = last_result_;
-    
+    Operand array = hold(last_result_, *node.index);
+
     node.index->accept(*this);
     Operand index = last_result_;
 
@@ -749,14 +644,16 @@ void IRGenerator::visit(ArrayAccessExprNode& node) {
 
 void IRGenerator::visit(ArrayInitExprNode& node) {
     int size = node.elements.size();
-    Operand array_dest = new_temp(type_string(node.resolved_type));
-    auto alloca = IRInstruction::make_alloca(array_dest, size * 4); // Default element size 4
+    std::string type = type_string(node.resolved_type);
+    IRType elem_type = ir_type_from_name(type.substr(0, type.find('[')));
+    Operand array_dest = new_temp(type);
+    auto alloca = IRInstruction::make_alloca(array_dest, size * (elem_type == IRType::Float ? 8 : 4));
     alloca.source_line = node.line;
     emit(alloca);
     
     for (size_t i = 0; i < node.elements.size(); ++i) {
         node.elements[i]->accept(*this);
-        Operand elem_val = last_result_;
+        Operand elem_val = convert(last_result_, elem_type);
         auto store = IRInstruction::make_store_elem(array_dest, Operand::int_lit(i), elem_val);
         store.source_line = node.line;
         emit(store);
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "ir/basic_block.h"
@@ -20,6 +21,10 @@ public:
     /// Generate IR for the entire program.
     IRProgram generate(ProgramNode& ast);
 
+    /// Leave these functions without a body, like externs (their
+    /// optimized IR comes from the compilation cache).
+    void set_skip_bodies(const std::unordered_set<std::string>* names) { skip_bodies_ = names; }
+
     /// Retrieve IR for a specific function.
     const IRFunction* get_function_ir(const std::string& name) const;
 
@@ -51,6 +56,7 @@ private:
     SemanticSymbolTable& sym_;
     TypeRegistry& types_;
     IRProgram program_;
+    const std::unordered_set<std::string>* skip_bodies_ = nullptr;
 
     // Current generation state
     IRFunction* cur_func_ = nullptr;
@@ -60,11 +66,17 @@ private:
     // Last expression result (set after visiting any expression node)
     Operand last_result_;
 
-    // Variable name → operand mapping per scope level
+    // Variable name → operand mapping per scope level.  Locals and
+    // parameters map to Variable operands; construct_ssa renames
+    // them once the function is complete.
     std::vector<std::unordered_map<std::string, Operand>> scope_stack_;
 
+    // Declarations per source name in the current function
+    std::unordered_map<std::string, int> var_versions_;
+
     // ----- helpers -----
-    Operand new_temp(const std::string& type = "");
+    Operand new_temp(IRType type = IRType::None);
+    Operand new_temp(const std::string& type);
     std::string new_label(const std::string& prefix = "L");
     void emit(const IRInstruction& instr);
 
@@ -77,11 +89,27 @@ private:
 
     void enter_scope();
     void exit_scope();
+    Operand declare_variable(const std::string& name, const std::string& type);
     void bind_variable(const std::string& name, const Operand& operand);
     Operand lookup_variable(const std::string& name);
 
+    // Copy a Variable read into a temp if `later` (evaluated before the
+    // read is consumed) assigns that variable.
+    Operand hold(const Operand& value, ASTNode& later);
+
     std::string type_string(const std::string& resolved_type);
 
+    // Implicit numeric conversion of `value` to `type`: int → float
+    // (INT_TO_FLOAT, folded for literals) and float → int (FLOAT_TO_INT,
+    // only for compound assignment to an int).  Other values are
+    // returned unchanged.
+    Operand convert(const Operand& value, IRType type);
+
+    // dest = lhs op rhs, computed in float if either side is float and
+    // converted back when dest is an int (`i += 0.5`).
+    void emit_compound(IROpcode op, const Operand& dest, const Operand& lhs,
+                       const Operand& rhs, int line);
+
     // Map binary operator string → IROpcode
     IROpcode binary_op_to_opcode(const std::string& op);
 };
@@ -23,6 +23,8 @@ std::string opcode_to_string(IROpcode op) {
         case IROpcode::CMP_LE:       return "CMP_LE";
         case IROpcode::CMP_GT:       return "CMP_GT";
         case IROpcode::CMP_GE:       return "CMP_GE";
+        case IROpcode::INT_TO_FLOAT: return "INT_TO_FLOAT";
+        case IROpcode::FLOAT_TO_INT: return "FLOAT_TO_INT";
         case IROpcode::LOAD:         return "LOAD";
         case IROpcode::STORE:        return "STORE";
         case IROpcode::ALLOCA:       return "ALLOCA";
@@ -36,6 +38,12 @@ std::string opcode_to_string(IROpcode op) {
         case IROpcode::CALL:         return "CALL";
         case IROpcode::RETURN:       return "RETURN";
         case IROpcode::PARAM:        return "PARAM";
+        case IROpcode::VEC_LOAD:     return "VEC_LOAD";
+        case IROpcode::VEC_STORE:    return "VEC_STORE";
+        case IROpcode::VEC_SPLAT:    return "VEC_SPLAT";
+        case IROpcode::VEC_ADD:      return "VEC_ADD";
+        case IROpcode::VEC_SUB:      return "VEC_SUB";
+        case IROpcode::VEC_MUL:      return "VEC_MUL";
         case IROpcode::PHI:          return "PHI";
         case IROpcode::NOP:          return "NOP";
     }
@@ -48,9 +56,9 @@ std::string opcode_to_string(IROpcode op) {
 std::string operand_to_string(const Operand& op) {
     switch (op.kind) {
         case OperandKind::Temp:
-            return op.name;
+            return op.name();
         case OperandKind::Variable:
-            return "[" + op.name + "]";
+            return "[" + op.name() + "]";
         case OperandKind::IntLiteral:
             return std::to_string(op.int_val);
         case OperandKind::FloatLiteral: {
@@ -61,39 +69,78 @@ std::string operand_to_string(const Operand& op) {
         case OperandKind::BoolLiteral:
             return op.int_val ? "true" : "false";
         case OperandKind::StringLiteral:
-            return "\"" + op.name + "\"";
+            return "\"" + op.name() + "\"";
         case OperandKind::Label:
-            return op.name;
+            return op.name();
         case OperandKind::None:
             return "<none>";
     }
     return "???";
 }
 
+// ---------------------------------------------------------------
+// IRType helpers
+// ---------------------------------------------------------------
+IRType ir_type_from_name(const std::string& type_name) {
+    if (type_name.empty())      return IRType::None;
+    if (type_name == "int")     return IRType::Int;
+    if (type_name == "float")   return IRType::Float;
+    if (type_name == "bool")    return IRType::Bool;
+    if (type_name == "string")  return IRType::String;
+    if (type_name == "void")    return IRType::Void;
+    if (type_name.find('[') != std::string::npos) return IRType::Array;
+    return IRType::Struct;
+}
+
+std::string ir_type_to_string(IRType type) {
+    switch (type) {
+        case IRType::None:   return "";
+        case IRType::Int:    return "int";
+        case IRType::Float:  return "float";
+        case IRType::Bool:   return "bool";
+        case IRType::String: return "string";
+        case IRType::Void:   return "void";
+        case IRType::Array:  return "array";
+        case IRType::Struct: return "struct";
+        case IRType::Long:   return "long";
+        case IRType::IntX4:  return "intx4";
+        case IRType::IntX8:  return "intx8";
+    }
+    return "";
+}
+
 // ---------------------------------------------------------------
 // Operand factory helpers
 // ---------------------------------------------------------------
-Operand Operand::temp(int id, const std::string& type) {
+Operand Operand::temp(int id, IRType type) {
     Operand o;
     o.kind = OperandKind::Temp;
-    o.name = "t" + std::to_string(id);
-    o.type_annotation = type;
+    o.id = intern_symbol("t" + std::to_string(id));
+    o.type = type;
     return o;
 }
 
-Operand Operand::var(const std::string& name, const std::string& type) {
+Operand Operand::temp(int id, const std::string& type) {
+    return temp(id, ir_type_from_name(type));
+}
+
+Operand Operand::var(const std::string& name, IRType type) {
     Operand o;
     o.kind = OperandKind::Variable;
-    o.name = name;
-    o.type_annotation = type;
+    o.id = intern_symbol(name);
+    o.type = type;
     return o;
 }
 
+Operand Operand::var(const std::string& name, const std::string& type) {
+    return var(name, ir_type_from_name(type));
+}
+
 Operand Operand::int_lit(int value) {
     Operand o;
     o.kind = OperandKind::IntLiteral;
     o.int_val = value;
-    o.type_annotation = "int";
+    o.type = IRType::Int;
     return o;
 }
 
@@ -101,7 +148,7 @@ Operand Operand::float_lit(double value) {
     Operand o;
     o.kind = OperandKind::FloatLiteral;
     o.float_val = value;
-    o.type_annotation = "float";
+    o.type = IRType::Float;
     return o;
 }
 
@@ -109,22 +156,22 @@ Operand Operand::bool_lit(bool value) {
     Operand o;
     o.kind = OperandKind::BoolLiteral;
     o.int_val = value ? 1 : 0;
-    o.type_annotation = "bool";
+    o.type = IRType::Bool;
     return o;
 }
 
 Operand Operand::string_lit(const std::string& value) {
     Operand o;
     o.kind = OperandKind::StringLiteral;
-    o.name = value;
-    o.type_annotation = "string";
+    o.id = intern_symbol(value);
+    o.type = IRType::String;
     return o;
 }
 
 Operand Operand::label(const std::string& name) {
     Operand o;
     o.kind = OperandKind::Label;
-    o.name = name;
+    o.id = intern_symbol(name);
     return o;
 }
 
@@ -254,6 +301,18 @@ IRInstruction IRInstruction::make_store_elem(Operand array, Operand index, Opera
     return i;
 }
 
+IRInstruction IRInstruction::make_vec_load(Operand dest, Operand array, Operand index) {
+    IRInstruction i = make_load_elem(dest, array, index);
+    i.opcode = IROpcode::VEC_LOAD;
+    return i;
+}
+
+IRInstruction IRInstruction::make_vec_store(Operand array, Operand index, Operand value) {
+    IRInstruction i = make_store_elem(array, index, value);
+    i.opcode = IROpcode::VEC_STORE;
+    return i;
+}
+
 IRInstruction IRInstruction::make_param(int index, Operand value) {
     IRInstruction i;
     i.opcode = IROpcode::PARAM;
@@ -359,6 +418,20 @@ std::string instruction_to_string(const IRInstruction& instr) {
                     + operand_to_string(instr.srcs[1]);
             break;
 
+        case IROpcode::VEC_LOAD:
+            result += operand_to_string(instr.dest) + " = VEC_LOAD "
+                    + operand_to_string(instr.srcs[0]) + "["
+                    + operand_to_string(instr.srcs[1]) + ":"
+                    + std::to_string(vector_lanes(instr.dest.type)) + "]";
+            break;
+
+        case IROpcode::VEC_STORE:
+            result += "VEC_STORE " + operand_to_string(instr.dest) + "["
+                    + operand_to_string(instr.srcs[0]) + ":"
+                    + std::to_string(vector_lanes(instr.srcs[1].type)) + "], "
+                    + operand_to_string(instr.srcs[1]);
+            break;
+
         case IROpcode::MOVE:
             result += operand_to_string(instr.dest) + " = MOVE "
                     + operand_to_string(instr.srcs[0]);
@@ -403,3 +476,12 @@ bool is_terminator(IROpcode op) {
            op == IROpcode::JUMP_IF_NOT ||
            op == IROpcode::RETURN;
 }
+
+// ---------------------------------------------------------------
+// element_size
+// ---------------------------------------------------------------
+int element_size(const IRInstruction& instr) {
+    if (instr.opcode == IROpcode::VEC_LOAD || instr.opcode == IROpcode::VEC_STORE) return 4;
+    const Operand& value = instr.opcode == IROpcode::LOAD_ELEM ? instr.dest : instr.srcs[1];
+    return value.type == IRType::Float ? 8 : 4;
+}
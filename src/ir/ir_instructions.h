@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <variant>
 #include <vector>
 
+#include "ir/interner.h"
+
 // ---------------------------------------------------------------
 // IROpcode — all three-address code operation codes
 // ---------------------------------------------------------------
@@ -14,6 +17,8 @@ enum class IROpcode {
     AND, OR, NOT, XOR,
     // Comparison
     CMP_EQ, CMP_NE, CMP_LT, CMP_LE, CMP_GT, CMP_GE,
+    // Conversion (int <-> float; float -> int truncates toward zero)
+    INT_TO_FLOAT, FLOAT_TO_INT,
     // Memory
     LOAD, STORE, ALLOCA,
     LOAD_ELEM, STORE_ELEM,
@@ -23,7 +28,10 @@ enum class IROpcode {
     JUMP, JUMP_IF, JUMP_IF_NOT, LABEL,
     // Function operations
     CALL, RETURN, PARAM,
-    // SSA (defined but not auto-inserted)
+    // Vector (emitted by the loop vectorizer; operands are IntX4/IntX8)
+    VEC_LOAD, VEC_STORE, VEC_SPLAT,
+    VEC_ADD, VEC_SUB, VEC_MUL,
+    // SSA (inserted by construct_ssa, removed by destruct_ssa)
     PHI,
     // No-op
     NOP
@@ -45,19 +53,63 @@ enum class OperandKind {
     None            // empty / unused
 };
 
+// ---------------------------------------------------------------
+// IRType — compact value type carried by every operand
+// ---------------------------------------------------------------
+enum class IRType : std::uint8_t {
+    None,       // unknown / not applicable (labels)
+    Int,
+    Float,
+    Bool,
+    String,
+    Void,
+    Array,      // pointer to array storage
+    Struct,
+    Long,       // 64-bit integer (widened induction variables)
+    IntX4,      // 4 x int (128-bit vector, SSE4.1)
+    IntX8       // 8 x int (256-bit vector, AVX2)
+};
+
+/// Values held in a full 64-bit register: Long and array pointers.
+inline bool is_wide(IRType type) {
+    return type == IRType::Long || type == IRType::Array;
+}
+
+/// Vector values: never register-allocated, they live in stack slots.
+inline bool is_vector(IRType type) {
+    return type == IRType::IntX4 || type == IRType::IntX8;
+}
+
+/// Number of int lanes of a vector type (0 for scalars).
+inline int vector_lanes(IRType type) {
+    return type == IRType::IntX4 ? 4 : type == IRType::IntX8 ? 8 : 0;
+}
+
+/// Map a source-level type name ("int", "float", "int[8]", "Point") to IRType.
+IRType ir_type_from_name(const std::string& type_name);
+
+/// Source-level spelling of an IRType ("" for None).
+std::string ir_type_to_string(IRType type);
+
 // ---------------------------------------------------------------
 // Operand — a single operand in an IR instruction
+//
+// Names are interned: `id` is the SymbolId of the temp/variable/
+// label/string spelling, so passes hash and compare integers.
+// Use name() only for printing and diagnostics.
 // ---------------------------------------------------------------
 struct Operand {
     OperandKind kind = OperandKind::None;
-    std::string name;           // for Temp, Variable, Label, StringLiteral
+    SymbolId id = kNoSymbol;    // for Temp, Variable, Label, StringLiteral
     int int_val = 0;            // for IntLiteral, BoolLiteral (0/1)
     double float_val = 0.0;     // for FloatLiteral
-    std::string type_annotation; // optional type info: "int", "float", etc.
+    IRType type = IRType::None; // value type
 
     // ----- factory helpers -----
-    static Operand temp(int id, const std::string& type = "");
-    static Operand var(const std::string& name, const std::string& type = "");
+    static Operand temp(int id, IRType type = IRType::None);
+    static Operand temp(int id, const std::string& type);
+    static Operand var(const std::string& name, IRType type = IRType::None);
+    static Operand var(const std::string& name, const std::string& type);
     static Operand int_lit(int value);
     static Operand float_lit(double value);
     static Operand bool_lit(bool value);
@@ -65,6 +117,12 @@ struct Operand {
     static Operand label(const std::string& name);
     static Operand none();
 
+    /// Interned spelling ("t3", "x", "L_then_0", string payload).
+    const std::string& name() const { return symbol_name(id); }
+
+    /// Replace the spelling (interns `new_name`).
+    void rename(const std::string& new_name) { id = intern_symbol(new_name); }
+
     bool is_none() const { return kind == OperandKind::None; }
     bool is_temp() const { return kind == OperandKind::Temp; }
     bool is_literal() const {
@@ -116,6 +174,10 @@ struct IRInstruction {
     static IRInstruction make_load_elem(Operand dest, Operand array, Operand index);
     static IRInstruction make_store_elem(Operand array, Operand index, Operand value);
 
+    // Vector: lanes index .. index+N-1 of an int array
+    static IRInstruction make_vec_load(Operand dest, Operand array, Operand index);
+    static IRInstruction make_vec_store(Operand array, Operand index, Operand value);
+
     // Function
     static IRInstruction make_param(int index, Operand value);
     static IRInstruction make_call(Operand dest, const std::string& func,
@@ -133,3 +195,8 @@ std::string instruction_to_string(const IRInstruction& instr);
 // Check if an opcode is a terminator (ends a basic block)
 // ---------------------------------------------------------------
 bool is_terminator(IROpcode op);
+
+/// Bytes per array element read or written by a LOAD_ELEM/STORE_ELEM:
+/// 8 for float (double) elements, 4 otherwise (also for VEC_LOAD/
+/// VEC_STORE, whose lanes are ints).
+int element_size(const IRInstruction& instr);
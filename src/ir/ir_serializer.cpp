@@ -0,0 +1,129 @@
+#include "ir/ir_serializer.h"
+
+#include <algorithm>
+
+namespace {
+
+void write_operand(utils::ByteWriter& out, const Operand& op) {
+    out.u8(static_cast<std::uint8_t>(op.kind));
+    out.u8(static_cast<std::uint8_t>(op.type));
+    out.u8(op.id != kNoSymbol);
+    if (op.id != kNoSymbol) out.str(op.name());
+    out.i64(op.int_val);
+    out.f64(op.float_val);
+}
+
+bool read_operand(utils::ByteReader& in, Operand& op) {
+    std::uint8_t kind = in.u8();
+    std::uint8_t type = in.u8();
+    if (kind > static_cast<std::uint8_t>(OperandKind::None) ||
+        type > static_cast<std::uint8_t>(IRType::IntX8)) {
+        return false;
+    }
+    op.kind = static_cast<OperandKind>(kind);
+    op.type = static_cast<IRType>(type);
+    op.id = in.u8() ? intern_symbol(in.str()) : kNoSymbol;
+    op.int_val = static_cast<int>(in.i64());
+    op.float_val = in.f64();
+    return in.ok();
+}
+
+void write_strings(utils::ByteWriter& out, const std::vector<std::string>& values) {
+    out.u64(values.size());
+    for (const auto& value : values) out.str(value);
+}
+
+void read_strings(utils::ByteReader& in, std::vector<std::string>& values) {
+    values.clear();
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) values.push_back(in.str());
+}
+
+} // namespace
+
+void write_ir_function(utils::ByteWriter& out, const IRFunction& func) {
+    out.str(func.name);
+    out.str(func.return_type);
+    out.u64(func.params.size());
+    for (const auto& param : func.params) {
+        out.str(param.first);
+        out.str(param.second);
+    }
+
+    out.u64(func.blocks.size());
+    for (const auto& block : func.blocks) {
+        out.str(block.label);
+        write_strings(out, block.successors);
+        write_strings(out, block.predecessors);
+        out.u64(block.instructions.size());
+        for (const auto& instr : block.instructions) {
+            out.u8(static_cast<std::uint8_t>(instr.opcode));
+            write_operand(out, instr.dest);
+            out.u64(instr.srcs.size());
+            for (const auto& src : instr.srcs) write_operand(out, src);
+            out.i64(instr.source_line);
+            out.str(instr.comment);
+        }
+    }
+
+    // Sorted, so equal functions serialize to equal bytes
+    std::vector<std::pair<std::string, std::string>> locations(func.var_to_location.begin(),
+                                                               func.var_to_location.end());
+    std::sort(locations.begin(), locations.end());
+    out.u64(locations.size());
+    for (const auto& loc : locations) {
+        out.str(loc.first);
+        out.str(loc.second);
+    }
+    out.i64(func.temp_counter);
+    out.i64(func.label_counter);
+}
+
+bool read_ir_function(utils::ByteReader& in, IRFunction& func) {
+    func = IRFunction{};
+    func.name = in.str();
+    func.return_type = in.str();
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) {
+        std::string name = in.str();
+        func.params.emplace_back(name, in.str());
+    }
+
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) {
+        BasicBlock block;
+        block.label = in.str();
+        read_strings(in, block.successors);
+        read_strings(in, block.predecessors);
+        for (std::uint64_t k = in.u64(); k > 0 && in.ok(); --k) {
+            IRInstruction instr;
+            std::uint8_t opcode = in.u8();
+            if (opcode > static_cast<std::uint8_t>(IROpcode::NOP)) return false;
+            instr.opcode = static_cast<IROpcode>(opcode);
+            if (!read_operand(in, instr.dest)) return false;
+            for (std::uint64_t s = in.u64(); s > 0 && in.ok(); --s) {
+                Operand src;
+                if (!read_operand(in, src)) return false;
+                instr.srcs.push_back(src);
+            }
+            instr.source_line = static_cast<int>(in.i64());
+            instr.comment = in.str();
+            block.instructions.push_back(std::move(instr));
+        }
+        func.blocks.push_back(std::move(block));
+    }
+
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) {
+        std::string var = in.str();
+        func.var_to_location[var] = in.str();
+    }
+    func.temp_counter = static_cast<int>(in.i64());
+    func.label_counter = static_cast<int>(in.i64());
+    return in.ok();
+}
+
+void shift_source_lines(IRFunction& func, int delta) {
+    if (delta == 0) return;
+    for (auto& block : func.blocks) {
+        for (auto& instr : block.instructions) {
+            if (instr.source_line > 0) instr.source_line += delta;
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ir/basic_block.h"
+#include "utils/byte_stream.h"
+
+// ---------------------------------------------------------------
+// IR serialization — binary form of an IRFunction
+//
+// Used by the compilation cache to keep optimized functions on
+// disk.  Operand names are written as spellings, not SymbolIds:
+// ids are process-local and are re-interned on reading.
+// ---------------------------------------------------------------
+
+/// Append `func` to `out`.
+void write_ir_function(utils::ByteWriter& out, const IRFunction& func);
+
+/// Read a function written by write_ir_function; false on malformed data.
+bool read_ir_function(utils::ByteReader& in, IRFunction& func);
+
+/// Add `delta` to every non-zero source_line (the function moved in the file).
+void shift_source_lines(IRFunction& func, int delta);
@@ -0,0 +1,168 @@
+#include "ir/loops.h"
+
+#include <algorithm>
+
+namespace {
+
+bool is_jump(IROpcode op) {
+    return op == IROpcode::JUMP || op == IROpcode::JUMP_IF || op == IROpcode::JUMP_IF_NOT;
+}
+
+bool same_operand(const Operand& a, const Operand& b) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case OperandKind::IntLiteral:
+        case OperandKind::BoolLiteral:
+            return a.int_val == b.int_val;
+        case OperandKind::FloatLiteral:
+            return a.float_val == b.float_val;
+        default:
+            return a.id == b.id;
+    }
+}
+
+} // namespace
+
+bool Loop::contains(int b) const {
+    return std::binary_search(blocks.begin(), blocks.end(), b);
+}
+
+// ---------------------------------------------------------------
+// LoopInfo
+// ---------------------------------------------------------------
+LoopInfo::LoopInfo(const DominatorTree& dom) : cfg_(dom.cfg()) {
+    const int n = cfg_.num_blocks();
+    innermost_.assign(n, -1);
+
+    // 1. Back edges, grouped by header in reverse post-order
+    for (int h : cfg_.rpo) {
+        Loop loop;
+        loop.header = h;
+        for (int p : cfg_.preds[h]) {
+            if (cfg_.reachable(p) && dom.dominates(h, p)) loop.latches.push_back(p);
+        }
+        if (loop.latches.empty()) continue;
+
+        // 2. Body: walk predecessors backwards from the latches
+        std::vector<char> in_loop(n, 0);
+        in_loop[h] = 1;
+        std::vector<int> work;
+        for (int l : loop.latches) {
+            if (!in_loop[l]) {
+                in_loop[l] = 1;
+                work.push_back(l);
+            }
+        }
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            for (int p : cfg_.preds[b]) {
+                if (!cfg_.reachable(p) || in_loop[p]) continue;
+                in_loop[p] = 1;
+                work.push_back(p);
+            }
+        }
+        for (int b = 0; b < n; ++b) {
+            if (in_loop[b]) loop.blocks.push_back(b);
+        }
+        loops_.push_back(std::move(loop));
+    }
+
+    // 3. Nesting: the parent is the smallest other loop containing the
+    //    header.  Natural loops are either nested or disjoint, and an
+    //    enclosing loop precedes its nested loops in the list.
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        auto& loop = loops_[i];
+        for (size_t j = 0; j < i; ++j) {
+            const auto& outer = loops_[j];
+            if (!outer.contains(loop.header)) continue;
+            if (loop.parent < 0 || outer.blocks.size() < loops_[loop.parent].blocks.size())
+                loop.parent = static_cast<int>(j);
+        }
+        if (loop.parent >= 0) {
+            loops_[loop.parent].children.push_back(static_cast<int>(i));
+            loop.depth = loops_[loop.parent].depth + 1;
+        }
+        // Later (nested) loops overwrite their blocks with themselves
+        for (int b : loop.blocks) innermost_[b] = static_cast<int>(i);
+    }
+}
+
+std::vector<int> LoopInfo::exiting_blocks(int loop) const {
+    std::vector<int> exiting;
+    const auto& l = loops_[loop];
+    for (int b : l.blocks) {
+        for (int s : cfg_.succs[b]) {
+            if (!l.contains(s)) {
+                exiting.push_back(b);
+                break;
+            }
+        }
+    }
+    return exiting;
+}
+
+// ---------------------------------------------------------------
+// insert_preheader
+// ---------------------------------------------------------------
+std::string insert_preheader(IRFunction& func, const std::string& header) {
+    DominatorTree dom(func);
+    const auto& cfg = dom.cfg();
+    const int h = cfg.index_of(intern_symbol(header));
+    if (h < 0) return {};
+
+    std::vector<int> entering;
+    for (int p : cfg.preds[h]) {
+        if (cfg.reachable(p) && !dom.dominates(h, p)) entering.push_back(p);
+    }
+    if (entering.size() == 1 && cfg.succs[entering[0]].size() == 1) {
+        return func.blocks[entering[0]].label;
+    }
+
+    BasicBlock pre;
+    pre.label = func.new_label("L_preheader");
+
+    std::vector<SymbolId> entering_ids;
+    for (int p : entering) {
+        entering_ids.push_back(intern_symbol(func.blocks[p].label));
+        for (auto& instr : func.blocks[p].instructions) {
+            if (is_jump(instr.opcode) && instr.dest.name() == header)
+                instr.dest = Operand::label(pre.label);
+        }
+    }
+
+    // Header PHI arguments from the entering blocks now arrive from
+    // the preheader; differing values are merged there first.
+    for (auto& instr : func.blocks[h].instructions) {
+        if (instr.opcode != IROpcode::PHI) continue;
+        std::vector<Operand> kept;
+        std::vector<Operand> incoming;
+        for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+            bool from_outside = std::find(entering_ids.begin(), entering_ids.end(),
+                                          instr.srcs[i + 1].id) != entering_ids.end();
+            auto& list = from_outside ? incoming : kept;
+            list.push_back(instr.srcs[i]);
+            list.push_back(instr.srcs[i + 1]);
+        }
+        if (incoming.empty()) continue;
+
+        Operand value = incoming[0];
+        for (size_t i = 2; i < incoming.size(); i += 2) {
+            if (!same_operand(incoming[i], value)) {
+                value = func.new_temp(instr.dest.type);
+                IRInstruction phi = IRInstruction::make_phi(value);
+                phi.srcs = incoming;
+                pre.instructions.push_back(std::move(phi));
+                break;
+            }
+        }
+        kept.push_back(value);
+        kept.push_back(Operand::label(pre.label));
+        instr.srcs = std::move(kept);
+    }
+
+    pre.instructions.push_back(IRInstruction::make_jump(header));
+    std::string label = pre.label;
+    func.blocks.insert(func.blocks.begin() + h, std::move(pre));
+    return label;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ir/dominators.h"
+
+// ---------------------------------------------------------------
+// Loop — one natural loop
+//
+// A back edge is an edge latch → header where the header dominates
+// the latch.  The natural loop of a header is the header plus every
+// block that reaches one of its latches without passing through the
+// header; back edges sharing a header form a single loop.
+// ---------------------------------------------------------------
+struct Loop {
+    int header = -1;
+    std::vector<int> latches;
+    std::vector<int> blocks;        // sorted block indices, header included
+    int parent = -1;                // enclosing loop (index into LoopInfo::loops), -1 = none
+    std::vector<int> children;      // directly nested loops
+    int depth = 1;                  // 1 = outermost
+
+    bool contains(int b) const;
+};
+
+// ---------------------------------------------------------------
+// LoopInfo — natural loops of a function and their nesting tree
+//
+// Loops are listed in the reverse post-order of their headers, so
+// an enclosing loop always comes before the loops nested in it.
+// Block indices refer to the DominatorTree's CFG, which must outlive
+// the LoopInfo.
+// ---------------------------------------------------------------
+class LoopInfo {
+public:
+    explicit LoopInfo(const DominatorTree& dom);
+
+    const std::vector<Loop>& loops() const { return loops_; }
+    bool empty() const { return loops_.empty(); }
+
+    /// Innermost loop containing block `b`, or -1.
+    int loop_of(int b) const { return innermost_[b]; }
+
+    /// Blocks of `loop` with a successor outside it.
+    std::vector<int> exiting_blocks(int loop) const;
+
+private:
+    const ControlFlowGraph& cfg_;
+    std::vector<Loop> loops_;
+    std::vector<int> innermost_;
+};
+
+/// Give the loop headed by `header` a preheader: a block outside the
+/// loop whose only successor is the header and through which every
+/// entry into the loop passes.  An existing single entering block
+/// with one successor is reused; otherwise a new block is placed
+/// before the header, the entering jumps are redirected to it and
+/// the header PHIs are updated.  Returns the preheader's label.
+std::string insert_preheader(IRFunction& func, const std::string& header);
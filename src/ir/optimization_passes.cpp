@@ -18,17 +18,28 @@ void FunctionInliner::run() {
     }
 }
 
-bool FunctionInliner::should_inline(const IRFunction& func) const {
-    if (func.blocks.empty()) return false;
+// Size budget in IR instructions; a hot call site (--profile-use)
+// may pull in a larger callee, a call that never ran is left alone.
+constexpr int kInlineBudget = 10;
+constexpr int kHotInlineBudget = 40;
+
+bool FunctionInliner::should_inline(const IRFunction& caller, const IRFunction& callee) const {
+    if (callee.blocks.empty()) return false;
+    int budget = kInlineBudget;
+    std::uint64_t calls = 0;
+    if (profile_ && profile_->call_count(caller.name, callee.name, calls)) {
+        if (calls == 0) return false;
+        if (profile_->is_hot_call(calls)) budget = kHotInlineBudget;
+    }
     int instr_count = 0;
-    for (const auto& b : func.blocks) {
+    for (const auto& b : callee.blocks) {
         for (const auto& i : b.instructions) {
             instr_count++;
             if (i.opcode == IROpcode::CALL) return false; // Don't inline functions that call other functions (avoid recursion/complexity)
         }
     }
-    if (instr_count > 10) return false;
-    if (func.params.size() > 4) return false;
+    if (instr_count > budget) return false;
+    if (callee.params.size() > 4) return false;
     return true;
 }
 
@@ -46,10 +57,10 @@ void FunctionInliner::inline_calls(IRFunction& caller) {
             auto& instr = block.instructions[i];
             
             if (instr.opcode == IROpcode::CALL) {
-                std::string func_name = instr.srcs[0].name;
+                std::string func_name = instr.srcs[0].name();
                 const IRFunction* callee = program_.find_function(func_name);
                 
-                if (callee && callee->name != caller.name && should_inline(*callee)) {
+                if (callee && callee->name != caller.name && should_inline(caller, *callee)) {
                     // Extract params
                     std::map<int, Operand> args;
                     for (int j = (int)current_instrs.size() - 1; j >= 0; --j) {
@@ -65,6 +76,10 @@ void FunctionInliner::inline_calls(IRFunction& caller) {
                     std::string suffix = "_inl" + std::to_string(inline_counter_);
                     
                     std::string after_label = caller.new_label("L_after_inline");
+
+                    std::vector<SymbolId> param_ids;
+                    for (const auto& param : callee->params)
+                        param_ids.push_back(intern_symbol(param.first));
                     
                     // 1. Jump to inlined start
                     current_instrs.push_back(IRInstruction::make_jump(callee->blocks[0].label + suffix));
@@ -73,36 +88,45 @@ void FunctionInliner::inline_calls(IRFunction& caller) {
                     bb_copy.instructions = current_instrs;
                     new_blocks.push_back(bb_copy);
                     
-                    // 2. Append callee blocks
+                    // 2. Append callee blocks.  With several returns the
+                    //    call result becomes a PHI in the "after" block,
+                    //    so the caller stays in SSA form.
+                    int value_returns = 0;
+                    for (const auto& cb : callee->blocks) {
+                        for (const auto& ci : cb.instructions) {
+                            if (ci.opcode == IROpcode::RETURN && !ci.srcs.empty()) value_returns++;
+                        }
+                    }
+                    IRInstruction result_phi = IRInstruction::make_phi(instr.dest);
                     for (size_t cb = 0; cb < callee->blocks.size(); ++cb) {
                         BasicBlock inlined_block = callee->blocks[cb];
                         inlined_block.label += suffix;
                         std::vector<IRInstruction> new_instrs;
                         for (auto& cinstr : inlined_block.instructions) {
                             if (cinstr.opcode == IROpcode::JUMP || cinstr.opcode == IROpcode::JUMP_IF || cinstr.opcode == IROpcode::JUMP_IF_NOT) {
-                                cinstr.dest.name += suffix;
+                                cinstr.dest.rename(cinstr.dest.name() + suffix);
                             }
                             if (cinstr.opcode == IROpcode::LABEL) {
-                                cinstr.dest.name += suffix;
+                                cinstr.dest.rename(cinstr.dest.name() + suffix);
                             }
                             if (cinstr.opcode == IROpcode::PHI) {
                                 for (size_t p = 1; p < cinstr.srcs.size(); p += 2) {
-                                    cinstr.srcs[p].name += suffix;
+                                    cinstr.srcs[p].rename(cinstr.srcs[p].name() + suffix);
                                 }
                             }
                             
                             auto rename_op = [&](Operand& op) {
                                 if (op.is_temp() || op.kind == OperandKind::Variable) {
                                     bool is_param = false;
-                                    for (size_t p = 0; p < callee->params.size(); ++p) {
-                                        if (op.name == callee->params[p].first) {
+                                    for (size_t p = 0; p < param_ids.size(); ++p) {
+                                        if (op.id == param_ids[p]) {
                                             op = args[p];
                                             is_param = true;
                                             break;
                                         }
                                     }
                                     if (!is_param) {
-                                        op.name += suffix;
+                                        op.rename(op.name() + suffix);
                                     }
                                 }
                             };
@@ -111,7 +135,11 @@ void FunctionInliner::inline_calls(IRFunction& caller) {
                             for (auto& src : cinstr.srcs) rename_op(src);
                             
                             if (cinstr.opcode == IROpcode::RETURN) {
-                                if (!instr.dest.is_none() && !cinstr.srcs.empty()) {
+                                if (!instr.dest.is_none() && !cinstr.srcs.empty() && value_returns > 1) {
+                                    result_phi.srcs.push_back(cinstr.srcs[0]);
+                                    result_phi.srcs.push_back(Operand::label(inlined_block.label));
+                                    new_instrs.push_back(IRInstruction::make_jump(after_label));
+                                } else if (!instr.dest.is_none() && !cinstr.srcs.empty()) {
                                     new_instrs.push_back(IRInstruction::make_move(instr.dest, cinstr.srcs[0]));
                                     new_instrs.push_back(IRInstruction::make_jump(after_label));
                                 } else {
@@ -127,6 +155,7 @@ void FunctionInliner::inline_calls(IRFunction& caller) {
                     
                     // 3. Create the "after" block
                     current_instrs.clear();
+                    if (!result_phi.srcs.empty()) current_instrs.push_back(result_phi);
                     block.label = after_label;
                     current_tail = after_label;
                     functions_inlined_++;
@@ -155,9 +184,9 @@ void FunctionInliner::inline_calls(IRFunction& caller) {
             for (auto& instr : new_bb.instructions) {
                 if (instr.opcode == IROpcode::PHI) {
                     for (size_t i = 1; i < instr.srcs.size(); i += 2) {
-                        auto it = split_block_tail.find(instr.srcs[i].name);
+                        auto it = split_block_tail.find(instr.srcs[i].name());
                         if (it != split_block_tail.end()) {
-                            instr.srcs[i].name = it->second;
+                            instr.srcs[i].rename(it->second);
                         }
                     }
                 }
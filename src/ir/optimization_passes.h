@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ir/basic_block.h"
+#include "ir/profile.h"
 
 class FunctionInliner {
 public:
@@ -8,11 +9,16 @@ public:
     void run();
     int get_functions_inlined() const { return functions_inlined_; }
 
+    /// Use recorded call counts (--profile-use): calls that never ran
+    /// are not inlined, hot ones get a larger size budget.
+    void set_profile(const ProfileData* profile) { profile_ = profile; }
+
 private:
     IRProgram& program_;
     int functions_inlined_ = 0;
     int inline_counter_ = 0;
+    const ProfileData* profile_ = nullptr;
 
-    bool should_inline(const IRFunction& func) const;
+    bool should_inline(const IRFunction& caller, const IRFunction& callee) const;
     void inline_calls(IRFunction& caller);
 };
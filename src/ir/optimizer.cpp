@@ -1,9 +1,345 @@
 #include "ir/optimizer.h"
 
+#include "ir/dominators.h"
+#include "ir/loops.h"
+#include "ir/ssa.h"
+
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <map>
 #include <set>
 #include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// ---------------------------------------------------------------
+// ExprKey — structural key for CSE (opcode + operand identities)
+// ---------------------------------------------------------------
+struct OperandKey {
+    OperandKind kind = OperandKind::None;
+    std::int64_t bits = 0;   // SymbolId, integer value or raw double bits
+
+    bool operator<(const OperandKey& o) const {
+        return std::tie(kind, bits) < std::tie(o.kind, o.bits);
+    }
+};
+
+struct ExprKey {
+    IROpcode opcode = IROpcode::NOP;
+    bool wide = false;          // 64-bit result (Long / Array dest)
+    std::vector<OperandKey> srcs;
+
+    bool operator<(const ExprKey& o) const {
+        return std::tie(opcode, wide, srcs) < std::tie(o.opcode, o.wide, o.srcs);
+    }
+};
+
+OperandKey operand_key(const Operand& op) {
+    OperandKey key;
+    key.kind = op.kind;
+    switch (op.kind) {
+        case OperandKind::Temp:
+        case OperandKind::Variable:
+        case OperandKind::Label:
+        case OperandKind::StringLiteral:
+            key.bits = op.id;
+            break;
+        case OperandKind::IntLiteral:
+        case OperandKind::BoolLiteral:
+            key.bits = op.int_val;
+            break;
+        case OperandKind::FloatLiteral:
+            std::memcpy(&key.bits, &op.float_val, sizeof(key.bits));
+            break;
+        case OperandKind::None:
+            break;
+    }
+    return key;
+}
+
+bool same_operand(const Operand& a, const Operand& b) {
+    OperandKey ka = operand_key(a), kb = operand_key(b);
+    return !(ka < kb) && !(kb < ka);
+}
+
+// STORE / STORE_ELEM / VEC_STORE read their dest (the address / array base).
+bool dest_is_read(IROpcode op) {
+    return op == IROpcode::STORE || op == IROpcode::STORE_ELEM || op == IROpcode::VEC_STORE;
+}
+
+// Number of instructions assigning each Temp/Variable name.
+std::unordered_map<SymbolId, int> count_definitions(const IRFunction& func) {
+    std::unordered_map<SymbolId, int> defs;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if ((instr.dest.kind == OperandKind::Temp ||
+                 instr.dest.kind == OperandKind::Variable) &&
+                !dest_is_read(instr.opcode)) {
+                defs[instr.dest.id]++;
+            }
+        }
+    }
+    return defs;
+}
+
+// Block and index of the (last) instruction assigning each temp.
+std::unordered_map<SymbolId, std::pair<int, size_t>> definition_sites(const IRFunction& func) {
+    std::unordered_map<SymbolId, std::pair<int, size_t>> sites;
+    for (size_t b = 0; b < func.blocks.size(); ++b) {
+        const auto& instrs = func.blocks[b].instructions;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            if (instrs[i].dest.is_temp() && !dest_is_read(instrs[i].opcode))
+                sites[instrs[i].dest.id] = {static_cast<int>(b), i};
+        }
+    }
+    return sites;
+}
+
+// Number of reads of each Temp/Variable name (PHI arguments included).
+std::unordered_map<SymbolId, int> count_uses(const IRFunction& func) {
+    std::unordered_map<SymbolId, int> uses;
+    auto read = [&](const Operand& op) {
+        if (op.kind == OperandKind::Temp || op.kind == OperandKind::Variable) uses[op.id]++;
+    };
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            for (const auto& src : instr.srcs) read(src);
+            if (dest_is_read(instr.opcode)) read(instr.dest);
+        }
+    }
+    return uses;
+}
+
+// Arithmetic, logical, comparison and conversion opcodes: no side
+// effects, the result depends only on the operands.
+bool is_pure(IROpcode op) {
+    return op >= IROpcode::ADD && op <= IROpcode::FLOAT_TO_INT;
+}
+
+bool is_vector_op(IROpcode op) {
+    return op >= IROpcode::VEC_LOAD && op <= IROpcode::VEC_MUL;
+}
+
+bool is_commutative(IROpcode op) {
+    switch (op) {
+        case IROpcode::ADD: case IROpcode::MUL:
+        case IROpcode::AND: case IROpcode::OR: case IROpcode::XOR:
+        case IROpcode::CMP_EQ: case IROpcode::CMP_NE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ---------------------------------------------------------------
+// LatticeCell — SCCP value: Top (unknown yet) → Const → Bottom
+// ---------------------------------------------------------------
+struct LatticeCell {
+    enum State { Top, Const, Bottom } state = Top;
+    int value = 0;
+};
+
+LatticeCell meet(const LatticeCell& a, const LatticeCell& b) {
+    if (a.state == LatticeCell::Top) return b;
+    if (b.state == LatticeCell::Top) return a;
+    if (a.state == LatticeCell::Const && b.state == LatticeCell::Const && a.value == b.value)
+        return a;
+    LatticeCell bottom;
+    bottom.state = LatticeCell::Bottom;
+    return bottom;
+}
+
+// Only 32-bit integers and booleans are folded.
+bool foldable_type(IRType type) {
+    return type == IRType::Int || type == IRType::Bool || type == IRType::None;
+}
+
+Operand make_literal(int value, IRType type) {
+    return type == IRType::Bool ? Operand::bool_lit(value != 0) : Operand::int_lit(value);
+}
+
+// Evaluate an opcode the way the generated 32-bit code does:
+// wrapping arithmetic, no folding of a trapping division.
+bool evaluate(IROpcode op, int a, int b, int& result) {
+    auto wrap = [](std::uint32_t v) { return static_cast<int>(v); };
+    const auto ua = static_cast<std::uint32_t>(a);
+    const auto ub = static_cast<std::uint32_t>(b);
+    switch (op) {
+        case IROpcode::ADD: result = wrap(ua + ub); return true;
+        case IROpcode::SUB: result = wrap(ua - ub); return true;
+        case IROpcode::MUL: result = wrap(ua * ub); return true;
+        case IROpcode::DIV:
+        case IROpcode::MOD:
+            if (b == 0 || (a == INT32_MIN && b == -1)) return false;
+            result = (op == IROpcode::DIV) ? a / b : a % b;
+            return true;
+        case IROpcode::NEG: result = wrap(0u - ua); return true;
+        case IROpcode::AND: result = a & b; return true;
+        case IROpcode::OR:  result = a | b; return true;
+        case IROpcode::XOR: result = a ^ b; return true;
+        case IROpcode::NOT: result = (a == 0) ? 1 : 0; return true;
+        case IROpcode::CMP_EQ: result = (a == b) ? 1 : 0; return true;
+        case IROpcode::CMP_NE: result = (a != b) ? 1 : 0; return true;
+        case IROpcode::CMP_LT: result = (a < b)  ? 1 : 0; return true;
+        case IROpcode::CMP_LE: result = (a <= b) ? 1 : 0; return true;
+        case IROpcode::CMP_GT: result = (a > b)  ? 1 : 0; return true;
+        case IROpcode::CMP_GE: result = (a >= b) ? 1 : 0; return true;
+        default: return false;
+    }
+}
+
+// ---------------------------------------------------------------
+// InductionVariable — basic induction variable of a loop header
+//
+//   i    = PHI (init, <entering block>), (next, <latch>)
+//   next = ADD i, step
+//
+// `counted` is set when the header exits unless `i < bound` (step 1)
+// or `i > bound` (step -1) with a loop-invariant bound, and every
+// increment runs only after that test passed: i then never wraps in
+// 32 bits and can live in a 64-bit register.
+// ---------------------------------------------------------------
+struct InductionVariable {
+    Operand phi;
+    Operand next;
+    Operand init;
+    Operand latch;              // label of the back edge
+    int step = 0;
+    bool counted = false;
+    Operand bound;
+    IROpcode test_op = IROpcode::NOP;       // with i on the left
+    std::pair<int, size_t> test_site{-1, 0};
+};
+
+using DefinitionSites = std::unordered_map<SymbolId, std::pair<int, size_t>>;
+
+IROpcode swap_comparison(IROpcode op) {
+    switch (op) {
+        case IROpcode::CMP_LT: return IROpcode::CMP_GT;
+        case IROpcode::CMP_GT: return IROpcode::CMP_LT;
+        case IROpcode::CMP_LE: return IROpcode::CMP_GE;
+        case IROpcode::CMP_GE: return IROpcode::CMP_LE;
+        default:               return op;
+    }
+}
+
+template <typename Invariant>
+std::vector<InductionVariable> find_induction_variables(const IRFunction& func,
+                                                        const DominatorTree& dom,
+                                                        const Loop& loop,
+                                                        const DefinitionSites& sites,
+                                                        Invariant invariant) {
+    std::vector<InductionVariable> ivs;
+    if (loop.latches.size() != 1) return ivs;
+    const auto& cfg = dom.cfg();
+    const auto& header = func.blocks[loop.header];
+
+    auto def_of = [&](const Operand& op) -> const IRInstruction* {
+        if (!op.is_temp()) return nullptr;
+        auto it = sites.find(op.id);
+        if (it == sites.end()) return nullptr;
+        return &func.blocks[it->second.first].instructions[it->second.second];
+    };
+
+    for (const auto& instr : header.instructions) {
+        if (instr.opcode != IROpcode::PHI || !instr.dest.is_temp()) continue;
+        if (instr.dest.type == IRType::Array || instr.dest.type == IRType::Float ||
+            instr.srcs.size() != 4) {
+            continue;
+        }
+
+        InductionVariable iv;
+        iv.phi = instr.dest;
+        int p0 = cfg.index_of(instr.srcs[1].id);
+        int p1 = cfg.index_of(instr.srcs[3].id);
+        if (p0 == loop.latches[0] && p1 >= 0 && !loop.contains(p1)) {
+            iv.next = instr.srcs[0];
+            iv.latch = instr.srcs[1];
+            iv.init = instr.srcs[2];
+        } else if (p1 == loop.latches[0] && p0 >= 0 && !loop.contains(p0)) {
+            iv.init = instr.srcs[0];
+            iv.next = instr.srcs[2];
+            iv.latch = instr.srcs[3];
+        } else {
+            continue;
+        }
+
+        const IRInstruction* inc = def_of(iv.next);
+        if (!inc || inc->srcs.size() != 2) continue;
+        const Operand& a = inc->srcs[0];
+        const Operand& b = inc->srcs[1];
+        auto is_phi = [&](const Operand& op) { return op.is_temp() && op.id == iv.phi.id; };
+        if (inc->opcode == IROpcode::ADD && is_phi(a) && b.kind == OperandKind::IntLiteral) {
+            iv.step = b.int_val;
+        } else if (inc->opcode == IROpcode::ADD && is_phi(b) && a.kind == OperandKind::IntLiteral) {
+            iv.step = a.int_val;
+        } else if (inc->opcode == IROpcode::SUB && is_phi(a) && b.kind == OperandKind::IntLiteral &&
+                   b.int_val != INT32_MIN) {
+            iv.step = -b.int_val;
+        }
+        if (iv.step == 0) continue;
+        ivs.push_back(iv);
+    }
+    if (ivs.empty()) return ivs;
+
+    // Exit test of the header: `JUMP_IF c, in; JUMP out` or
+    // `JUMP_IF_NOT c, out; JUMP in`
+    const auto& code = header.instructions;
+    for (size_t i = 0; i + 1 < code.size(); ++i) {
+        const auto& br = code[i];
+        const auto& jmp = code[i + 1];
+        if ((br.opcode != IROpcode::JUMP_IF && br.opcode != IROpcode::JUMP_IF_NOT) ||
+            jmp.opcode != IROpcode::JUMP) {
+            continue;
+        }
+        bool when_true = br.opcode == IROpcode::JUMP_IF;
+        int in = cfg.index_of((when_true ? br.dest : jmp.dest).id);
+        int out = cfg.index_of((when_true ? jmp.dest : br.dest).id);
+        if (in < 0 || out < 0 || !loop.contains(in) || loop.contains(out)) break;
+        if (cfg.preds[in].size() != 1) break;
+
+        const IRInstruction* test = def_of(br.srcs[0]);
+        if (!test || test->srcs.size() != 2) break;
+        auto site = sites.at(br.srcs[0].id);
+        if (site.first != loop.header) break;
+
+        for (auto& iv : ivs) {
+            IROpcode op = test->opcode;
+            Operand bound;
+            if (test->srcs[0].is_temp() && test->srcs[0].id == iv.phi.id) {
+                bound = test->srcs[1];
+            } else if (test->srcs[1].is_temp() && test->srcs[1].id == iv.phi.id) {
+                bound = test->srcs[0];
+                op = swap_comparison(op);
+            } else {
+                continue;
+            }
+            if (!invariant(bound)) continue;
+
+            bool no_wrap = (op == IROpcode::CMP_LT && iv.step == 1) ||
+                           (op == IROpcode::CMP_GT && iv.step == -1) ||
+                           (op == IROpcode::CMP_LE && iv.step == 1 &&
+                            bound.kind == OperandKind::IntLiteral && bound.int_val < INT32_MAX) ||
+                           (op == IROpcode::CMP_GE && iv.step == -1 &&
+                            bound.kind == OperandKind::IntLiteral && bound.int_val > INT32_MIN);
+            int inc_block = sites.at(iv.next.id).first;
+            if (!no_wrap || !dom.dominates(in, inc_block)) continue;
+
+            iv.counted = true;
+            iv.bound = bound;
+            iv.test_op = op;
+            iv.test_site = site;
+        }
+        break;
+    }
+    return ivs;
+}
+
+} // namespace
 
 // ---------------------------------------------------------------
 // Constructor
@@ -14,22 +350,77 @@ PeepholeOptimizer::PeepholeOptimizer(IRProgram& program)
 // ---------------------------------------------------------------
 // optimize — run all passes
 // ---------------------------------------------------------------
-void PeepholeOptimizer::optimize() {
+void PeepholeOptimizer::optimize(utils::ThreadPool* pool) {
+    if (!pool || pool->jobs() <= 1) {
+        int prev_modified = -1;
+        while (prev_modified != metrics_.instructions_modified) {
+            prev_modified = metrics_.instructions_modified;
+            for (auto& func : program_.functions) {
+                run_round(func);
+            }
+        }
+        return;
+    }
+
+    // Parallel: the passes only touch their own function, so a round
+    // runs every function on its own worker optimizer.  Metrics and
+    // log entries are merged in function order after each round, and
+    // the round loop keeps the same global termination test.
+    PeepholeOptimizer worker(program_);
+    worker.vector_lanes_ = vector_lanes_;
+    std::vector<PeepholeOptimizer> workers(program_.functions.size(), worker);
     int prev_modified = -1;
     while (prev_modified != metrics_.instructions_modified) {
         prev_modified = metrics_.instructions_modified;
-        for (auto& func : program_.functions) {
-            propagate_copies(func);
-            fold_constants(func);
-            simplify_algebraic(func);
-            reduce_strength(func);
-            eliminate_common_subexpressions(func);
-            eliminate_dead_code(func);
-            chain_jumps(func);
+        pool->parallel_for(workers.size(), [&](size_t i) {
+            workers[i].run_round(program_.functions[i]);
+        });
+        for (auto& w : workers) {
+            metrics_ += w.metrics_;
+            log_.insert(log_.end(), w.log_.begin(), w.log_.end());
+            w.metrics_ = OptimizationMetrics{};
+            w.log_.clear();
         }
     }
 }
 
+void PeepholeOptimizer::run_round(IRFunction& func) {
+    auto pass = [&](void (PeepholeOptimizer::*run)(IRFunction&), const char* name) {
+        const int before = metrics_.instructions_modified + metrics_.instructions_removed;
+        (this->*run)(func);
+        if (pass_hook_ && metrics_.instructions_modified + metrics_.instructions_removed != before)
+            pass_hook_(name, func);
+    };
+    pass(&PeepholeOptimizer::propagate_copies, "propagate_copies");
+    pass(&PeepholeOptimizer::propagate_constants, "propagate_constants");
+    pass(&PeepholeOptimizer::simplify_algebraic, "simplify_algebraic");
+    pass(&PeepholeOptimizer::reduce_strength, "reduce_strength");
+    pass(&PeepholeOptimizer::number_values, "number_values");
+    pass(&PeepholeOptimizer::hoist_loop_invariants, "hoist_loop_invariants");
+    pass(&PeepholeOptimizer::eliminate_dead_code, "eliminate_dead_code");
+    pass(&PeepholeOptimizer::vectorize_loops, "vectorize_loops");
+    pass(&PeepholeOptimizer::reduce_induction_variables, "reduce_induction_variables");
+    pass(&PeepholeOptimizer::chain_jumps, "chain_jumps");
+}
+
+OptimizationMetrics& OptimizationMetrics::operator+=(const OptimizationMetrics& other) {
+    instructions_removed             += other.instructions_removed;
+    instructions_modified            += other.instructions_modified;
+    constants_folded                 += other.constants_folded;
+    algebraic_simplifications        += other.algebraic_simplifications;
+    strength_reductions              += other.strength_reductions;
+    dead_code_eliminated             += other.dead_code_eliminated;
+    jumps_chained                    += other.jumps_chained;
+    copies_propagated                += other.copies_propagated;
+    common_subexpressions_eliminated += other.common_subexpressions_eliminated;
+    branches_folded                  += other.branches_folded;
+    instructions_hoisted             += other.instructions_hoisted;
+    induction_variables_reduced      += other.induction_variables_reduced;
+    induction_variables_widened      += other.induction_variables_widened;
+    loops_vectorized                 += other.loops_vectorized;
+    return *this;
+}
+
 // ---------------------------------------------------------------
 // add_entry
 // ---------------------------------------------------------------
@@ -40,54 +431,234 @@ void PeepholeOptimizer::add_entry(const std::string& func,
 }
 
 // ---------------------------------------------------------------
-// fold_constants — evaluate constant expressions at compile time
+// propagate_constants — sparse conditional constant propagation
+//
+// Wegman & Zadeck: every SSA value starts unknown (Top) and every
+// CFG edge not executable.  A block is evaluated once one of its
+// incoming edges becomes executable, and a branch on a known
+// constant marks only the edge it takes, so a PHI meets just the
+// arguments of executable edges.  Constants are therefore found
+// across branches and around loops, not only inside one block.
+//
+// Afterwards constant definitions become MOVEs of the literal,
+// constant uses are replaced by the literal, constant branches are
+// resolved and the blocks left unreachable are removed.
 //   e.g. ADD t1, 3, 4 → MOVE t1, 7
 // ---------------------------------------------------------------
-void PeepholeOptimizer::fold_constants(IRFunction& func) {
-    for (auto& block : func.blocks) {
+void PeepholeOptimizer::propagate_constants(IRFunction& func) {
+    ControlFlowGraph cfg(func);
+    const int n = cfg.num_blocks();
+    if (n == 0) return;
+
+    auto defs = count_definitions(func);
+    std::unordered_map<SymbolId, LatticeCell> cells;
+    std::unordered_map<SymbolId, std::vector<std::pair<int, size_t>>> uses;
+    for (int b = 0; b < n; ++b) {
+        const auto& instrs = func.blocks[b].instructions;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            const auto& instr = instrs[i];
+            if (instr.dest.is_temp() && !dest_is_read(instr.opcode)) {
+                cells[instr.dest.id].state = defs[instr.dest.id] == 1
+                                                 ? LatticeCell::Top : LatticeCell::Bottom;
+            }
+            for (const auto& src : instr.srcs) {
+                if (src.is_temp()) uses[src.id].push_back({b, i});
+            }
+        }
+    }
+
+    auto value_of = [&](const Operand& op) {
+        LatticeCell cell;
+        if (op.kind == OperandKind::IntLiteral || op.kind == OperandKind::BoolLiteral) {
+            cell.state = LatticeCell::Const;
+            cell.value = op.int_val;
+        } else if (op.is_temp() && cells.count(op.id)) {
+            cell = cells[op.id];
+        } else {
+            cell.state = LatticeCell::Bottom;
+        }
+        return cell;
+    };
+
+    std::vector<SymbolId> ssa_work;
+    auto lower = [&](const Operand& dest, const LatticeCell& value) {
+        auto& cell = cells[dest.id];
+        LatticeCell merged = meet(cell, value);
+        if (merged.state != cell.state || merged.value != cell.value) {
+            cell = merged;
+            ssa_work.push_back(dest.id);
+        }
+    };
+
+    std::vector<char> visited(n, 0);
+    std::set<std::pair<int, int>> executable;
+    std::vector<std::pair<int, int>> flow_work = {{-1, 0}};
+    auto mark_edge = [&](int from, const Operand& target) {
+        int to = cfg.index_of(target.id);
+        if (to >= 0 && executable.insert({from, to}).second) flow_work.push_back({from, to});
+    };
+
+    // Branches are evaluated in order: a taken branch ends the block,
+    // a branch on an unknown condition is not evaluated yet.
+    auto visit_branches = [&](int b) {
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (instr.opcode == IROpcode::RETURN) return;
+            if (instr.opcode == IROpcode::JUMP) {
+                mark_edge(b, instr.dest);
+                return;
+            }
+            if (instr.opcode != IROpcode::JUMP_IF && instr.opcode != IROpcode::JUMP_IF_NOT)
+                continue;
+            LatticeCell cond = value_of(instr.srcs[0]);
+            if (cond.state == LatticeCell::Top) return;
+            if (cond.state == LatticeCell::Bottom) {
+                mark_edge(b, instr.dest);
+                continue;
+            }
+            if ((cond.value != 0) == (instr.opcode == IROpcode::JUMP_IF)) {
+                mark_edge(b, instr.dest);
+                return;
+            }
+        }
+    };
+
+    auto visit = [&](int b, const IRInstruction& instr) {
+        if (!instr.dest.is_temp() || dest_is_read(instr.opcode)) return;
+        if (cells[instr.dest.id].state == LatticeCell::Bottom) return;
+
+        LatticeCell result;
+        if (instr.opcode == IROpcode::PHI) {
+            for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+                int p = cfg.index_of(instr.srcs[i + 1].id);
+                if (p >= 0 && executable.count({p, b}))
+                    result = meet(result, value_of(instr.srcs[i]));
+            }
+        } else if (!foldable_type(instr.dest.type)) {
+            result.state = LatticeCell::Bottom;
+        } else if (instr.opcode == IROpcode::MOVE) {
+            result = value_of(instr.srcs[0]);
+        } else if (is_pure(instr.opcode)) {
+            LatticeCell a = value_of(instr.srcs[0]);
+            LatticeCell c = instr.srcs.size() > 1 ? value_of(instr.srcs[1]) : a;
+            if (a.state == LatticeCell::Bottom || c.state == LatticeCell::Bottom) {
+                result.state = LatticeCell::Bottom;
+            } else if (a.state == LatticeCell::Const && c.state == LatticeCell::Const) {
+                if (evaluate(instr.opcode, a.value, c.value, result.value)) {
+                    result.state = LatticeCell::Const;
+                } else {
+                    result.state = LatticeCell::Bottom;
+                }
+            }
+        } else {
+            result.state = LatticeCell::Bottom;
+        }
+        lower(instr.dest, result);
+    };
+
+    while (!flow_work.empty() || !ssa_work.empty()) {
+        if (!flow_work.empty()) {
+            int b = flow_work.back().second;
+            flow_work.pop_back();
+            bool first = !visited[b];
+            visited[b] = 1;
+            for (const auto& instr : func.blocks[b].instructions) {
+                if (first || instr.opcode == IROpcode::PHI) visit(b, instr);
+            }
+            if (first) visit_branches(b);
+            continue;
+        }
+        SymbolId id = ssa_work.back();
+        ssa_work.pop_back();
+        for (auto [b, i] : uses[id]) {
+            if (!visited[b]) continue;
+            const auto& instr = func.blocks[b].instructions[i];
+            if (instr.opcode == IROpcode::JUMP_IF || instr.opcode == IROpcode::JUMP_IF_NOT) {
+                visit_branches(b);
+            } else {
+                visit(b, instr);
+            }
+        }
+    }
+
+    // Rewrite the executable blocks with what is known
+    auto constant = [&](const Operand& op, Operand& lit) {
+        if (!op.is_temp()) return false;
+        auto it = cells.find(op.id);
+        if (it == cells.end() || it->second.state != LatticeCell::Const) return false;
+        lit = make_literal(it->second.value, op.type);
+        return true;
+    };
+
+    bool branch_folded = false;
+    for (int b = 0; b < n; ++b) {
+        if (!visited[b]) continue;
+        auto& block = func.blocks[b];
         for (size_t i = 0; i < block.instructions.size(); ++i) {
             auto& instr = block.instructions[i];
+            Operand lit;
 
-            // Only binary ops with two int literal sources
-            if (instr.srcs.size() != 2) continue;
-            if (instr.srcs[0].kind != OperandKind::IntLiteral) continue;
-            if (instr.srcs[1].kind != OperandKind::IntLiteral) continue;
-
-            int a = instr.srcs[0].int_val;
-            int b = instr.srcs[1].int_val;
-            int result = 0;
-            bool fold = true;
-
-            switch (instr.opcode) {
-                case IROpcode::ADD: result = a + b; break;
-                case IROpcode::SUB: result = a - b; break;
-                case IROpcode::MUL: result = a * b; break;
-                case IROpcode::DIV:
-                    if (b == 0) { fold = false; break; }
-                    result = a / b; break;
-                case IROpcode::MOD:
-                    if (b == 0) { fold = false; break; }
-                    result = a % b; break;
-                case IROpcode::CMP_EQ: result = (a == b) ? 1 : 0; break;
-                case IROpcode::CMP_NE: result = (a != b) ? 1 : 0; break;
-                case IROpcode::CMP_LT: result = (a < b)  ? 1 : 0; break;
-                case IROpcode::CMP_LE: result = (a <= b) ? 1 : 0; break;
-                case IROpcode::CMP_GT: result = (a > b)  ? 1 : 0; break;
-                case IROpcode::CMP_GE: result = (a >= b) ? 1 : 0; break;
-                default: fold = false; break;
-            }
-
-            if (fold) {
+            if (instr.opcode == IROpcode::JUMP_IF || instr.opcode == IROpcode::JUMP_IF_NOT) {
+                LatticeCell cond = value_of(instr.srcs[0]);
+                if (cond.state != LatticeCell::Const) continue;
                 std::string old_str = instruction_to_string(instr);
-                instr = IRInstruction::make_move(instr.dest, Operand::int_lit(result));
+                bool taken = (cond.value != 0) == (instr.opcode == IROpcode::JUMP_IF);
+                metrics_.branches_folded++;
+                metrics_.instructions_modified++;
+                branch_folded = true;
+                if (taken) {
+                    instr = IRInstruction::make_jump(instr.dest.name());
+                    instr.comment = "folded: " + old_str;
+                    block.instructions.resize(i + 1);
+                    add_entry(func.name, block.label, static_cast<int>(i),
+                             "branch fold: " + old_str + " → always taken");
+                    break;
+                }
+                add_entry(func.name, block.label, static_cast<int>(i),
+                         "branch fold: " + old_str + " → never taken");
+                block.instructions.erase(block.instructions.begin() + i);
+                --i;
+                continue;
+            }
+
+            if (instr.opcode != IROpcode::PHI && !dest_is_read(instr.opcode) &&
+                constant(instr.dest, lit) &&
+                !(instr.opcode == IROpcode::MOVE && instr.srcs[0].is_literal())) {
+                std::string old_str = instruction_to_string(instr);
+                instr = IRInstruction::make_move(instr.dest, lit);
                 instr.comment = "folded: " + old_str;
                 metrics_.constants_folded++;
                 metrics_.instructions_modified++;
                 add_entry(func.name, block.label, static_cast<int>(i),
-                         "constant fold: " + old_str + " → " + std::to_string(result));
+                         "constant fold: " + old_str + " → " + operand_to_string(lit));
+                continue;
+            }
+
+            for (size_t s = 0; s < instr.srcs.size(); ++s) {
+                if (instr.opcode == IROpcode::PHI && s % 2 == 1) continue;
+                if (constant(instr.srcs[s], lit)) {
+                    instr.srcs[s] = lit;
+                    metrics_.instructions_modified++;
+                }
             }
         }
     }
+
+    if (branch_folded || std::count(visited.begin(), visited.end(), 0) > 0) {
+        auto count_instructions = [&]() {
+            size_t total = 0;
+            for (const auto& block : func.blocks) total += block.instructions.size();
+            return total;
+        };
+        size_t blocks_before = func.blocks.size();
+        size_t instrs_before = count_instructions();
+        remove_unreachable_blocks(func);
+        if (func.blocks.size() != blocks_before) {
+            metrics_.instructions_removed += static_cast<int>(instrs_before - count_instructions());
+            add_entry(func.name, func.blocks.front().label, 0,
+                     "unreachable: removed " +
+                     std::to_string(blocks_before - func.blocks.size()) + " block(s)");
+        }
+    }
 }
 
 // ---------------------------------------------------------------
@@ -196,28 +767,28 @@ void PeepholeOptimizer::reduce_strength(IRFunction& func) {
 // ---------------------------------------------------------------
 void PeepholeOptimizer::eliminate_dead_code(IRFunction& func) {
     // Collect all used operands
-    std::set<std::string> used;
+    std::unordered_set<SymbolId> used;
     for (const auto& block : func.blocks) {
         for (const auto& instr : block.instructions) {
             for (const auto& src : instr.srcs) {
                 if (src.kind == OperandKind::Temp)
-                    used.insert(src.name);
+                    used.insert(src.id);
             }
             // Jump conditions also use operands
             if (instr.opcode == IROpcode::JUMP_IF ||
                 instr.opcode == IROpcode::JUMP_IF_NOT) {
                 if (!instr.srcs.empty() && instr.srcs[0].kind == OperandKind::Temp)
-                    used.insert(instr.srcs[0].name);
+                    used.insert(instr.srcs[0].id);
             }
             // Return value
             if (instr.opcode == IROpcode::RETURN) {
                 if (!instr.srcs.empty() && instr.srcs[0].kind == OperandKind::Temp)
-                    used.insert(instr.srcs[0].name);
+                    used.insert(instr.srcs[0].id);
             }
-            // For STORE and STORE_ELEM, dest is actually a pointer that is USED
-            if (instr.opcode == IROpcode::STORE || instr.opcode == IROpcode::STORE_ELEM) {
+            // For stores, dest is actually a pointer that is USED
+            if (dest_is_read(instr.opcode)) {
                 if (instr.dest.kind == OperandKind::Temp)
-                    used.insert(instr.dest.name);
+                    used.insert(instr.dest.id);
             }
         }
     }
@@ -228,13 +799,12 @@ void PeepholeOptimizer::eliminate_dead_code(IRFunction& func) {
         while (it != block.instructions.end()) {
             if (it->dest.kind == OperandKind::Temp &&
                 !it->dest.is_none() &&
-                used.find(it->dest.name) == used.end() &&
+                used.find(it->dest.id) == used.end() &&
                 it->opcode != IROpcode::CALL &&
-                it->opcode != IROpcode::STORE &&
-                it->opcode != IROpcode::STORE_ELEM &&
+                !dest_is_read(it->opcode) &&
                 !is_terminator(it->opcode)) {
                 add_entry(func.name, block.label, 0,
-                         "dead code: removed unused " + it->dest.name);
+                         "dead code: removed unused " + it->dest.name());
                 it = block.instructions.erase(it);
                 metrics_.dead_code_eliminated++;
                 metrics_.instructions_removed++;
@@ -257,7 +827,7 @@ void PeepholeOptimizer::chain_jumps(IRFunction& func) {
             if (instr.opcode != IROpcode::LABEL && instr.opcode != IROpcode::NOP) {
                 real_count++;
                 if (instr.opcode == IROpcode::JUMP) {
-                    jump_target = instr.dest.name;
+                    jump_target = instr.dest.name();
                 }
             }
         }
@@ -279,15 +849,29 @@ void PeepholeOptimizer::chain_jumps(IRFunction& func) {
         return {cur, pred};
     };
 
+    // A block may reach a PHI block along one edge only: once the PHIs
+    // of `target` list `pred`, a second jump cannot be redirected there.
+    auto phi_lists_pred = [&](const std::string& target, const std::string& pred) {
+        const BasicBlock* tb = func.find_block(target);
+        if (!tb) return false;
+        for (const auto& ti : tb->instructions) {
+            if (ti.opcode != IROpcode::PHI) continue;
+            for (size_t i = 1; i < ti.srcs.size(); i += 2) {
+                if (ti.srcs[i].name() == pred) return true;
+            }
+        }
+        return false;
+    };
+
     // Rewrite jump targets
     for (auto& block : func.blocks) {
         for (auto& instr : block.instructions) {
             if (instr.opcode == IROpcode::JUMP ||
                 instr.opcode == IROpcode::JUMP_IF ||
                 instr.opcode == IROpcode::JUMP_IF_NOT) {
-                std::string old_target = instr.dest.name;
+                std::string old_target = instr.dest.name();
                 auto [new_target, pred] = resolve_and_get_last_pred(old_target);
-                if (new_target != old_target) {
+                if (new_target != old_target && !phi_lists_pred(new_target, block.label)) {
                     instr.dest = Operand::label(new_target);
                     metrics_.jumps_chained++;
                     metrics_.instructions_modified++;
@@ -301,7 +885,7 @@ void PeepholeOptimizer::chain_jumps(IRFunction& func) {
                                 if (target_instr.opcode == IROpcode::PHI) {
                                     // Check if the original predecessor (or the last block in the chain) is in the PHI sources
                                     for (size_t i = 1; i < target_instr.srcs.size(); i += 2) {
-                                        if (target_instr.srcs[i].name == pred) {
+                                        if (target_instr.srcs[i].name() == pred) {
                                             target_instr.srcs.push_back(target_instr.srcs[i - 1]); // The value
                                             target_instr.srcs.push_back(Operand::label(block.label)); // The new predecessor
                                             break;
@@ -318,6 +902,693 @@ void PeepholeOptimizer::chain_jumps(IRFunction& func) {
     }
 }
 
+// ---------------------------------------------------------------
+// vectorize_loops — counted int array loops → vector kernels
+//
+// With vector_lanes_ = N (4 for SSE4.1, 8 for AVX2) an innermost
+// loop of the shape
+//
+//   H:  i = PHI (init, P), (next, latch)
+//       c = CMP_LT i, n                    n invariant
+//       JUMP_IF c, body; JUMP exit
+//   body .. latch: straight-line blocks, next = ADD i, 1
+//
+// whose body only reads and writes int elements a[i + k] of
+// invariant arrays and combines them with ADD / SUB / MUL / MOVE
+// of ints, gets a vector loop in front of it:
+//
+//   P:  vb = SUB n, N-1; VEC_SPLAT of the invariant operands
+//       [ok = CMP_LE vb, n; JUMP_IF ok, VH; JUMP H]     n not a literal
+//   VH: vi = PHI (init, P), (vnext, VB)
+//       vc = CMP_LT vi, vb; JUMP_IF vc, VB; JUMP H
+//   VB: the body on lanes vi .. vi+N-1; vnext = ADD vi, N; JUMP VH
+//
+// The scalar loop stays as the epilogue and starts at i = vi.  The
+// guard skips the vector loop when n - (N-1) would wrap; a literal
+// trip count below N leaves the loop alone.
+//
+// Legality: body values are not used after the loop (reductions
+// stay scalar), i appears only as an index, and no two accesses to
+// possibly the same array, one of them a store, have the later one
+// 1 .. N-1 elements ahead of the earlier: that loop-carried
+// dependence is what running N iterations at once would break.
+// Arrays are allocated and passed whole, so two bases are the same
+// array or disjoint: an ALLOCA aliases only itself, array
+// parameters may alias each other.
+// ---------------------------------------------------------------
+void PeepholeOptimizer::vectorize_loops(IRFunction& func) {
+    const int lanes = vector_lanes_;
+    if (lanes < 2) return;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (is_vector_op(instr.opcode)) return;     // done in an earlier round
+        }
+    }
+    const IRType vtype = lanes == 8 ? IRType::IntX8 : IRType::IntX4;
+
+    std::unordered_set<SymbolId> tried;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        DominatorTree dom(func);
+        LoopInfo info(dom);
+        const auto& cfg = dom.cfg();
+        auto defs = count_definitions(func);
+        auto sites = definition_sites(func);
+        auto uses = count_uses(func);
+
+        const auto& loops = info.loops();
+        for (int l = static_cast<int>(loops.size()) - 1; l >= 0 && !changed; --l) {
+            const Loop& loop = loops[l];
+            if (loop.header == 0 || !loop.children.empty()) continue;
+            const std::string header = func.blocks[loop.header].label;
+            if (!tried.insert(intern_symbol(header)).second) continue;
+
+            auto invariant = [&](const Operand& op) {
+                if (op.kind == OperandKind::IntLiteral) return true;
+                if (op.kind == OperandKind::Variable) return defs.count(op.id) == 0;
+                if (!op.is_temp() || defs[op.id] != 1) return false;
+                auto it = sites.find(op.id);
+                return it != sites.end() && !loop.contains(it->second.first);
+            };
+            auto ivs = find_induction_variables(func, dom, loop, sites, invariant);
+            const auto& head = func.blocks[loop.header].instructions;
+            if (ivs.size() != 1 || head.size() != 4 || head[0].opcode != IROpcode::PHI) continue;
+            const InductionVariable& iv = ivs[0];
+            if (!iv.counted || iv.step != 1 || iv.phi.type != IRType::Int ||
+                iv.bound.type != IRType::Int || uses[iv.next.id] != 1) {
+                continue;
+            }
+
+            // ---- trip count: i < n, or i <= c as i < c + 1 ----
+            Operand bound = iv.bound;
+            if (iv.test_op == IROpcode::CMP_LE) {
+                if (bound.kind != OperandKind::IntLiteral || bound.int_val == INT32_MAX) continue;
+                bound = Operand::int_lit(bound.int_val + 1);
+            } else if (iv.test_op != IROpcode::CMP_LT) {
+                continue;
+            }
+            if (bound.kind == OperandKind::IntLiteral) {
+                if (static_cast<long long>(bound.int_val) - (lanes - 1) < INT32_MIN) continue;
+                if (iv.init.kind == OperandKind::IntLiteral &&
+                    static_cast<long long>(bound.int_val) - iv.init.int_val < lanes) {
+                    continue;
+                }
+            }
+
+            // ---- body: a chain of blocks from the header to the latch ----
+            const IRInstruction& branch = head[2];
+            const Operand& in = branch.opcode == IROpcode::JUMP_IF ? branch.dest : head[3].dest;
+            std::vector<int> chain;
+            int b = cfg.index_of(in.id);
+            while (b >= 0 && b != loop.header && chain.size() < loop.blocks.size()) {
+                const auto& code = func.blocks[b].instructions;
+                if (code.empty() || code.back().opcode != IROpcode::JUMP || cfg.preds[b].size() != 1)
+                    break;
+                chain.push_back(b);
+                b = cfg.index_of(code.back().dest.id);
+            }
+            if (b != loop.header || chain.size() + 1 != loop.blocks.size()) continue;
+
+            auto is_iv = [&](const Operand& op) { return op.is_temp() && op.id == iv.phi.id; };
+            auto array_base = [&](const Operand& base) {
+                if (base.type != IRType::Array) return false;
+                if (base.kind == OperandKind::Variable) return defs.count(base.id) == 0;
+                if (!base.is_temp() || defs[base.id] != 1) return false;
+                auto it = sites.find(base.id);
+                return it != sites.end() && !loop.contains(it->second.first) &&
+                       func.blocks[it->second.first].instructions[it->second.second].opcode ==
+                           IROpcode::ALLOCA;
+            };
+
+            struct Access { bool store; Operand base; int offset; };
+            std::vector<Access> accesses;
+            std::unordered_map<SymbolId, int> index_temps;      // i + c → c
+            std::unordered_map<SymbolId, int> index_reads;
+            std::unordered_set<SymbolId> values;                // ints computed per lane
+            std::vector<IRInstruction> body;
+            int iv_reads = 2;                                   // exit test, increment
+            auto lane_value = [&](const Operand& op) {
+                if (op.is_temp() && values.count(op.id)) return true;
+                return op.type == IRType::Int && invariant(op);
+            };
+            auto index_offset = [&](const Operand& index, int& offset) {
+                if (is_iv(index)) {
+                    offset = 0;
+                    ++iv_reads;
+                    return true;
+                }
+                auto it = index.is_temp() ? index_temps.find(index.id) : index_temps.end();
+                if (it == index_temps.end()) return false;
+                offset = it->second;
+                index_reads[index.id]++;
+                return true;
+            };
+
+            bool ok = true;
+            for (int cb : chain) {
+                const auto& code = func.blocks[cb].instructions;
+                for (size_t i = 0; ok && i + 1 < code.size(); ++i) {
+                    const auto& instr = code[i];
+                    const auto& s = instr.srcs;
+                    body.push_back(instr);
+                    switch (instr.opcode) {
+                        case IROpcode::LOAD_ELEM:
+                        case IROpcode::STORE_ELEM: {
+                            bool store = instr.opcode == IROpcode::STORE_ELEM;
+                            const Operand& base = store ? instr.dest : s[0];
+                            int offset = 0;
+                            ok = element_size(instr) == 4 && array_base(base) &&
+                                 index_offset(store ? s[0] : s[1], offset) &&
+                                 (store ? lane_value(s[1])
+                                        : instr.dest.is_temp() && instr.dest.type == IRType::Int);
+                            if (ok && !store) values.insert(instr.dest.id);
+                            accesses.push_back({store, base, offset});
+                            break;
+                        }
+                        case IROpcode::ADD:
+                        case IROpcode::SUB: {
+                            if (instr.dest.is_temp() && instr.dest.id == iv.next.id) break;
+                            long long offset = 0;
+                            bool index = false;
+                            if (is_iv(s[0]) && s[1].kind == OperandKind::IntLiteral) {
+                                index = true;
+                                offset = instr.opcode == IROpcode::ADD ? s[1].int_val
+                                                                       : -static_cast<long long>(s[1].int_val);
+                            } else if (instr.opcode == IROpcode::ADD && is_iv(s[1]) &&
+                                       s[0].kind == OperandKind::IntLiteral) {
+                                index = true;
+                                offset = s[0].int_val;
+                            }
+                            if (index) {
+                                ok = instr.dest.is_temp() && offset > -(1 << 20) && offset < (1 << 20);
+                                index_temps[instr.dest.id] = static_cast<int>(offset);
+                                ++iv_reads;
+                                break;
+                            }
+                            [[fallthrough]];
+                        }
+                        case IROpcode::MUL:
+                            ok = instr.dest.is_temp() && instr.dest.type == IRType::Int &&
+                                 lane_value(s[0]) && lane_value(s[1]);
+                            values.insert(instr.dest.id);
+                            break;
+                        case IROpcode::MOVE:
+                            ok = instr.dest.is_temp() && instr.dest.type == IRType::Int &&
+                                 lane_value(s[0]);
+                            values.insert(instr.dest.id);
+                            break;
+                        default:
+                            ok = false;
+                            break;
+                    }
+                }
+            }
+            if (!ok || uses[iv.phi.id] != iv_reads ||
+                std::none_of(accesses.begin(), accesses.end(), [](const Access& a) { return a.store; })) {
+                continue;
+            }
+            for (const auto& entry : index_temps) {
+                if (uses[entry.first] != index_reads[entry.first]) ok = false;
+            }
+            // Lane values are read only inside the body
+            std::unordered_map<SymbolId, int> body_reads;
+            for (const auto& instr : body) {
+                for (const auto& src : instr.srcs) {
+                    if (src.is_temp() && values.count(src.id)) body_reads[src.id]++;
+                }
+            }
+            for (SymbolId id : values) {
+                if (uses[id] != body_reads[id]) ok = false;
+            }
+            auto may_alias = [](const Operand& x, const Operand& y) {
+                if (x.kind == y.kind && x.id == y.id) return true;
+                return x.kind == OperandKind::Variable && y.kind == OperandKind::Variable;
+            };
+            for (size_t x = 0; ok && x < accesses.size(); ++x) {
+                for (size_t y = x + 1; ok && y < accesses.size(); ++y) {
+                    const Access& ax = accesses[x];
+                    const Access& ay = accesses[y];
+                    if (!(ax.store || ay.store) || !may_alias(ax.base, ay.base)) continue;
+                    long long distance = static_cast<long long>(ay.offset) - ax.offset;
+                    if (distance >= 1 && distance < lanes) ok = false;
+                }
+            }
+            if (!ok) continue;
+
+            // ---- rewrite ----
+            const std::string pre = insert_preheader(func, header);
+            const std::string vhead = func.new_label("L_vec");
+            const std::string vbody = func.new_label("L_vecbody");
+            IRInstruction* phi = &func.find_block(header)->instructions[0];
+            Operand init;
+            for (size_t k = 0; k + 1 < phi->srcs.size(); k += 2) {
+                if (phi->srcs[k + 1].name() == pre) init = phi->srcs[k];
+            }
+
+            std::vector<IRInstruction> setup;
+            Operand vbound, guard;
+            if (bound.kind == OperandKind::IntLiteral) {
+                vbound = Operand::int_lit(bound.int_val - (lanes - 1));
+            } else {
+                vbound = func.new_temp(IRType::Int);
+                guard = func.new_temp(IRType::Bool);
+                setup.push_back(IRInstruction::make_binary(IROpcode::SUB, vbound, bound,
+                                                           Operand::int_lit(lanes - 1)));
+                setup.push_back(IRInstruction::make_binary(IROpcode::CMP_LE, guard, vbound, bound));
+            }
+
+            Operand vi = func.new_temp(IRType::Int);
+            std::map<OperandKey, Operand> splats;
+            std::unordered_map<SymbolId, Operand> vec;
+            std::map<int, Operand> indices;
+            std::vector<IRInstruction> kernel;
+            auto lanes_of = [&](const Operand& op) {
+                if (op.is_temp()) {
+                    auto it = vec.find(op.id);
+                    if (it != vec.end()) return it->second;
+                }
+                OperandKey key = operand_key(op);
+                auto it = splats.find(key);
+                if (it == splats.end()) {
+                    Operand v = func.new_temp(vtype);
+                    setup.push_back(IRInstruction::make_unary(IROpcode::VEC_SPLAT, v, op));
+                    it = splats.emplace(key, v).first;
+                }
+                return it->second;
+            };
+            auto index_at = [&](const Operand& index) {
+                int offset = is_iv(index) ? 0 : index_temps.at(index.id);
+                if (offset == 0) return vi;
+                auto it = indices.find(offset);
+                if (it == indices.end()) {
+                    Operand t = func.new_temp(IRType::Int);
+                    kernel.push_back(IRInstruction::make_binary(IROpcode::ADD, t, vi,
+                                                                Operand::int_lit(offset)));
+                    it = indices.emplace(offset, t).first;
+                }
+                return it->second;
+            };
+
+            for (const auto& instr : body) {
+                const auto& s = instr.srcs;
+                IRInstruction out;
+                switch (instr.opcode) {
+                    case IROpcode::LOAD_ELEM: {
+                        Operand v = func.new_temp(vtype);
+                        out = IRInstruction::make_vec_load(v, s[0], index_at(s[1]));
+                        vec[instr.dest.id] = v;
+                        break;
+                    }
+                    case IROpcode::STORE_ELEM:
+                        out = IRInstruction::make_vec_store(instr.dest, index_at(s[0]), lanes_of(s[1]));
+                        break;
+                    case IROpcode::MOVE:
+                        vec[instr.dest.id] = lanes_of(s[0]);
+                        continue;
+                    default: {
+                        if (instr.dest.id == iv.next.id || index_temps.count(instr.dest.id)) continue;
+                        IROpcode op = instr.opcode == IROpcode::ADD ? IROpcode::VEC_ADD
+                                    : instr.opcode == IROpcode::SUB ? IROpcode::VEC_SUB
+                                                                    : IROpcode::VEC_MUL;
+                        Operand v = func.new_temp(vtype);
+                        out = IRInstruction::make_binary(op, v, lanes_of(s[0]), lanes_of(s[1]));
+                        vec[instr.dest.id] = v;
+                        break;
+                    }
+                }
+                out.source_line = instr.source_line;
+                kernel.push_back(std::move(out));
+            }
+
+            Operand vnext = func.new_temp(IRType::Int);
+            Operand vtest = func.new_temp(IRType::Bool);
+            kernel.push_back(IRInstruction::make_binary(IROpcode::ADD, vnext, vi,
+                                                        Operand::int_lit(lanes)));
+            kernel.push_back(IRInstruction::make_jump(vhead));
+
+            BasicBlock vh;
+            vh.label = vhead;
+            IRInstruction vphi = IRInstruction::make_phi(vi);
+            vphi.srcs = {init, Operand::label(pre), vnext, Operand::label(vbody)};
+            vh.instructions.push_back(std::move(vphi));
+            vh.instructions.push_back(IRInstruction::make_binary(IROpcode::CMP_LT, vtest, vi, vbound));
+            vh.instructions.push_back(IRInstruction::make_jump_if(vtest, vbody));
+            vh.instructions.push_back(IRInstruction::make_jump(header));
+            vh.instructions[0].comment = "vectorized: " + std::to_string(lanes) + " lanes";
+            BasicBlock vb;
+            vb.label = vbody;
+            vb.instructions = std::move(kernel);
+
+            // The scalar loop now continues from the vector loop (or is
+            // entered directly when the guard fails)
+            for (size_t k = 0; k + 1 < phi->srcs.size(); k += 2) {
+                if (phi->srcs[k + 1].name() != pre) continue;
+                if (guard.is_none()) {
+                    phi->srcs[k] = vi;
+                    phi->srcs[k + 1] = Operand::label(vhead);
+                } else {
+                    phi->srcs.push_back(vi);
+                    phi->srcs.push_back(Operand::label(vhead));
+                }
+                break;
+            }
+            auto& pre_code = func.find_block(pre)->instructions;
+            pre_code.pop_back();                            // JUMP header
+            pre_code.insert(pre_code.end(), setup.begin(), setup.end());
+            if (guard.is_none()) {
+                pre_code.push_back(IRInstruction::make_jump(vhead));
+            } else {
+                pre_code.push_back(IRInstruction::make_jump_if(guard, vhead));
+                pre_code.push_back(IRInstruction::make_jump(header));
+            }
+            auto at = std::find_if(func.blocks.begin(), func.blocks.end(),
+                                   [&](const BasicBlock& blk) { return blk.label == header; });
+            at = func.blocks.insert(at, std::move(vb));
+            func.blocks.insert(at, std::move(vh));
+
+            metrics_.loops_vectorized++;
+            metrics_.instructions_modified++;
+            add_entry(func.name, header, 0,
+                      "vectorized: " + iv.phi.name() + " loop, " + std::to_string(lanes) +
+                      " int lanes in " + vhead + ", scalar epilogue in " + header);
+            changed = true;
+        }
+    }
+}
+
+// ---------------------------------------------------------------
+// reduce_induction_variables — IV strength reduction and widening
+//
+// Works on the basic induction variables of one loop per call,
+// innermost loops first:
+//
+//   * a derived IV `d = MUL i, k` (k invariant) gets its own PHI,
+//     advanced by k * step next to i's increment;
+//   * in a counted loop, LOAD_ELEM / STORE_ELEM of an invariant array
+//     at index i + c go through a pointer p = a + s * i that advances
+//     by s * step, s being the element size; the access becomes
+//     [p + s * c];
+//   * when i is then left with only its increment and the exit test,
+//     the test compares p with a + s * bound and i disappears;
+//   * a counted IV still used as an index is widened to Long, so the
+//     access no longer needs a sign extension.
+// ---------------------------------------------------------------
+void PeepholeOptimizer::reduce_induction_variables(IRFunction& func) {
+    DominatorTree dom(func);
+    LoopInfo info(dom);
+    if (info.empty()) return;
+
+    auto defs = count_definitions(func);
+    auto sites = definition_sites(func);
+    auto uses = count_uses(func);
+
+    const auto& loops = info.loops();
+    for (int l = static_cast<int>(loops.size()) - 1; l >= 0; --l) {
+        const Loop& loop = loops[l];
+        if (loop.header == 0) continue;                 // no room for a preheader
+
+        auto invariant = [&](const Operand& op) {
+            if (op.kind == OperandKind::IntLiteral) return true;
+            if (op.kind == OperandKind::Variable) return defs.count(op.id) == 0;
+            if (!op.is_temp() || defs[op.id] != 1) return false;
+            auto it = sites.find(op.id);
+            return it != sites.end() && !loop.contains(it->second.first);
+        };
+        auto ivs = find_induction_variables(func, dom, loop, sites, invariant);
+        if (ivs.empty()) continue;
+
+        auto iv_of = [&](const Operand& op) {
+            for (size_t k = 0; k < ivs.size(); ++k) {
+                if (op.is_temp() && op.id == ivs[k].phi.id) return static_cast<int>(k);
+            }
+            return -1;
+        };
+
+        // Index as (counted IV, constant offset): i, i + c, c + i or i - c
+        auto split_index = [&](const Operand& index, int& iv, int& offset) {
+            offset = 0;
+            iv = iv_of(index);
+            if (iv < 0 && index.is_temp()) {
+                auto it = sites.find(index.id);
+                if (it == sites.end()) return false;
+                const auto& def = func.blocks[it->second.first].instructions[it->second.second];
+                if (def.srcs.size() != 2) return false;
+                const Operand& a = def.srcs[0];
+                const Operand& b = def.srcs[1];
+                if (def.opcode == IROpcode::ADD && b.kind == OperandKind::IntLiteral) {
+                    iv = iv_of(a);
+                    offset = b.int_val;
+                } else if (def.opcode == IROpcode::ADD && a.kind == OperandKind::IntLiteral) {
+                    iv = iv_of(b);
+                    offset = a.int_val;
+                } else if (def.opcode == IROpcode::SUB && b.kind == OperandKind::IntLiteral) {
+                    iv = iv_of(a);
+                    offset = -b.int_val;
+                }
+            }
+            return iv >= 0 && ivs[iv].counted && offset > -(1 << 20) && offset < (1 << 20);
+        };
+
+        struct Derived { int block; size_t index; int iv; Operand factor; };
+        struct Access {
+            int block; size_t index; int iv; int offset; int size; Operand base; Operand index_op;
+        };
+        std::vector<Derived> derived;
+        std::vector<Access> accesses;
+        std::vector<char> indexed(ivs.size(), 0);      // still used as an array index
+
+        for (int b : loop.blocks) {
+            const auto& instrs = func.blocks[b].instructions;
+            for (size_t i = 0; i < instrs.size(); ++i) {
+                const auto& instr = instrs[i];
+                if (instr.opcode == IROpcode::MUL) {
+                    if (!instr.dest.is_temp() || is_wide(instr.dest.type)) continue;
+                    int a = iv_of(instr.srcs[0]);
+                    int c = iv_of(instr.srcs[1]);
+                    if (a >= 0 && invariant(instr.srcs[1])) {
+                        derived.push_back({b, i, a, instr.srcs[1]});
+                    } else if (c >= 0 && invariant(instr.srcs[0])) {
+                        derived.push_back({b, i, c, instr.srcs[0]});
+                    }
+                    continue;
+                }
+                if (instr.opcode != IROpcode::LOAD_ELEM && instr.opcode != IROpcode::STORE_ELEM)
+                    continue;
+                bool load = instr.opcode == IROpcode::LOAD_ELEM;
+                const Operand& base = load ? instr.srcs[0] : instr.dest;
+                const Operand& index = load ? instr.srcs[1] : instr.srcs[0];
+                int iv = -1, offset = 0;
+                if (!split_index(index, iv, offset)) continue;
+                if (base.type == IRType::Array && invariant(base)) {
+                    accesses.push_back({b, i, iv, offset, element_size(instr), base, index});
+                } else if (offset == 0) {
+                    indexed[iv] = 1;
+                }
+            }
+        }
+
+        // Test replacement needs every use of i to go away: its
+        // increment, the exit test, the reduced MULs and the accesses
+        // (directly or through offset temps used nowhere else).
+        std::vector<char> replace_test(ivs.size(), 0);
+        std::unordered_set<SymbolId> removed;
+        for (size_t k = 0; k < ivs.size(); ++k) {
+            const auto& iv = ivs[k];
+            if (!iv.counted || indexed[k] || uses[iv.next.id] != 1) continue;
+            int removable = 2;
+            std::unordered_map<SymbolId, int> offsets;
+            bool accessed = false;
+            for (const auto& a : accesses) {
+                if (a.iv != static_cast<int>(k)) continue;
+                accessed = true;
+                if (a.index_op.id == iv.phi.id) ++removable;
+                else offsets[a.index_op.id]++;
+            }
+            for (const auto& [id, count] : offsets) {
+                if (uses[id] == count) ++removable;
+            }
+            for (const auto& d : derived) {
+                if (d.iv == static_cast<int>(k)) ++removable;
+            }
+            if (!accessed || uses[iv.phi.id] != removable) continue;
+            replace_test[k] = 1;
+            removed.insert(iv.phi.id);
+            removed.insert(iv.next.id);
+            for (const auto& entry : offsets) removed.insert(entry.first);
+        }
+
+        std::vector<int> widen;
+        for (size_t k = 0; k < ivs.size(); ++k) {
+            if (ivs[k].counted && indexed[k] && ivs[k].phi.type == IRType::Int)
+                widen.push_back(static_cast<int>(k));
+        }
+        if (derived.empty() && accesses.empty() && widen.empty()) continue;
+
+        // ---- rewrite (block indices are looked up again by label,
+        //      since insert_preheader may add a block) ----
+        std::vector<std::string> labels;
+        for (const auto& block : func.blocks) labels.push_back(block.label);
+        const std::string header = labels[loop.header];
+        const std::string pre = insert_preheader(func, header);
+        auto instruction_at = [&](int b, size_t i) -> IRInstruction& {
+            return func.find_block(labels[b])->instructions[i];
+        };
+
+        std::vector<IRInstruction> setup;              // preheader code
+        std::vector<IRInstruction> phis;
+        std::vector<std::pair<SymbolId, IRInstruction>> steps;  // placed after an IV's increment
+        auto wrap = [](long long v) { return static_cast<int>(static_cast<std::uint32_t>(v)); };
+        auto add_iv = [&](const Operand& phi, const Operand& start, const InductionVariable& iv,
+                          const Operand& step) {
+            Operand next = func.new_temp(phi.type);
+            IRInstruction instr = IRInstruction::make_phi(phi);
+            instr.srcs = {start, Operand::label(pre), next, iv.latch};
+            phis.push_back(std::move(instr));
+            steps.push_back({iv.next.id, IRInstruction::make_binary(IROpcode::ADD, next, phi, step)});
+        };
+        // size * op as a 64-bit byte offset
+        auto bytes = [&](const Operand& op, int size) {
+            if (op.kind == OperandKind::IntLiteral && op.int_val > -(1 << 27) &&
+                op.int_val < (1 << 27)) {
+                return Operand::int_lit(op.int_val * size);
+            }
+            Operand t = func.new_temp(IRType::Long);
+            setup.push_back(IRInstruction::make_binary(IROpcode::MUL, t, op, Operand::int_lit(size)));
+            return t;
+        };
+        // base + size * op
+        auto element = [&](const Operand& base, const Operand& op, int size) {
+            Operand offset = bytes(op, size);
+            if (offset.kind == OperandKind::IntLiteral && offset.int_val == 0) return base;
+            Operand t = func.new_temp(IRType::Array);
+            setup.push_back(IRInstruction::make_binary(IROpcode::ADD, t, base, offset));
+            return t;
+        };
+
+        for (const auto& d : derived) {
+            const auto& iv = ivs[d.iv];
+            Operand start, step;
+            if (iv.init.kind == OperandKind::IntLiteral && d.factor.kind == OperandKind::IntLiteral) {
+                start = Operand::int_lit(wrap(static_cast<long long>(iv.init.int_val) * d.factor.int_val));
+            } else {
+                start = func.new_temp(IRType::Int);
+                setup.push_back(IRInstruction::make_binary(IROpcode::MUL, start, iv.init, d.factor));
+            }
+            if (d.factor.kind == OperandKind::IntLiteral) {
+                step = Operand::int_lit(wrap(static_cast<long long>(d.factor.int_val) * iv.step));
+            } else if (iv.step == 1) {
+                step = d.factor;
+            } else {
+                step = func.new_temp(IRType::Int);
+                setup.push_back(IRInstruction::make_binary(IROpcode::MUL, step, d.factor,
+                                                           Operand::int_lit(iv.step)));
+            }
+            Operand phi = func.new_temp(IRType::Int);
+            add_iv(phi, start, iv, step);
+
+            auto& instr = instruction_at(d.block, d.index);
+            std::string old_str = instruction_to_string(instr);
+            instr = IRInstruction::make_move(instr.dest, phi);
+            instr.comment = "strength reduction: induction variable";
+            metrics_.induction_variables_reduced++;
+            metrics_.instructions_modified++;
+            add_entry(func.name, labels[d.block], static_cast<int>(d.index),
+                      "induction variable: " + old_str + " → " + phi.name() + " += " +
+                      operand_to_string(step));
+        }
+
+        // One pointer per (array, IV)
+        std::map<std::pair<SymbolId, int>, Operand> pointers;
+        for (const auto& a : accesses) {
+            const auto& iv = ivs[a.iv];
+            auto key = std::make_pair(a.base.id, a.iv);
+            auto p = pointers.find(key);
+            if (p == pointers.end()) {
+                Operand phi = func.new_temp(IRType::Array);
+                add_iv(phi, element(a.base, iv.init, a.size), iv, Operand::int_lit(a.size * iv.step));
+                p = pointers.emplace(key, phi).first;
+                metrics_.induction_variables_reduced++;
+                metrics_.instructions_modified++;
+                add_entry(func.name, header, 0,
+                          "induction variable: pointer " + phi.name() + " = " +
+                          operand_to_string(a.base) + " + " + std::to_string(a.size) + " * " +
+                          iv.phi.name());
+            }
+
+            auto& instr = instruction_at(a.block, a.index);
+            if (instr.opcode == IROpcode::LOAD_ELEM) {
+                instr.srcs[0] = p->second;
+                instr.srcs[1] = Operand::int_lit(a.offset);
+            } else {
+                instr.dest = p->second;
+                instr.srcs[0] = Operand::int_lit(a.offset);
+            }
+            metrics_.instructions_modified++;
+        }
+
+        for (size_t k = 0; k < ivs.size(); ++k) {
+            if (!replace_test[k]) continue;
+            const auto& iv = ivs[k];
+            const Access& first = *std::find_if(accesses.begin(), accesses.end(),
+                                                [&](const Access& a) { return a.iv == static_cast<int>(k); });
+            Operand end = element(first.base, iv.bound, first.size);
+
+            auto& test = instruction_at(iv.test_site.first, iv.test_site.second);
+            std::string old_str = instruction_to_string(test);
+            test = IRInstruction::make_binary(iv.test_op, test.dest,
+                                              pointers.at({first.base.id, first.iv}), end);
+            metrics_.induction_variables_reduced++;
+            metrics_.instructions_modified++;
+            add_entry(func.name, header, static_cast<int>(iv.test_site.second),
+                      "induction variable: " + old_str + " → " + instruction_to_string(test));
+            test.comment = "test replaced: " + old_str;
+        }
+
+        for (int k : widen) {
+            const auto& iv = ivs[k];
+            auto retype = [&](Operand& op) {
+                if (op.is_temp() && (op.id == iv.phi.id || op.id == iv.next.id))
+                    op.type = IRType::Long;
+            };
+            for (auto& block : func.blocks) {
+                for (auto& instr : block.instructions) {
+                    retype(instr.dest);
+                    for (auto& src : instr.srcs) retype(src);
+                }
+            }
+            metrics_.induction_variables_widened++;
+            metrics_.instructions_modified++;
+            add_entry(func.name, header, 0,
+                      "induction variable: " + iv.phi.name() + " widened to 64 bits");
+        }
+
+        // New increments follow the IV's own increment, which is still
+        // in place; then the replaced IVs go, the new PHIs open the
+        // header and the set-up code ends the preheader.
+        for (auto& [after, instr] : steps) {
+            auto& code = func.find_block(labels[sites.at(after).first])->instructions;
+            auto pos = std::find_if(code.begin(), code.end(), [&](const IRInstruction& i) {
+                return i.dest.is_temp() && i.dest.id == after;
+            });
+            code.insert(pos + 1, std::move(instr));
+        }
+        for (auto& block : func.blocks) {
+            auto& code = block.instructions;
+            code.erase(std::remove_if(code.begin(), code.end(), [&](const IRInstruction& i) {
+                return i.dest.is_temp() && !dest_is_read(i.opcode) && removed.count(i.dest.id);
+            }), code.end());
+        }
+        auto& head = func.find_block(header)->instructions;
+        head.insert(head.begin(), phis.begin(), phis.end());
+        auto& pre_code = func.find_block(pre)->instructions;
+        size_t pos = pre_code.size();
+        while (pos > 0 && is_terminator(pre_code[pos - 1].opcode)) --pos;
+        pre_code.insert(pre_code.begin() + pos, setup.begin(), setup.end());
+        return;                                         // analyses are stale now
+    }
+}
+
 // ---------------------------------------------------------------
 // get_optimization_report
 // ---------------------------------------------------------------
@@ -332,6 +1603,12 @@ std::string PeepholeOptimizer::get_optimization_report() const {
     out << "Jumps chained:             " << metrics_.jumps_chained << "\n";
     out << "Copies propagated:         " << metrics_.copies_propagated << "\n";
     out << "CSEs eliminated:           " << metrics_.common_subexpressions_eliminated << "\n";
+    out << "Branches folded:           " << metrics_.branches_folded << "\n";
+    out << "Instructions hoisted:      " << metrics_.instructions_hoisted << "\n";
+    out << "IVs strength-reduced:      " << metrics_.induction_variables_reduced << "\n";
+    out << "IVs widened:               " << metrics_.induction_variables_widened << "\n";
+    if (vector_lanes_ > 0)
+        out << "Loops vectorized:          " << metrics_.loops_vectorized << "\n";
     out << "Total modified:            " << metrics_.instructions_modified << "\n";
     out << "Total removed:             " << metrics_.instructions_removed << "\n";
 
@@ -347,75 +1624,304 @@ std::string PeepholeOptimizer::get_optimization_report() const {
 
 // ---------------------------------------------------------------
 // propagate_copies
+//
+// The IR is in SSA form, so a copy `x = MOVE y` holds wherever x is
+// used: every use of x in the function is replaced by y (following
+// chains of copies).  A PHI whose arguments are all the same value
+// is a copy as well and is rewritten into a MOVE first.
 // ---------------------------------------------------------------
 void PeepholeOptimizer::propagate_copies(IRFunction& func) {
+    std::unordered_map<SymbolId, Operand> copies;
     for (auto& block : func.blocks) {
-        std::map<std::string, Operand> copies;
         for (size_t i = 0; i < block.instructions.size(); ++i) {
             auto& instr = block.instructions[i];
 
-            for (auto& src : instr.srcs) {
-                if (src.is_temp() || src.kind == OperandKind::Variable) {
-                    if (copies.find(src.name) != copies.end()) {
-                        src = copies[src.name];
-                        metrics_.copies_propagated++;
-                        metrics_.instructions_modified++;
-                    }
+            if (instr.opcode == IROpcode::PHI && instr.dest.is_temp()) {
+                const Operand* same = nullptr;
+                bool trivial = true;
+                for (size_t j = 0; j + 1 < instr.srcs.size(); j += 2) {
+                    const Operand& val = instr.srcs[j];
+                    if (val.is_none() || (val.is_temp() && val.id == instr.dest.id)) continue;
+                    if (!same) same = &val;
+                    else if (!same_operand(*same, val)) trivial = false;
                 }
-            }
-
-            if (!instr.dest.is_none()) {
-                for (auto it = copies.begin(); it != copies.end(); ) {
-                    if (it->second.name == instr.dest.name || it->first == instr.dest.name) {
-                        it = copies.erase(it);
-                    } else {
-                        ++it;
-                    }
+                if (trivial && same) {
+                    std::string old_str = instruction_to_string(instr);
+                    instr = IRInstruction::make_move(instr.dest, *same);
+                    metrics_.instructions_modified++;
+                    add_entry(func.name, block.label, static_cast<int>(i),
+                             "trivial phi: " + old_str);
                 }
+            }
 
-                if (instr.opcode == IROpcode::MOVE &&
-                    (instr.srcs[0].is_literal() || instr.srcs[0].is_temp() || instr.srcs[0].kind == OperandKind::Variable)) {
-                    copies[instr.dest.name] = instr.srcs[0];
-                }
+            if (instr.opcode == IROpcode::MOVE && instr.dest.is_temp() &&
+                (instr.srcs[0].is_literal() || instr.srcs[0].is_temp() ||
+                 instr.srcs[0].kind == OperandKind::Variable)) {
+                copies[instr.dest.id] = instr.srcs[0];
             }
         }
     }
+    if (copies.empty()) return;
+
+    auto forward = [&](Operand& op) {
+        if (!op.is_temp()) return;
+        auto cp = copies.find(op.id);
+        if (cp == copies.end()) return;
+        Operand value = cp->second;
+        for (size_t hops = 0; value.is_temp() && hops < copies.size(); ++hops) {
+            auto next = copies.find(value.id);
+            if (next == copies.end()) break;
+            value = next->second;
+        }
+        if (same_operand(value, op)) return;
+        op = value;
+        metrics_.copies_propagated++;
+        metrics_.instructions_modified++;
+    };
+
+    for (auto& block : func.blocks) {
+        for (auto& instr : block.instructions) {
+            for (auto& src : instr.srcs) forward(src);
+            // Stores read their dest (address / array base)
+            if (dest_is_read(instr.opcode)) forward(instr.dest);
+        }
+    }
 }
 
 // ---------------------------------------------------------------
-// eliminate_common_subexpressions
+// number_values — dominator-based global value numbering
+//
+// Walks the dominator tree with a scoped table of available
+// expressions (Briggs, Cooper & Simpson).  In SSA form an
+// expression over the same values has the same result wherever an
+// earlier evaluation dominates it, so the later one becomes a copy
+// of the earlier result.  Commutative operands are ordered, and a
+// PHI with the same arguments as another PHI of its block is
+// merged into it.
 // ---------------------------------------------------------------
-void PeepholeOptimizer::eliminate_common_subexpressions(IRFunction& func) {
-    for (auto& block : func.blocks) {
-        std::map<std::string, Operand> expressions;
+void PeepholeOptimizer::number_values(IRFunction& func) {
+    DominatorTree dom(func);
+    if (dom.preorder().empty()) return;
+
+    // Names assigned more than once are not SSA values and block
+    // every expression they appear in.
+    auto defs = count_definitions(func);
+    auto single_value = [&](const Operand& op) {
+        if (op.kind != OperandKind::Temp && op.kind != OperandKind::Variable) return true;
+        auto it = defs.find(op.id);
+        return it == defs.end() || it->second <= 1;
+    };
+
+    std::unordered_map<SymbolId, Operand> leader;   // copy → value it holds
+    auto canonical = [&](const Operand& op) {
+        if (op.is_temp()) {
+            auto it = leader.find(op.id);
+            if (it != leader.end()) return it->second;
+        }
+        return op;
+    };
+
+    std::map<ExprKey, Operand> available;
+    std::vector<std::vector<ExprKey>> scope(dom.cfg().num_blocks());
+
+    auto visit_block = [&](int b) {
+        auto& block = func.blocks[b];
+        std::map<ExprKey, Operand> phis;
         for (size_t i = 0; i < block.instructions.size(); ++i) {
             auto& instr = block.instructions[i];
+            if (!instr.dest.is_temp() || !single_value(instr.dest)) continue;
 
-            if (instr.opcode >= IROpcode::ADD && instr.opcode <= IROpcode::CMP_GE) {
-                std::string expr = opcode_to_string(instr.opcode) + " ";
-                for (size_t j = 0; j < instr.srcs.size(); ++j) {
-                    expr += operand_to_string(instr.srcs[j]) + (j == 0 ? ", " : "");
+            if (instr.opcode == IROpcode::MOVE) {
+                if (single_value(instr.srcs[0]))
+                    leader[instr.dest.id] = canonical(instr.srcs[0]);
+                continue;
+            }
+
+            ExprKey expr;
+            expr.opcode = instr.opcode;
+            expr.wide = is_wide(instr.dest.type);
+            if (instr.opcode == IROpcode::PHI) {
+                std::vector<std::pair<OperandKey, OperandKey>> args;
+                for (size_t j = 0; j + 1 < instr.srcs.size(); j += 2) {
+                    args.push_back({operand_key(instr.srcs[j + 1]),
+                                    operand_key(canonical(instr.srcs[j]))});
                 }
-                
-                if (expressions.find(expr) != expressions.end()) {
-                    Operand prev_dest = expressions[expr];
-                    instr = IRInstruction::make_move(instr.dest, prev_dest);
-                    metrics_.common_subexpressions_eliminated++;
-                    metrics_.instructions_modified++;
-                } else {
-                    expressions[expr] = instr.dest;
+                std::sort(args.begin(), args.end());
+                for (const auto& [label, value] : args) {
+                    expr.srcs.push_back(label);
+                    expr.srcs.push_back(value);
                 }
+            } else if (is_pure(instr.opcode) &&
+                       std::all_of(instr.srcs.begin(), instr.srcs.end(), single_value)) {
+                for (const auto& src : instr.srcs)
+                    expr.srcs.push_back(operand_key(canonical(src)));
+                if (is_commutative(instr.opcode) && expr.srcs[1] < expr.srcs[0])
+                    std::swap(expr.srcs[0], expr.srcs[1]);
+            } else {
+                continue;
+            }
+
+            // PHIs are only equal within one block: their arguments
+            // are selected by the edge that entered that block.
+            auto& table = instr.opcode == IROpcode::PHI ? phis : available;
+            auto found = table.find(expr);
+            if (found == table.end()) {
+                table.emplace(expr, instr.dest);
+                if (&table == &available) scope[b].push_back(std::move(expr));
+                continue;
+            }
+
+            std::string old_str = instruction_to_string(instr);
+            Operand value = found->second;
+            instr = IRInstruction::make_move(instr.dest, value);
+            leader[instr.dest.id] = value;
+            metrics_.common_subexpressions_eliminated++;
+            metrics_.instructions_modified++;
+            add_entry(func.name, block.label, static_cast<int>(i),
+                     "value numbering: " + old_str + " → " + value.name());
+        }
+    };
+
+    // Pre-order walk; a block's expressions leave the table once its
+    // dominator subtree is done.
+    std::vector<std::pair<int, bool>> stack = {{dom.preorder().front(), false}};
+    while (!stack.empty()) {
+        auto [b, done] = stack.back();
+        stack.pop_back();
+        if (done) {
+            for (const auto& expr : scope[b]) available.erase(expr);
+            continue;
+        }
+        visit_block(b);
+        stack.push_back({b, true});
+        const auto& kids = dom.children(b);
+        for (auto it = kids.rbegin(); it != kids.rend(); ++it) stack.push_back({*it, false});
+    }
+}
+
+// ---------------------------------------------------------------
+// hoist_loop_invariants — loop-invariant code motion
+//
+// An instruction inside a natural loop is invariant when each of its
+// operands is a literal, a value defined outside the loop, or the
+// result of another invariant instruction.  Invariant instructions
+// move to the loop's preheader, in their original order, so they run
+// once instead of once per iteration.  Only instructions that cannot
+// fault are hoisted speculatively: arithmetic, but no division by a
+// divisor that may be 0 or -1.  A LOAD / LOAD_ELEM is hoisted only
+// out of a loop without stores or calls, and only from a block that
+// runs on every pass through the loop (it dominates every exit).
+//
+// Inner loops are visited first.  A hoisted instruction lands in the
+// enclosing loop and may move again in the next round.
+// ---------------------------------------------------------------
+void PeepholeOptimizer::hoist_loop_invariants(IRFunction& func) {
+    DominatorTree dom(func);
+    LoopInfo info(dom);
+    if (info.empty()) return;
+
+    const auto& cfg = dom.cfg();
+    auto defs = count_definitions(func);
+    auto def_site = definition_sites(func);
+
+    struct Hoist {
+        std::string header;
+        std::vector<std::pair<int, size_t>> instrs;     // (block, index)
+        std::vector<IRInstruction> moved;
+    };
+    std::vector<Hoist> plans;
+    std::set<std::pair<int, size_t>> taken;
+
+    const auto& loops = info.loops();
+    for (int l = static_cast<int>(loops.size()) - 1; l >= 0; --l) {
+        const Loop& loop = loops[l];
+        if (loop.header == 0) continue;                 // no room for a preheader
+
+        bool writes_memory = false;
+        for (int b : loop.blocks) {
+            for (const auto& instr : func.blocks[b].instructions) {
+                if (dest_is_read(instr.opcode) || instr.opcode == IROpcode::CALL)
+                    writes_memory = true;
             }
+        }
+        auto exiting = info.exiting_blocks(l);
+        auto always_runs = [&](int b) {
+            return std::all_of(exiting.begin(), exiting.end(),
+                               [&](int e) { return dom.dominates(b, e); });
+        };
+
+        std::unordered_set<SymbolId> invariant;
+        auto available = [&](const Operand& op) {
+            if (op.is_literal()) return true;
+            if (op.kind == OperandKind::Variable) return defs.count(op.id) == 0;
+            if (!op.is_temp()) return false;
+            if (invariant.count(op.id)) return true;
+            auto it = def_site.find(op.id);
+            return it != def_site.end() && !loop.contains(it->second.first);
+        };
+
+        Hoist plan;
+        plan.header = func.blocks[loop.header].label;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int b : cfg.rpo) {
+                if (!loop.contains(b)) continue;
+                const auto& instrs = func.blocks[b].instructions;
+                for (size_t i = 0; i < instrs.size(); ++i) {
+                    const auto& instr = instrs[i];
+                    if (!instr.dest.is_temp() || defs[instr.dest.id] != 1) continue;
+                    if (invariant.count(instr.dest.id) || taken.count({b, i})) continue;
 
-            if (!instr.dest.is_none()) {
-                for (auto it = expressions.begin(); it != expressions.end(); ) {
-                    if (it->first.find(instr.dest.name) != std::string::npos) {
-                        it = expressions.erase(it);
-                    } else {
-                        ++it;
+                    bool movable = false;
+                    if ((instr.opcode == IROpcode::DIV || instr.opcode == IROpcode::MOD) &&
+                        instr.dest.type != IRType::Float) {
+                        const Operand& d = instr.srcs[1];
+                        movable = d.kind == OperandKind::IntLiteral && d.int_val != 0 &&
+                                  d.int_val != -1;
+                    } else if (is_pure(instr.opcode)) {
+                        movable = true;
+                    } else if (instr.opcode == IROpcode::LOAD ||
+                               instr.opcode == IROpcode::LOAD_ELEM) {
+                        movable = !writes_memory && always_runs(b);
                     }
+                    if (!movable ||
+                        !std::all_of(instr.srcs.begin(), instr.srcs.end(), available))
+                        continue;
+
+                    invariant.insert(instr.dest.id);
+                    plan.instrs.push_back({b, i});
+                    changed = true;
                 }
             }
         }
+        if (plan.instrs.empty()) continue;
+        for (auto pos : plan.instrs) {
+            taken.insert(pos);
+            plan.moved.push_back(func.blocks[pos.first].instructions[pos.second]);
+        }
+        plans.push_back(std::move(plan));
+    }
+    if (plans.empty()) return;
+
+    // Remove the hoisted instructions (back to front within a block)
+    for (auto it = taken.rbegin(); it != taken.rend(); ++it) {
+        auto& instrs = func.blocks[it->first].instructions;
+        instrs.erase(instrs.begin() + it->second);
+    }
+
+    for (auto& plan : plans) {
+        std::string pre = insert_preheader(func, plan.header);
+        BasicBlock* block = func.find_block(pre);
+        size_t pos = block->instructions.size();
+        while (pos > 0 && is_terminator(block->instructions[pos - 1].opcode)) --pos;
+        for (auto& instr : plan.moved) {
+            add_entry(func.name, pre, static_cast<int>(pos),
+                     "loop invariant: hoisted " + instruction_to_string(instr) +
+                     " out of " + plan.header);
+            block->instructions.insert(block->instructions.begin() + pos++, std::move(instr));
+            metrics_.instructions_hoisted++;
+            metrics_.instructions_modified++;
+        }
     }
 }
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 
 #include "ir/basic_block.h"
+#include "utils/thread_pool.h"
 
 // ---------------------------------------------------------------
 // OptimizationEntry — a single optimization performed
@@ -28,6 +30,13 @@ struct OptimizationMetrics {
     int jumps_chained = 0;
     int copies_propagated = 0;
     int common_subexpressions_eliminated = 0;
+    int branches_folded = 0;
+    int instructions_hoisted = 0;
+    int induction_variables_reduced = 0;
+    int induction_variables_widened = 0;
+    int loops_vectorized = 0;
+
+    OptimizationMetrics& operator+=(const OptimizationMetrics& other);
 };
 
 // ---------------------------------------------------------------
@@ -38,7 +47,9 @@ public:
     explicit PeepholeOptimizer(IRProgram& program);
 
     /// Apply all optimization passes.
-    void optimize();
+    /// With a pool, each round runs the functions in parallel; the
+    /// result, metrics and log order are the same as the serial run.
+    void optimize(utils::ThreadPool* pool = nullptr);
 
     /// Get human-readable report of changes.
     std::string get_optimization_report() const;
@@ -46,19 +57,37 @@ public:
     /// Get raw metrics.
     const OptimizationMetrics& get_metrics() const { return metrics_; }
 
+    /// Called after every pass that changed a function (serial runs
+    /// only), with the program in a consistent state.  Used by
+    /// `compiler interp --verify-passes` to re-run the program.
+    using PassHook = std::function<void(const char* pass, const IRFunction& func)>;
+    void set_pass_hook(PassHook hook) { pass_hook_ = std::move(hook); }
+
+    /// Int lanes per vector for vectorize_loops: 4 (SSE4.1), 8 (AVX2)
+    /// or 0 to leave loops scalar (the default).
+    void set_vector_lanes(int lanes) { vector_lanes_ = lanes; }
+
 private:
     IRProgram& program_;
     std::vector<OptimizationEntry> log_;
     OptimizationMetrics metrics_;
+    PassHook pass_hook_;
+    int vector_lanes_ = 0;
+
+    // One round of all passes over a single function
+    void run_round(IRFunction& func);
 
     // Individual passes
-    void fold_constants(IRFunction& func);
+    void propagate_constants(IRFunction& func);
     void simplify_algebraic(IRFunction& func);
     void reduce_strength(IRFunction& func);
     void eliminate_dead_code(IRFunction& func);
     void chain_jumps(IRFunction& func);
     void propagate_copies(IRFunction& func);
-    void eliminate_common_subexpressions(IRFunction& func);
+    void number_values(IRFunction& func);
+    void hoist_loop_invariants(IRFunction& func);
+    void vectorize_loops(IRFunction& func);
+    void reduce_induction_variables(IRFunction& func);
 
     void add_entry(const std::string& func, const std::string& block,
                    int idx, const std::string& desc);
@@ -0,0 +1,138 @@
+#include "ir/profile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+constexpr std::uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t kFnvPrime = 0x100000001b3ULL;
+
+void fnv(std::uint64_t& hash, const std::string& text) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= kFnvPrime;
+    }
+    hash ^= 0xFF;       // separator: "ab","c" differs from "a","bc"
+    hash *= kFnvPrime;
+}
+
+bool parse_count(const std::string& text, std::uint64_t& out) {
+    if (text.empty()) return false;
+    out = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        out = out * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+std::uint64_t profile_cfg_hash(const IRFunction& func) {
+    std::uint64_t hash = kFnvOffset;
+    for (const auto& block : func.blocks) {
+        fnv(hash, block.label);
+        for (const auto& instr : block.instructions) {
+            switch (instr.opcode) {
+                case IROpcode::JUMP:
+                case IROpcode::JUMP_IF:
+                case IROpcode::JUMP_IF_NOT:
+                    fnv(hash, instr.dest.name());
+                    break;
+                case IROpcode::RETURN:
+                    fnv(hash, "ret");
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return hash;
+}
+
+std::string profile_function_header(const IRFunction& func) {
+    char hash[17];
+    std::snprintf(hash, sizeof hash, "%016llx", static_cast<unsigned long long>(profile_cfg_hash(func)));
+    return "fn " + func.name + " " + hash + "\n";
+}
+
+std::string profile_block_format(const std::string& func, const std::string& label) {
+    return "block " + func + " " + label + " %lu\n";
+}
+
+std::string profile_call_format(const std::string& caller, const std::string& callee) {
+    return "call " + caller + " " + callee + " %lu\n";
+}
+
+// ---------------------------------------------------------------
+// ProfileData
+// ---------------------------------------------------------------
+bool ProfileData::parse(const std::string& text, std::string& error) {
+    std::istringstream in(text);
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        std::istringstream fields(line);
+        std::string kind, a, b, c, extra;
+        fields >> kind >> a >> b >> c >> extra;
+        if (kind.empty()) continue;
+        auto fail = [&](const char* message) {
+            error = "line " + std::to_string(line_no) + ": " + message;
+            return false;
+        };
+        if (!extra.empty()) return fail("too many fields");
+
+        if (kind == "fn") {
+            if (b.empty() || !c.empty()) return fail("expected 'fn <name> <hash>'");
+            char* end = nullptr;
+            const unsigned long long hash = std::strtoull(b.c_str(), &end, 16);
+            if (*end != '\0') return fail("invalid CFG hash");
+            functions_[a].cfg_hash = hash;
+        } else if (kind == "block" || kind == "call") {
+            std::uint64_t count = 0;
+            if (!parse_count(c, count)) return fail("expected '<kind> <name> <name> <count>'");
+            if (kind == "block") {
+                functions_[a].blocks[b] += count;
+            } else {
+                std::uint64_t& total = calls_[{a, b}];
+                total += count;
+                if (total > max_call_count_) max_call_count_ = total;
+            }
+        } else {
+            return fail("unknown record");
+        }
+    }
+    return true;
+}
+
+const FunctionProfile* ProfileData::function(const IRFunction& func) const {
+    auto it = functions_.find(func.name);
+    if (it == functions_.end() || it->second.cfg_hash != profile_cfg_hash(func)) return nullptr;
+    return &it->second;
+}
+
+std::vector<std::uint64_t> ProfileData::block_counts(const IRFunction& func) const {
+    std::vector<std::uint64_t> counts;
+    const FunctionProfile* profile = function(func);
+    if (!profile) return counts;
+    for (const auto& block : func.blocks) {
+        auto it = profile->blocks.find(block.label);
+        counts.push_back(it == profile->blocks.end() ? 0 : it->second);
+    }
+    return counts;
+}
+
+bool ProfileData::call_count(const std::string& caller, const std::string& callee,
+                             std::uint64_t& count) const {
+    auto it = calls_.find({caller, callee});
+    if (it == calls_.end()) return false;
+    count = it->second;
+    return true;
+}
+
+bool ProfileData::is_hot_call(std::uint64_t count) const {
+    return count > 0 && count * 100 >= max_call_count_;
+}
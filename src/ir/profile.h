@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir/basic_block.h"
+
+// ---------------------------------------------------------------
+// ProfileData — execution counts of a --profile-generate build
+//
+// The instrumented program counts every basic block and every call
+// to a function of the program, and when main returns writes one
+// line per counter:
+//
+//   fn fib 8f3a61c2d0b4e597       function header: CFG hash (hex)
+//   block fib entry 177           block executions
+//   call fib fib 176              calls caller -> callee (summed over sites)
+//
+// Counters are keyed by the IR the code generator sees (after
+// optimization and SSA destruction).  A function whose CFG hash
+// differs from the recorded one has been edited or optimized
+// differently since, and its block counts are ignored.
+// ---------------------------------------------------------------
+struct FunctionProfile {
+    std::uint64_t cfg_hash = 0;
+    std::unordered_map<std::string, std::uint64_t> blocks;     // label -> executions
+};
+
+class ProfileData {
+public:
+    /// Parse a profile file; false with a message (and line) on malformed text.
+    bool parse(const std::string& text, std::string& error);
+
+    bool empty() const { return functions_.empty() && calls_.empty(); }
+
+    /// Counts for `func`, or nullptr when it was not profiled or its CFG changed.
+    const FunctionProfile* function(const IRFunction& func) const;
+
+    /// Executions of each block of `func` in block order; empty without a profile.
+    std::vector<std::uint64_t> block_counts(const IRFunction& func) const;
+
+    /// Recorded calls caller -> callee.  False when the edge was never
+    /// instrumented (no such call in the profiled build, e.g. it was inlined).
+    bool call_count(const std::string& caller, const std::string& callee, std::uint64_t& count) const;
+
+    /// A call edge taking at least 1% of the hottest edge's calls.
+    bool is_hot_call(std::uint64_t count) const;
+
+private:
+    std::unordered_map<std::string, FunctionProfile> functions_;
+    std::map<std::pair<std::string, std::string>, std::uint64_t> calls_;
+    std::uint64_t max_call_count_ = 0;
+};
+
+/// Hash of the block labels and branch targets of `func` (FNV-1a).
+std::uint64_t profile_cfg_hash(const IRFunction& func);
+
+// Line formats written by the instrumented program (printf-style,
+// the count is the single %lu argument of block and call lines).
+std::string profile_function_header(const IRFunction& func);
+std::string profile_block_format(const std::string& func, const std::string& label);
+std::string profile_call_format(const std::string& caller, const std::string& callee);
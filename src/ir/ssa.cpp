@@ -0,0 +1,498 @@
+#include "ir/ssa.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "ir/dominators.h"
+#include "utils/bit_vector.h"
+
+using utils::BitVector;
+
+namespace {
+
+bool is_value(const Operand& op) {
+    return op.kind == OperandKind::Temp || op.kind == OperandKind::Variable;
+}
+
+// STORE / STORE_ELEM / VEC_STORE read their dest (the address / array base).
+bool dest_is_read(IROpcode op) {
+    return op == IROpcode::STORE || op == IROpcode::STORE_ELEM || op == IROpcode::VEC_STORE;
+}
+
+bool defines_value(const IRInstruction& instr) {
+    return is_value(instr.dest) && !dest_is_read(instr.opcode);
+}
+
+bool same_value(const Operand& a, const Operand& b) {
+    return is_value(a) && a.kind == b.kind && a.id == b.id;
+}
+
+// Value used on a path where the name was never assigned.  The
+// language zero-initializes declarations, so zero is the natural
+// stand-in.
+Operand undefined_value(IRType type) {
+    switch (type) {
+        case IRType::Float: return Operand::float_lit(0.0);
+        case IRType::Bool:  return Operand::bool_lit(false);
+        default:            return Operand::int_lit(0);
+    }
+}
+
+// ---------------------------------------------------------------
+// NameTable — dense numbering of the Temp/Variable names of a function
+// ---------------------------------------------------------------
+struct NameTable {
+    std::unordered_map<SymbolId, int> index;
+    std::vector<Operand> proto;     // first occurrence (kind and type)
+
+    int add(const Operand& op) {
+        auto [it, inserted] = index.emplace(op.id, static_cast<int>(proto.size()));
+        if (inserted) proto.push_back(op);
+        return it->second;
+    }
+    int find(SymbolId id) const {
+        auto it = index.find(id);
+        return it == index.end() ? -1 : it->second;
+    }
+    int size() const { return static_cast<int>(proto.size()); }
+};
+
+NameTable number_names(const IRFunction& func) {
+    NameTable names;
+    for (const auto& param : func.params) {
+        names.add(Operand::var(param.first, param.second));
+    }
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (is_value(instr.dest)) names.add(instr.dest);
+            for (const auto& src : instr.srcs) {
+                if (is_value(src)) names.add(src);
+            }
+        }
+    }
+    return names;
+}
+
+// ---------------------------------------------------------------
+// compute_live_in — names live on entry to each block
+//
+// PHI destinations are defined at the top of their block and are
+// not part of its live-in set; PHI arguments are live-out of the
+// predecessor they are paired with.
+// ---------------------------------------------------------------
+std::vector<BitVector> compute_live_in(const IRFunction& func,
+                                       const ControlFlowGraph& cfg,
+                                       const NameTable& names) {
+    const int n = cfg.num_blocks();
+    const size_t num_names = static_cast<size_t>(names.size());
+    std::vector<BitVector> use(n, BitVector(num_names));
+    std::vector<BitVector> def(n, BitVector(num_names));
+    std::vector<BitVector> phi_out(n, BitVector(num_names));
+
+    for (int b = 0; b < n; ++b) {
+        auto read = [&](const Operand& op) {
+            if (!is_value(op)) return;
+            int v = names.find(op.id);
+            if (v >= 0 && !def[b].test(v)) use[b].set(v);
+        };
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (instr.opcode == IROpcode::PHI) {
+                if (is_value(instr.dest)) def[b].set(names.find(instr.dest.id));
+                for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+                    int p = cfg.index_of(instr.srcs[i + 1].id);
+                    if (p >= 0 && is_value(instr.srcs[i]))
+                        phi_out[p].set(names.find(instr.srcs[i].id));
+                }
+                continue;
+            }
+            for (const auto& src : instr.srcs) read(src);
+            if (dest_is_read(instr.opcode)) {
+                read(instr.dest);
+            } else if (is_value(instr.dest)) {
+                def[b].set(names.find(instr.dest.id));
+            }
+        }
+    }
+
+    std::vector<BitVector> live_in(n, BitVector(num_names));
+    BitVector live_out(num_names);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = cfg.rpo.rbegin(); it != cfg.rpo.rend(); ++it) {
+            int b = *it;
+            live_out = phi_out[b];
+            for (int s : cfg.succs[b]) live_out.union_with(live_in[s]);
+            changed |= live_in[b].assign_union_diff(use[b], live_out, def[b]);
+        }
+    }
+    return live_in;
+}
+
+// Position before the trailing terminators (JUMP_IF + JUMP, RETURN).
+size_t terminator_start(const BasicBlock& block) {
+    size_t pos = block.instructions.size();
+    while (pos > 0 && is_terminator(block.instructions[pos - 1].opcode)) --pos;
+    return pos;
+}
+
+// ---------------------------------------------------------------
+// Parallel copies
+// ---------------------------------------------------------------
+struct Copy {
+    Operand dest;
+    Operand src;
+};
+
+// Order a parallel copy so that no destination is overwritten
+// before every copy reading it has run.  When only cycles are left
+// one destination is saved in a fresh temp first.
+std::vector<IRInstruction> sequentialize(std::vector<Copy> pending, IRFunction& func) {
+    std::vector<IRInstruction> out;
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [](const Copy& c) { return same_value(c.dest, c.src); }),
+                  pending.end());
+
+    while (!pending.empty()) {
+        auto ready = std::find_if(pending.begin(), pending.end(), [&](const Copy& c) {
+            return std::none_of(pending.begin(), pending.end(), [&](const Copy& other) {
+                return same_value(other.src, c.dest);
+            });
+        });
+        if (ready != pending.end()) {
+            out.push_back(IRInstruction::make_move(ready->dest, ready->src));
+            pending.erase(ready);
+            continue;
+        }
+
+        Operand saved = pending.front().dest;
+        Operand tmp = func.new_temp(saved.type);
+        out.push_back(IRInstruction::make_move(tmp, saved));
+        for (auto& c : pending) {
+            if (same_value(c.src, saved)) c.src = tmp;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------
+// remove_unreachable_blocks
+// ---------------------------------------------------------------
+void remove_unreachable_blocks(IRFunction& func) {
+    ControlFlowGraph cfg(func);
+    const int n = cfg.num_blocks();
+
+    std::vector<BasicBlock> kept;
+    kept.reserve(cfg.rpo.size());
+    for (int b = 0; b < n; ++b) {
+        if (!cfg.reachable(b)) continue;
+        for (auto& instr : func.blocks[b].instructions) {
+            if (instr.opcode != IROpcode::PHI) continue;
+            std::vector<Operand> srcs;
+            for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+                int p = cfg.index_of(instr.srcs[i + 1].id);
+                if (p < 0 || !cfg.reachable(p)) continue;
+                const auto& preds = cfg.preds[b];
+                if (std::find(preds.begin(), preds.end(), p) == preds.end()) continue;
+                srcs.push_back(instr.srcs[i]);
+                srcs.push_back(instr.srcs[i + 1]);
+            }
+            instr.srcs = std::move(srcs);
+        }
+        kept.push_back(std::move(func.blocks[b]));
+    }
+    func.blocks = std::move(kept);
+}
+
+// ---------------------------------------------------------------
+// construct_ssa
+// ---------------------------------------------------------------
+void construct_ssa(IRFunction& func) {
+    if (func.blocks.empty()) return;
+
+    remove_unreachable_blocks(func);
+    DominatorTree dom(func);
+    const ControlFlowGraph& cfg = dom.cfg();
+    const int n = cfg.num_blocks();
+
+    NameTable names = number_names(func);
+    const int num_names = names.size();
+
+    // 1. Definition sites; parameters are defined on entry.
+    std::vector<std::vector<int>> def_blocks(num_names);
+    for (const auto& param : func.params) {
+        def_blocks[names.find(intern_symbol(param.first))].push_back(0);
+    }
+    for (int b = 0; b < n; ++b) {
+        for (const auto& instr : func.blocks[b].instructions) {
+            if (!defines_value(instr)) continue;
+            auto& sites = def_blocks[names.find(instr.dest.id)];
+            if (sites.empty() || sites.back() != b) sites.push_back(b);
+        }
+    }
+
+    // 2. PHI insertion on the iterated dominance frontier, pruned by
+    //    liveness so that no dead or half-undefined PHI is created.
+    std::vector<BitVector> live_in = compute_live_in(func, cfg, names);
+    std::vector<std::vector<int>> phi_names(n);     // names of the inserted PHIs per block
+    std::vector<int> has_phi(n, -1), on_list(n, -1);
+    for (int v = 0; v < num_names; ++v) {
+        std::vector<int> work = def_blocks[v];
+        for (int b : work) on_list[b] = v;
+        while (!work.empty()) {
+            int x = work.back();
+            work.pop_back();
+            for (int y : dom.frontier(x)) {
+                if (has_phi[y] == v || !live_in[y].test(v)) continue;
+                has_phi[y] = v;
+                phi_names[y].push_back(v);
+                if (on_list[y] != v) {
+                    on_list[y] = v;
+                    work.push_back(y);
+                }
+            }
+        }
+    }
+    for (int b = 0; b < n; ++b) {
+        auto& instrs = func.blocks[b].instructions;
+        std::vector<IRInstruction> phis;
+        for (int v : phi_names[b]) {
+            phis.push_back(IRInstruction::make_phi(names.proto[v]));
+        }
+        instrs.insert(instrs.begin(), phis.begin(), phis.end());
+    }
+
+    // 3. Renaming: a dominator-tree walk with one stack of reaching
+    //    definitions per name.  Every definition gets a fresh temp.
+    std::vector<std::vector<Operand>> stacks(num_names);
+    for (const auto& param : func.params) {
+        stacks[names.find(intern_symbol(param.first))].push_back(
+            Operand::var(param.first, param.second));
+    }
+    std::vector<int> def_log;       // names pushed, popped on leaving a subtree
+    int next_temp = 0;
+
+    auto reaching = [&](int v) {
+        return stacks[v].empty() ? undefined_value(names.proto[v].type) : stacks[v].back();
+    };
+    auto rename_use = [&](Operand& op) {
+        if (is_value(op)) op = reaching(names.find(op.id));
+    };
+    auto rename_def = [&](Operand& op) {
+        int v = names.find(op.id);
+        op = Operand::temp(next_temp++, op.type);
+        stacks[v].push_back(op);
+        def_log.push_back(v);
+    };
+
+    struct Frame {
+        int block;
+        size_t next_child;
+        size_t log_mark;
+    };
+    std::vector<Frame> walk;
+    auto enter = [&](int b) {
+        walk.push_back({b, 0, def_log.size()});
+        BasicBlock& block = func.blocks[b];
+        for (auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::PHI) {
+                if (is_value(instr.dest)) rename_def(instr.dest);
+                continue;
+            }
+            for (auto& src : instr.srcs) rename_use(src);
+            if (dest_is_read(instr.opcode)) {
+                rename_use(instr.dest);
+            } else if (is_value(instr.dest)) {
+                rename_def(instr.dest);
+            }
+        }
+
+        // Fill the PHI arguments this block provides to its successors.
+        // The first phi_names[s].size() PHIs of s are the inserted ones,
+        // whose arguments are appended; existing PHIs (from && / ||)
+        // already list this block and only need their value renamed.
+        for (int s : cfg.succs[b]) {
+            auto& succ_instrs = func.blocks[s].instructions;
+            for (size_t i = 0; i < succ_instrs.size(); ++i) {
+                auto& phi = succ_instrs[i];
+                if (phi.opcode != IROpcode::PHI) continue;
+                if (i < phi_names[s].size()) {
+                    phi.srcs.push_back(reaching(phi_names[s][i]));
+                    phi.srcs.push_back(Operand::label(block.label));
+                    continue;
+                }
+                for (size_t j = 0; j + 1 < phi.srcs.size(); j += 2) {
+                    if (phi.srcs[j + 1].id == intern_symbol(block.label))
+                        rename_use(phi.srcs[j]);
+                }
+            }
+        }
+    };
+
+    enter(dom.preorder().front());
+    while (!walk.empty()) {
+        Frame& top = walk.back();
+        const auto& kids = dom.children(top.block);
+        if (top.next_child < kids.size()) {
+            enter(kids[top.next_child++]);
+            continue;
+        }
+        while (def_log.size() > top.log_mark) {
+            stacks[def_log.back()].pop_back();
+            def_log.pop_back();
+        }
+        walk.pop_back();
+    }
+
+    func.temp_counter = next_temp;
+}
+
+// ---------------------------------------------------------------
+// destruct_ssa
+// ---------------------------------------------------------------
+void destruct_ssa(IRFunction& func) {
+    bool any_phi = false;
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::PHI) any_phi = true;
+        }
+    }
+    if (!any_phi) return;
+
+    ControlFlowGraph cfg(func);
+    const int n = cfg.num_blocks();
+
+    // 1. Collect the parallel copy of every edge pred -> succ.
+    struct EdgeCopies {
+        int pred;
+        int succ;
+        std::vector<Copy> copies;
+    };
+    std::vector<EdgeCopies> edges;
+    for (int s = 0; s < n; ++s) {
+        for (int p : cfg.preds[s]) {
+            SymbolId pred_label = intern_symbol(func.blocks[p].label);
+            EdgeCopies edge{p, s, {}};
+            for (const auto& instr : func.blocks[s].instructions) {
+                if (instr.opcode != IROpcode::PHI) continue;
+                for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+                    if (instr.srcs[i + 1].id != pred_label) continue;
+                    if (!instr.srcs[i].is_none())
+                        edge.copies.push_back({instr.dest, instr.srcs[i]});
+                    break;
+                }
+            }
+            if (!edge.copies.empty()) edges.push_back(std::move(edge));
+        }
+    }
+
+    // 2. Decide where each parallel copy goes (on the unmodified IR).
+    //    Critical edges are split unless the copies can be hoisted
+    //    above the branch: nothing they overwrite may be read by the
+    //    branch or be live into the predecessor's other successors.
+    enum class Place { PredEnd, SuccStart, Split };
+    std::vector<Place> place(edges.size(), Place::PredEnd);
+    NameTable names;
+    std::vector<BitVector> live_in;
+    for (size_t e = 0; e < edges.size(); ++e) {
+        const auto& edge = edges[e];
+        const BasicBlock& pred = func.blocks[edge.pred];
+
+        bool branch_reads = false;
+        for (size_t i = terminator_start(pred); i < pred.instructions.size(); ++i) {
+            for (const auto& src : pred.instructions[i].srcs) {
+                for (const auto& c : edge.copies) branch_reads |= same_value(src, c.dest);
+            }
+        }
+
+        if (cfg.succs[edge.pred].size() == 1 && !branch_reads) continue;
+        if (cfg.preds[edge.succ].size() == 1) {
+            place[e] = Place::SuccStart;
+            continue;
+        }
+        if (live_in.empty()) {
+            names = number_names(func);
+            live_in = compute_live_in(func, cfg, names);
+        }
+        bool hoist = !branch_reads;
+        for (int t : cfg.succs[edge.pred]) {
+            if (t == edge.succ || !hoist) continue;
+            for (const auto& c : edge.copies) {
+                if (live_in[t].test(names.find(c.dest.id))) hoist = false;
+            }
+            for (const auto& instr : func.blocks[t].instructions) {
+                if (instr.opcode != IROpcode::PHI) continue;
+                for (size_t i = 0; i + 1 < instr.srcs.size(); i += 2) {
+                    if (instr.srcs[i + 1].name() != pred.label) continue;
+                    for (const auto& c : edge.copies)
+                        hoist &= !same_value(instr.srcs[i], c.dest);
+                }
+            }
+        }
+        place[e] = hoist ? Place::PredEnd : Place::Split;
+    }
+
+    // 3. Remove the PHIs and materialize the copies.
+    for (auto& block : func.blocks) {
+        auto& instrs = block.instructions;
+        instrs.erase(std::remove_if(instrs.begin(), instrs.end(),
+                                    [](const IRInstruction& i) { return i.opcode == IROpcode::PHI; }),
+                     instrs.end());
+    }
+
+    std::vector<std::vector<BasicBlock>> splits_after(n);
+    for (size_t e = 0; e < edges.size(); ++e) {
+        auto& edge = edges[e];
+        std::vector<IRInstruction> moves = sequentialize(std::move(edge.copies), func);
+        BasicBlock& pred = func.blocks[edge.pred];
+        BasicBlock& succ = func.blocks[edge.succ];
+
+        switch (place[e]) {
+            case Place::PredEnd: {
+                auto& instrs = pred.instructions;
+                instrs.insert(instrs.begin() + terminator_start(pred), moves.begin(), moves.end());
+                break;
+            }
+            case Place::SuccStart:
+                succ.instructions.insert(succ.instructions.begin(), moves.begin(), moves.end());
+                break;
+            case Place::Split: {
+                BasicBlock split;
+                split.label = func.new_label("L_split");
+                split.instructions = std::move(moves);
+                split.instructions.push_back(IRInstruction::make_jump(succ.label));
+                for (auto& instr : pred.instructions) {
+                    if ((instr.opcode == IROpcode::JUMP ||
+                         instr.opcode == IROpcode::JUMP_IF ||
+                         instr.opcode == IROpcode::JUMP_IF_NOT) &&
+                        instr.dest.name() == succ.label) {
+                        instr.dest = Operand::label(split.label);
+                    }
+                }
+                splits_after[edge.pred].push_back(std::move(split));
+                break;
+            }
+        }
+    }
+
+    // Split blocks follow their predecessor in the layout.
+    std::vector<BasicBlock> blocks;
+    for (int b = 0; b < n; ++b) {
+        blocks.push_back(std::move(func.blocks[b]));
+        for (auto& split : splits_after[b]) blocks.push_back(std::move(split));
+    }
+    func.blocks = std::move(blocks);
+}
+
+// ---------------------------------------------------------------
+// Whole-program drivers
+// ---------------------------------------------------------------
+void construct_ssa(IRProgram& program) {
+    for (auto& func : program.functions) construct_ssa(func);
+}
+
+void destruct_ssa(IRProgram& program) {
+    for (auto& func : program.functions) destruct_ssa(func);
+}
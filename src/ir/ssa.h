@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ir/basic_block.h"
+
+// ---------------------------------------------------------------
+// SSA construction and destruction
+//
+// IRGenerator emits source variables as Variable operands that may
+// be assigned many times (`[x] = MOVE 0`).  construct_ssa turns a
+// function into pruned SSA form:
+//
+//   1. unreachable blocks are removed;
+//   2. PHIs are inserted at the iterated dominance frontier of the
+//      definitions of every name that is live-in there;
+//   3. a dominator-tree walk renames every definition to a fresh
+//      temp (t0, t1, ... in dominator order) and rewrites its uses.
+//
+// Parameters are defined on entry by their incoming value, so an
+// unassigned parameter keeps its Variable operand.  Temps with more
+// than one definition are handled the same way as variables.
+//
+// destruct_ssa replaces the PHIs with copies on the incoming edges.
+// The copies of one edge form a parallel copy; they are placed at
+// the end of the predecessor, at the start of a single-predecessor
+// successor, before a conditional branch whose other target does
+// not need the overwritten values, or in a new block splitting the
+// critical edge, and are then sequentialized (cycles are broken
+// through a fresh temp).
+// ---------------------------------------------------------------
+
+/// Rewrite `func` into pruned SSA form.
+void construct_ssa(IRFunction& func);
+
+/// Replace every PHI in `func` with sequentialized edge copies.
+void destruct_ssa(IRFunction& func);
+
+/// Drop blocks not reachable from the entry, and PHI arguments whose
+/// label is not an actual predecessor (stale after jump rewriting).
+void remove_unreachable_blocks(IRFunction& func);
+
+/// Run construct_ssa / destruct_ssa over every function with a body.
+void construct_ssa(IRProgram& program);
+void destruct_ssa(IRProgram& program);
@@ -0,0 +1,145 @@
+#include "lexer/char_scan.h"
+
+#include <cstring>
+#include <initializer_list>
+
+namespace char_scan {
+
+namespace {
+
+// ---------------------------------------------------------------
+// Скалярная реализация: класс байта — из таблицы
+// ---------------------------------------------------------------
+enum : unsigned char { kSpace = 1, kIdent = 2, kDigit = 4 };
+
+struct ClassTable {
+    unsigned char cls[256] = {};
+    ClassTable() {
+        for (const char* c = " \t\n\r"; *c; ++c) cls[static_cast<unsigned char>(*c)] |= kSpace;
+        for (int c = 'a'; c <= 'z'; ++c) cls[c] |= kIdent;
+        for (int c = 'A'; c <= 'Z'; ++c) cls[c] |= kIdent;
+        for (int c = '0'; c <= '9'; ++c) cls[c] |= kIdent | kDigit;
+        cls[static_cast<unsigned char>('_')] |= kIdent;
+    }
+};
+
+const ClassTable table;
+
+inline bool is(char c, unsigned char cls) {
+    return (table.cls[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+// Перевод строки, кончающийся на p: '\n' или '\r' без '\n' следом
+inline void note_newline(const char* p, const char* end, Newlines& nl) {
+    if (*p == '\n' || (*p == '\r' && (p + 1 == end || p[1] != '\n'))) {
+        ++nl.count;
+        nl.line_start = p + 1;
+    }
+}
+
+const char* scalar_skip_whitespace(const char* p, const char* end, Newlines& nl) {
+    for (; p < end && is(*p, kSpace); ++p) note_newline(p, end, nl);
+    return p;
+}
+
+const char* scalar_find_line_end(const char* p, const char* end) {
+    while (p < end && *p != '\n' && *p != '\r') ++p;
+    return p;
+}
+
+const char* scalar_find_comment_end(const char* p, const char* end, Newlines& nl) {
+    for (; p < end; ++p) {
+        if (*p == '*' && p + 1 < end && p[1] == '/') return p;
+        note_newline(p, end, nl);
+    }
+    return end;
+}
+
+const char* scalar_skip_ident(const char* p, const char* end) {
+    while (p < end && is(*p, kIdent)) ++p;
+    return p;
+}
+
+const char* scalar_skip_digits(const char* p, const char* end) {
+    while (p < end && is(*p, kDigit)) ++p;
+    return p;
+}
+
+const Kernels scalar_kernels = {
+    scalar_skip_whitespace, scalar_find_line_end, scalar_find_comment_end,
+    scalar_skip_ident, scalar_skip_digits,
+};
+
+bool supported(Level level) {
+    switch (level) {
+    case Level::Scalar:
+        return true;
+#ifdef MINICOMPILER_SIMD_SCAN
+    case Level::SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case Level::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const Kernels& kernels_for(Level level) {
+#ifdef MINICOMPILER_SIMD_SCAN
+    if (level == Level::AVX2) return avx2_kernels();
+    if (level == Level::SSE42) return sse42_kernels();
+#endif
+    (void)level;
+    return scalar_kernels;
+}
+
+struct Active {
+    Level level;
+    const Kernels* kernels;
+    Active() : level(best_level()), kernels(&kernels_for(level)) {}
+};
+
+Active& active() {
+    static Active state;
+    return state;
+}
+
+} // namespace
+
+const Kernels& kernels() { return *active().kernels; }
+
+Level level() { return active().level; }
+
+Level best_level() {
+    if (supported(Level::AVX2)) return Level::AVX2;
+    if (supported(Level::SSE42)) return Level::SSE42;
+    return Level::Scalar;
+}
+
+bool set_level(Level level) {
+    if (!supported(level)) return false;
+    active().level = level;
+    active().kernels = &kernels_for(level);
+    return true;
+}
+
+const char* level_name(Level level) {
+    switch (level) {
+    case Level::SSE42: return "sse4.2";
+    case Level::AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+bool parse_level(const char* name, Level& out) {
+    for (Level level : {Level::Scalar, Level::SSE42, Level::AVX2}) {
+        if (std::strcmp(name, level_name(level)) == 0) {
+            out = level;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace char_scan
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+// ---------------------------------------------------------------
+// char_scan — быстрые пути Scanner'а: классификация байтов блоками
+//
+// Каждая функция получает диапазон [p, end) и возвращает первый
+// байт, на котором кончается серия своего класса.  Реализаций
+// три: скалярная (таблица классов), SSE4.2 (16 байт за шаг) и
+// AVX2 (32 байта); лучшая из поддерживаемых процессором
+// выбирается при первом вызове.  Результат от уровня не зависит.
+//
+// Переводы строк считаются так же, как Scanner::advance(): "\r\n"
+// — одна строка, одиночный '\r' — тоже.
+// ---------------------------------------------------------------
+namespace char_scan {
+
+enum class Level { Scalar, SSE42, AVX2 };
+
+/// Переводы строк внутри пропущенного диапазона.
+struct Newlines {
+    int count = 0;
+    const char* line_start = nullptr;   // байт после последнего перевода
+};
+
+struct Kernels {
+    // ' ', '\t', '\n', '\r'
+    const char* (*skip_whitespace)(const char* p, const char* end, Newlines& nl);
+    // тело комментария // — до '\n' или '\r'
+    const char* (*find_line_end)(const char* p, const char* end);
+    // тело комментария /* — до "*/" (или end)
+    const char* (*find_comment_end)(const char* p, const char* end, Newlines& nl);
+    // [A-Za-z0-9_]
+    const char* (*skip_ident)(const char* p, const char* end);
+    // [0-9]
+    const char* (*skip_digits)(const char* p, const char* end);
+};
+
+/// Реализация текущего уровня.
+const Kernels& kernels();
+
+Level level();
+
+/// Лучший уровень, который поддерживает процессор (и сборка).
+Level best_level();
+
+/// Сменить уровень (тесты, бенчмарк); false, если он недоступен.
+/// Вызывать до начала сканирования: переключение не потокобезопасно.
+bool set_level(Level level);
+
+const char* level_name(Level level);
+
+/// "scalar" / "sse4.2" / "avx2"; false для неизвестного имени.
+bool parse_level(const char* name, Level& out);
+
+#ifdef MINICOMPILER_SIMD_SCAN
+const Kernels& sse42_kernels();
+const Kernels& avx2_kernels();
+#endif
+
+} // namespace char_scan
@@ -0,0 +1,38 @@
+// Собирается с -mavx2 (см. CMakeLists.txt); вызывается, только
+// если процессор поддерживает AVX2
+#include <immintrin.h>
+
+#include "lexer/char_scan_simd.h"
+
+namespace char_scan {
+namespace {
+
+struct Avx2 {
+    using reg = __m256i;
+    static constexpr int W = 32;
+
+    static reg load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+    static unsigned eq(reg v, char c) {
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+
+    static unsigned range(reg v, char lo, char hi) {
+        reg d = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+        reg in = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(static_cast<char>(hi - lo))), d);
+        return static_cast<unsigned>(_mm256_movemask_epi8(in));
+    }
+
+    static reg lower(reg v) { return _mm256_or_si256(v, _mm256_set1_epi8(0x20)); }
+};
+
+const Kernels kernels_avx2 = {
+    skip_whitespace<Avx2>, find_line_end<Avx2>, find_comment_end<Avx2>,
+    skip_ident<Avx2>, skip_digits<Avx2>,
+};
+
+} // namespace
+
+const Kernels& avx2_kernels() { return kernels_avx2; }
+
+} // namespace char_scan
@@ -0,0 +1,150 @@
+#pragma once
+
+// ---------------------------------------------------------------
+// Общие алгоритмы char_scan для векторных реализаций
+//
+// Подключается только из char_scan_sse42.cpp и char_scan_avx2.cpp,
+// которые собираются с -msse4.2 / -mavx2.  Всё лежит в анонимном
+// пространстве имён: векторный код не должен попасть в общий
+// экземпляр inline-функции и исполниться на процессоре без AVX2.
+//
+// V — политика регистра: W байт, load, eq (маска байтов == c),
+// range (маска lo <= байт <= hi, без знака), lower (байт | 0x20).
+//
+// Короткие серии (пробел между токенами, имя из нескольких букв)
+// встречаются чаще длинных, поэтому первые kProbe байт
+// проверяются побайтно, а вектор включается только на длинной
+// серии.  Пока до конца буфера больше W байт, читаются блок и
+// блок, сдвинутый на байт (по нему видно, идёт ли за '\r' '\n' и
+// за '*' — '/'); остаток досчитывается побайтно.
+// ---------------------------------------------------------------
+#include "lexer/char_scan.h"
+
+namespace char_scan {
+namespace {
+
+constexpr int kProbe = 8;
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline void add_lines(const char* block, unsigned mask, Newlines& nl) {
+    if (mask == 0) return;
+    nl.count += __builtin_popcount(mask);
+    nl.line_start = block + (31 - __builtin_clz(mask)) + 1;
+}
+
+inline unsigned below(int n) {
+    return n >= 32 ? ~0u : (1u << n) - 1;
+}
+
+inline bool tail_newline(const char* p, const char* end, Newlines& nl) {
+    if (*p == '\n' || (*p == '\r' && (p + 1 == end || p[1] != '\n'))) {
+        ++nl.count;
+        nl.line_start = p + 1;
+        return true;
+    }
+    return false;
+}
+
+template <class V>
+unsigned newline_mask(typename V::reg v, typename V::reg next) {
+    return V::eq(v, '\n') | (V::eq(v, '\r') & ~V::eq(next, '\n'));
+}
+
+template <class V>
+const char* skip_whitespace(const char* p, const char* end, Newlines& nl) {
+    for (const char* probe = p + kProbe; p < end && p < probe; ++p) {
+        if (!is_space(*p)) return p;
+        tail_newline(p, end, nl);
+    }
+    while (end - p > V::W) {
+        typename V::reg v = V::load(p);
+        unsigned space = V::eq(v, ' ') | V::eq(v, '\t') | V::eq(v, '\n') | V::eq(v, '\r');
+        unsigned lines = newline_mask<V>(v, V::load(p + 1));
+        unsigned stop = ~space & below(V::W);
+        if (stop != 0) {
+            int n = __builtin_ctz(stop);
+            add_lines(p, lines & below(n), nl);
+            return p + n;
+        }
+        add_lines(p, lines, nl);
+        p += V::W;
+    }
+    for (; p < end && is_space(*p); ++p) {
+        tail_newline(p, end, nl);
+    }
+    return p;
+}
+
+template <class V>
+const char* find_line_end(const char* p, const char* end) {
+    while (end - p >= V::W) {
+        typename V::reg v = V::load(p);
+        unsigned stop = V::eq(v, '\n') | V::eq(v, '\r');
+        if (stop != 0) return p + __builtin_ctz(stop);
+        p += V::W;
+    }
+    while (p < end && *p != '\n' && *p != '\r') ++p;
+    return p;
+}
+
+template <class V>
+const char* find_comment_end(const char* p, const char* end, Newlines& nl) {
+    while (end - p > V::W) {
+        typename V::reg v = V::load(p);
+        typename V::reg next = V::load(p + 1);
+        unsigned close = V::eq(v, '*') & V::eq(next, '/');
+        unsigned lines = newline_mask<V>(v, next);
+        if (close != 0) {
+            int n = __builtin_ctz(close);
+            add_lines(p, lines & below(n), nl);
+            return p + n;
+        }
+        add_lines(p, lines, nl);
+        p += V::W;
+    }
+    for (; p < end; ++p) {
+        if (*p == '*' && p + 1 < end && p[1] == '/') return p;
+        tail_newline(p, end, nl);
+    }
+    return end;
+}
+
+inline bool tail_ident(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+template <class V>
+const char* skip_ident(const char* p, const char* end) {
+    for (const char* probe = p + kProbe; p < end && p < probe; ++p) {
+        if (!tail_ident(*p)) return p;
+    }
+    while (end - p >= V::W) {
+        typename V::reg v = V::load(p);
+        unsigned ident = V::range(V::lower(v), 'a', 'z') | V::range(v, '0', '9') | V::eq(v, '_');
+        unsigned stop = ~ident & below(V::W);
+        if (stop != 0) return p + __builtin_ctz(stop);
+        p += V::W;
+    }
+    while (p < end && tail_ident(*p)) ++p;
+    return p;
+}
+
+template <class V>
+const char* skip_digits(const char* p, const char* end) {
+    for (const char* probe = p + kProbe; p < end && p < probe; ++p) {
+        if (*p < '0' || *p > '9') return p;
+    }
+    while (end - p >= V::W) {
+        unsigned stop = ~V::range(V::load(p), '0', '9') & below(V::W);
+        if (stop != 0) return p + __builtin_ctz(stop);
+        p += V::W;
+    }
+    while (p < end && *p >= '0' && *p <= '9') ++p;
+    return p;
+}
+
+} // namespace
+} // namespace char_scan
@@ -0,0 +1,70 @@
+// Собирается с -msse4.2 (см. CMakeLists.txt); вызывается, только
+// если процессор поддерживает SSE4.2
+#include <nmmintrin.h>
+
+#include "lexer/char_scan_simd.h"
+
+namespace char_scan {
+namespace {
+
+struct Sse42 {
+    using reg = __m128i;
+    static constexpr int W = 16;
+
+    static reg load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+    static unsigned eq(reg v, char c) {
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+
+    static unsigned range(reg v, char lo, char hi) {
+        reg d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+        reg in = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(static_cast<char>(hi - lo))), d);
+        return static_cast<unsigned>(_mm_movemask_epi8(in));
+    }
+
+    static reg lower(reg v) { return _mm_or_si128(v, _mm_set1_epi8(0x20)); }
+};
+
+// Конец серии байтов из диапазонов `ranges` — PCMPISTRI: индекс
+// первого байта вне диапазонов (16 — весь блок в них).  Строка
+// неявной длины: '\0' в исходнике считается концом серии, а он и
+// так не входит ни в один класс
+template <int Mode>
+const char* skip_ranges(__m128i ranges, const char* p, const char* end, bool (*tail)(char)) {
+    for (const char* probe = p + kProbe; p < end && p < probe; ++p) {
+        if (!tail(*p)) return p;
+    }
+    while (end - p >= 16) {
+        int n = _mm_cmpistri(ranges, Sse42::load(p), Mode);
+        if (n < 16) return p + n;
+        p += 16;
+    }
+    while (p < end && tail(*p)) ++p;
+    return p;
+}
+
+constexpr int kRangeMode = _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+
+const char* sse42_skip_ident(const char* p, const char* end) {
+    const __m128i ranges = _mm_setr_epi8('a', 'z', 'A', 'Z', '0', '9', '_', '_', 0, 0, 0, 0, 0, 0, 0, 0);
+    return skip_ranges<kRangeMode>(ranges, p, end, tail_ident);
+}
+
+bool tail_digit(char c) { return c >= '0' && c <= '9'; }
+
+const char* sse42_skip_digits(const char* p, const char* end) {
+    const __m128i ranges = _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    return skip_ranges<kRangeMode>(ranges, p, end, tail_digit);
+}
+
+const Kernels kernels_sse42 = {
+    skip_whitespace<Sse42>, find_line_end<Sse42>, find_comment_end<Sse42>,
+    sse42_skip_ident, sse42_skip_digits,
+};
+
+} // namespace
+
+const Kernels& sse42_kernels() { return kernels_sse42; }
+
+} // namespace char_scan
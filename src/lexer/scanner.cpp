@@ -1,9 +1,58 @@
 #include "lexer/scanner.h"
 
 #include <cctype>
+#include <cstdint>
 #include <limits>
 
-Scanner::Scanner(const std::string& source)
+#include "ir/interner.h"
+#include "lexer/char_scan.h"
+
+namespace {
+
+// ---------------------------------------------------------------
+// Ключевые слова — совершенный хеш: (длина + первый + последний
+// байт) & 31 различен у всех 15 слов, так что на идентификатор
+// приходится одно сравнение вместо цепочки из 15
+// ---------------------------------------------------------------
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+struct KeywordTable {
+    Keyword slots[32] = {};
+    KeywordTable() {
+        const Keyword words[] = {
+            {"if", TokenType::KW_IF},         {"else", TokenType::KW_ELSE},
+            {"while", TokenType::KW_WHILE},   {"for", TokenType::KW_FOR},
+            {"int", TokenType::KW_INT},       {"float", TokenType::KW_FLOAT},
+            {"bool", TokenType::KW_BOOL},     {"return", TokenType::KW_RETURN},
+            {"void", TokenType::KW_VOID},     {"struct", TokenType::KW_STRUCT},
+            {"fn", TokenType::KW_FN},         {"extern", TokenType::KW_EXTERN},
+            {"import", TokenType::KW_IMPORT},
+            {"true", TokenType::BOOL_LITERAL}, {"false", TokenType::BOOL_LITERAL},
+        };
+        for (const Keyword& kw : words) {
+            slots[hash(kw.text)] = kw;
+        }
+    }
+    static std::size_t hash(std::string_view word) {
+        return (word.size() + static_cast<unsigned char>(word.front()) +
+                static_cast<unsigned char>(word.back())) & 31;
+    }
+};
+
+const KeywordTable keyword_table;
+
+const Keyword* find_keyword(std::string_view word) {
+    if (word.size() < 2 || word.size() > 6) return nullptr;
+    const Keyword& kw = keyword_table.slots[KeywordTable::hash(word)];
+    return kw.text == word ? &kw : nullptr;
+}
+
+} // namespace
+
+Scanner::Scanner(std::string_view source)
     : source_(source), current_(0), line_(1), column_(1) {}
 
 Token Scanner::next_token() {
@@ -31,55 +80,10 @@ int Scanner::get_column() const { return column_; }
 
 const std::vector<ScanError>& Scanner::errors() const { return errors_; }
 
-namespace {
-// позиция EOF = после последнего не-пробела (для тестов)
-void compute_eof_position(const std::string& source, int& out_line,
-                          int& out_col) {
-    std::size_t last_non_ws = std::string::npos;
-    for (std::size_t i = source.size(); i > 0; --i) {
-        char c = source[i - 1];
-        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
-            last_non_ws = i - 1;
-            break;
-        }
-    }
-    if (last_non_ws == std::string::npos) {
-        out_line = 1;
-        out_col = 1;
-        return;
-    }
-
-    int line = 1;
-    int col = 1;
-    for (std::size_t i = 0; i <= last_non_ws; ++i) {
-        char c = source[i];
-        if (c == '\r') {
-            if (i + 1 < source.size() && source[i + 1] == '\n') {
-                ++i;
-            }
-            line++;
-            col = 1;
-            continue;
-        }
-        if (c == '\n') {
-            line++;
-            col = 1;
-            continue;
-        }
-        col++;
-    }
-    out_line = line;
-    out_col = col;
-}
-}
-
 Token Scanner::scan_token() {
     skip_whitespace_and_comments();
     if (current_ >= source_.size()) {
-        int eof_line = 1;
-        int eof_col = 1;
-        compute_eof_position(source_, eof_line, eof_col);
-        return Token{TokenType::END_OF_FILE, "", eof_line, eof_col, {}};
+        return Token{TokenType::END_OF_FILE, "", end_line_, end_column_, {}};
     }
 
     int start_line = line_;
@@ -192,39 +196,39 @@ Token Scanner::scan_token() {
     return scan_token();
 }
 
+// Пропуск начинается сразу после токена (или ошибочного символа),
+// поэтому здесь запоминается позиция для EOF: комментарии в конце
+// файла её не сдвигают
 void Scanner::skip_whitespace_and_comments() {
+    end_line_ = line_;
+    end_column_ = column_;
+    const char_scan::Kernels& scan = char_scan::kernels();
+    const char* begin = source_.data();
+    const char* end = begin + source_.size();
     while (current_ < source_.size()) {
         char c = peek();
         if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-            advance();
+            char_scan::Newlines nl;
+            const char* stop = scan.skip_whitespace(begin + current_, end, nl);
+            skip_to(static_cast<std::size_t>(stop - begin), nl);
             continue;
         }
         if (c == '/' && peek_next() == '/') {
-            advance();
-            advance();
-            while (current_ < source_.size() && peek() != '\n' && peek() != '\r') {
-                advance();
-            }
+            const char* stop = scan.find_line_end(begin + current_ + 2, end);
+            skip_to(static_cast<std::size_t>(stop - begin), char_scan::Newlines{});
             continue;
         }
         if (c == '/' && peek_next() == '*') {
             int start_line = line_;
             int start_col = column_;
-            advance();
-            advance();
-            bool closed = false;
-            while (current_ < source_.size()) {
-                if (peek() == '*' && peek_next() == '/') {
-                    advance();
-                    advance();
-                    closed = true;
-                    break;
-                }
-                advance();
-            }
-            if (!closed) {
+            char_scan::Newlines nl;
+            const char* close = scan.find_comment_end(begin + current_ + 2, end, nl);
+            if (close == end) {
+                skip_to(source_.size(), nl);
                 report_error(start_line, start_col,
                              "Unterminated multi-line comment");
+            } else {
+                skip_to(static_cast<std::size_t>(close - begin) + 2, nl);
             }
             continue;
         }
@@ -232,6 +236,18 @@ void Scanner::skip_whitespace_and_comments() {
     }
 }
 
+// Пропуск серии байтов без advance(): строка и колонка — по
+// переводам строк, найденным char_scan
+void Scanner::skip_to(std::size_t pos, const char_scan::Newlines& nl) {
+    if (nl.count > 0) {
+        line_ += nl.count;
+        column_ = static_cast<int>(source_.data() + pos - nl.line_start) + 1;
+    } else {
+        column_ += static_cast<int>(pos - current_);
+    }
+    current_ = pos;
+}
+
 char Scanner::advance() {
     if (current_ >= source_.size()) {
         return '\0';
@@ -283,82 +299,67 @@ bool Scanner::is_alpha(char c) const {
     return std::isalpha(static_cast<unsigned char>(c)) != 0;
 }
 
-bool Scanner::is_alnum_or_underscore(char c) const {
-    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
-}
-
 Token Scanner::identifier_or_keyword(int start_line, int start_col) {
     std::size_t start = current_ - 1;
-    while (current_ < source_.size() && is_alnum_or_underscore(peek())) {
-        advance();
-    }
-    std::string lexeme = source_.substr(start, current_ - start);
+    const char* begin = source_.data();
+    const char* stop = char_scan::kernels().skip_ident(begin + current_, begin + source_.size());
+    skip_to(static_cast<std::size_t>(stop - begin), char_scan::Newlines{});
+    std::string_view lexeme = source_.substr(start, current_ - start);
     if (lexeme.size() > 255) {
         report_error(start_line, start_col, "Identifier exceeds 255 characters");
     }
 
-    if (lexeme == "if")
-        return Token{TokenType::KW_IF, lexeme, start_line, start_col, {}};
-    if (lexeme == "else")
-        return Token{TokenType::KW_ELSE, lexeme, start_line, start_col, {}};
-    if (lexeme == "while")
-        return Token{TokenType::KW_WHILE, lexeme, start_line, start_col, {}};
-    if (lexeme == "for")
-        return Token{TokenType::KW_FOR, lexeme, start_line, start_col, {}};
-    if (lexeme == "int")
-        return Token{TokenType::KW_INT, lexeme, start_line, start_col, {}};
-    if (lexeme == "float")
-        return Token{TokenType::KW_FLOAT, lexeme, start_line, start_col, {}};
-    if (lexeme == "bool")
-        return Token{TokenType::KW_BOOL, lexeme, start_line, start_col, {}};
-    if (lexeme == "return")
-        return Token{TokenType::KW_RETURN, lexeme, start_line, start_col, {}};
-    if (lexeme == "void")
-        return Token{TokenType::KW_VOID, lexeme, start_line, start_col, {}};
-    if (lexeme == "struct")
-        return Token{TokenType::KW_STRUCT, lexeme, start_line, start_col, {}};
-    if (lexeme == "fn")
-        return Token{TokenType::KW_FN, lexeme, start_line, start_col, {}};
-    if (lexeme == "extern")
-        return Token{TokenType::KW_EXTERN, lexeme, start_line, start_col, {}};
-    if (lexeme == "true")
-        return Token{TokenType::BOOL_LITERAL, lexeme, start_line, start_col,
-                     true};
-    if (lexeme == "false")
-        return Token{TokenType::BOOL_LITERAL, lexeme, start_line, start_col,
-                     false};
-
-    return Token{TokenType::IDENTIFIER, lexeme, start_line, start_col, {}};
+    if (const Keyword* kw = find_keyword(lexeme)) {
+        LiteralValue literal;
+        if (kw->type == TokenType::BOOL_LITERAL) {
+            literal = kw->text == "true";
+        }
+        return Token{kw->type, kw->text, start_line, start_col, literal};
+    }
+    return Token{TokenType::IDENTIFIER, intern_name(lexeme), start_line,
+                 start_col, {}};
+}
+
+// Имена повторяются: кэш прямого отображения перед SymbolInterner
+// экономит блокировку и поиск в общей таблице на каждом вхождении
+std::string_view Scanner::intern_name(std::string_view name) {
+    std::uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    std::string_view& slot = name_cache_[hash % kNameCacheSize];
+    if (slot != name) {
+        slot = symbol_name(intern_symbol(name));
+    }
+    return slot;
 }
 
 Token Scanner::number_literal(int start_line, int start_col) {
     std::size_t start = current_ - 1;
-    while (current_ < source_.size() &&
-           std::isdigit(static_cast<unsigned char>(peek()))) {
-        advance();
-    }
+    const char_scan::Kernels& scan = char_scan::kernels();
+    const char* begin = source_.data();
+    const char* end = begin + source_.size();
+    skip_to(static_cast<std::size_t>(scan.skip_digits(begin + current_, end) - begin), char_scan::Newlines{});
 
     bool is_float = false;
     if (peek() == '.' &&
         std::isdigit(static_cast<unsigned char>(peek_next()))) {
         is_float = true;
         advance();
-        while (current_ < source_.size() &&
-               std::isdigit(static_cast<unsigned char>(peek()))) {
-            advance();
-        }
+        skip_to(static_cast<std::size_t>(scan.skip_digits(begin + current_, end) - begin), char_scan::Newlines{});
     }
 
-    std::string lexeme = source_.substr(start, current_ - start);
+    std::string_view lexeme = source_.substr(start, current_ - start);
+    const std::string digits(lexeme);
     if (is_float) {
-        double value = std::stod(lexeme);
+        double value = std::stod(digits);
         return Token{TokenType::FLOAT_LITERAL, lexeme, start_line, start_col,
                      value};
     }
 
     long long value = 0;
     try {
-        value = std::stoll(lexeme);
+        value = std::stoll(digits);
     } catch (...) {
         report_error(start_line, start_col, "Malformed number literal");
         return Token{TokenType::INT_LITERAL, lexeme, start_line, start_col,
@@ -422,7 +423,7 @@ Token Scanner::string_literal(int start_line, int start_col) {
         value.push_back(advance());
     }
 
-    std::string lexeme = source_.substr(start, current_ - start);
+    std::string_view lexeme = source_.substr(start, current_ - start);
     if (!terminated) {
         report_error(start_line, start_col, "Unterminated string literal");
     }
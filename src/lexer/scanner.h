@@ -1,20 +1,33 @@
 #pragma once
 
+#include <array>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "lexer/token.h"
 
+namespace char_scan {
+struct Newlines;
+}
+
 struct ScanError {
     int line;
     int column;
     std::string message;
 };
 
+// ---------------------------------------------------------------
+// Scanner не копирует исходник: лексемы чисел и строк указывают в
+// переданный буфер (файл, отображённый в память, или вывод
+// препроцессора), поэтому буфер должен жить, пока используются
+// токены.  Временная строка буфером быть не может.
+// ---------------------------------------------------------------
 class Scanner {
 public:
-    explicit Scanner(const std::string& source);
+    explicit Scanner(std::string_view source);
+    explicit Scanner(std::string&& source) = delete;
 
     Token next_token();
     Token peek_token();
@@ -25,23 +38,28 @@ public:
     const std::vector<ScanError>& errors() const;
 
 private:
-    const std::string source_;
+    std::string_view source_;
     std::size_t current_;
     int line_;
     int column_;
+    int end_line_ = 1;      // позиция сразу после последнего токена
+    int end_column_ = 1;    // (туда ставится EOF)
     std::optional<Token> peeked_;
     std::vector<ScanError> errors_;
+    static constexpr std::size_t kNameCacheSize = 1024;
+    std::array<std::string_view, kNameCacheSize> name_cache_{};   // интернированные имена
 
     Token scan_token();
     void skip_whitespace_and_comments();
+    void skip_to(std::size_t pos, const char_scan::Newlines& nl);
     char advance();
     char peek() const;
     char peek_next() const;
     bool match(char expected);
     bool is_alpha(char c) const;
-    bool is_alnum_or_underscore(char c) const;
 
     Token identifier_or_keyword(int start_line, int start_col);
+    std::string_view intern_name(std::string_view name);
     Token number_literal(int start_line, int start_col);
     Token string_literal(int start_line, int start_col);
     void report_error(int line, int col, const std::string& message);
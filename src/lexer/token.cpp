@@ -29,6 +29,8 @@ std::string token_type_to_string(TokenType type) {
         return "KW_FN";
     case TokenType::KW_EXTERN:
         return "KW_EXTERN";
+    case TokenType::KW_IMPORT:
+        return "KW_IMPORT";
     case TokenType::IDENTIFIER:
         return "IDENTIFIER";
     case TokenType::INT_LITERAL:
@@ -128,7 +130,7 @@ std::string literal_to_string(const LiteralValue& literal) {
     return std::get<std::string>(literal);
 }
 
-std::string escape_lexeme(const std::string& lexeme) {
+std::string escape_lexeme(std::string_view lexeme) {
     std::string out;
     out.reserve(lexeme.size());
     for (char c : lexeme) {
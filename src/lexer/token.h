@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <variant>
 
 enum class TokenType {
@@ -18,6 +19,7 @@ enum class TokenType {
     KW_STRUCT,
     KW_FN,
     KW_EXTERN,
+    KW_IMPORT,
 
     // Identifiers and literals
     IDENTIFIER,
@@ -68,9 +70,17 @@ enum class TokenType {
 using LiteralValue =
     std::variant<std::monostate, std::int32_t, double, bool, std::string>;
 
+// ---------------------------------------------------------------
+// Token — лексема хранится как string_view, без копии:
+//   ключевые слова, операторы, true/false — строковые литералы;
+//   идентификаторы — интернированы (SymbolInterner), живут до
+//     конца процесса;
+//   числа и строки — указывают в исходный буфер Scanner'а и
+//     действительны, пока жив буфер (значение — в literal).
+// ---------------------------------------------------------------
 struct Token {
     TokenType type;
-    std::string lexeme;
+    std::string_view lexeme;
     int line;
     int column;
     LiteralValue literal;
@@ -78,5 +88,5 @@ struct Token {
 
 std::string token_type_to_string(TokenType type);
 std::string literal_to_string(const LiteralValue& literal);
-std::string escape_lexeme(const std::string& lexeme);
+std::string escape_lexeme(std::string_view lexeme);
 std::string format_token(const Token& token);
@@ -1,8 +1,24 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
+#include <sys/resource.h>
+
+#include "lexer/char_scan.h"
 #include "lexer/scanner.h"
 #include "lexer/token.h"
 #include "parser/ast.h"
@@ -12,135 +28,300 @@
 #include "preprocessor/preprocessor.h"
 #include "semantic/analyzer.h"
 #include "semantic/errors.h"
+#include "semantic/module_interface.h"
 #include "ir/ir_generator.h"
 #include "ir/ir_printer.h"
 #include "ir/optimizer.h"
 #include "ir/optimization_passes.h"
+#include "ir/profile.h"
+#include "ir/ssa.h"
+#include "ir/interpreter.h"
 #include "codegen/x86_generator.h"
+#include "codegen/jit.h"
+#include "cache/compile_cache.h"
+#include "utils/file_utils.h"
+#include "utils/json.h"
+#include "utils/thread_pool.h"
 
 static void print_usage() {
     std::cout << "Usage:\n";
-    std::cout << "  compiler lex      --input <file> [--output <file>]\n";
-    std::cout << "  compiler parse    --input <file> [--output <file>] [--format text|dot|json] [--verbose]\n";
-    std::cout << "  compiler check    --input <file> [--output <file>] [--verbose] [--show-types]\n";
+    std::cout << "  compiler lex      --input <file> [--output <file>] [--verbose] [--scanner auto|scalar|sse4.2|avx2]\n";
+    std::cout << "  compiler parse    --input <file> [--output <file>] [--format text|dot|json] [--verbose] [--no-ast-arena]\n";
+    std::cout << "  compiler check    --input <file> [--output <file>] [--verbose] [--show-types] [--no-ast-arena] [--emit-interface <file.mi>]\n";
     std::cout << "  compiler symbols  --input <file> [--format text|json] [--output <file>]\n";
     std::cout << "  compiler ir       --input <file> [--output <file>] [--format text|dot|json] [--stats] [--optimize]\n";
-    std::cout << "  compiler compile  --input <file> [--output <file>] [--optimize] [--regalloc lsra|stack] [--x86-peephole] [--dwarf]\n";
+    std::cout << "  compiler compile  --input <file> [--output <file>] [--optimize] [--regalloc lsra|graph|stack] [--x86-peephole] [--omit-frame-pointer] [--dwarf] [--jobs N] [--emit asm|obj] [--cache-dir <dir>] [--emit-interface <file.mi>]\n";
+    std::cout << "                    (check/symbols/ir/compile: [--module-path <dir>]... for import)\n";
+    std::cout << "                    (compile/run: [--profile-generate <file>] counts blocks and calls, [--profile-use <file>] applies them)\n";
+    std::cout << "                    (ir/compile/run/interp: [--target-features none|sse4.1|avx2|native] vectorizes loops with --optimize)\n";
+    std::cout << "  compiler run      --input <file> [--optimize] [--regalloc lsra|graph|stack] [--x86-peephole] [--omit-frame-pointer] [--jobs N]\n";
+    std::cout << "  compiler interp   --input <file> [--optimize] [--inline] [--verify-passes]\n";
+    std::cout << "  compiler serve    [--jobs N]   (JSON requests on stdin, one per line)\n";
 }
 
-static std::string read_source(const std::string& path) {
-    std::ifstream in(path, std::ios::in | std::ios::binary);
-    if (!in)
-        return "";
-    return std::string((std::istreambuf_iterator<char>(in)),
-                       std::istreambuf_iterator<char>());
+// ---------------------------------------------------------------
+// Workspace — окружение одной команды
+//
+// В CLI результат идёт в std::cout, диагностика — в std::cerr.  В
+// compiler serve у каждого запроса свои буферы, а у каждого
+// рабочего потока — свой Workspace: реестр типов не создаётся
+// заново для каждого файла, а сбрасывается до встроенных типов.
+// ---------------------------------------------------------------
+struct Workspace {
+    std::ostream* out_stream = &std::cout;
+    std::ostream* err_stream = &std::cerr;
+    TypeRegistry types;
+    bool use_ast_arena = true;          // --no-ast-arena: узлы через new (для сравнения)
+    std::vector<std::string> module_paths;  // --module-path: где искать интерфейсы import
+    int vector_lanes = 0;               // --target-features: 4 (sse4.1), 8 (avx2), 0 — без векторизации
+    std::string profile_generate;       // --profile-generate: куда программа запишет профиль
+    ProfileData profile;                // --profile-use
+    std::string profile_key;            // хеш файла профиля для ключей кэша ("" — без профиля)
+    std::vector<std::string> written;   // файлы, записанные командой
+
+    std::ostream& out() { return *out_stream; }
+    std::ostream& err() { return *err_stream; }
+};
+
+// ---------------------------------------------------------------
+// Память и время парсинга (parse/check --verbose)
+// ---------------------------------------------------------------
+static void report_parse_memory(Workspace& ws, const ProgramNode& ast, double parse_ms) {
+    if (ast.arena) {
+        ws.err() << "AST arena: " << ast.arena->bytes_used() << " bytes used, "
+                  << ast.arena->bytes_reserved() << " reserved in "
+                  << ast.arena->block_count() << " blocks ("
+                  << ast.arena->object_count() << " nodes)\n";
+    } else {
+        ws.err() << "AST arena: disabled\n";
+    }
+    ws.err() << "Parse time: " << parse_ms << " ms\n";
+
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    ws.err() << "Peak RSS: " << usage.ru_maxrss << " KB\n";
 }
 
-static bool write_output(const std::string& path, const std::string& data) {
+static bool write_output(Workspace& ws, const std::string& path, const std::string& data) {
     std::ofstream out(path, std::ios::out | std::ios::binary);
     if (!out) return false;
     out << data;
+    ws.written.push_back(path);
     return true;
 }
 
-static std::vector<Token> tokenize(const std::string& source,
-                                   bool report_errors) {
-    Preprocessor preprocessor(source);
-    std::string processed = preprocessor.process();
-    if (report_errors) {
+// ---------------------------------------------------------------
+// Исходник
+//
+// Файл отображается в память; если в нём нет '#', препроцессор
+// пропускается и Scanner идёт прямо по отображению.  Лексемы
+// чисел и строк указывают в этот буфер, поэтому он живёт, пока
+// используются токены.
+// ---------------------------------------------------------------
+struct SourceText {
+    utils::MappedFile file;
+    std::string processed;          // вывод препроцессора, если он нужен
+    bool preprocessed = false;
+    std::string_view text;          // то, что читает Scanner
+};
+
+static bool load_source(Workspace& ws, const std::string& input_path, SourceText& src) {
+    if (!src.file.open(input_path)) {
+        ws.err() << "Failed to read input file: " << input_path << "\n";
+        return false;
+    }
+    src.text = src.file.text();
+    src.preprocessed = Preprocessor::needs_processing(src.text);
+    if (src.preprocessed) {
+        Preprocessor preprocessor{std::string(src.text)};
+        src.processed = preprocessor.process();
+        src.text = src.processed;
         for (const auto& err : preprocessor.errors()) {
-            std::cerr << err.line << ":" << err.column << " ERROR "
+            ws.err() << err.line << ":" << err.column << " ERROR "
                       << err.message << "\n";
         }
     }
+    return true;
+}
 
-    Scanner scanner(processed);
+static void report_scan_errors(Workspace& ws, const Scanner& scanner) {
+    for (const auto& err : scanner.errors()) {
+        ws.err() << err.line << ":" << err.column << " ERROR "
+                  << err.message << "\n";
+    }
+}
+
+static std::vector<Token> read_all_tokens(Scanner& scanner, std::size_t source_size) {
     std::vector<Token> tokens;
+    // грубая оценка: токен на ~8 байт исходника
+    tokens.reserve(source_size / 8 + 1);
     while (true) {
         Token tok = scanner.next_token();
         tokens.push_back(tok);
         if (tok.type == TokenType::END_OF_FILE) break;
     }
-    if (report_errors) {
-        for (const auto& err : scanner.errors()) {
-            std::cerr << err.line << ":" << err.column << " ERROR "
-                      << err.message << "\n";
+    return tokens;
+}
+
+// ---------------------------------------------------------------
+// Модули
+//
+// import name; читает интерфейс name.mi: сначала рядом с
+// исходником, затем в каталогах --module-path по порядку.
+// Интерфейсы складываются в modules (анализатор хранит указатели
+// на них, поэтому вектор не должен перераспределяться).
+// ---------------------------------------------------------------
+static bool import_modules(Workspace& ws, const std::string& input_path, const ProgramNode& ast,
+                           SemanticAnalyzer& analyzer, std::vector<ModuleInterface>& modules) {
+    std::vector<std::filesystem::path> dirs = {std::filesystem::path(input_path).parent_path()};
+    dirs.insert(dirs.end(), ws.module_paths.begin(), ws.module_paths.end());
+    modules.clear();
+    modules.reserve(ast.imports.size());
+
+    bool ok = true;
+    std::unordered_set<std::string> seen;
+    for (const auto& imp : ast.imports) {
+        if (!seen.insert(imp.module).second) continue;
+        std::string path;
+        std::string data;
+        for (const auto& dir : dirs) {
+            path = (dir / (imp.module + ".mi")).string();
+            data = utils::read_file(path);
+            if (!data.empty()) break;
         }
+        if (data.empty()) {
+            ws.err() << imp.line << ":" << imp.column << " ERROR module '" << imp.module
+                     << "' not found: no " << imp.module << ".mi next to the source or in --module-path\n";
+            ok = false;
+            continue;
+        }
+        ModuleInterface module;
+        if (!read_module_interface(data, module)) {
+            ws.err() << imp.line << ":" << imp.column << " ERROR " << path
+                     << " is not a module interface of this compiler version\n";
+            ok = false;
+            continue;
+        }
+        if (module.name != imp.module) {
+            ws.err() << imp.line << ":" << imp.column << " ERROR " << path << " is the interface of module '"
+                     << module.name << "', not '" << imp.module << "'\n";
+            ok = false;
+            continue;
+        }
+        modules.push_back(std::move(module));
+        analyzer.add_import(modules.back(), imp.line, imp.column);
     }
-    return tokens;
+    return ok;
 }
 
-static int cmd_lex(const std::string& input_path,
-                   const std::string& output_path) {
-    std::string source = read_source(input_path);
-    if (source.empty()) {
-        std::ifstream test(input_path);
-        if (!test) {
-            std::cerr << "Failed to read input file: " << input_path << "\n";
-            return 1;
+// --emit-interface: модуль называется по имени файла интерфейса.
+// Файл переписывается, только если интерфейс изменился: когда
+// поменялись лишь тела функций, make не пересобирает зависимые
+// модули.
+static bool write_interface(Workspace& ws, const std::string& path, const ProgramNode& ast,
+                            SemanticAnalyzer& analyzer) {
+    const std::string module = std::filesystem::path(path).stem().string();
+    const std::string data = write_module_interface(build_module_interface(module, ast, analyzer.get_type_registry()));
+    if (utils::read_file(path) == data) {
+        ws.written.push_back(path);
+        return true;
+    }
+    if (!write_output(ws, path, data)) {
+        ws.err() << "Failed to write interface file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+static int cmd_lex(Workspace& ws,
+                   const std::string& input_path,
+                   const std::string& output_path, bool verbose) {
+    auto lex_start = std::chrono::steady_clock::now();
+    SourceText src;
+    if (!load_source(ws, input_path, src)) {
+        return 1;
+    }
+    Scanner scanner(src.text);
+    const std::vector<Token> tokens = read_all_tokens(scanner, src.text.size());
+    std::chrono::duration<double, std::milli> lex_ms =
+        std::chrono::steady_clock::now() - lex_start;
+    report_scan_errors(ws, scanner);
+    if (verbose) {
+        ws.err() << "Source: " << src.file.text().size() << " bytes ("
+                  << (src.file.mapped() ? "mmap" : "read") << "), preprocessor "
+                  << (src.preprocessed ? "ran" : "skipped") << "\n";
+        ws.err() << "Tokens: " << tokens.size() << "\n";
+        ws.err() << "Scanner: " << char_scan::level_name(char_scan::level()) << "\n";
+        ws.err() << "Lex time: " << lex_ms.count() << " ms\n";
+        if (lex_ms.count() > 0) {
+            ws.err() << "Lex speed: " << static_cast<long long>(tokens.size() / (lex_ms.count() / 1000.0))
+                      << " tokens/s, " << src.file.text().size() / (lex_ms.count() * 1000.0) << " MB/s\n";
         }
     }
-    auto tokens = tokenize(source, true);
     std::string output;
     for (const auto& tok : tokens) {
         output += format_token(tok);
         output += "\n";
     }
     if (output_path.empty()) {
-        std::cout << output;
-    } else if (!write_output(output_path, output)) {
-        std::cerr << "Failed to write output file: " << output_path << "\n";
+        ws.out() << output;
+    } else if (!write_output(ws, output_path, output)) {
+        ws.err() << "Failed to write output file: " << output_path << "\n";
         return 1;
     }
     return 0;
 }
 
-static int cmd_parse(const std::string& input_path,
+static int cmd_parse(Workspace& ws,
+                     const std::string& input_path,
                      const std::string& output_path,
                      const std::string& format, bool verbose) {
-    std::string source = read_source(input_path);
-    if (source.empty()) {
-        std::ifstream test(input_path);
-        if (!test) {
-            std::cerr << "Failed to read input file: " << input_path << "\n";
-            return 1;
-        }
+    SourceText src;
+    if (!load_source(ws, input_path, src)) {
+        return 1;
     }
-    auto tokens = tokenize(source, true);
+
+    // Токены идут из Scanner'а в Parser по одному
+    Scanner scanner(src.text);
+    Parser parser(scanner);
+    parser.set_use_arena(ws.use_ast_arena);
+    auto parse_start = std::chrono::steady_clock::now();
+    auto ast = parser.parse();
+    std::chrono::duration<double, std::milli> parse_ms =
+        std::chrono::steady_clock::now() - parse_start;
+    report_scan_errors(ws, scanner);
 
     if (verbose) {
-        std::cerr << "Tokens: " << tokens.size() << "\n";
+        ws.err() << "Tokens: " << parser.tokens_read() << "\n";
     }
 
-    Parser parser(tokens);
-    auto ast = parser.parse();
-
     for (const auto& err : parser.errors()) {
-        std::cerr << err.line << ":" << err.column << " ERROR "
+        ws.err() << err.line << ":" << err.column << " ERROR "
                   << err.message << "\n";
     }
 
     for (const auto& err : parser.errors()) {
     if (!err.suggestion.empty()) {
-        std::cerr << err.line << ":" << err.column << " SUGGESTION: " 
+        ws.err() << err.line << ":" << err.column << " SUGGESTION: " 
                   << err.suggestion << "\n";
     }
 }
 
     if (verbose) {
         const auto& m = parser.metrics();
-        std::cerr << "Parse errors: " << m.total_errors << "\n";
-        std::cerr << "Recovered: " << m.recovered << "\n";
-        std::cerr << "Tokens skipped: " << m.tokens_skipped << "\n";
-        std::cerr << "Recovery rate: " << (m.recovery_rate() * 100) << "%\n";
+        ws.err() << "Parse errors: " << m.total_errors << "\n";
+        ws.err() << "Recovered: " << m.recovered << "\n";
+        ws.err() << "Tokens skipped: " << m.tokens_skipped << "\n";
+        ws.err() << "Recovery rate: " << (m.recovery_rate() * 100) << "%\n";
+        report_parse_memory(ws, *ast, parse_ms.count());
 
         auto sym = build_symbol_tables(*ast);
         for (const auto& e : sym.errors) {
-            std::cerr << "SEMANTIC " << e << "\n";
+            ws.err() << "SEMANTIC " << e << "\n";
         }
-        std::cerr << "Scopes: " << sym.scopes.size() << "\n";
+        ws.err() << "Scopes: " << sym.scopes.size() << "\n";
         for (const auto& scope : sym.scopes) {
-            std::cerr << "  scope#" << scope.id << " parent=" << scope.parent_id
+            ws.err() << "  scope#" << scope.id << " parent=" << scope.parent_id
                       << " symbols=" << scope.symbols.size() << "\n";
         }
     }
@@ -162,9 +343,9 @@ static int cmd_parse(const std::string& input_path,
     }
 
     if (output_path.empty()) {
-        std::cout << output;
-    } else if (!write_output(output_path, output)) {
-        std::cerr << "Failed to write output file: " << output_path << "\n";
+        ws.out() << output;
+    } else if (!write_output(ws, output_path, output)) {
+        ws.err() << "Failed to write output file: " << output_path << "\n";
         return 1;
     }
     return 0;
@@ -173,34 +354,48 @@ static int cmd_parse(const std::string& input_path,
 // ---------------------------------------------------------------
 // Sprint 3: semantic check command
 // ---------------------------------------------------------------
-static int cmd_check(const std::string& input_path,
+static int cmd_check(Workspace& ws,
+                     const std::string& input_path,
                      const std::string& output_path,
-                     bool verbose, bool show_types) {
-    std::string source = read_source(input_path);
-    if (source.empty()) {
-        std::ifstream test(input_path);
-        if (!test) {
-            std::cerr << "Failed to read input file: " << input_path << "\n";
-            return 1;
-        }
+                     bool verbose, bool show_types,
+                     const std::string& interface_path) {
+    SourceText src;
+    if (!load_source(ws, input_path, src)) {
+        return 1;
     }
 
-    auto tokens = tokenize(source, true);
-
-    Parser parser(tokens);
+    Scanner scanner(src.text);
+    Parser parser(scanner);
+    parser.set_use_arena(ws.use_ast_arena);
+    auto parse_start = std::chrono::steady_clock::now();
     auto ast = parser.parse();
+    std::chrono::duration<double, std::milli> parse_ms =
+        std::chrono::steady_clock::now() - parse_start;
+    report_scan_errors(ws, scanner);
 
     if (!parser.errors().empty()) {
         for (const auto& err : parser.errors()) {
-            std::cerr << err.line << ":" << err.column << " PARSE ERROR: "
+            ws.err() << err.line << ":" << err.column << " PARSE ERROR: "
                       << err.message << "\n";
         }
-        std::cerr << "Cannot run semantic analysis: parse errors present\n";
+        ws.err() << "Cannot run semantic analysis: parse errors present\n";
         return 1;
     }
 
-    SemanticAnalyzer analyzer;
+    SemanticAnalyzer analyzer(ws.types);
+    std::vector<ModuleInterface> modules;
+    if (!import_modules(ws, input_path, *ast, analyzer, modules)) {
+        return 1;
+    }
     analyzer.analyze(*ast);
+    if (!interface_path.empty() && analyzer.get_errors().empty() &&
+        !write_interface(ws, interface_path, *ast, analyzer)) {
+        return 1;
+    }
+
+    if (verbose) {
+        report_parse_memory(ws, *ast, parse_ms.count());
+    }
 
     std::string output;
 
@@ -219,9 +414,9 @@ static int cmd_check(const std::string& input_path,
     }
 
     if (output_path.empty()) {
-        std::cout << output;
-    } else if (!write_output(output_path, output)) {
-        std::cerr << "Failed to write output file: " << output_path << "\n";
+        ws.out() << output;
+    } else if (!write_output(ws, output_path, output)) {
+        ws.err() << "Failed to write output file: " << output_path << "\n";
         return 1;
     }
 
@@ -231,32 +426,34 @@ static int cmd_check(const std::string& input_path,
 // ---------------------------------------------------------------
 // Sprint 3: symbol table dump command
 // ---------------------------------------------------------------
-static int cmd_symbols(const std::string& input_path,
+static int cmd_symbols(Workspace& ws,
+                       const std::string& input_path,
                        const std::string& output_path,
                        const std::string& format) {
-    std::string source = read_source(input_path);
-    if (source.empty()) {
-        std::ifstream test(input_path);
-        if (!test) {
-            std::cerr << "Failed to read input file: " << input_path << "\n";
-            return 1;
-        }
+    SourceText src;
+    if (!load_source(ws, input_path, src)) {
+        return 1;
     }
 
-    auto tokens = tokenize(source, true);
-
-    Parser parser(tokens);
+    Scanner scanner(src.text);
+    Parser parser(scanner);
+    parser.set_use_arena(ws.use_ast_arena);
     auto ast = parser.parse();
+    report_scan_errors(ws, scanner);
 
     if (!parser.errors().empty()) {
         for (const auto& err : parser.errors()) {
-            std::cerr << err.line << ":" << err.column << " PARSE ERROR: "
+            ws.err() << err.line << ":" << err.column << " PARSE ERROR: "
                       << err.message << "\n";
         }
         return 1;
     }
 
-    SemanticAnalyzer analyzer;
+    SemanticAnalyzer analyzer(ws.types);
+    std::vector<ModuleInterface> modules;
+    if (!import_modules(ws, input_path, *ast, analyzer, modules)) {
+        return 1;
+    }
     analyzer.analyze(*ast);
 
     std::string output;
@@ -268,9 +465,9 @@ static int cmd_symbols(const std::string& input_path,
     }
 
     if (output_path.empty()) {
-        std::cout << output;
-    } else if (!write_output(output_path, output)) {
-        std::cerr << "Failed to write output file: " << output_path << "\n";
+        ws.out() << output;
+    } else if (!write_output(ws, output_path, output)) {
+        ws.err() << "Failed to write output file: " << output_path << "\n";
         return 1;
     }
     return 0;
@@ -279,41 +476,43 @@ static int cmd_symbols(const std::string& input_path,
 // ---------------------------------------------------------------
 // Sprint 4: IR generation command
 // ---------------------------------------------------------------
-static int cmd_ir(const std::string& input_path,
+static int cmd_ir(Workspace& ws,
+                  const std::string& input_path,
                   const std::string& output_path,
                   const std::string& format,
                   bool show_stats,
                   bool do_optimize,
                   bool do_inline) {
-    std::string source = read_source(input_path);
-    if (source.empty()) {
-        std::ifstream test(input_path);
-        if (!test) {
-            std::cerr << "Failed to read input file: " << input_path << "\n";
-            return 1;
-        }
+    SourceText src;
+    if (!load_source(ws, input_path, src)) {
+        return 1;
     }
 
-    auto tokens = tokenize(source, true);
-
-    Parser parser(tokens);
+    Scanner scanner(src.text);
+    Parser parser(scanner);
+    parser.set_use_arena(ws.use_ast_arena);
     auto ast = parser.parse();
+    report_scan_errors(ws, scanner);
 
     if (!parser.errors().empty()) {
         for (const auto& err : parser.errors()) {
-            std::cerr << err.line << ":" << err.column << " PARSE ERROR: "
+            ws.err() << err.line << ":" << err.column << " PARSE ERROR: "
                       << err.message << "\n";
         }
-        std::cerr << "Cannot generate IR: parse errors present\n";
+        ws.err() << "Cannot generate IR: parse errors present\n";
         return 1;
     }
 
-    SemanticAnalyzer analyzer;
+    SemanticAnalyzer analyzer(ws.types);
+    std::vector<ModuleInterface> modules;
+    if (!import_modules(ws, input_path, *ast, analyzer, modules)) {
+        return 1;
+    }
     analyzer.analyze(*ast);
 
     if (!analyzer.get_errors().empty()) {
-        std::cerr << format_error_report(analyzer.get_errors());
-        std::cerr << "Cannot generate IR: semantic errors present\n";
+        ws.err() << format_error_report(analyzer.get_errors());
+        ws.err() << "Cannot generate IR: semantic errors present\n";
         return 1;
     }
 
@@ -322,14 +521,16 @@ static int cmd_ir(const std::string& input_path,
 
     if (do_inline) {
         FunctionInliner inliner(program);
+        if (!ws.profile.empty()) inliner.set_profile(&ws.profile);
         inliner.run();
-        std::cerr << "Functions inlined: " << inliner.get_functions_inlined() << "\n";
+        ws.err() << "Functions inlined: " << inliner.get_functions_inlined() << "\n";
     }
 
     if (do_optimize) {
         PeepholeOptimizer opt(program);
+        opt.set_vector_lanes(ws.vector_lanes);
         opt.optimize();
-        std::cerr << opt.get_optimization_report();
+        ws.err() << opt.get_optimization_report();
     }
 
     std::string output;
@@ -346,9 +547,9 @@ static int cmd_ir(const std::string& input_path,
     }
 
     if (output_path.empty()) {
-        std::cout << output;
-    } else if (!write_output(output_path, output)) {
-        std::cerr << "Failed to write output file: " << output_path << "\n";
+        ws.out() << output;
+    } else if (!write_output(ws, output_path, output)) {
+        ws.err() << "Failed to write output file: " << output_path << "\n";
         return 1;
     }
 
@@ -356,100 +557,395 @@ static int cmd_ir(const std::string& input_path,
 }
 
 // ---------------------------------------------------------------
-// Sprint 5: compile command (source → x86-64 NASM assembly)
+// Фронтенд: исходник → IR (SSA) после инлайнинга
+//
+// С кэшем (--cache-dir) функции, чей IR найден в кэше, остаются
+// пустыми заглушками: их тела не проверяются и не переводятся в IR.
 // ---------------------------------------------------------------
-static int cmd_compile(const std::string& input_path,
-                       const std::string& output_path,
-                       bool do_optimize,
-                       bool do_inline,
-                       RegAllocStrategy regalloc_strategy,
-                       bool x86_peephole,
-                       bool dwarf) {
-    std::string source = read_source(input_path);
-    if (source.empty()) {
-        std::ifstream test(input_path);
-        if (!test) {
-            std::cerr << "Failed to read input file: " << input_path << "\n";
-            return 1;
-        }
+static bool build_ir(Workspace& ws,
+                     const std::string& input_path,
+                     bool do_inline,
+                     IRProgram& program,
+                     CompileCache* cache = nullptr,
+                     const std::string& interface_path = "") {
+    SourceText src;
+    if (!load_source(ws, input_path, src)) {
+        return false;
     }
 
-    auto tokens = tokenize(source, true);
-
-    Parser parser(tokens);
+    // Кэшу нужны все токены (ключи функций), иначе разбор потоковый
+    Scanner scanner(src.text);
+    std::vector<Token> tokens;
+    if (cache) {
+        tokens = read_all_tokens(scanner, src.text.size());
+    }
+    Parser parser = cache ? Parser(tokens) : Parser(scanner);
+    parser.set_use_arena(ws.use_ast_arena);
     auto ast = parser.parse();
+    report_scan_errors(ws, scanner);
 
     if (!parser.errors().empty()) {
         for (const auto& err : parser.errors()) {
-            std::cerr << err.line << ":" << err.column << " PARSE ERROR: "
+            ws.err() << err.line << ":" << err.column << " PARSE ERROR: "
                       << err.message << "\n";
         }
-        std::cerr << "Cannot compile: parse errors present\n";
-        return 1;
+        ws.err() << "Cannot compile: parse errors present\n";
+        return false;
+    }
+
+    SemanticAnalyzer analyzer(ws.types);
+    std::vector<ModuleInterface> modules;
+    if (!import_modules(ws, input_path, *ast, analyzer, modules)) {
+        return false;
+    }
+
+    // Сигнатуры импортированных функций входят в ключи кэша
+    std::string imports_key;
+    for (const auto& module : modules) {
+        imports_key += write_module_interface(module);
     }
+    const std::unordered_set<std::string>* cached =
+        cache ? &cache->plan(tokens, do_inline, imports_key) : nullptr;
 
-    SemanticAnalyzer analyzer;
+    analyzer.set_skip_bodies(cached);
     analyzer.analyze(*ast);
 
     if (!analyzer.get_errors().empty()) {
-        std::cerr << format_error_report(analyzer.get_errors());
-        std::cerr << "Cannot compile: semantic errors present\n";
-        return 1;
+        ws.err() << format_error_report(analyzer.get_errors());
+        ws.err() << "Cannot compile: semantic errors present\n";
+        return false;
+    }
+
+    if (!interface_path.empty() && !write_interface(ws, interface_path, *ast, analyzer)) {
+        return false;
     }
 
     IRGenerator gen(analyzer.get_symbol_table(), analyzer.get_type_registry());
-    IRProgram program = gen.generate(*ast);
+    gen.set_skip_bodies(cached);
+    program = gen.generate(*ast);
 
+    // Инлайнинг меняет несколько функций сразу — всегда последовательно
     if (do_inline) {
         FunctionInliner inliner(program);
+        if (!ws.profile.empty()) inliner.set_profile(&ws.profile);
         inliner.run();
-        std::cerr << "Functions inlined: " << inliner.get_functions_inlined() << "\n";
+        ws.err() << "Functions inlined: " << inliner.get_functions_inlined() << "\n";
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------
+// Фронтенд compile/run: исходник → IR после оптимизаций и выхода из SSA
+// ---------------------------------------------------------------
+static bool build_program(Workspace& ws,
+                          const std::string& input_path,
+                          bool do_optimize,
+                          bool do_inline,
+                          utils::ThreadPool& pool,
+                          IRProgram& program,
+                          CompileCache* cache = nullptr,
+                          const std::string& interface_path = "") {
+    if (!build_ir(ws, input_path, do_inline, program, cache, interface_path)) {
+        return false;
     }
 
     if (do_optimize) {
         PeepholeOptimizer opt(program);
-        opt.optimize();
-        std::cerr << opt.get_optimization_report();
+        opt.set_vector_lanes(ws.vector_lanes);
+        opt.optimize(&pool);
+        ws.err() << opt.get_optimization_report();
+    }
+
+    // Выход из SSA: PHI заменяются параллельными копиями на рёбрах
+    pool.parallel_for(program.functions.size(), [&](size_t i) {
+        destruct_ssa(program.functions[i]);
+    });
+
+    // Заглушки ← IR из кэша; новый IR сохраняется в кэш
+    if (cache) {
+        cache->complete_program(program);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------
+// Профиль для кодогенерации.  Инструментируется только модуль с
+// main: счётчики записываются при выходе из неё.
+// ---------------------------------------------------------------
+static void set_generator_profile(Workspace& ws, const IRProgram& program, X86Generator& x86gen) {
+    if (!ws.profile_generate.empty()) {
+        const IRFunction* main_func = program.find_function("main");
+        if (!main_func || main_func->blocks.empty()) {
+            ws.err() << "Warning: --profile-generate is ignored: the module does not define main\n";
+        }
+        x86gen.set_profile_generate(ws.profile_generate);
+    }
+    if (!ws.profile.empty()) {
+        x86gen.set_profile(&ws.profile);
+    }
+}
+
+// ---------------------------------------------------------------
+// Sprint 5: compile command (source → x86-64 NASM assembly / ELF object)
+// ---------------------------------------------------------------
+static int cmd_compile(Workspace& ws,
+                       const std::string& input_path,
+                       const std::string& output_path,
+                       bool do_optimize,
+                       bool do_inline,
+                       RegAllocStrategy regalloc_strategy,
+                       bool x86_peephole,
+                       bool omit_frame_pointer,
+                       bool dwarf,
+                       int jobs,
+                       bool emit_object,
+                       const std::string& cache_dir,
+                       const std::string& interface_path) {
+    // --cache-dir: неизменившиеся функции берутся из кэша (IR и код)
+    std::unique_ptr<CompileCache> cache;
+    if (!cache_dir.empty()) {
+        const bool gas = dwarf && !emit_object;
+        cache = std::make_unique<CompileCache>(
+            cache_dir,
+            std::string("optimize=") + (do_optimize ? "1" : "0") + " inline=" + (do_inline ? "1" : "0") +
+                " vector=" + std::to_string(ws.vector_lanes) + " profile=" + ws.profile_key,
+            " regalloc=" + std::to_string(static_cast<int>(regalloc_strategy)) +
+                " x86-peephole=" + (x86_peephole ? "1" : "0") + " omit-fp=" + (omit_frame_pointer ? "1" : "0") +
+                " dwarf=" + (gas ? "1" : "0") + " profile-generate=" + ws.profile_generate +
+                " profile=" + ws.profile_key);
+    }
+
+    // --jobs N: оптимизация и кодогенерация функций на пуле потоков
+    utils::ThreadPool pool(jobs);
+    IRProgram program;
+    if (!build_program(ws, input_path, do_optimize, do_inline, pool, program, cache.get(), interface_path)) {
+        return 1;
     }
 
     X86Generator x86gen;
+    if (cache) {
+        x86gen.set_unit_cache(&cache->unit_cache());
+    }
+    x86gen.set_thread_pool(&pool);
     x86gen.set_regalloc_strategy(regalloc_strategy);
     x86gen.set_peephole(x86_peephole);
-    if (dwarf) {
+    x86gen.set_omit_frame_pointer(omit_frame_pointer);
+    set_generator_profile(ws, program, x86gen);
+    if (emit_object) {
+        // --emit obj: машинный код кодируется сам, DWARF не выдаётся
+        if (dwarf) {
+            ws.err() << "Warning: --dwarf is ignored with --emit obj\n";
+        }
+        x86gen.set_emit_object(true);
+        x86gen.set_source_file(input_path);
+    } else if (dwarf) {
         x86gen.set_dwarf(true);
         x86gen.set_source_file(input_path);
     }
     std::string asm_output = x86gen.generate(program);
+    if (!x86gen.errors().empty()) {
+        for (const auto& err : x86gen.errors()) {
+            ws.err() << "CODEGEN ERROR: " << err << "\n";
+        }
+        return 1;
+    }
 
     // Определяем имя выходного файла
     std::string out_path = output_path;
     if (out_path.empty()) {
-        // Заменяем расширение на .asm
+        // Заменяем расширение на .asm (.o для --emit obj)
         out_path = input_path;
         auto dot = out_path.rfind('.');
         if (dot != std::string::npos) {
             out_path = out_path.substr(0, dot);
         }
-        out_path += ".asm";
+        out_path += emit_object ? ".o" : ".asm";
     }
 
-    if (!write_output(out_path, asm_output)) {
-        std::cerr << "Failed to write output file: " << out_path << "\n";
+    if (!write_output(ws, out_path, asm_output)) {
+        ws.err() << "Failed to write output file: " << out_path << "\n";
         return 1;
     }
 
-    std::cerr << "Compiled to: " << out_path << "\n";
-    std::cerr << x86gen.statistics();
+    ws.err() << "Compiled to: " << out_path << "\n";
+    ws.err() << x86gen.statistics();
+    if (cache) {
+        for (const auto& err : cache->errors()) {
+            ws.err() << "Warning: " << err << "\n";
+        }
+        ws.err() << cache->statistics();
+    }
     return 0;
 }
 
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        print_usage();
+// ---------------------------------------------------------------
+// interp: IR исполняется интерпретатором, без ассемблера.
+//
+// --verify-passes: программа запускается до оптимизаций, после
+// инлайнинга, после каждого изменившего функцию прохода и после
+// выхода из SSA; вывод и код возврата должны совпадать.
+// ---------------------------------------------------------------
+static int cmd_interp(Workspace& ws,
+                      const std::string& input_path,
+                      bool do_optimize,
+                      bool do_inline,
+                      bool verify_passes) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (!verify_passes) {
+        utils::ThreadPool pool(1);
+        IRProgram program;
+        if (!build_program(ws, input_path, do_optimize, do_inline, pool, program)) {
+            return 1;
+        }
+        IRInterpreter interp(program);
+        bool ok = interp.run();
+        std::fflush(stdout);
+        std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+        for (const auto& err : interp.errors()) {
+            ws.err() << "INTERP ERROR: " << err << "\n";
+        }
+        ws.err() << "Interpret time: " << ms.count() << " ms\n";
+        return ok ? interp.exit_code() : 1;
+    }
+
+    IRProgram program;
+    if (!build_ir(ws, input_path, false, program)) {
         return 1;
     }
+    // stdin читается лениво, по мере read_int; все прогоны видят один буфер
+    std::string input;
+
+    struct Outcome {
+        bool ok = false;
+        int exit_code = 0;
+        std::string output;
+        std::uint64_t branches = 0;
+    };
+    std::uint64_t limit = 0;
+    auto execute = [&](Outcome& result) {
+        IRInterpreter interp(program);
+        interp.set_capture_output(true);
+        interp.set_input(&input, &std::cin);
+        interp.set_branch_limit(limit);
+        result.ok = interp.run();
+        result.exit_code = interp.exit_code();
+        result.output = interp.output();
+        result.branches = interp.branches_executed();
+        for (const auto& err : interp.errors()) {
+            ws.err() << "INTERP ERROR: " << err << "\n";
+        }
+    };
+
+    Outcome baseline;
+    execute(baseline);
+    if (!baseline.ok) return 1;
+    // Зациклившийся после прохода вариант останавливается по лимиту
+    limit = baseline.branches * 4 + 1000000;
+
+    int checks = 0;
+    int failures = 0;
+    auto verify = [&](const std::string& stage) {
+        Outcome now;
+        execute(now);
+        ++checks;
+        if (now.ok && now.exit_code == baseline.exit_code && now.output == baseline.output) {
+            return;
+        }
+        ++failures;
+        ws.err() << "VERIFY FAILED after " << stage << ": exit " << baseline.exit_code
+                  << " -> " << (now.ok ? std::to_string(now.exit_code) : "error")
+                  << (now.output == baseline.output ? "" : ", output differs") << "\n";
+    };
 
-    std::string command = argv[1];
+    if (do_inline) {
+        FunctionInliner inliner(program);
+        inliner.run();
+        verify("inlining");
+    }
+    if (do_optimize) {
+        PeepholeOptimizer opt(program);
+        opt.set_vector_lanes(ws.vector_lanes);
+        opt.set_pass_hook([&](const char* pass, const IRFunction& func) {
+            verify(std::string(pass) + " in " + func.name);
+        });
+        opt.optimize();
+    }
+    destruct_ssa(program);
+    verify("destruct_ssa");
+
+    std::cout << baseline.output;
+    std::cout.flush();
+    std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+    ws.err() << "Verified " << checks << " stages, " << failures << " failed\n";
+    ws.err() << "Interpret time: " << ms.count() << " ms\n";
+    return failures == 0 ? baseline.exit_code : 1;
+}
+
+// ---------------------------------------------------------------
+// run: JIT — объект загружается в память процесса, main вызывается
+// напрямую.  Время компиляции и выполнения выводится отдельно.
+// ---------------------------------------------------------------
+static int cmd_run(Workspace& ws,
+                   const std::string& input_path,
+                   bool do_optimize,
+                   bool do_inline,
+                   RegAllocStrategy regalloc_strategy,
+                   bool x86_peephole,
+                   bool omit_frame_pointer,
+                   int jobs) {
+    auto compile_start = std::chrono::steady_clock::now();
+
+    utils::ThreadPool pool(jobs);
+    IRProgram program;
+    if (!build_program(ws, input_path, do_optimize, do_inline, pool, program)) {
+        return 1;
+    }
+
+    X86Generator x86gen;
+    x86gen.set_thread_pool(&pool);
+    x86gen.set_regalloc_strategy(regalloc_strategy);
+    x86gen.set_peephole(x86_peephole);
+    x86gen.set_omit_frame_pointer(omit_frame_pointer);
+    x86gen.set_source_file(input_path);
+    set_generator_profile(ws, program, x86gen);
+    elf::Object object = x86gen.generate_object(program);
+    if (!x86gen.errors().empty()) {
+        for (const auto& err : x86gen.errors()) {
+            ws.err() << "CODEGEN ERROR: " << err << "\n";
+        }
+        return 1;
+    }
+
+    JitModule module;
+    if (!module.load(object)) {
+        ws.err() << "JIT ERROR: " << module.error() << "\n";
+        return 1;
+    }
+    auto* entry = reinterpret_cast<int (*)()>(module.symbol("main"));
+    if (!entry) {
+        ws.err() << "JIT ERROR: function main is not defined\n";
+        return 1;
+    }
+    std::chrono::duration<double, std::milli> compile_ms =
+        std::chrono::steady_clock::now() - compile_start;
+
+    auto run_start = std::chrono::steady_clock::now();
+    int result = entry();
+    std::fflush(stdout);
+    std::chrono::duration<double, std::milli> run_ms =
+        std::chrono::steady_clock::now() - run_start;
+
+    ws.err() << "Compile time: " << compile_ms.count() << " ms\n";
+    ws.err() << "Run time: " << run_ms.count() << " ms\n";
+    return result;
+}
+
+// ---------------------------------------------------------------
+// Флаги команды — из командной строки или из запроса serve
+// ---------------------------------------------------------------
+struct Options {
+    std::string command;
     std::string input_path;
     std::string output_path;
     std::string format = "text";
@@ -460,63 +956,387 @@ int main(int argc, char** argv) {
     bool do_inline = false;
     std::string regalloc_str = "stack";
     bool x86_peephole = false;
+    bool omit_frame_pointer = false;
     bool dwarf = false;
-
-    for (int i = 2; i < argc; ++i) {
-        std::string arg = argv[i];
-        if (arg == "--input" && i + 1 < argc) {
-            input_path = argv[++i];
-        } else if (arg == "--output" && i + 1 < argc) {
-            output_path = argv[++i];
-        } else if (arg == "--format" && i + 1 < argc) {
-            format = argv[++i];
+    int jobs = 1;
+    std::string emit = "asm";
+    bool verify_passes = false;
+    std::string cache_dir;
+    std::string scanner_level = "auto";
+    bool use_ast_arena = true;
+    std::vector<std::string> module_paths;
+    std::string emit_interface;
+    std::string target_features = "none";
+    std::string profile_generate;
+    std::string profile_use;
+};
+
+static void parse_flags(const std::vector<std::string>& args, Options& opt) {
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        const bool has_value = i + 1 < args.size();
+        if (arg == "--input" && has_value) {
+            opt.input_path = args[++i];
+        } else if (arg == "--output" && has_value) {
+            opt.output_path = args[++i];
+        } else if (arg == "--format" && has_value) {
+            opt.format = args[++i];
         } else if (arg == "--verbose") {
-            verbose = true;
+            opt.verbose = true;
         } else if (arg == "--show-types") {
-            show_types = true;
+            opt.show_types = true;
         } else if (arg == "--stats") {
-            show_stats = true;
+            opt.show_stats = true;
         } else if (arg == "--optimize") {
-            do_optimize = true;
+            opt.do_optimize = true;
         } else if (arg == "--inline") {
-            do_inline = true;
-        } else if (arg == "--regalloc" && i + 1 < argc) {
-            regalloc_str = argv[++i];
+            opt.do_inline = true;
+        } else if (arg == "--regalloc" && has_value) {
+            opt.regalloc_str = args[++i];
         } else if (arg == "--x86-peephole") {
-            x86_peephole = true;
+            opt.x86_peephole = true;
+        } else if (arg == "--omit-frame-pointer") {
+            opt.omit_frame_pointer = true;
         } else if (arg == "--dwarf") {
-            dwarf = true;
+            opt.dwarf = true;
+        } else if (arg == "--jobs" && has_value) {
+            opt.jobs = std::atoi(args[++i].c_str());
+            if (opt.jobs <= 0) {
+                opt.jobs = static_cast<int>(std::thread::hardware_concurrency());
+                if (opt.jobs <= 0) opt.jobs = 1;
+            }
+        } else if (arg == "--emit" && has_value) {
+            opt.emit = args[++i];
+        } else if (arg == "--cache-dir" && has_value) {
+            opt.cache_dir = args[++i];
+        } else if (arg == "--verify-passes") {
+            opt.verify_passes = true;
+        } else if (arg == "--no-ast-arena") {
+            opt.use_ast_arena = false;
+        } else if (arg == "--scanner" && has_value) {
+            opt.scanner_level = args[++i];
+        } else if (arg == "--module-path" && has_value) {
+            opt.module_paths.push_back(args[++i]);
+        } else if (arg == "--emit-interface" && has_value) {
+            opt.emit_interface = args[++i];
+        } else if (arg == "--target-features" && has_value) {
+            opt.target_features = args[++i];
+        } else if (arg == "--profile-generate" && has_value) {
+            opt.profile_generate = args[++i];
+        } else if (arg == "--profile-use" && has_value) {
+            opt.profile_use = args[++i];
         }
     }
+}
 
-    if (input_path.empty()) {
-        print_usage();
-        return 1;
+// ---------------------------------------------------------------
+// --target-features → ширина векторов для векторизатора циклов
+//
+// sse4.1 — 4 int в xmm (pmulld появилась в SSE4.1), avx2 — 8 int в
+// ymm, native — лучшее, что есть у этого процессора.  compile
+// собирает и для другой машины, поэтому проверка процессора нужна
+// только run: там код исполняется здесь же.
+// ---------------------------------------------------------------
+static bool target_lanes(Workspace& ws, const std::string& features, bool host_only, int& lanes) {
+    if (features == "none") {
+        lanes = 0;
+    } else if (features == "sse4.1") {
+        lanes = 4;
+    } else if (features == "avx2") {
+        lanes = 8;
+    } else if (features == "native") {
+        lanes = __builtin_cpu_supports("avx2") ? 8 : __builtin_cpu_supports("sse4.1") ? 4 : 0;
+    } else {
+        ws.err() << "Unknown --target-features: " << features
+                 << " (expected none, sse4.1, avx2 or native)\n";
+        return false;
     }
+    if (host_only && ((lanes == 8 && !__builtin_cpu_supports("avx2")) ||
+                      (lanes == 4 && !__builtin_cpu_supports("sse4.1")))) {
+        ws.err() << "Target features " << features << " are not supported on this CPU\n";
+        return false;
+    }
+    return true;
+}
 
+static int run_command(Workspace& ws, const Options& opt) {
+    ws.use_ast_arena = opt.use_ast_arena;
+    ws.module_paths = opt.module_paths;
+    const std::string& command = opt.command;
+    if (!target_lanes(ws, opt.target_features, command == "run", ws.vector_lanes)) {
+        return 1;
+    }
+    ws.profile_generate = opt.profile_generate;
+    ws.profile = ProfileData{};
+    ws.profile_key.clear();
+    if (!opt.profile_use.empty()) {
+        std::ifstream in(opt.profile_use, std::ios::binary);
+        if (!in) {
+            ws.err() << "Failed to read profile: " << opt.profile_use << "\n";
+            return 1;
+        }
+        const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::string error;
+        if (!ws.profile.parse(text, error)) {
+            ws.err() << "Invalid profile " << opt.profile_use << ": " << error << "\n";
+            return 1;
+        }
+        ws.profile_key = std::to_string(std::hash<std::string>{}(text));
+    }
     if (command == "lex") {
-        return cmd_lex(input_path, output_path);
+        return cmd_lex(ws, opt.input_path, opt.output_path, opt.verbose);
     }
     if (command == "parse") {
-        return cmd_parse(input_path, output_path, format, verbose);
+        return cmd_parse(ws, opt.input_path, opt.output_path, opt.format, opt.verbose);
     }
     if (command == "check") {
-        return cmd_check(input_path, output_path, verbose, show_types);
+        return cmd_check(ws, opt.input_path, opt.output_path, opt.verbose, opt.show_types, opt.emit_interface);
     }
     if (command == "symbols") {
-        return cmd_symbols(input_path, output_path, format);
+        return cmd_symbols(ws, opt.input_path, opt.output_path, opt.format);
     }
     if (command == "ir") {
-        return cmd_ir(input_path, output_path, format, show_stats, do_optimize, do_inline);
+        return cmd_ir(ws, opt.input_path, opt.output_path, opt.format, opt.show_stats, opt.do_optimize,
+                      opt.do_inline);
+    }
+
+    RegAllocStrategy strategy = RegAllocStrategy::StackOnly;
+    if (opt.regalloc_str == "lsra") {
+        strategy = RegAllocStrategy::LinearScan;
+    } else if (opt.regalloc_str == "graph") {
+        strategy = RegAllocStrategy::GraphColoring;
     }
     if (command == "compile") {
-        RegAllocStrategy strategy = RegAllocStrategy::StackOnly;
-        if (regalloc_str == "lsra") {
-            strategy = RegAllocStrategy::LinearScan;
+        if (opt.emit != "asm" && opt.emit != "obj") {
+            ws.err() << "Unknown --emit kind: " << opt.emit << " (expected asm or obj)\n";
+            return 1;
         }
-        return cmd_compile(input_path, output_path, do_optimize, do_inline, strategy, x86_peephole, dwarf);
+        return cmd_compile(ws, opt.input_path, opt.output_path, opt.do_optimize, opt.do_inline, strategy,
+                           opt.x86_peephole, opt.omit_frame_pointer, opt.dwarf, opt.jobs, opt.emit == "obj", opt.cache_dir,
+                           opt.emit_interface);
+    }
+    if (command == "interp") {
+        return cmd_interp(ws, opt.input_path, opt.do_optimize, opt.do_inline, opt.verify_passes);
+    }
+    if (command == "run") {
+        return cmd_run(ws, opt.input_path, opt.do_optimize, opt.do_inline, strategy, opt.x86_peephole,
+                       opt.omit_frame_pointer, opt.jobs);
     }
 
     print_usage();
     return 1;
 }
+
+// ---------------------------------------------------------------
+// serve: один долгоживущий процесс на сборку всего проекта
+//
+// Запрос — строка JSON на stdin:
+//   {"id": 7, "command": "compile", "input": "a.src", "output": "a.o",
+//    "flags": ["--optimize", "--emit", "obj"]}
+// "flags" — те же флаги, что в командной строке.  Ответ — строка
+// JSON на stdout, в порядке готовности (id связывает её с
+// запросом):
+//   {"id": 7, "command": "compile", "input": "a.src", "exit_code": 0,
+//    "outputs": ["a.o"], "diagnostics": [...], "time_ms": 3.1}
+// То, что команда вывела бы в stdout, приходит в поле "stdout".
+//
+// Запросы выполняются на --jobs рабочих потоках, у каждого свой
+// Workspace.  run и interp недоступны: программа исполнялась бы в
+// процессе сервера, а его stdout занят ответами.
+// ---------------------------------------------------------------
+static bool request_options(const utils::JsonValue& request, Options& opt, std::ostream& err) {
+    if (request.kind != utils::JsonValue::Kind::Object) {
+        err << "Invalid request: expected a JSON object\n";
+        return false;
+    }
+    const utils::JsonValue* command = request.get("command");
+    if (!command || !command->is_string()) {
+        err << "Invalid request: \"command\" must be a string\n";
+        return false;
+    }
+    std::vector<std::string> args;
+    if (const utils::JsonValue* flags = request.get("flags")) {
+        if (flags->kind != utils::JsonValue::Kind::Array) {
+            err << "Invalid request: \"flags\" must be an array of strings\n";
+            return false;
+        }
+        for (const auto& flag : flags->items) {
+            if (!flag.is_string()) {
+                err << "Invalid request: \"flags\" must be an array of strings\n";
+                return false;
+            }
+            args.push_back(flag.text);
+        }
+    }
+    for (const char* field : {"input", "output"}) {
+        const utils::JsonValue* value = request.get(field);
+        if (!value) continue;
+        if (!value->is_string()) {
+            err << "Invalid request: \"" << field << "\" must be a string\n";
+            return false;
+        }
+        args.push_back(std::string("--") + field);
+        args.push_back(value->text);
+    }
+    opt.command = command->text;
+    parse_flags(args, opt);
+
+    static const std::unordered_set<std::string> served = {"lex", "parse", "check", "symbols", "ir", "compile"};
+    if (!served.count(opt.command)) {
+        err << "Command " << opt.command << " is not available in serve mode\n";
+        return false;
+    }
+    if (opt.input_path.empty()) {
+        err << "Invalid request: \"input\" is required\n";
+        return false;
+    }
+    if (opt.scanner_level != "auto") {
+        err << "Warning: --scanner is ignored in a request (pass it to compiler serve)\n";
+    }
+    return true;
+}
+
+static std::string serve_request(Workspace& ws, const std::string& line, int& exit_code) {
+    auto start = std::chrono::steady_clock::now();
+    std::ostringstream out;
+    std::ostringstream err;
+    ws.out_stream = &out;
+    ws.err_stream = &err;
+    ws.written.clear();
+
+    exit_code = 1;
+    std::string id = "null";
+    Options opt;
+    utils::JsonValue request;
+    std::string error;
+    if (!utils::parse_json(line, request, error)) {
+        err << "Invalid request: " << error << "\n";
+    } else {
+        if (const utils::JsonValue* value = request.get("id")) id = utils::to_json(*value);
+        if (request_options(request, opt, err)) {
+            exit_code = run_command(ws, opt);
+        }
+    }
+    std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+
+    std::string response = "{\"id\":" + id;
+    if (!opt.command.empty()) response += ",\"command\":" + utils::json_quote(opt.command);
+    if (!opt.input_path.empty()) response += ",\"input\":" + utils::json_quote(opt.input_path);
+    response += ",\"exit_code\":" + std::to_string(exit_code);
+    response += ",\"outputs\":[";
+    for (std::size_t i = 0; i < ws.written.size(); ++i) {
+        if (i) response += ",";
+        response += utils::json_quote(ws.written[i]);
+    }
+    response += "],\"diagnostics\":[";
+    std::istringstream lines(err.str());
+    bool first = true;
+    for (std::string diag; std::getline(lines, diag);) {
+        if (!first) response += ",";
+        response += utils::json_quote(diag);
+        first = false;
+    }
+    response += "]";
+    if (!out.str().empty()) response += ",\"stdout\":" + utils::json_quote(out.str());
+    response += ",\"time_ms\":" + std::to_string(ms.count()) + "}";
+    return response;
+}
+
+static int cmd_serve(int jobs) {
+    auto start = std::chrono::steady_clock::now();
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::string> queue;
+    bool closed = false;
+    std::mutex output_mutex;
+    std::atomic<int> failed{0};
+
+    auto worker = [&] {
+        Workspace ws;
+        while (true) {
+            std::string line;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [&] { return closed || !queue.empty(); });
+                if (queue.empty()) return;
+                line = std::move(queue.front());
+                queue.pop_front();
+            }
+            int exit_code = 0;
+            const std::string response = serve_request(ws, line, exit_code);
+            if (exit_code != 0) ++failed;
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << response << "\n";
+            std::cout.flush();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < jobs; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    int requests = 0;
+    for (std::string line; std::getline(std::cin, line);) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        ++requests;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            queue.push_back(std::move(line));
+        }
+        queue_cv.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        closed = true;
+    }
+    queue_cv.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+    std::cerr << "Served " << requests << " requests (" << failed.load() << " failed) on " << jobs
+              << " workers in " << ms.count() << " ms\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    // serve: --jobs — число рабочих потоков (по умолчанию — все ядра)
+    Options opt;
+    opt.command = argv[1];
+    if (opt.command == "serve") {
+        opt.jobs = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    parse_flags(std::vector<std::string>(argv + 2, argv + argc), opt);
+
+    // --scanner: уровень быстрых путей лексера (по умолчанию — лучший)
+    if (opt.scanner_level != "auto") {
+        char_scan::Level level;
+        if (!char_scan::parse_level(opt.scanner_level.c_str(), level)) {
+            std::cerr << "Unknown --scanner level: " << opt.scanner_level
+                      << " (expected auto, scalar, sse4.2 or avx2)\n";
+            return 1;
+        }
+        if (!char_scan::set_level(level)) {
+            std::cerr << "Scanner level " << opt.scanner_level << " is not supported on this CPU\n";
+            return 1;
+        }
+    }
+
+    if (opt.command == "serve") {
+        return cmd_serve(opt.jobs);
+    }
+
+    if (opt.input_path.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    Workspace ws;
+    return run_command(ws, opt);
+}
@@ -5,6 +5,8 @@
 #include <variant>
 #include <vector>
 
+#include "parser/ast_arena.h"
+
 struct ASTNode;
 struct ExpressionNode;
 struct StatementNode;
@@ -60,19 +62,32 @@ public:
 struct ASTNode {
     int line = 0;
     int column = 0;
+    bool arena_owned = false;   // storage belongs to an ASTArena
     virtual ~ASTNode() = default;
     virtual void accept(ASTVisitor& visitor) = 0;
 };
 
+// Arena nodes are only destroyed; their memory goes away with the arena.
+struct ASTNodeDeleter {
+    void operator()(ASTNode* node) const {
+        if (!node) return;
+        if (node->arena_owned) node->~ASTNode();
+        else delete node;
+    }
+};
+
+template <typename T>
+using NodePtr = std::unique_ptr<T, ASTNodeDeleter>;
+
 struct ExpressionNode : virtual ASTNode {
     std::string resolved_type;  // filled by semantic analyzer (Sprint 3)
 };
 struct StatementNode : virtual ASTNode {};
 struct DeclarationNode : virtual ASTNode {};
 
-using ExprPtr = std::unique_ptr<ExpressionNode>;
-using StmtPtr = std::unique_ptr<StatementNode>;
-using DeclPtr = std::unique_ptr<DeclarationNode>;
+using ExprPtr = NodePtr<ExpressionNode>;
+using StmtPtr = NodePtr<StatementNode>;
+using DeclPtr = NodePtr<DeclarationNode>;
 
 struct LiteralExprNode : ExpressionNode {
     enum class Kind { Integer, Float, Bool, String };
@@ -174,7 +189,7 @@ struct VarDeclStmtNode : StatementNode, DeclarationNode {
     
     bool is_array = false;
     std::vector<int> array_sizes;
-    std::unique_ptr<ArrayInitExprNode> array_init;
+    NodePtr<ArrayInitExprNode> array_init;
     
     void accept(ASTVisitor& v) override { v.visit(*this); }
 };
@@ -191,18 +206,27 @@ struct FunctionDeclNode : DeclarationNode {
     std::string name;
     std::vector<ParamNode> parameters;
     std::string return_type;
-    std::unique_ptr<BlockStmtNode> body;
+    NodePtr<BlockStmtNode> body;
     bool is_extern = false;
     void accept(ASTVisitor& v) override { v.visit(*this); }
 };
 
 struct StructDeclNode : DeclarationNode {
     std::string name;
-    std::vector<std::unique_ptr<VarDeclStmtNode>> fields;
+    std::vector<NodePtr<VarDeclStmtNode>> fields;
     void accept(ASTVisitor& v) override { v.visit(*this); }
 };
 
+// import name; — the module's interface file is read by the driver
+struct ImportDecl {
+    std::string module;
+    int line = 0;
+    int column = 0;
+};
+
 struct ProgramNode : ASTNode {
+    std::unique_ptr<ASTArena> arena;    // declared first: outlives declarations
+    std::vector<ImportDecl> imports;
     std::vector<DeclPtr> declarations;
     void accept(ASTVisitor& v) override { v.visit(*this); }
 };
@@ -0,0 +1,32 @@
+#include "parser/ast_arena.h"
+
+#include <cstdint>
+
+ASTArena::ASTArena(std::size_t block_size)
+    : block_size_(block_size) {}
+
+void ASTArena::add_block(std::size_t min_size) {
+    std::size_t size = min_size > block_size_ ? min_size : block_size_;
+    blocks_.emplace_back(new unsigned char[size]);
+    cur_ = blocks_.back().get();
+    end_ = cur_ + size;
+    bytes_reserved_ += size;
+}
+
+void* ASTArena::allocate(std::size_t size, std::size_t align) {
+    auto aligned = [align](unsigned char* p) {
+        auto addr = reinterpret_cast<std::uintptr_t>(p);
+        addr = (addr + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+        return reinterpret_cast<unsigned char*>(addr);
+    };
+
+    unsigned char* p = cur_ ? aligned(cur_) : nullptr;
+    if (!p || p + size > end_) {
+        // Oversized requests get a block of their own
+        add_block(size + align);
+        p = aligned(cur_);
+    }
+    cur_ = p + size;
+    bytes_used_ += size;
+    return p;
+}
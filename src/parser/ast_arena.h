@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------
+// ASTArena — bump allocator for AST nodes of one compilation
+//
+// Nodes are carved out of large blocks and the blocks are released
+// together when the arena is destroyed.  Node destructors still run
+// (through ASTNodeDeleter) so std::string / std::vector members free
+// their own storage; only the per-node heap allocation goes away.
+//
+// The arena is owned by the ProgramNode it was used for, so a tree
+// can outlive the Parser that built it.  Not thread-safe.
+// ---------------------------------------------------------------
+class ASTArena {
+public:
+    static constexpr std::size_t kDefaultBlockSize = 64 * 1024;
+
+    explicit ASTArena(std::size_t block_size = kDefaultBlockSize);
+    ~ASTArena() = default;
+
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+
+    /// Raw storage for `size` bytes aligned to `align`.
+    void* allocate(std::size_t size, std::size_t align);
+
+    /// Construct a T in the arena.
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* mem = allocate(sizeof(T), alignof(T));
+        T* obj = new (mem) T(std::forward<Args>(args)...);
+        obj->arena_owned = true;
+        ++objects_;
+        return obj;
+    }
+
+    std::size_t bytes_used() const { return bytes_used_; }
+    std::size_t bytes_reserved() const { return bytes_reserved_; }
+    std::size_t block_count() const { return blocks_.size(); }
+    std::size_t object_count() const { return objects_; }
+
+private:
+    std::size_t block_size_;
+    std::vector<std::unique_ptr<unsigned char[]>> blocks_;
+    unsigned char* cur_ = nullptr;
+    unsigned char* end_ = nullptr;
+    std::size_t bytes_used_ = 0;
+    std::size_t bytes_reserved_ = 0;
+    std::size_t objects_ = 0;
+
+    void add_block(std::size_t min_size);
+};
@@ -12,6 +12,10 @@ public:
     void visit(ProgramNode& node) override {
         out_ << "Program [line " << node.line << "]:\n";
         indent_++;
+        for (const auto& imp : node.imports) {
+            ind();
+            out_ << "Import: " << imp.module << " [line " << imp.line << "]\n";
+        }
         for (auto& d : node.declarations) {
             d->accept(*this);
         }
@@ -541,8 +545,16 @@ public:
     std::string result() const { return out_.str(); }
 
     void visit(ProgramNode& node) override {
-        out_ << "{\"type\":\"Program\",\"line\":" << node.line
-             << ",\"declarations\":[";
+        out_ << "{\"type\":\"Program\",\"line\":" << node.line;
+        if (!node.imports.empty()) {
+            out_ << ",\"imports\":[";
+            for (std::size_t i = 0; i < node.imports.size(); ++i) {
+                if (i > 0) out_ << ",";
+                out_ << "\"" << node.imports[i].module << "\"";
+            }
+            out_ << "]";
+        }
+        out_ << ",\"declarations\":[";
         for (std::size_t i = 0; i < node.declarations.size(); ++i) {
             if (i > 0) out_ << ",";
             node.declarations[i]->accept(*this);
@@ -2,15 +2,42 @@
 
 #include <stdexcept>
 
-Parser::Parser(const std::vector<Token>& tokens)
-    : tokens_(tokens), current_(0) {}
+Parser::Parser(const std::vector<Token>& tokens) : tokens_(&tokens) {
+    fetch();
+    fetch();
+}
+
+Parser::Parser(Scanner& scanner) : scanner_(&scanner) {
+    fetch();
+    fetch();
+}
 
 const std::vector<ParseError>& Parser::errors() const { return errors_; }
 const ErrorMetrics& Parser::metrics() const { return metrics_; }
 
-const Token& Parser::peek() const { return tokens_[current_]; }
+// Следующий токен потока в окно; после END_OF_FILE окно
+// заполняется его копиями
+void Parser::fetch() {
+    Token& slot = window_[fetched_ & (kWindow - 1)];
+    const Token& last = window_[(fetched_ - 1) & (kWindow - 1)];
+    if (fetched_ > 0 && last.type == TokenType::END_OF_FILE) {
+        slot = last;
+    } else if (scanner_) {
+        slot = scanner_->next_token();
+        ++tokens_read_;
+    } else if (tokens_read_ < tokens_->size()) {
+        slot = (*tokens_)[tokens_read_++];
+    } else {
+        slot = Token{TokenType::END_OF_FILE, "", 0, 0, {}};
+    }
+    ++fetched_;
+}
+
+const Token& Parser::peek() const { return window_[current_ & (kWindow - 1)]; }
+
+const Token& Parser::peek_next() const { return window_[(current_ + 1) & (kWindow - 1)]; }
 
-const Token& Parser::previous() const { return tokens_[current_ - 1]; }
+const Token& Parser::previous() const { return window_[(current_ - 1) & (kWindow - 1)]; }
 
 bool Parser::isAtEnd() const {
     return peek().type == TokenType::END_OF_FILE;
@@ -19,6 +46,8 @@ bool Parser::isAtEnd() const {
 const Token& Parser::advance() {
     if (!isAtEnd()) {
         current_++;
+        // текущий и следующий токены — всегда в окне
+        if (fetched_ <= current_ + 1) fetch();
     }
     return previous();
 }
@@ -74,6 +103,7 @@ void Parser::synchronize() {
         }
         switch (peek().type) {
         case TokenType::KW_FN:
+        case TokenType::KW_IMPORT:
         case TokenType::KW_STRUCT:
         case TokenType::KW_INT:
         case TokenType::KW_FLOAT:
@@ -98,6 +128,10 @@ void Parser::synchronize() {
 
 std::unique_ptr<ProgramNode> Parser::parse() {
     auto program = std::make_unique<ProgramNode>();
+    if (use_arena_) {
+        program->arena = std::make_unique<ASTArena>();
+        arena_ = program->arena.get();
+    }
     program->line = peek().line;
     program->column = peek().column;
 
@@ -107,6 +141,8 @@ std::unique_ptr<ProgramNode> Parser::parse() {
             program->declarations.push_back(std::move(decl));
         }
     }
+    arena_ = nullptr;
+    program->imports = std::move(imports_);
     return program;
 }
 
@@ -119,7 +155,7 @@ bool Parser::isTypeName() const {
 std::string Parser::parseTypeName() {
     if (match({TokenType::KW_INT, TokenType::KW_FLOAT, TokenType::KW_BOOL,
                TokenType::KW_VOID, TokenType::IDENTIFIER})) {
-        return previous().lexeme;
+        return std::string(previous().lexeme);
     }
     report_error(peek(), "Ожидается имя типа");
     return "?";
@@ -127,6 +163,10 @@ std::string Parser::parseTypeName() {
 
 DeclPtr Parser::parseDeclaration() {
     try {
+        if (check(TokenType::KW_IMPORT)) {
+            parseImport();
+            return nullptr;
+        }
         if (check(TokenType::KW_EXTERN)) {
             return parseExternDecl();
         }
@@ -152,8 +192,23 @@ DeclPtr Parser::parseDeclaration() {
     }
 }
 
-std::unique_ptr<FunctionDeclNode> Parser::parseExternDecl() {
-    auto node = std::make_unique<FunctionDeclNode>();
+void Parser::parseImport() {
+    ImportDecl decl;
+    decl.line = peek().line;
+    decl.column = peek().column;
+    consume(TokenType::KW_IMPORT, "Ожидается 'import'");
+    if (!check(TokenType::IDENTIFIER)) {
+        report_error(peek(), "Ожидается имя модуля");
+        synchronize();
+        return;
+    }
+    decl.module = advance().lexeme;
+    imports_.push_back(std::move(decl));
+    consume(TokenType::SEMICOLON, "Ожидается ';' после import");
+}
+
+NodePtr<FunctionDeclNode> Parser::parseExternDecl() {
+    auto node = make_node<FunctionDeclNode>();
     node->line = peek().line;
     node->column = peek().column;
     node->is_extern = true;
@@ -199,8 +254,8 @@ std::unique_ptr<FunctionDeclNode> Parser::parseExternDecl() {
     return node;
 }
 
-std::unique_ptr<FunctionDeclNode> Parser::parseFunctionDecl() {
-    auto node = std::make_unique<FunctionDeclNode>();
+NodePtr<FunctionDeclNode> Parser::parseFunctionDecl() {
+    auto node = make_node<FunctionDeclNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::KW_FN, "Ожидается 'fn'");
@@ -235,8 +290,8 @@ std::unique_ptr<FunctionDeclNode> Parser::parseFunctionDecl() {
     return node;
 }
 
-std::unique_ptr<StructDeclNode> Parser::parseStructDecl() {
-    auto node = std::make_unique<StructDeclNode>();
+NodePtr<StructDeclNode> Parser::parseStructDecl() {
+    auto node = make_node<StructDeclNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::KW_STRUCT, "Ожидается 'struct'");
@@ -258,9 +313,9 @@ std::unique_ptr<StructDeclNode> Parser::parseStructDecl() {
     return node;
 }
 
-std::unique_ptr<VarDeclStmtNode> Parser::parseVarDecl(
+NodePtr<VarDeclStmtNode> Parser::parseVarDecl(
     const std::string& type_name, int line, int col) {
-    auto node = std::make_unique<VarDeclStmtNode>();
+    auto node = make_node<VarDeclStmtNode>();
     node->line = line;
     node->column = col;
     node->type_name = type_name;
@@ -282,7 +337,7 @@ std::unique_ptr<VarDeclStmtNode> Parser::parseVarDecl(
     
     if (match(TokenType::ASSIGN)) {
         if (check(TokenType::LBRACE)) {
-            node->array_init = std::unique_ptr<ArrayInitExprNode>(static_cast<ArrayInitExprNode*>(parseArrayInit().release()));
+            node->array_init = NodePtr<ArrayInitExprNode>(static_cast<ArrayInitExprNode*>(parseArrayInit().release()));
         } else {
             node->initializer = parseExpression();
         }
@@ -299,7 +354,7 @@ StmtPtr Parser::parseStatement() {
     if (check(TokenType::KW_RETURN)) return parseReturnStmt();
 
     if (match(TokenType::SEMICOLON)) {
-        auto empty = std::make_unique<ExprStmtNode>();
+        auto empty = make_node<ExprStmtNode>();
         empty->line = previous().line;
         empty->column = previous().column;
         return empty;
@@ -313,7 +368,7 @@ StmtPtr Parser::parseStatement() {
     }
 
     auto expr = parseExpression();
-    auto stmt = std::make_unique<ExprStmtNode>();
+    auto stmt = make_node<ExprStmtNode>();
     stmt->line = expr->line;
     stmt->column = expr->column;
     stmt->expression = std::move(expr);
@@ -321,8 +376,8 @@ StmtPtr Parser::parseStatement() {
     return stmt;
 }
 
-std::unique_ptr<BlockStmtNode> Parser::parseBlock() {
-    auto node = std::make_unique<BlockStmtNode>();
+NodePtr<BlockStmtNode> Parser::parseBlock() {
+    auto node = make_node<BlockStmtNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::LBRACE, "Ожидается '{'");
@@ -337,7 +392,7 @@ std::unique_ptr<BlockStmtNode> Parser::parseBlock() {
 }
 
 StmtPtr Parser::parseIfStmt() {
-    auto node = std::make_unique<IfStmtNode>();
+    auto node = make_node<IfStmtNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::KW_IF, "Ожидается 'if'");
@@ -353,7 +408,7 @@ StmtPtr Parser::parseIfStmt() {
 
 StmtPtr Parser::parseExprStmt() {
     auto expr = parseExpression();
-    auto node = std::make_unique<ExprStmtNode>();
+    auto node = make_node<ExprStmtNode>();
     node->line = expr->line;
     node->column = expr->column;
     node->expression = std::move(expr);
@@ -362,7 +417,7 @@ StmtPtr Parser::parseExprStmt() {
 }
 
 StmtPtr Parser::parseWhileStmt() {
-    auto node = std::make_unique<WhileStmtNode>();
+    auto node = make_node<WhileStmtNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::KW_WHILE, "Ожидается 'while'");
@@ -374,7 +429,7 @@ StmtPtr Parser::parseWhileStmt() {
 }
 
 StmtPtr Parser::parseForStmt() {
-    auto node = std::make_unique<ForStmtNode>();
+    auto node = make_node<ForStmtNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::KW_FOR, "Ожидается 'for'");
@@ -387,27 +442,16 @@ StmtPtr Parser::parseForStmt() {
         int c = peek().column;
         std::string type = parseTypeName();
         node->init = parseVarDecl(type, l, c);
-    } else if (peek().type == TokenType::IDENTIFIER) {
-        std::size_t saved = current_;
-        std::string maybe_type = peek().lexeme;
-        advance();
-        if (check(TokenType::IDENTIFIER)) {
-            int l = tokens_[saved].line;
-            int c = tokens_[saved].column;
-            node->init = parseVarDecl(maybe_type, l, c);
-        } else {
-            current_ = saved;
-            auto expr = parseExpression();
-            auto es = std::make_unique<ExprStmtNode>();
-            es->line = expr->line;
-            es->column = expr->column;
-            es->expression = std::move(expr);
-            consume(TokenType::SEMICOLON, "Ожидается ';'");
-            node->init = std::move(es);
-        }
+    } else if (peek().type == TokenType::IDENTIFIER &&
+               peek_next().type == TokenType::IDENTIFIER) {
+        // "Point p = ..." — объявление переменной типа-структуры
+        int l = peek().line;
+        int c = peek().column;
+        std::string type_name(advance().lexeme);
+        node->init = parseVarDecl(type_name, l, c);
     } else {
         auto expr = parseExpression();
-        auto es = std::make_unique<ExprStmtNode>();
+        auto es = make_node<ExprStmtNode>();
         es->line = expr->line;
         es->column = expr->column;
         es->expression = std::move(expr);
@@ -430,7 +474,7 @@ StmtPtr Parser::parseForStmt() {
 }
 
 StmtPtr Parser::parseReturnStmt() {
-    auto node = std::make_unique<ReturnStmtNode>();
+    auto node = make_node<ReturnStmtNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::KW_RETURN, "Ожидается 'return'");
@@ -449,11 +493,11 @@ ExprPtr Parser::parseAssignment() {
     if (match({TokenType::ASSIGN, TokenType::PLUS_ASSIGN,
                TokenType::MINUS_ASSIGN, TokenType::STAR_ASSIGN,
                TokenType::SLASH_ASSIGN})) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto value = parseAssignment();
-        auto node = std::make_unique<AssignmentExprNode>();
+        auto node = make_node<AssignmentExprNode>();
         node->line = l;
         node->column = c;
         node->target = std::move(expr);
@@ -467,11 +511,11 @@ ExprPtr Parser::parseAssignment() {
 ExprPtr Parser::parseLogicalOr() {
     auto left = parseLogicalAnd();
     while (match(TokenType::OR)) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto right = parseLogicalAnd();
-        auto node = std::make_unique<BinaryExprNode>();
+        auto node = make_node<BinaryExprNode>();
         node->line = l;
         node->column = c;
         node->left = std::move(left);
@@ -485,11 +529,11 @@ ExprPtr Parser::parseLogicalOr() {
 ExprPtr Parser::parseLogicalAnd() {
     auto left = parseEquality();
     while (match(TokenType::AND)) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto right = parseEquality();
-        auto node = std::make_unique<BinaryExprNode>();
+        auto node = make_node<BinaryExprNode>();
         node->line = l;
         node->column = c;
         node->left = std::move(left);
@@ -503,11 +547,11 @@ ExprPtr Parser::parseLogicalAnd() {
 ExprPtr Parser::parseEquality() {
     auto left = parseRelational();
     if (match({TokenType::EQ, TokenType::NEQ})) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto right = parseRelational();
-        auto node = std::make_unique<BinaryExprNode>();
+        auto node = make_node<BinaryExprNode>();
         node->line = l;
         node->column = c;
         node->left = std::move(left);
@@ -522,11 +566,11 @@ ExprPtr Parser::parseRelational() {
     auto left = parseAdditive();
     if (match({TokenType::LT, TokenType::LTE, TokenType::GT,
                TokenType::GTE})) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto right = parseAdditive();
-        auto node = std::make_unique<BinaryExprNode>();
+        auto node = make_node<BinaryExprNode>();
         node->line = l;
         node->column = c;
         node->left = std::move(left);
@@ -540,11 +584,11 @@ ExprPtr Parser::parseRelational() {
 ExprPtr Parser::parseAdditive() {
     auto left = parseMultiplicative();
     while (match({TokenType::PLUS, TokenType::MINUS})) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto right = parseMultiplicative();
-        auto node = std::make_unique<BinaryExprNode>();
+        auto node = make_node<BinaryExprNode>();
         node->line = l;
         node->column = c;
         node->left = std::move(left);
@@ -558,11 +602,11 @@ ExprPtr Parser::parseAdditive() {
 ExprPtr Parser::parseMultiplicative() {
     auto left = parseUnary();
     while (match({TokenType::STAR, TokenType::SLASH, TokenType::PERCENT})) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto right = parseUnary();
-        auto node = std::make_unique<BinaryExprNode>();
+        auto node = make_node<BinaryExprNode>();
         node->line = l;
         node->column = c;
         node->left = std::move(left);
@@ -575,11 +619,11 @@ ExprPtr Parser::parseMultiplicative() {
 
 ExprPtr Parser::parseUnary() {
     if (match({TokenType::MINUS, TokenType::NOT, TokenType::INC, TokenType::DEC})) {
-        std::string op = previous().lexeme;
+        std::string op(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
         auto operand = parseUnary();
-        auto node = std::make_unique<UnaryExprNode>();
+        auto node = make_node<UnaryExprNode>();
         node->line = l;
         node->column = c;
         node->op = op;
@@ -591,7 +635,7 @@ ExprPtr Parser::parseUnary() {
 
 ExprPtr Parser::parsePrimary() {
     if (match(TokenType::INT_LITERAL)) {
-        auto node = std::make_unique<LiteralExprNode>();
+        auto node = make_node<LiteralExprNode>();
         node->line = previous().line;
         node->column = previous().column;
         node->kind = LiteralExprNode::Kind::Integer;
@@ -604,7 +648,7 @@ ExprPtr Parser::parsePrimary() {
         return node;
     }
     if (match(TokenType::FLOAT_LITERAL)) {
-        auto node = std::make_unique<LiteralExprNode>();
+        auto node = make_node<LiteralExprNode>();
         node->line = previous().line;
         node->column = previous().column;
         node->kind = LiteralExprNode::Kind::Float;
@@ -617,7 +661,7 @@ ExprPtr Parser::parsePrimary() {
         return node;
     }
     if (match(TokenType::BOOL_LITERAL)) {
-        auto node = std::make_unique<LiteralExprNode>();
+        auto node = make_node<LiteralExprNode>();
         node->line = previous().line;
         node->column = previous().column;
         node->kind = LiteralExprNode::Kind::Bool;
@@ -630,7 +674,7 @@ ExprPtr Parser::parsePrimary() {
         return node;
     }
     if (match(TokenType::STRING_LITERAL)) {
-        auto node = std::make_unique<LiteralExprNode>();
+        auto node = make_node<LiteralExprNode>();
         node->line = previous().line;
         node->column = previous().column;
         node->kind = LiteralExprNode::Kind::String;
@@ -643,12 +687,12 @@ ExprPtr Parser::parsePrimary() {
         return node;
     }
     if (match(TokenType::IDENTIFIER)) {
-        std::string name = previous().lexeme;
+        std::string name(previous().lexeme);
         int l = previous().line;
         int c = previous().column;
 
         if (match(TokenType::LPAREN)) {
-            auto call = std::make_unique<CallExprNode>();
+            auto call = make_node<CallExprNode>();
             call->line = l;
             call->column = c;
             call->callee = name;
@@ -661,7 +705,7 @@ ExprPtr Parser::parsePrimary() {
             consume(TokenType::RPAREN, "Ожидается ')' после аргументов");
             ExprPtr base = std::move(call);
             if (match({TokenType::INC, TokenType::DEC})) {
-                auto post = std::make_unique<PostfixExprNode>();
+                auto post = make_node<PostfixExprNode>();
                 post->line = previous().line;
                 post->column = previous().column;
                 post->operand = std::move(base);
@@ -671,14 +715,14 @@ ExprPtr Parser::parsePrimary() {
             return base;
         }
 
-        auto ident = std::make_unique<IdentifierExprNode>();
+        auto ident = make_node<IdentifierExprNode>();
         ident->line = l;
         ident->column = c;
         ident->name = name;
         ExprPtr base = std::move(ident);
         
         while (match(TokenType::LBRACKET)) {
-            auto arr_node = std::make_unique<ArrayAccessExprNode>();
+            auto arr_node = make_node<ArrayAccessExprNode>();
             arr_node->line = previous().line;
             arr_node->column = previous().column;
             arr_node->base = std::move(base);
@@ -688,7 +732,7 @@ ExprPtr Parser::parsePrimary() {
         }
         
         if (match({TokenType::INC, TokenType::DEC})) {
-            auto post = std::make_unique<PostfixExprNode>();
+            auto post = make_node<PostfixExprNode>();
             post->line = previous().line;
             post->column = previous().column;
             post->operand = std::move(base);
@@ -709,7 +753,7 @@ ExprPtr Parser::parsePrimary() {
 
     report_error(peek(), "Ожидается выражение");
     advance();
-    auto dummy = std::make_unique<LiteralExprNode>();
+    auto dummy = make_node<LiteralExprNode>();
     dummy->line = previous().line;
     dummy->column = previous().column;
     dummy->kind = LiteralExprNode::Kind::Integer;
@@ -719,7 +763,7 @@ ExprPtr Parser::parsePrimary() {
 }
 
 ExprPtr Parser::parseArrayInit() {
-    auto node = std::make_unique<ArrayInitExprNode>();
+    auto node = make_node<ArrayInitExprNode>();
     node->line = peek().line;
     node->column = peek().column;
     consume(TokenType::LBRACE, "Ожидается '{' для инициализации массива");
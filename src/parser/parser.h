@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "lexer/scanner.h"
 #include "lexer/token.h"
 #include "parser/ast.h"
 
@@ -23,24 +25,59 @@ struct ErrorMetrics {
              : static_cast<double>(recovered) / total_errors;
     }
 };
+
+// ---------------------------------------------------------------
+// Parser — рекурсивный спуск
+//
+// Токены читаются через окно из kWindow последних токенов:
+// грамматике хватает previous(), peek() и одного токена вперёд
+// (peek_next()).  Источник — готовый вектор или Scanner: во втором
+// случае токены берутся по одному и вектор всех токенов не
+// строится, так что память разбора ограничена размером AST.
+// ---------------------------------------------------------------
 class Parser {
 public:
     explicit Parser(const std::vector<Token>& tokens);
+    explicit Parser(Scanner& scanner);
 
     std::unique_ptr<ProgramNode> parse();
 
+    /// Bump-allocate AST nodes from an arena owned by the ProgramNode
+    /// (default) instead of one heap allocation per node.
+    void set_use_arena(bool enabled) { use_arena_ = enabled; }
+
     const std::vector<ParseError>& errors() const;
     const ErrorMetrics& metrics() const;
 
+    /// Сколько токенов прочитано из источника (с END_OF_FILE).
+    std::size_t tokens_read() const { return tokens_read_; }
+
 private:
-    const std::vector<Token>& tokens_;
-    std::size_t current_;
+    static constexpr std::size_t kWindow = 4;   // степень двойки
+
+    const std::vector<Token>* tokens_ = nullptr;
+    Scanner* scanner_ = nullptr;
+    std::array<Token, kWindow> window_{};
+    std::size_t current_ = 0;       // номер текущего токена в потоке
+    std::size_t fetched_ = 0;       // токенов в окне за всё время
+    std::size_t tokens_read_ = 0;   // из них прочитано из источника
     std::vector<ParseError> errors_;
+    std::vector<ImportDecl> imports_;
     ErrorMetrics metrics_;
     static constexpr int MAX_ERRORS = 50;
+    bool use_arena_ = true;
+    ASTArena* arena_ = nullptr;   // arena of the tree being built
+
+    template <typename T>
+    NodePtr<T> make_node() {
+        if (arena_) return NodePtr<T>(arena_->create<T>());
+        return NodePtr<T>(new T());
+    }
 
     // Utility
+    void fetch();
     const Token& peek() const;
+    const Token& peek_next() const;
     const Token& previous() const;
     bool isAtEnd() const;
     const Token& advance();
@@ -56,14 +93,15 @@ private:
 
     // Grammar rules
     DeclPtr parseDeclaration();
-    std::unique_ptr<FunctionDeclNode> parseFunctionDecl();
-    std::unique_ptr<FunctionDeclNode> parseExternDecl();
-    std::unique_ptr<StructDeclNode> parseStructDecl();
-    std::unique_ptr<VarDeclStmtNode> parseVarDecl(const std::string& type_name,
-                                                    int line, int col);
+    NodePtr<FunctionDeclNode> parseFunctionDecl();
+    NodePtr<FunctionDeclNode> parseExternDecl();
+    void parseImport();
+    NodePtr<StructDeclNode> parseStructDecl();
+    NodePtr<VarDeclStmtNode> parseVarDecl(const std::string& type_name,
+                                          int line, int col);
 
     StmtPtr parseStatement();
-    std::unique_ptr<BlockStmtNode> parseBlock();
+    NodePtr<BlockStmtNode> parseBlock();
     StmtPtr parseIfStmt();
     StmtPtr parseWhileStmt();
     StmtPtr parseForStmt();
@@ -1,10 +1,15 @@
 #include "preprocessor/preprocessor.h"
 
 #include <cctype>
+#include <cstring>
 #include <sstream>
 
 Preprocessor::Preprocessor(const std::string& source) : source_(source) {}
 
+bool Preprocessor::needs_processing(std::string_view source) {
+    return std::memchr(source.data(), '#', source.size()) != nullptr;
+}
+
 void Preprocessor::define(const std::string& name,
                            const std::string& value) {
     macros_[name] = value;
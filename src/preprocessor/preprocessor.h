@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -16,6 +17,12 @@ public:
 
     std::string process();
 
+    // Без '#' (и без define() извне) нет ни директив, ни макросов:
+    // process() только заменил бы комментарии пробелами, а их
+    // Scanner пропускает сам (с той же ошибкой о незакрытом
+    // комментарии)
+    static bool needs_processing(std::string_view source);
+
     void define(const std::string& name, const std::string& value);
     void undefine(const std::string& name);
 
@@ -7,7 +7,12 @@
 // ---------------------------------------------------------------
 // Constructor
 // ---------------------------------------------------------------
-SemanticAnalyzer::SemanticAnalyzer() = default;
+SemanticAnalyzer::SemanticAnalyzer()
+    : own_types_(std::make_unique<TypeRegistry>()), types_(*own_types_) {}
+
+SemanticAnalyzer::SemanticAnalyzer(TypeRegistry& types) : types_(types) {
+    types_.reset();
+}
 
 // ---------------------------------------------------------------
 // Error helper
@@ -79,6 +84,77 @@ std::string SemanticAnalyzer::find_similar(const std::string& name) const {
     return best.empty() ? "" : "возможно, вы имели в виду '" + best + "'?";
 }
 
+// ---------------------------------------------------------------
+// Imported modules — declared like extern functions and structs
+// ---------------------------------------------------------------
+void SemanticAnalyzer::add_import(const ModuleInterface& module, int line, int col) {
+    imports_.push_back(Import{&module, line, col});
+}
+
+static bool same_fields(const std::vector<StructField>& a, const std::vector<StructField>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].name != b[i].name || a[i].type_name != b[i].type_name) return false;
+    }
+    return true;
+}
+
+void SemanticAnalyzer::declare_imports() {
+    for (const auto& imp : imports_) {
+        const std::string& module = imp.module->name;
+        for (const auto& st : imp.module->structs) {
+            // The same struct reached through two modules is declared once
+            if (Type* existing = types_.resolve(st.name)) {
+                if (existing->kind != TypeKind::Struct || !same_fields(existing->fields, st.fields)) {
+                    error(SemanticErrorKind::ImportConflict, imp.line, imp.column,
+                          "структура '" + st.name + "' из модуля '" + module +
+                          "' не совпадает с уже объявленной");
+                }
+                continue;
+            }
+            Type* t = types_.register_struct(st.name, st.fields);
+            if (t->size_bytes != st.size_bytes) {
+                error(SemanticErrorKind::ImportConflict, imp.line, imp.column,
+                      "размер структуры '" + st.name + "' не совпадает с интерфейсом модуля '" + module + "'",
+                      std::to_string(st.size_bytes), std::to_string(t->size_bytes));
+            }
+            Symbol sym;
+            sym.name = st.name;
+            sym.type = t;
+            sym.kind = SymbolKind::Struct;
+            sym.decl_line = imp.line;
+            sym.decl_column = imp.column;
+            sym.fields = st.fields;
+            sym_.insert(sym);
+        }
+
+        for (const auto& fn : imp.module->functions) {
+            std::vector<FunctionParam> params;
+            for (const auto& p : fn.params) {
+                std::string param_type_name = p.type_name;
+                if (p.is_array) {
+                    if (Type* pt = types_.resolve(p.type_name)) {
+                        param_type_name = types_.register_array(pt, {0})->name;
+                    }
+                }
+                params.push_back(FunctionParam{p.name, param_type_name});
+            }
+            Symbol sym;
+            sym.name = fn.name;
+            sym.type = types_.register_function(fn.name, params, fn.return_type);
+            sym.kind = SymbolKind::Function;
+            sym.decl_line = imp.line;
+            sym.decl_column = imp.column;
+            sym.params = params;
+            sym.return_type_name = fn.return_type;
+            if (!sym_.insert(sym)) {
+                error(SemanticErrorKind::ImportConflict, imp.line, imp.column,
+                      "функция '" + fn.name + "' из модуля '" + module + "' уже объявлена");
+            }
+        }
+    }
+}
+
 // ---------------------------------------------------------------
 // Pass 1 — collect top-level declarations (forward refs)
 // ---------------------------------------------------------------
@@ -157,7 +233,8 @@ void SemanticAnalyzer::collect_declarations(ProgramNode& ast) {
 // ---------------------------------------------------------------
 void SemanticAnalyzer::analyze(ProgramNode& ast) {
     errors_.clear();
-    // Pass 1: collect forward declarations
+    // Pass 1: imported modules, then the program's own declarations
+    declare_imports();
     collect_declarations(ast);
     // Pass 2: full traversal
     ast.accept(*this);
@@ -216,7 +293,7 @@ void SemanticAnalyzer::visit(FunctionDeclNode& node) {
     // (this is done during collect_declarations for structs)
 
     // Visit body
-    if (node.body) {
+    if (node.body && !(skip_bodies_ && skip_bodies_->count(node.name))) {
         // Visit body statements directly (don't push another scope for the body block)
         for (auto& s : node.body->statements) {
             s->accept(*this);
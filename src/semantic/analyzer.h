@@ -1,10 +1,13 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "parser/ast.h"
 #include "semantic/errors.h"
+#include "semantic/module_interface.h"
 #include "semantic/symbol_table.h"
 #include "semantic/type_system.h"
 
@@ -19,9 +22,23 @@ class SemanticAnalyzer : public ASTVisitor {
 public:
     SemanticAnalyzer();
 
+    /// Check against a caller-owned registry instead of a fresh one.
+    /// The registry is reset to the built-in types first; it must
+    /// outlive the analyzer and everything that uses its types.
+    explicit SemanticAnalyzer(TypeRegistry& types);
+
     /// Run full semantic analysis; decorates the AST in-place.
     void analyze(ProgramNode& ast);
 
+    /// Do not check the bodies of these functions (their IR comes
+    /// from the compilation cache); signatures are still registered.
+    void set_skip_bodies(const std::unordered_set<std::string>* names) { skip_bodies_ = names; }
+
+    /// Declare the functions and structs of a module imported at
+    /// line:col (`import name;`) before the program's own
+    /// declarations.  The interface must outlive analyze().
+    void add_import(const ModuleInterface& module, int line, int col);
+
     const std::vector<SemanticError>& get_errors() const { return errors_; }
     SemanticSymbolTable& get_symbol_table()                { return sym_; }
     const SemanticSymbolTable& get_symbol_table() const    { return sym_; }
@@ -55,7 +72,8 @@ public:
     void visit(StructDeclNode& node) override;
 
 private:
-    TypeRegistry types_;
+    std::unique_ptr<TypeRegistry> own_types_;   // null when borrowed
+    TypeRegistry& types_;
     SemanticSymbolTable sym_;
     std::vector<SemanticError> errors_;
 
@@ -63,6 +81,14 @@ private:
     std::string current_function_;      // for context in errors
     Type* current_return_type_ = nullptr;
     int loop_depth_ = 0;
+    const std::unordered_set<std::string>* skip_bodies_ = nullptr;
+
+    struct Import {
+        const ModuleInterface* module;
+        int line;
+        int column;
+    };
+    std::vector<Import> imports_;
 
     // Last inferred type for expression nodes (set after visiting an expr)
     Type* last_expr_type_ = nullptr;
@@ -77,6 +103,7 @@ private:
     Type* resolve_type_name(const std::string& name, int line, int col);
 
     // Pass 1
+    void declare_imports();
     void collect_declarations(ProgramNode& ast);
 
     // Find similar names for suggestions
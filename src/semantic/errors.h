@@ -18,7 +18,8 @@ enum class SemanticErrorKind {
     InvalidAssignmentTarget,
     UnknownType,
     InvalidOperator,
-    MissingReturn
+    MissingReturn,
+    ImportConflict
 };
 
 inline std::string error_kind_str(SemanticErrorKind k) {
@@ -35,6 +36,7 @@ inline std::string error_kind_str(SemanticErrorKind k) {
         case SemanticErrorKind::UnknownType:             return "неизвестный тип";
         case SemanticErrorKind::InvalidOperator:         return "недопустимый оператор";
         case SemanticErrorKind::MissingReturn:           return "отсутствует оператор return";
+        case SemanticErrorKind::ImportConflict:          return "конфликт импорта";
     }
     return "неизвестная ошибка";
 }
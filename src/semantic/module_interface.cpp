@@ -0,0 +1,114 @@
+#include "semantic/module_interface.h"
+
+#include <unordered_set>
+
+#include "utils/byte_stream.h"
+
+namespace {
+
+// Changes whenever the encoding or the meaning of a field changes
+constexpr const char* INTERFACE_FORMAT = "minicompiler-module-1";
+
+// Struct `name` and, before it, every struct its fields use
+void collect_struct(const std::string& name, const TypeRegistry& types,
+                    std::unordered_set<std::string>& seen, std::vector<ModuleStruct>& out) {
+    const Type* t = types.resolve(name);
+    if (!t || t->kind != TypeKind::Struct || !seen.insert(name).second) return;
+    ModuleStruct st;
+    st.name = t->name;
+    st.size_bytes = t->size_bytes;
+    for (const auto& f : t->fields) {
+        collect_struct(f.type_name, types, seen, out);
+        st.fields.push_back(StructField{f.name, f.type_name, 0, 0});
+    }
+    out.push_back(std::move(st));
+}
+
+} // namespace
+
+ModuleInterface build_module_interface(const std::string& name, const ProgramNode& ast,
+                                       const TypeRegistry& types) {
+    ModuleInterface module;
+    module.name = name;
+    std::unordered_set<std::string> seen;
+    for (const auto& decl : ast.declarations) {
+        if (auto* st = dynamic_cast<const StructDeclNode*>(decl.get())) {
+            collect_struct(st->name, types, seen, module.structs);
+        }
+    }
+    for (const auto& decl : ast.declarations) {
+        auto* fn = dynamic_cast<const FunctionDeclNode*>(decl.get());
+        if (!fn || fn->is_extern || !fn->body) continue;
+        ModuleFunction func;
+        func.name = fn->name;
+        func.return_type = fn->return_type.empty() ? "void" : fn->return_type;
+        collect_struct(func.return_type, types, seen, module.structs);
+        for (const auto& p : fn->parameters) {
+            func.params.push_back(ModuleParam{p.name, p.type_name, p.is_array});
+            collect_struct(p.type_name, types, seen, module.structs);
+        }
+        module.functions.push_back(std::move(func));
+    }
+    return module;
+}
+
+std::string write_module_interface(const ModuleInterface& module) {
+    utils::ByteWriter out;
+    out.str(INTERFACE_FORMAT);
+    out.str(module.name);
+    out.u64(module.structs.size());
+    for (const auto& st : module.structs) {
+        out.str(st.name);
+        out.i64(st.size_bytes);
+        out.u64(st.fields.size());
+        for (const auto& f : st.fields) {
+            out.str(f.name);
+            out.str(f.type_name);
+        }
+    }
+    out.u64(module.functions.size());
+    for (const auto& fn : module.functions) {
+        out.str(fn.name);
+        out.str(fn.return_type);
+        out.u64(fn.params.size());
+        for (const auto& p : fn.params) {
+            out.str(p.name);
+            out.str(p.type_name);
+            out.u8(p.is_array);
+        }
+    }
+    return out.data();
+}
+
+bool read_module_interface(const std::string& data, ModuleInterface& out) {
+    out = ModuleInterface{};
+    utils::ByteReader in(data);
+    if (in.str() != INTERFACE_FORMAT) return false;
+    out.name = in.str();
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) {
+        ModuleStruct st;
+        st.name = in.str();
+        st.size_bytes = static_cast<int>(in.i64());
+        for (std::uint64_t k = in.u64(); k > 0 && in.ok(); --k) {
+            StructField f;
+            f.name = in.str();
+            f.type_name = in.str();
+            st.fields.push_back(std::move(f));
+        }
+        out.structs.push_back(std::move(st));
+    }
+    for (std::uint64_t n = in.u64(); n > 0 && in.ok(); --n) {
+        ModuleFunction fn;
+        fn.name = in.str();
+        fn.return_type = in.str();
+        for (std::uint64_t k = in.u64(); k > 0 && in.ok(); --k) {
+            ModuleParam p;
+            p.name = in.str();
+            p.type_name = in.str();
+            p.is_array = in.u8() != 0;
+            fn.params.push_back(std::move(p));
+        }
+        out.functions.push_back(std::move(fn));
+    }
+    return in.ok() && in.at_end();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "parser/ast.h"
+#include "semantic/type_system.h"
+
+// ---------------------------------------------------------------
+// ModuleInterface — what other modules see of a compiled module
+//
+// Written next to the object file by --emit-interface and read
+// back for every `import name;`, so importing a module does not
+// re-parse its source.  It holds the signatures of the functions
+// the module defines and the layouts of the structs they need:
+// the module's own structs plus every struct reachable from a
+// signature or a field (including structs the module imported),
+// dependencies first, so they can be registered in order.
+//
+// The encoding is utils::ByteWriter; see write_module_interface.
+// ---------------------------------------------------------------
+struct ModuleParam {
+    std::string name;
+    std::string type_name;      // element type for arrays
+    bool is_array = false;
+};
+
+struct ModuleFunction {
+    std::string name;
+    std::vector<ModuleParam> params;
+    std::string return_type;
+};
+
+struct ModuleStruct {
+    std::string name;
+    std::vector<StructField> fields;    // name and type only
+    int size_bytes = 0;
+};
+
+struct ModuleInterface {
+    std::string name;
+    std::vector<ModuleStruct> structs;
+    std::vector<ModuleFunction> functions;
+};
+
+/// Interface of a checked program: its defined (non-extern) functions
+/// and the struct layouts they reach, taken from `types`.
+ModuleInterface build_module_interface(const std::string& name, const ProgramNode& ast,
+                                       const TypeRegistry& types);
+
+std::string write_module_interface(const ModuleInterface& module);
+
+/// Decode an interface; false if the data is truncated, malformed
+/// or was written by an incompatible compiler version.
+bool read_module_interface(const std::string& data, ModuleInterface& out);
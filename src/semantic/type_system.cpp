@@ -11,6 +11,13 @@ TypeRegistry::TypeRegistry() {
     void_   = make(TypeKind::Void,   "void",   0);
     string_ = make(TypeKind::String, "string", 8);
     error_  = make(TypeKind::Error,  "<error>", 0);
+    builtin_count_ = owned_.size();
+}
+
+void TypeRegistry::reset() {
+    owned_.resize(builtin_count_);
+    named_types_.clear();
+    for (const auto& t : owned_) named_types_[t->name] = t.get();
 }
 
 Type* TypeRegistry::make(TypeKind k, const std::string& n, int sz) {
@@ -103,6 +103,13 @@ public:
     // Common type of two operands (for binary operations)
     Type* common_numeric_type(const Type* a, const Type* b) const;
 
+    // Forget everything registered after the built-ins, so one registry
+    // can serve many compilations (compiler serve keeps one per worker).
+    // Types from earlier compilations are destroyed.
+    void reset();
+
+    std::size_t type_count() const { return owned_.size(); }
+
 private:
     std::vector<std::unique_ptr<Type>> owned_;
     Type* int_;
@@ -113,6 +120,7 @@ private:
     Type* error_;
 
     std::unordered_map<std::string, Type*> named_types_;
+    std::size_t builtin_count_ = 0;
 
     Type* make(TypeKind k, const std::string& n, int sz);
 };
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace utils {
+
+inline unsigned count_trailing_zeros(std::uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+// ---------------------------------------------------------------
+// BitVector — fixed-size dense bit set for dataflow problems
+//
+// Set operations work a 64-bit word at a time.  All operands of a
+// binary operation must have the same size.
+// ---------------------------------------------------------------
+class BitVector {
+public:
+    BitVector() = default;
+    explicit BitVector(std::size_t bits)
+        : bits_(bits), words_((bits + 63) / 64, 0) {}
+
+    std::size_t size() const { return bits_; }
+
+    void set(std::size_t i)   { words_[i >> 6] |= word_bit(i); }
+    void reset(std::size_t i) { words_[i >> 6] &= ~word_bit(i); }
+    bool test(std::size_t i) const { return (words_[i >> 6] & word_bit(i)) != 0; }
+
+    void clear() {
+        for (auto& w : words_) w = 0;
+    }
+
+    bool any() const {
+        for (auto w : words_)
+            if (w) return true;
+        return false;
+    }
+
+    /// this |= other; returns true if any bit changed.
+    bool union_with(const BitVector& other) {
+        std::uint64_t changed = 0;
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            std::uint64_t merged = words_[w] | other.words_[w];
+            changed |= merged ^ words_[w];
+            words_[w] = merged;
+        }
+        return changed != 0;
+    }
+
+    /// this = a | (b & ~c); returns true if any bit changed.
+    bool assign_union_diff(const BitVector& a, const BitVector& b,
+                           const BitVector& c) {
+        std::uint64_t changed = 0;
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            std::uint64_t value = a.words_[w] | (b.words_[w] & ~c.words_[w]);
+            changed |= value ^ words_[w];
+            words_[w] = value;
+        }
+        return changed != 0;
+    }
+
+    bool operator==(const BitVector& other) const {
+        return bits_ == other.bits_ && words_ == other.words_;
+    }
+    bool operator!=(const BitVector& other) const { return !(*this == other); }
+
+    /// Call fn(index) for every set bit, in increasing order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            std::uint64_t word = words_[w];
+            while (word) {
+                unsigned bit = count_trailing_zeros(word);
+                fn(w * 64 + bit);
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    std::size_t bits_ = 0;
+    std::vector<std::uint64_t> words_;
+
+    static std::uint64_t word_bit(std::size_t i) {
+        return std::uint64_t{1} << (i & 63);
+    }
+};
+
+} // namespace utils
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+// ---------------------------------------------------------------
+// ByteWriter / ByteReader — compact binary encoding for on-disk
+// caches
+//
+// Unsigned integers are LEB128 varints, signed ones are zigzag
+// encoded first, doubles are stored as their 64-bit pattern and
+// strings are length-prefixed.  A reader never throws: reading
+// past the end or a malformed varint sets ok() to false and
+// returns zeros from then on.
+// ---------------------------------------------------------------
+class ByteWriter {
+public:
+    void u8(std::uint8_t value) { data_.push_back(static_cast<char>(value)); }
+
+    void u64(std::uint64_t value) {
+        while (value >= 0x80) {
+            u8(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        u8(static_cast<std::uint8_t>(value));
+    }
+
+    void i64(std::int64_t value) {
+        u64((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    void f64(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        u64(bits);
+    }
+
+    void str(std::string_view value) {
+        u64(value.size());
+        data_ += value;
+    }
+
+    const std::string& data() const { return data_; }
+
+private:
+    std::string data_;
+};
+
+class ByteReader {
+public:
+    explicit ByteReader(const std::string& data) : data_(data) {}
+
+    std::uint8_t u8() {
+        if (pos_ >= data_.size()) {
+            ok_ = false;
+            return 0;
+        }
+        return static_cast<std::uint8_t>(data_[pos_++]);
+    }
+
+    std::uint64_t u64() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64 && ok_; shift += 7) {
+            std::uint8_t byte = u8();
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    std::int64_t i64() {
+        std::uint64_t value = u64();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    double f64() {
+        std::uint64_t bits = u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    std::string str() {
+        std::uint64_t size = u64();
+        if (!ok_ || size > data_.size() - pos_) {
+            ok_ = false;
+            return {};
+        }
+        std::string value = data_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return pos_ == data_.size(); }
+
+private:
+    const std::string& data_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace utils
@@ -3,6 +3,11 @@
 #include <fstream>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace utils {
 
 // читаем весь файл в строку
@@ -25,4 +30,50 @@ bool write_file(const std::string& path, const std::string& content) {
     return true;
 }
 
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::close() {
+    if (map_) {
+        munmap(map_, size_);
+        map_ = nullptr;
+    }
+    size_ = 0;
+    fallback_.clear();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* map = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+            map_ = map;
+            size_ = static_cast<std::size_t>(st.st_size);
+            ::close(fd);
+            return true;
+        }
+    }
+
+    // не отображается — читаем как есть
+    char buffer[65536];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof buffer)) > 0) {
+        fallback_.append(buffer, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return n == 0;
+}
+
+std::string_view MappedFile::text() const {
+    if (map_) {
+        return std::string_view(static_cast<const char*>(map_), size_);
+    }
+    return fallback_;
+}
+
 } // namespace utils
@@ -1,8 +1,41 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace utils {
 std::string read_file(const std::string& path);
 bool write_file(const std::string& path, const std::string& content);
+
+// ---------------------------------------------------------------
+// MappedFile — файл, отображённый в память только для чтения
+//
+// Исходник не копируется: Scanner работает прямо по страницам
+// файла.  Если mmap недоступен (канал, /proc, пустой файл),
+// содержимое читается в обычную строку — text() одинаков в обоих
+// случаях.  Буфер живёт до разрушения объекта.
+// ---------------------------------------------------------------
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Открыть файл; false, если его нельзя прочитать.
+    bool open(const std::string& path);
+
+    std::string_view text() const;
+
+    /// true — данные отображены, false — прочитаны в память.
+    bool mapped() const { return map_ != nullptr; }
+
+private:
+    void* map_ = nullptr;
+    std::size_t size_ = 0;
+    std::string fallback_;
+
+    void close();
+};
 } // namespace utils
@@ -0,0 +1,285 @@
+#include "utils/json.h"
+
+#include <cstdio>
+
+namespace utils {
+
+namespace {
+
+// Вложенность ограничена: запрос не должен исчерпать стек
+constexpr int kMaxDepth = 64;
+
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : text_(text) {}
+
+    bool document(JsonValue& out) {
+        skip_space();
+        if (!value(out, 0)) return false;
+        skip_space();
+        if (pos_ != text_.size()) return fail("unexpected text after the value");
+        return true;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    std::string_view text_;
+    std::size_t pos_ = 0;
+    std::string error_;
+
+    bool fail(const char* message) {
+        if (error_.empty()) error_ = std::string(message) + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    bool at_end() const { return pos_ >= text_.size(); }
+    char peek() const { return at_end() ? '\0' : text_[pos_]; }
+
+    void skip_space() {
+        while (!at_end() && (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r')) ++pos_;
+    }
+
+    bool literal(std::string_view word) {
+        if (text_.substr(pos_, word.size()) != word) return fail("invalid literal");
+        pos_ += word.size();
+        return true;
+    }
+
+    bool value(JsonValue& out, int depth) {
+        if (depth > kMaxDepth) return fail("nesting is too deep");
+        switch (peek()) {
+        case '{': return object(out, depth);
+        case '[': return array(out, depth);
+        case '"':
+            out.kind = JsonValue::Kind::String;
+            return string(out.text);
+        case 't':
+            out.kind = JsonValue::Kind::Bool;
+            out.boolean = true;
+            return literal("true");
+        case 'f':
+            out.kind = JsonValue::Kind::Bool;
+            return literal("false");
+        case 'n':
+            out.kind = JsonValue::Kind::Null;
+            return literal("null");
+        default:
+            return number(out);
+        }
+    }
+
+    bool object(JsonValue& out, int depth) {
+        out.kind = JsonValue::Kind::Object;
+        ++pos_;
+        skip_space();
+        if (peek() == '}') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            std::pair<std::string, JsonValue> member;
+            if (peek() != '"') return fail("expected a member name");
+            if (!string(member.first)) return false;
+            skip_space();
+            if (peek() != ':') return fail("expected ':'");
+            ++pos_;
+            skip_space();
+            if (!value(member.second, depth + 1)) return false;
+            out.members.push_back(std::move(member));
+            skip_space();
+            if (peek() == '}') {
+                ++pos_;
+                return true;
+            }
+            if (peek() != ',') return fail("expected ',' or '}'");
+            ++pos_;
+            skip_space();
+        }
+    }
+
+    bool array(JsonValue& out, int depth) {
+        out.kind = JsonValue::Kind::Array;
+        ++pos_;
+        skip_space();
+        if (peek() == ']') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            out.items.emplace_back();
+            if (!value(out.items.back(), depth + 1)) return false;
+            skip_space();
+            if (peek() == ']') {
+                ++pos_;
+                return true;
+            }
+            if (peek() != ',') return fail("expected ',' or ']'");
+            ++pos_;
+            skip_space();
+        }
+    }
+
+    bool number(JsonValue& out) {
+        const std::size_t start = pos_;
+        auto digits = [&] {
+            const std::size_t from = pos_;
+            while (!at_end() && peek() >= '0' && peek() <= '9') ++pos_;
+            return pos_ > from;
+        };
+        if (peek() == '-') ++pos_;
+        if (!digits()) return fail("unexpected character");
+        if (peek() == '.') {
+            ++pos_;
+            if (!digits()) return fail("expected digits after '.'");
+        }
+        if (peek() == 'e' || peek() == 'E') {
+            ++pos_;
+            if (peek() == '+' || peek() == '-') ++pos_;
+            if (!digits()) return fail("expected exponent digits");
+        }
+        out.kind = JsonValue::Kind::Number;
+        out.text = std::string(text_.substr(start, pos_ - start));
+        return true;
+    }
+
+    bool hex4(unsigned& code) {
+        if (text_.size() - pos_ < 4) return fail("truncated \\u escape");
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = text_[pos_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void append_utf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool string(std::string& out) {
+        ++pos_;
+        while (true) {
+            if (at_end()) return fail("unterminated string");
+            const char c = text_[pos_++];
+            if (c == '"') return true;
+            if (static_cast<unsigned char>(c) < 0x20) return fail("control character in string");
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (at_end()) return fail("unterminated string");
+            switch (text_[pos_++]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                if (!hex4(code)) return false;
+                // Суррогатная пара — один символ за пределами BMP
+                if (code >= 0xD800 && code < 0xDC00 && text_.substr(pos_, 2) == "\\u") {
+                    pos_ += 2;
+                    unsigned low = 0;
+                    if (!hex4(low)) return false;
+                    if (low < 0xDC00 || low >= 0xE000) return fail("invalid surrogate pair");
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+    }
+};
+
+} // namespace
+
+const JsonValue* JsonValue::get(std::string_view key) const {
+    for (const auto& member : members) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+bool parse_json(std::string_view text, JsonValue& out, std::string& error) {
+    out = JsonValue();
+    JsonReader reader(text);
+    if (reader.document(out)) return true;
+    error = reader.error();
+    return false;
+}
+
+std::string to_json(const JsonValue& value) {
+    switch (value.kind) {
+    case JsonValue::Kind::Null: return "null";
+    case JsonValue::Kind::Bool: return value.boolean ? "true" : "false";
+    case JsonValue::Kind::Number: return value.text;
+    case JsonValue::Kind::String: return json_quote(value.text);
+    case JsonValue::Kind::Array: {
+        std::string out = "[";
+        for (std::size_t i = 0; i < value.items.size(); ++i) {
+            if (i) out += ",";
+            out += to_json(value.items[i]);
+        }
+        return out + "]";
+    }
+    case JsonValue::Kind::Object: {
+        std::string out = "{";
+        for (std::size_t i = 0; i < value.members.size(); ++i) {
+            if (i) out += ",";
+            out += json_quote(value.members[i].first) + ":" + to_json(value.members[i].second);
+        }
+        return out + "}";
+    }
+    }
+    return "null";
+}
+
+std::string json_quote(std::string_view s) {
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof buf, "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace utils
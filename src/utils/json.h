@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+// ---------------------------------------------------------------
+// JsonValue — разобранный документ JSON
+//
+// Нужен протоколу compiler serve: запросы приходят строками JSON.
+// Числа не переводятся в double — text хранит их запись как есть,
+// так что id запроса возвращается в ответе без изменений.
+// ---------------------------------------------------------------
+struct JsonValue {
+    enum class Kind { Null, Bool, Number, String, Array, Object };
+
+    Kind kind = Kind::Null;
+    bool boolean = false;
+    std::string text;       // строка — раскодированная, число — как записано
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    bool is_string() const { return kind == Kind::String; }
+
+    /// Поле объекта (nullptr, если его нет или это не объект).
+    const JsonValue* get(std::string_view key) const;
+};
+
+/// Разобрать ровно один документ JSON (пробелы по краям допустимы).
+/// Исключений нет: при ошибке false и описание с позицией в error.
+bool parse_json(std::string_view text, JsonValue& out, std::string& error);
+
+/// Значение как литерал JSON: строка в кавычках, число как было.
+std::string to_json(const JsonValue& value);
+
+/// Строковый литерал JSON с экранированием.
+std::string json_quote(std::string_view s);
+
+} // namespace utils
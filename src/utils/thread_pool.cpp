@@ -0,0 +1,77 @@
+#include "utils/thread_pool.h"
+
+namespace utils {
+
+ThreadPool::ThreadPool(int jobs) {
+    for (int i = 1; i < jobs; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+// берём следующий индекс и выполняем его без блокировки
+bool ThreadPool::run_one(std::unique_lock<std::mutex>& lock) {
+    if (!task_ || next_index_ >= task_size_) return false;
+    std::size_t i = next_index_++;
+    const auto* fn = task_;
+    lock.unlock();
+    // исключение не должно выйти из рабочего потока (std::terminate)
+    // и оставить remaining_ > 0 — запоминаем первое для parallel_for
+    std::exception_ptr error;
+    try {
+        (*fn)(i);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    lock.lock();
+    if (error && !error_) error_ = error;
+    if (--remaining_ == 0) done_cv_.notify_all();
+    return true;
+}
+
+void ThreadPool::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    unsigned seen = generation_;
+    while (true) {
+        work_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        while (run_one(lock)) {}
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t n,
+                              const std::function<void(std::size_t)>& fn) {
+    if (n == 0) return;
+    if (workers_.empty() || n == 1) {
+        for (std::size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &fn;
+    task_size_ = n;
+    next_index_ = 0;
+    remaining_ = n;
+    ++generation_;
+    work_cv_.notify_all();
+
+    while (run_one(lock)) {}
+    done_cv_.wait(lock, [&] { return remaining_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::exception_ptr error = std::move(error_);
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace utils
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+// ---------------------------------------------------------------
+// ThreadPool — фиксированный пул потоков для parallel_for
+//
+// Пул из N заданий держит N-1 рабочих потоков; вызывающий поток
+// участвует в работе сам.  При N <= 1 потоки не создаются и
+// parallel_for выполняется последовательно.
+// ---------------------------------------------------------------
+class ThreadPool {
+public:
+    explicit ThreadPool(int jobs);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int jobs() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /// Выполнить fn(i) для всех i в [0, n) и дождаться завершения.
+    /// Порядок выполнения не гарантирован; результаты нужно
+    /// складывать по индексу i.  Если fn бросает исключение, первое
+    /// из них пробрасывается после завершения всех индексов.
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn);
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    const std::function<void(std::size_t)>* task_ = nullptr;
+    std::size_t task_size_ = 0;
+    std::size_t next_index_ = 0;
+    std::size_t remaining_ = 0;
+    std::exception_ptr error_;        // первое исключение из fn
+    unsigned generation_ = 0;
+    bool stop_ = false;
+
+    void worker_loop();
+    bool run_one(std::unique_lock<std::mutex>& lock);
+};
+
+} // namespace utils
@@ -2,13 +2,23 @@
 # ============================================================
 # benchmark.sh — Профайлинг и замеры производительности
 #
-# Три режима:
+# Режимы:
 #   1. time (секундомер)
 #   2. perf stat (IPC, cache misses, cycles)
 #   3. perf record + perf report (горячие функции)
+#   4. ast — arena vs heap для узлов AST (parse/check большого
+#      синтетического файла: время парсинга и пиковый RSS)
+#   5. lex — токенизация многомегабайтного файла: прямо по mmap
+#      (без директив) и через препроцессор (одна #define в начале),
+#      затем по уровням быстрых путей (--scanner): токены в секунду
+#   6. serve — SERVE_FILES маленьких файлов: отдельный процесс на
+#      каждый compile против одного compiler serve
 #
 # Использование: bash tests/scripts/benchmark.sh [compiler_path] [mode]
-#   mode: time | perf | profile | all  (default: all)
+#   mode: time | perf | profile | ast | lex | serve | all  (default: all)
+#   AST_FUNCS — число функций в синтетической программе (default: 4000)
+#   LEX_FUNCS — то же для режима lex (default: 20000, ~6.5 МБ)
+#   SERVE_FILES — число файлов для режима serve (default: 500)
 # ============================================================
 set -euo pipefail
 
@@ -101,4 +111,104 @@ if [ "$MODE" = "profile" ] || [ "$MODE" = "all" ]; then
     fi
 fi
 
+# --- 4. AST arena vs heap ---
+# Генерирует большую программу: AST_FUNCS функций с циклами,
+# ветвлениями и вложенными выражениями.
+gen_large_program() {
+    local n="$1"
+    for ((i = 0; i < n; i++)); do
+        cat <<SRC
+fn f$i(int a, int b) -> int {
+    int s = 0;
+    for (int k = 0; k < a; k = k + 1) {
+        if ((k % 3 == 0 && b > k) || k * 2 + 1 < a - b) {
+            s = s + (k * b - (a + k) / 2) % 7;
+        } else {
+            s = s - k + b * (a - k);
+        }
+    }
+    while (s > 1000) { s = s / 2 + a * b - 3; }
+    return s + $i;
+}
+SRC
+    done
+    echo "fn main() -> int { return f0(10, 3); }"
+}
+
+if [ "$MODE" = "ast" ] || [ "$MODE" = "all" ]; then
+    echo "--- 4. AST arena (parse/check, ${AST_FUNCS:-4000} функций) ---"
+    echo ""
+    LARGE="$TMPDIR/large.src"
+    gen_large_program "${AST_FUNCS:-4000}" > "$LARGE"
+    echo "Input: $LARGE ($(wc -c < "$LARGE") bytes)"
+    echo ""
+
+    for cmd in parse check; do
+        for variant in arena heap; do
+            flag=""
+            [ "$variant" = "heap" ] && flag="--no-ast-arena"
+            echo "$cmd ($variant):"
+            # shellcheck disable=SC2086
+            "$COMPILER" "$cmd" --input "$LARGE" --output "$TMPDIR/ast_$cmd.txt" --verbose $flag 2>&1 >/dev/null \
+                | grep -E "^(AST arena|Parse time|Peak RSS):" || true
+            echo ""
+        done
+    done
+fi
+
+# --- 5. Лексер: mmap без препроцессора vs препроцессор ---
+if [ "$MODE" = "lex" ] || [ "$MODE" = "all" ]; then
+    echo "--- 5. Lex (${LEX_FUNCS:-20000} функций) ---"
+    echo ""
+    LEX_PLAIN="$TMPDIR/lex_plain.src"
+    LEX_PP="$TMPDIR/lex_pp.src"
+    gen_large_program "${LEX_FUNCS:-20000}" > "$LEX_PLAIN"
+    { echo "#define UNUSED 1"; cat "$LEX_PLAIN"; } > "$LEX_PP"
+    echo "Input: $LEX_PLAIN ($(wc -c < "$LEX_PLAIN") bytes)"
+    echo ""
+
+    for variant in plain pp; do
+        file="$LEX_PLAIN"
+        [ "$variant" = "pp" ] && file="$LEX_PP"
+        echo "lex ($variant):"
+        "$COMPILER" lex --input "$file" --output /dev/null --verbose 2>&1 \
+            | grep -E "^(Source|Tokens|Scanner|Lex time|Lex speed):" || true
+        echo ""
+    done
+
+    for level in scalar sse4.2 avx2; do
+        echo "lex (--scanner $level):"
+        "$COMPILER" lex --input "$LEX_PLAIN" --output /dev/null --verbose --scanner "$level" 2>&1 \
+            | grep -E "^(Lex time|Lex speed|Scanner level)" || true
+        echo ""
+    done
+fi
+
+# --- 6. Сервер сборки: процесс на файл vs compiler serve ---
+if [ "$MODE" = "serve" ] || [ "$MODE" = "all" ]; then
+    echo "--- 6. Serve (${SERVE_FILES:-500} файлов) ---"
+    echo ""
+    mkdir -p "$TMPDIR/serve"
+    : > "$TMPDIR/serve/requests.jsonl"
+    for i in $(seq 1 "${SERVE_FILES:-500}"); do
+        gen_large_program 5 > "$TMPDIR/serve/f$i.src"
+        echo "{\"id\": $i, \"command\": \"compile\", \"input\": \"$TMPDIR/serve/f$i.src\", \"flags\": [\"--optimize\", \"--emit\", \"obj\"]}" \
+            >> "$TMPDIR/serve/requests.jsonl"
+    done
+
+    echo "process per file:"
+    start=$(date +%s%N)
+    for i in $(seq 1 "${SERVE_FILES:-500}"); do
+        "$COMPILER" compile --input "$TMPDIR/serve/f$i.src" --optimize --emit obj >/dev/null 2>&1
+    done
+    echo "  $(( ($(date +%s%N) - start) / 1000000 )) ms"
+    echo ""
+
+    for workers in 1 0; do
+        echo "serve --jobs $workers:"
+        "$COMPILER" serve --jobs "$workers" < "$TMPDIR/serve/requests.jsonl" 2>&1 >/dev/null | sed 's/^/  /'
+        echo ""
+    done
+fi
+
 echo "=== Benchmark complete ==="
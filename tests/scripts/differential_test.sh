@@ -5,7 +5,8 @@
 # Для каждой пары program.src / program.c:
 #   1. Компилирует .src нашим компилятором → запускает → exit code A
 #   2. Компилирует .c через gcc → запускает → exit code B
-#   3. A == B → PASS
+#   3. Исполняет IR интерпретатором (compiler interp) → exit code C
+#   4. A == B == C → PASS
 #
 # Использование: bash tests/scripts/differential_test.sh [compiler_path]
 # ============================================================
@@ -69,6 +70,12 @@ for src_file in "$DIFF_DIR"/*.src; do
     our_exit=$?
     set -e
 
+    # --- Интерпретатор IR ---
+    set +e
+    "$COMPILER" interp --input "$src_file" --optimize > "$TMPDIR/interp_stdout.txt" 2>/dev/null
+    interp_exit=$?
+    set -e
+
     # --- GCC ---
     gcc_bin="$TMPDIR/${name}_gcc"
     if ! gcc -o "$gcc_bin" "$c_file" -lm 2>/dev/null; then
@@ -83,11 +90,11 @@ for src_file in "$DIFF_DIR"/*.src; do
     set -e
 
     # --- Сравнение ---
-    if [ "$our_exit" -eq "$gcc_exit" ]; then
-        echo "  PASS: $name (exit: ours=$our_exit, gcc=$gcc_exit)"
+    if [ "$our_exit" -eq "$gcc_exit" ] && [ "$interp_exit" -eq "$gcc_exit" ]; then
+        echo "  PASS: $name (exit: ours=$our_exit, interp=$interp_exit, gcc=$gcc_exit)"
         PASS=$((PASS + 1))
     else
-        echo "  FAIL: $name (exit: ours=$our_exit, gcc=$gcc_exit)"
+        echo "  FAIL: $name (exit: ours=$our_exit, interp=$interp_exit, gcc=$gcc_exit)"
         FAIL=$((FAIL + 1))
     fi
 done
@@ -22,17 +22,18 @@ nasm -f elf64 -o "$TMPDIR/runtime.o" "$RUNTIME_SRC"
 echo "OK"
 echo ""
 
-# run_test <name> <source> <expected_exit> [expected_stdout_pattern]
+# run_test <name> <source> <expected_exit> [expected_stdout_pattern] [regalloc]
 run_test() {
     local name="$1"
     local src_file="$2"
     local expected_exit="$3"
     local expected_stdout="${4:-}"
+    local regalloc="${5:-stack}"
     TOTAL=$((TOTAL + 1))
 
     # 1. Compile
     local asm_file="$TMPDIR/${name}.asm"
-    if ! "$COMPILER" compile --input "$src_file" --output "$asm_file" --optimize 2>/dev/null; then
+    if ! "$COMPILER" compile --input "$src_file" --output "$asm_file" --optimize --regalloc "$regalloc" 2>/dev/null; then
         echo "  FAIL: $name — compilation error"
         FAIL=$((FAIL + 1))
         return
@@ -84,10 +85,44 @@ run_test() {
     PASS=$((PASS + 1))
 }
 
+# run_jit_test <name> <source> <expected_exit> [expected_stdout_pattern]
+# compiler run без --optimize со стековым аллокатором: в JIT куча
+# лежит выше 4 ГБ, поэтому обрезанный до DWORD указатель здесь падает
+run_jit_test() {
+    local name="$1"
+    local src_file="$2"
+    local expected_exit="$3"
+    local expected_stdout="${4:-}"
+    TOTAL=$((TOTAL + 1))
+
+    set +e
+    local actual_stdout
+    actual_stdout=$("$COMPILER" run --input "$src_file" --regalloc stack </dev/null 2>/dev/null)
+    local actual_exit=$?
+    set -e
+
+    if [ "$actual_exit" -ne "$expected_exit" ]; then
+        echo "  FAIL: $name (exit=$actual_exit, expected=$expected_exit)"
+        FAIL=$((FAIL + 1))
+        return
+    fi
+    if [ -n "$expected_stdout" ]; then
+        if ! echo "$actual_stdout" | grep -q "$expected_stdout"; then
+            echo "  FAIL: $name — stdout mismatch (expected pattern: '$expected_stdout')"
+            echo "  actual: $actual_stdout"
+            FAIL=$((FAIL + 1))
+            return
+        fi
+    fi
+
+    echo "  PASS: $name (exit=$actual_exit)"
+    PASS=$((PASS + 1))
+}
+
 echo "=== Integration Tests (E2E) ==="
 echo ""
 
-# --- Тесты на файлах из tests/integration/e2e/ ---
+# --- Тесты на файлах из tests/integration/e2e/ (каждый аллокатор и JIT) ---
 for src_file in tests/integration/e2e/*.src; do
     [ -f "$src_file" ] || continue
     name=$(basename "$src_file" .src)
@@ -95,7 +130,10 @@ for src_file in tests/integration/e2e/*.src; do
     if [ -f "$expected_file" ]; then
         expected_exit=$(head -1 "$expected_file" | tr -d '[:space:]')
         expected_stdout=$(tail -n +2 "$expected_file" | head -1)
-        run_test "$name" "$src_file" "$expected_exit" "$expected_stdout"
+        for regalloc in stack lsra graph; do
+            run_test "$name-$regalloc" "$src_file" "$expected_exit" "$expected_stdout" "$regalloc"
+        done
+        run_jit_test "$name-jit" "$src_file" "$expected_exit" "$expected_stdout"
     fi
 done
 
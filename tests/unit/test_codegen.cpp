@@ -7,12 +7,34 @@
 #include "semantic/analyzer.h"
 #include "ir/ir_generator.h"
 #include "codegen/x86_generator.h"
+#include "codegen/abi.h"
+#include "codegen/liveness.h"
+#include "codegen/machine_ir.h"
+#include "codegen/x86_peephole.h"
+#include "codegen/x86_encoder.h"
+#include "codegen/jit.h"
+#include "codegen/graph_coloring.h"
+#include "cache/compile_cache.h"
+#include "utils/bit_vector.h"
+#include "utils/thread_pool.h"
+#include "ir/optimizer.h"
+#include "ir/ssa.h"
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <stdexcept>
 #include <string>
 #include <vector>
 
-// Helper: compile source to asm string
-static std::string compile_to_asm(const std::string& source) {
+// Helper: front end (preprocessor → parser → semantic → IR), как в cmd_compile
+struct FrontEndOptions {
+    CompileCache* cache = nullptr;   // тела функций из кэша не разбираются
+};
+
+static IRProgram compile_to_ir(const std::string& source, const FrontEndOptions& options = {}) {
     Preprocessor pp(source);
     std::string processed = pp.process();
     Scanner scanner(processed);
@@ -25,13 +47,28 @@ static std::string compile_to_asm(const std::string& source) {
     Parser parser(tokens);
     auto ast = parser.parse();
 
+    const std::unordered_set<std::string>* cached =
+        options.cache ? &options.cache->plan(tokens, false) : nullptr;
     SemanticAnalyzer analyzer;
+    analyzer.set_skip_bodies(cached);
     analyzer.analyze(*ast);
+    // кэш записывается только для корректной программы
+    if (options.cache) REQUIRE(analyzer.get_errors().empty());
 
     IRGenerator gen(analyzer.get_symbol_table(), analyzer.get_type_registry());
-    IRProgram program = gen.generate(*ast);
+    gen.set_skip_bodies(cached);
+    return gen.generate(*ast);
+}
+
+// Helper: compile source to asm string
+static std::string compile_to_asm(const std::string& source,
+                                  RegAllocStrategy strategy = RegAllocStrategy::StackOnly,
+                                  bool omit_frame_pointer = false) {
+    IRProgram program = compile_to_ir(source);
 
     X86Generator x86gen;
+    x86gen.set_regalloc_strategy(strategy);
+    x86gen.set_omit_frame_pointer(omit_frame_pointer);
     return x86gen.generate(program);
 }
 
@@ -80,21 +117,7 @@ TEST_CASE("Codegen: multiple functions", "[codegen]") {
 }
 
 TEST_CASE("Codegen: LSRA strategy compiles", "[codegen]") {
-    Preprocessor pp("fn main() -> int { return 42; }");
-    std::string processed = pp.process();
-    Scanner scanner(processed);
-    std::vector<Token> tokens;
-    while (true) {
-        Token tok = scanner.next_token();
-        tokens.push_back(tok);
-        if (tok.type == TokenType::END_OF_FILE) break;
-    }
-    Parser parser(tokens);
-    auto ast = parser.parse();
-    SemanticAnalyzer analyzer;
-    analyzer.analyze(*ast);
-    IRGenerator gen(analyzer.get_symbol_table(), analyzer.get_type_registry());
-    IRProgram program = gen.generate(*ast);
+    IRProgram program = compile_to_ir("fn main() -> int { return 42; }");
 
     X86Generator x86gen;
     x86gen.set_regalloc_strategy(RegAllocStrategy::LinearScan);
@@ -103,24 +126,152 @@ TEST_CASE("Codegen: LSRA strategy compiles", "[codegen]") {
     CHECK(asm_code.find("main:") != std::string::npos);
 }
 
+TEST_CASE("Codegen: LSRA leaf function needs no callee-saved registers", "[codegen]") {
+    auto asm_code = compile_to_asm(R"(
+        fn f(int a, int b) -> int {
+            int c = a * b; int d = c + a; int e = d - b;
+            return c + d + e;
+        }
+        fn main() -> int { return 0; }
+    )", RegAllocStrategy::LinearScan);
+    CHECK(asm_code.find("save callee-saved") == std::string::npos);
+    CHECK(asm_code.find("r10") != std::string::npos);
+}
+
+TEST_CASE("Codegen: LSRA saves caller-saved registers only across calls", "[codegen]") {
+    // Шесть значений живы через g(7): пять берут callee-saved, шестое —
+    // caller-saved регистр, который сохраняется вокруг этого call
+    auto asm_code = compile_to_asm(R"(
+        fn g(int x) -> int { return x + 1; }
+        fn main() -> int {
+            int a = g(1); int b = g(2); int c = g(3); int d = g(4);
+            int e = g(5); int f = g(6);
+            int z = g(7);
+            return a + b + c + d + e + f + z;
+        }
+    )", RegAllocStrategy::LinearScan);
+    const size_t save = asm_code.find("; save caller-saved");
+    REQUIRE(save != std::string::npos);
+    const size_t push = asm_code.rfind("push ", save) + 5;
+    const std::string reg = asm_code.substr(push, asm_code.find_first_of(" \t", push) - push);
+    CHECK((reg == "rsi" || reg == "rdi" || reg == "r9" || reg == "r10" || reg == "r11"));
+    // push → call g(7) → pop того же регистра
+    const size_t call = asm_code.find("call g", save);
+    REQUIRE(call != std::string::npos);
+    CHECK(asm_code.find("pop ", call) == asm_code.find("pop " + reg, call));
+    CHECK(asm_code.find("; save caller-saved", save + 1) == std::string::npos);
+    // В прологе (до первого вызова) регистр не сохраняется
+    const size_t main_at = asm_code.find("main:");
+    const size_t first_call = asm_code.find("call ", main_at);
+    CHECK(asm_code.substr(main_at, first_call - main_at).find("push " + reg) == std::string::npos);
+
+    // Без вызовов caller-saved регистры используются без сохранений
+    auto leaf = compile_to_asm(R"(
+        fn f(int a, int b) -> int {
+            int c = a * b; int d = c + a; int e = d - b;
+            return c + d + e;
+        }
+        fn main() -> int { return 0; }
+    )", RegAllocStrategy::LinearScan);
+    CHECK(leaf.find("r10") != std::string::npos);
+    CHECK(leaf.find("; save") == std::string::npos);
+}
+
+// ---- --omit-frame-pointer ----
+
+TEST_CASE("Codegen: leaf function keeps its frame in the red zone", "[codegen][frame]") {
+    auto asm_code = compile_to_asm(R"(
+        fn f(int a, int b) -> int { int c = a * b; return c + a; }
+        fn main() -> int { return 0; }
+    )", RegAllocStrategy::StackOnly, true);
+    CHECK(asm_code.find("push rbp") == std::string::npos);
+    CHECK(asm_code.find("sub rsp") == std::string::npos);
+    CHECK(asm_code.find("leave") == std::string::npos);
+    CHECK(asm_code.find("[rsp-") != std::string::npos);
+}
+
+TEST_CASE("Codegen: early return skips the shrink-wrapped prologue", "[codegen][frame]") {
+    auto asm_code = compile_to_asm(R"(
+        fn fib(int n) -> int {
+            if (n < 2) { return n; }
+            return fib(n - 1) + fib(n - 2);
+        }
+        fn main() -> int { return fib(10); }
+    )", RegAllocStrategy::LinearScan, true);
+    // Пролог — на ребре к рекурсивной ветке, ранний выход — голый ret
+    std::size_t fib = asm_code.find("fib:");
+    std::size_t setup = asm_code.find("Laux_frame", fib);
+    REQUIRE(setup != std::string::npos);
+    CHECK(asm_code.find("save callee-saved", fib) > setup);
+    std::size_t early = asm_code.find("then_0:", fib);
+    REQUIRE(early != std::string::npos);
+    std::size_t ret = asm_code.find("ret", early);
+    CHECK(asm_code.substr(early, ret - early).find("pop") == std::string::npos);
+}
+
+// ---- Раскладка фрейма ----
+
+TEST_CASE("Codegen: stack slots are shared by disjoint live intervals", "[codegen][frame]") {
+    auto asm_code = compile_to_asm(R"(
+        fn chain(int a) -> int {
+            int b = a + 1;
+            int c = b * 2;
+            int d = c - 3;
+            int e = d * d;
+            return e + b;
+        }
+        fn main() -> int { return chain(4); }
+    )");
+    // 11 значений в четырёх DWORD-слотах: b занимает слот мёртвого a
+    std::size_t chain = asm_code.find("chain:");
+    CHECK(asm_code.find("sub rsp, 16", chain) < asm_code.find("leave", chain));
+    CHECK(asm_code.find("mov dword [rbp-12], edi    ; param a") != std::string::npos);
+    CHECK(asm_code.find("mov dword [rbp-12], eax", chain) != std::string::npos);
+    CHECK(asm_code.find("qword [rbp") == std::string::npos);
+}
+
+// ---- Graph coloring (--regalloc graph) ----
+
+TEST_CASE("Codegen: graph coloring coalesces a copy", "[codegen][graph]") {
+    // t0 = 1; t1 = MOVE t0; t2 = ADD t1, t0; RETURN t2
+    IRFunction func;
+    func.name = "f";
+    func.add_block("B0").instructions = {
+        IRInstruction::make_move(Operand::temp(0), Operand::int_lit(1)),
+        IRInstruction::make_move(Operand::temp(1), Operand::temp(0)),
+        IRInstruction::make_binary(IROpcode::ADD, Operand::temp(2), Operand::temp(1), Operand::int_lit(1)),
+        IRInstruction::make_return(Operand::temp(2))};
+
+    InterferenceGraph graph = build_interference_graph(func);
+    REQUIRE(graph.nodes.size() == 3);
+    REQUIRE(graph.moves.size() == 1);
+    CHECK_FALSE(graph.interferes(0, 1));
+
+    ColoringResult result = color_interference_graph(graph, {false, true}, {});
+    CHECK(result.coalesced_moves == 1);
+    CHECK(result.color[0] >= 0);
+    CHECK(result.color[0] == result.color[1]);
+}
+
+TEST_CASE("Codegen: graph coloring saves caller-saved registers across calls", "[codegen][graph]") {
+    // Семь значений живы через вызов — пяти callee-saved не хватает
+    auto asm_code = compile_to_asm(R"(
+        fn g(int x) -> int { return x + 1; }
+        fn main() -> int {
+            int a = g(1); int b = g(2); int c = g(3); int d = g(4);
+            int e = g(5); int f = g(6); int h = g(7);
+            int z = g(8);
+            return a + b + c + d + e + f + h + z;
+        }
+    )", RegAllocStrategy::GraphColoring);
+    CHECK(asm_code.find("; save caller-saved") != std::string::npos);
+    CHECK(asm_code.find("push rbx") != std::string::npos);
+}
+
 // ---- DWARF mode ----
 
 TEST_CASE("Codegen: DWARF mode outputs GAS syntax", "[codegen][dwarf]") {
-    Preprocessor pp("fn main() -> int { return 0; }");
-    std::string processed = pp.process();
-    Scanner scanner(processed);
-    std::vector<Token> tokens;
-    while (true) {
-        Token tok = scanner.next_token();
-        tokens.push_back(tok);
-        if (tok.type == TokenType::END_OF_FILE) break;
-    }
-    Parser parser(tokens);
-    auto ast = parser.parse();
-    SemanticAnalyzer analyzer;
-    analyzer.analyze(*ast);
-    IRGenerator gen(analyzer.get_symbol_table(), analyzer.get_type_registry());
-    IRProgram program = gen.generate(*ast);
+    IRProgram program = compile_to_ir("fn main() -> int { return 0; }");
 
     X86Generator x86gen;
     x86gen.set_dwarf(true);
@@ -136,21 +287,7 @@ TEST_CASE("Codegen: DWARF mode outputs GAS syntax", "[codegen][dwarf]") {
 }
 
 TEST_CASE("Codegen: DWARF mode emits .loc", "[codegen][dwarf]") {
-    Preprocessor pp("fn main() -> int { int x = 42; return x; }");
-    std::string processed = pp.process();
-    Scanner scanner(processed);
-    std::vector<Token> tokens;
-    while (true) {
-        Token tok = scanner.next_token();
-        tokens.push_back(tok);
-        if (tok.type == TokenType::END_OF_FILE) break;
-    }
-    Parser parser(tokens);
-    auto ast = parser.parse();
-    SemanticAnalyzer analyzer;
-    analyzer.analyze(*ast);
-    IRGenerator gen(analyzer.get_symbol_table(), analyzer.get_type_registry());
-    IRProgram program = gen.generate(*ast);
+    IRProgram program = compile_to_ir("fn main() -> int { int x = 42; return x; }");
 
     X86Generator x86gen;
     x86gen.set_dwarf(true);
@@ -160,3 +297,503 @@ TEST_CASE("Codegen: DWARF mode emits .loc", "[codegen][dwarf]") {
     // Should contain .loc directives
     CHECK(asm_code.find(".loc 1") != std::string::npos);
 }
+
+// ---- Float (SSE2) ----
+
+TEST_CASE("Codegen: System V classifies int and float arguments separately", "[codegen][float]") {
+    using Kind = x86abi::ArgLocation::Kind;
+    std::vector<bool> is_float = {false, true, false, true};
+    is_float.resize(16, true);
+    auto locs = x86abi::classify_args(is_float);
+    CHECK((locs[0].kind == Kind::Gpr && locs[0].index == 0));
+    CHECK((locs[1].kind == Kind::Xmm && locs[1].index == 0));
+    CHECK((locs[2].kind == Kind::Gpr && locs[2].index == 1));
+    CHECK((locs[9].kind == Kind::Xmm && locs[9].index == 7));
+    CHECK((locs[10].kind == Kind::Stack && locs[10].index == 0));
+}
+
+TEST_CASE("Codegen: float arithmetic uses SSE2 and a constant pool", "[codegen][float]") {
+    auto asm_code = compile_to_asm(R"(
+        fn scale(int n, float x) -> float { return n * x * 2.5; }
+        fn main() -> int {
+            float y = scale(3, 1.5);
+            return 0;
+        }
+    )");
+    CHECK(asm_code.find("cvtsi2sd xmm0, eax") != std::string::npos);
+    CHECK(asm_code.find("mulsd xmm0, xmm1") != std::string::npos);
+    CHECK(asm_code.find("movsd qword [rbp-16], xmm0    ; param x") != std::string::npos);
+    CHECK(asm_code.find("mov dword [rbp-20], edi    ; param n") != std::string::npos);
+    CHECK(asm_code.find("dq 0x4004000000000000") != std::string::npos);     // 2.5
+    CHECK(asm_code.find("mov eax, 1") != std::string::npos);                // one xmm argument
+    CHECK(asm_code.find("TODO: float") == std::string::npos);
+}
+
+TEST_CASE("Codegen: float comparison is NaN-aware", "[codegen][float]") {
+    auto asm_code = compile_to_asm(R"(
+        fn eq(float a, float b) -> bool { return a == b; }
+        fn lt(float a, float b) -> bool { return a < b; }
+    )");
+    CHECK(asm_code.find("ucomisd xmm0, xmm1") != std::string::npos);
+    CHECK(asm_code.find("setnp cl") != std::string::npos);
+    CHECK(asm_code.find("ucomisd xmm1, xmm0") != std::string::npos);   // a < b as b > a
+    CHECK(asm_code.find("seta al") != std::string::npos);
+}
+
+// ---- Machine IR + x86 peephole ----
+
+TEST_CASE("Machine IR: operands print in NASM and GAS syntax", "[codegen][mir]") {
+    using namespace mir;
+    Instr load = make(Op::MOV, reg(Reg::R12, 32), mem(Reg::RBP, -8, 32));
+    CHECK(format_instr(load, Syntax::Nasm, "f") == "    mov r12d, dword [rbp-8]");
+    CHECK(format_instr(load, Syntax::Gas, "f") == "    mov r12d, dword ptr [rbp-8]");
+
+    mir::Symbol str{mir::Symbol::Kind::String, "", 3};
+    Instr lea = make(Op::LEA, reg(Reg::RAX), mem_rel(str));
+    CHECK(format_instr(lea, Syntax::Nasm, "f") == "    lea rax, [rel Lstr_3]");
+    CHECK(format_instr(lea, Syntax::Gas, "f") == "    lea rax, [rip + Lstr_3]");
+
+    Instr jl = make_cc(Op::JCC, Cond::L, label({mir::Symbol::Kind::Block, "L_for_0", 0}));
+    CHECK(format_instr(jl, Syntax::Nasm, "f") == "    jl .L_for_0");
+    CHECK(format_instr(jl, Syntax::Gas, "f") == "    jl .L_f_L_for_0");
+    CHECK(invert(Cond::L) == Cond::GE);
+    CHECK(parse_reg("r9d") == Reg::R9);
+}
+
+TEST_CASE("Peephole: store-load forwarding across instructions", "[codegen][mir]") {
+    using namespace mir;
+    Function fn;
+    fn.name = "f";
+    fn.blocks.push_back({{mir::Symbol::Kind::Global, "f", 0}, {}});
+    auto& code = fn.blocks[0].code;
+    code.push_back(make(Op::MOV, mem(Reg::RBP, -8, 64), reg(Reg::RAX)));
+    code.push_back(make(Op::ADD, reg(Reg::RCX), imm(1)));
+    code.push_back(make(Op::MOV, reg(Reg::RDX), mem(Reg::RBP, -16, 64)));
+    code.push_back(make(Op::MOV, reg(Reg::RCX), mem(Reg::RBP, -8, 64)));   // → mov rcx, rax
+    code.push_back(make(Op::MOV, reg(Reg::RAX), mem(Reg::RBP, -8, 64)));   // → удалить
+    code.push_back(make(Op::MOV, mem(Reg::RBP, -8, 64), imm(0)));
+    code.push_back(make(Op::MOV, reg(Reg::RSI), mem(Reg::RBP, -8, 64)));   // слот переписан
+    code.push_back(make(Op::RET));
+
+    X86Peephole peephole;
+    peephole.optimize(fn);
+    REQUIRE(code.size() == 7);
+    CHECK(code[3].src == reg(Reg::RAX));
+    CHECK(code[4].dst.is_mem());
+    CHECK(code[5].src == mem(Reg::RBP, -8, 64));
+    CHECK(peephole.forwarded() == 2);
+}
+
+TEST_CASE("Peephole: setcc + test + jnz becomes a single jcc", "[codegen][mir]") {
+    using namespace mir;
+    Function fn;
+    fn.name = "f";
+    fn.blocks.push_back({{mir::Symbol::Kind::Global, "f", 0}, {}});
+    fn.blocks.push_back({{mir::Symbol::Kind::Block, "then", 0}, {}});
+    fn.blocks.push_back({{mir::Symbol::Kind::Block, "else", 0}, {}});
+    auto& code = fn.blocks[0].code;
+    code.push_back(make(Op::CMP, reg(Reg::RAX), reg(Reg::RCX)));
+    code.push_back(make_cc(Op::SETCC, Cond::L, reg(Reg::RAX, 8)));
+    code.push_back(make(Op::MOVZX, reg(Reg::RAX, 32), reg(Reg::RAX, 8)));
+    code.push_back(make(Op::TEST, reg(Reg::RAX, 32), reg(Reg::RAX, 32)));
+    code.push_back(make_cc(Op::JCC, Cond::NE, label(fn.blocks[1].label)));
+    code.push_back(make(Op::JMP, label(fn.blocks[2].label)));
+    fn.blocks[1].code.push_back(make(Op::RET));
+    fn.blocks[2].code.push_back(make(Op::RET));
+
+    X86Peephole peephole;
+    peephole.optimize(fn);
+    // test удалён, jnz → jl, а jl .then; jmp .else → jge .else
+    REQUIRE(code.size() == 4);
+    CHECK(code[3].is_op(Op::JCC));
+    CHECK(code[3].cond == Cond::GE);
+    CHECK(code[3].dst.sym == fn.blocks[2].label);
+    CHECK(peephole.compares() == 1);
+}
+
+// ---- Кодирование x86-64 и ELF (--emit obj) ----
+
+TEST_CASE("Encoder: registers, memory, immediates and RIP literals", "[codegen][obj]") {
+    using namespace mir;
+    Function fn;
+    fn.name = "f";
+    fn.blocks.push_back({{mir::Symbol::Kind::Global, "f", 0}, {}});
+    auto& code = fn.blocks[0].code;
+    code.push_back(make(Op::MOV, reg(Reg::RAX), mem(Reg::RBP, -8, 64)));              // 48 8B 45 F8
+    code.push_back(make(Op::MOV, reg(Reg::R12, 32), imm(5)));                         // 41 BC 05 00 00 00
+    code.push_back(make_cc(Op::SETCC, Cond::L, reg(Reg::RSI, 8)));                    // 40 0F 9C C6
+    code.push_back(make(Op::MOVSD, reg(Reg::XMM8), mem_rel({mir::Symbol::Kind::Float, "", 0}, 64)));
+    code.push_back(make(Op::CALL, label({mir::Symbol::Kind::Global, "printf", 0})));
+
+    X86Encoder enc;
+    REQUIRE(enc.add_function(fn));
+    REQUIRE(enc.finish());
+    const std::vector<std::uint8_t> expected = {
+        0x48, 0x8B, 0x45, 0xF8,
+        0x41, 0xBC, 0x05, 0x00, 0x00, 0x00,
+        0x40, 0x0F, 0x9C, 0xC6,
+        0xF2, 0x44, 0x0F, 0x10, 0x05, 0, 0, 0, 0,
+        0xE8, 0, 0, 0, 0,
+    };
+    CHECK(enc.code() == expected);
+    REQUIRE(enc.relocations().size() == 2);
+    CHECK(enc.relocations()[0].offset == 19);
+    CHECK(enc.relocations()[0].addend == -4);
+    CHECK(enc.relocations()[1].type == X86Encoder::Relocation::Type::PLT32);
+    CHECK(enc.relocations()[1].sym.name == "printf");
+}
+
+TEST_CASE("Encoder: jumps start short and relax to rel32", "[codegen][obj]") {
+    using namespace mir;
+    Function fn;
+    fn.name = "f";
+    mir::Symbol near_label{mir::Symbol::Kind::Block, "near", 0};
+    mir::Symbol far_label{mir::Symbol::Kind::Block, "far", 0};
+    fn.blocks.push_back({{mir::Symbol::Kind::Global, "f", 0}, {}});
+    fn.blocks[0].code.push_back(make_cc(Op::JCC, Cond::E, label(near_label)));
+    fn.blocks[0].code.push_back(make(Op::JMP, label(far_label)));
+    fn.blocks.push_back({near_label, {}});
+    for (int i = 0; i < 40; ++i) {
+        fn.blocks[1].code.push_back(make(Op::ADD, reg(Reg::RAX), mem(Reg::RBP, -16, 64)));  // 4 байта
+    }
+    fn.blocks.push_back({far_label, {}});
+    fn.blocks[2].code.push_back(make(Op::RET));
+
+    X86Encoder enc;
+    REQUIRE(enc.add_function(fn));
+    REQUIRE(enc.finish());
+    const auto& code = enc.code();
+    REQUIRE(code.size() == 2 + 5 + 160 + 1);
+    CHECK(code[0] == 0x74);         // je rel8
+    CHECK(code[1] == 5);
+    CHECK(code[2] == 0xE9);         // jmp rel32: 160 байт не влезают в rel8
+    CHECK(code[3] == 160);
+    CHECK(enc.short_branches() == 1);
+    CHECK(enc.near_branches() == 1);
+    REQUIRE(enc.functions().size() == 1);
+    CHECK(enc.functions()[0].size == code.size());
+}
+
+TEST_CASE("Encoder: SSE4.1 and AVX2 vector instructions", "[codegen][obj]") {
+    using namespace mir;
+    Function fn;
+    fn.name = "f";
+    fn.blocks.push_back({{mir::Symbol::Kind::Global, "f", 0}, {}});
+    auto& code = fn.blocks[0].code;
+    code.push_back(make(Op::MOVDQU, reg(Reg::XMM0, 128), mem(Reg::RBP, -16, 128)));       // F3 0F 6F 45 F0
+    code.push_back(make(Op::PMULLD, reg(Reg::XMM0, 128), reg(Reg::XMM1, 128)));          // 66 0F 38 40 C1
+    code.push_back(make(Op::VPADDD, reg(Reg::XMM0, 256), reg(Reg::XMM1, 256)));          // C5 FD FE C1
+    code.push_back(make(Op::VPMULLD, reg(Reg::XMM0, 256), reg(Reg::XMM1, 256)));         // C4 E2 7D 40 C1
+    code.push_back(make(Op::VMOVDQU, mem(Reg::R12, Reg::RCX, 4, 0, 256), reg(Reg::XMM0, 256)));
+    code.push_back(make(Op::VZEROUPPER));
+
+    X86Encoder enc;
+    REQUIRE(enc.add_function(fn));
+    REQUIRE(enc.finish());
+    const std::vector<std::uint8_t> expected = {
+        0xF3, 0x0F, 0x6F, 0x45, 0xF0,
+        0x66, 0x0F, 0x38, 0x40, 0xC1,
+        0xC5, 0xFD, 0xFE, 0xC1,
+        0xC4, 0xE2, 0x7D, 0x40, 0xC1,
+        0xC4, 0xC1, 0x7E, 0x7F, 0x04, 0x8C,     // база r12 — трёхбайтовый VEX
+        0xC5, 0xF8, 0x77,
+    };
+    CHECK(enc.code() == expected);
+    CHECK(format_instr(code[2], Syntax::Nasm, "f") == "    vpaddd ymm0, ymm0, ymm1");
+    CHECK(format_instr(code[4], Syntax::Gas, "f") == "    vmovdqu ymmword ptr [r12+rcx*4], ymm0");
+}
+
+TEST_CASE("Codegen: --emit obj writes an ELF64 relocatable object", "[codegen][obj]") {
+    IRProgram program = compile_to_ir(R"(
+        extern fn printf(string format, ...) -> int;
+        fn main() -> int { printf("x = %d\n", 42); return 0; }
+    )");
+
+    X86Generator x86gen;
+    x86gen.set_emit_object(true);
+    std::string obj = x86gen.generate(program);
+    CHECK(x86gen.errors().empty());
+    REQUIRE(obj.size() > 64);
+    CHECK(obj.compare(0, 4, "\x7f" "ELF") == 0);
+    CHECK(obj[4] == 2);                 // ELFCLASS64
+    CHECK(obj[16] == 1);                // ET_REL
+    CHECK(static_cast<unsigned char>(obj[18]) == 62);   // EM_X86_64
+    CHECK(obj.find(".rela.text") != std::string::npos);
+    CHECK(obj.find(".rodata") != std::string::npos);
+    CHECK(obj.find(std::string("printf\0", 7)) != std::string::npos);
+    CHECK(obj.find(std::string("x = %d\n\0", 8)) != std::string::npos);
+    CHECK(obj.find("section .text") == std::string::npos);
+}
+
+// ---- JIT (compiler run) ----
+
+// Helper: compile source into memory and call main
+static int jit_main(const std::string& source, RegAllocStrategy strategy) {
+    IRProgram program = compile_to_ir(source);
+
+    X86Generator x86gen;
+    x86gen.set_regalloc_strategy(strategy);
+    elf::Object obj = x86gen.generate_object(program);
+    REQUIRE(x86gen.errors().empty());
+    JitModule module;
+    REQUIRE(module.load(obj));
+    auto* entry = reinterpret_cast<int (*)()>(module.symbol("main"));
+    REQUIRE(entry != nullptr);
+    return entry();
+}
+
+TEST_CASE("JIT: main is called in process memory", "[codegen][jit]") {
+    const std::string src = R"(
+        fn fact(int n) -> int { if (n <= 1) { return 1; } return n * fact(n - 1); }
+        fn half(float x) -> float { return x / 2.0; }
+        fn main() -> int { return fact(5) + half(9.0); }
+    )";
+    CHECK(jit_main(src, RegAllocStrategy::StackOnly) == 124);
+    CHECK(jit_main(src, RegAllocStrategy::LinearScan) == 124);
+}
+
+TEST_CASE("JIT: extern functions resolve through dlsym", "[codegen][jit]") {
+    CHECK(jit_main(R"(
+        extern fn abs(int x) -> int;
+        fn main() -> int { return abs(0 - 17); }
+    )", RegAllocStrategy::GraphColoring) == 17);
+
+    JitModule module;
+    elf::Object obj;
+    obj.symbols.push_back({"no_such_symbol_xyz", elf::Section::Undef, 0, 0, true, false});
+    CHECK_FALSE(module.load(obj));
+    CHECK(module.error().find("no_such_symbol_xyz") != std::string::npos);
+}
+
+// ---- Профиль (--profile-generate / --profile-use) ----
+
+TEST_CASE("Profile: counters are dumped at exit and cold blocks move last", "[codegen][profile]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "minicompiler_profile_test.txt").string();
+    std::filesystem::remove(path);
+    const std::string src = R"(
+        fn pick(int i) -> int { if (i == 7) { return 100; } return 1; }
+        fn main() -> int {
+            int s = 0;
+            for (int i = 0; i < 50; i = i + 1) { s = s + pick(i); }
+            return s - 100;
+        }
+    )";
+    IRProgram program = compile_to_ir(src);
+
+    // Счётчик в начале каждого блока и перед вызовом, запись — в выходе из main
+    X86Generator instrumented;
+    instrumented.set_profile_generate(path);
+    std::string asm_out = instrumented.generate(program);
+    CHECK(asm_out.find("add qword [rel Lprof_0], 1") != std::string::npos);
+    CHECK(asm_out.find("call __mc_profile_dump") != std::string::npos);
+    CHECK(asm_out.find("section .bss") != std::string::npos);
+    CHECK(asm_out.find("global __mc_profile_dump") == std::string::npos);
+
+    // Тот же код через JIT: .bss обнулена, профиль записан
+    elf::Object obj = instrumented.generate_object(program);
+    REQUIRE(instrumented.errors().empty());
+    CHECK(obj.bss_size > 0);
+    {
+        JitModule module;
+        REQUIRE(module.load(obj));
+        auto* entry = reinterpret_cast<int (*)()>(module.symbol("main"));
+        REQUIRE(entry != nullptr);
+        CHECK(entry() == 49);
+    }
+    std::ifstream in(path);
+    REQUIRE(in);
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+    CHECK(text.find("call main pick 50\n") != std::string::npos);
+
+    ProfileData profile;
+    std::string error;
+    REQUIRE(profile.parse(text, error));
+    const IRFunction* pick = program.find_function("pick");
+    REQUIRE(pick != nullptr);
+    auto counts = profile.block_counts(*pick);
+    REQUIRE(counts.size() == pick->blocks.size());
+    CHECK(counts[0] == 50);
+
+    // С профилем ветка, выполненная один раз, уходит за горячий путь
+    X86Generator optimized;
+    optimized.set_profile(&profile);
+    optimized.set_regalloc_strategy(RegAllocStrategy::LinearScan);
+    std::string laid_out = optimized.generate(program);
+    std::string cold, hot;
+    for (size_t b = 1; b < pick->blocks.size(); ++b) {
+        auto it = profile.function(*pick)->blocks.find(pick->blocks[b].label);
+        REQUIRE(it != profile.function(*pick)->blocks.end());
+        (it->second == 1 ? cold : hot) = "." + pick->blocks[b].label + ":";
+    }
+    REQUIRE(!cold.empty());
+    REQUIRE(!hot.empty());
+    const size_t pick_at = laid_out.find("pick:");
+    CHECK(laid_out.find(hot, pick_at) < laid_out.find(cold, pick_at));
+    CHECK(optimized.statistics().find("Profiled functions: 2 of 2") != std::string::npos);
+}
+
+// ---- Liveness ----
+
+TEST_CASE("Liveness: bit vector word-parallel ops", "[codegen][liveness]") {
+    utils::BitVector a(130), b(130), c(130), out(130);
+    a.set(0);
+    b.set(64);
+    b.set(129);
+    c.set(129);
+    CHECK(out.assign_union_diff(a, b, c));
+    CHECK(out.test(0));
+    CHECK(out.test(64));
+    CHECK_FALSE(out.test(129));
+    CHECK_FALSE(out.assign_union_diff(a, b, c));   // no change
+
+    std::vector<size_t> bits;
+    out.for_each([&](size_t i) { bits.push_back(i); });
+    CHECK(bits == std::vector<size_t>{0, 64});
+    CHECK_FALSE(a.union_with(a));
+}
+
+TEST_CASE("Liveness: value live around a loop back edge", "[codegen][liveness]") {
+    // B0: t0 = 1; JUMP B1
+    // B1: t1 = ADD t0, 1; JUMP_IF t1 B1; JUMP B2
+    // B2: RETURN t1
+    IRFunction func;
+    func.name = "f";
+    func.add_block("B0").instructions = {
+        IRInstruction::make_move(Operand::temp(0), Operand::int_lit(1)),
+        IRInstruction::make_jump("B1")};
+    func.add_block("B1").instructions = {
+        IRInstruction::make_binary(IROpcode::ADD, Operand::temp(1), Operand::temp(0), Operand::int_lit(1)),
+        IRInstruction::make_jump_if(Operand::temp(1), "B1"),
+        IRInstruction::make_jump("B2")};
+    func.add_block("B2").instructions = {
+        IRInstruction::make_return(Operand::temp(1))};
+
+    auto intervals = compute_live_intervals(func);
+    REQUIRE(intervals.size() == 2);
+    CHECK(intervals[0].name() == "t0");
+    CHECK(intervals[0].start == 1);
+    CHECK(intervals[0].end == 5);    // live-out of B1 via the back edge
+    CHECK(intervals[1].name() == "t1");
+    CHECK(intervals[1].start == 3);
+    CHECK(intervals[1].end == 6);
+}
+
+// ---- Parallel pipeline (--jobs) ----
+
+TEST_CASE("Parallel: thread pool visits every index once", "[codegen][jobs]") {
+    utils::ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallel_for(hits.size(), [&](size_t i) { hits[i]++; });
+    pool.parallel_for(hits.size(), [&](size_t i) { hits[i]++; });
+    bool all_twice = true;
+    for (auto& h : hits) all_twice = all_twice && h.load() == 2;
+    CHECK(all_twice);
+}
+
+TEST_CASE("Parallel: thread pool rethrows and stays usable", "[codegen][jobs]") {
+    utils::ThreadPool pool(4);
+    std::atomic<int> done{0};
+    CHECK_THROWS_AS(pool.parallel_for(100, [&](size_t i) {
+        done++;
+        if (i % 10 == 3) throw std::runtime_error("fail");
+    }), std::runtime_error);
+    CHECK(done.load() == 100);
+    done = 0;
+    pool.parallel_for(100, [&](size_t) { done++; });
+    CHECK(done.load() == 100);
+}
+
+TEST_CASE("Parallel: --jobs output is byte-identical", "[codegen][jobs]") {
+    const std::string src = R"(
+        extern fn printf(string format, ...) -> int;
+        fn f(int a, int b) -> int {
+            int x = a; int y = b;
+            for (int k = 0; k < a; k = k + 1) {
+                if (k % 2 == 0 && b > k || x > y) { x = x + k; y = y - 1; }
+                else { y = y + k; x = x - 1; }
+            }
+            printf("f %d\n", x);
+            return x * y;
+        }
+        fn g(int n) -> int { printf("g\n"); printf("f %d\n", n); return f(n, 2) + 1; }
+        fn main() -> int { return g(3) + f(1, 2); }
+    )";
+    auto build = [&](int jobs, bool dwarf) {
+        IRProgram program = compile_to_ir(src);
+
+        utils::ThreadPool pool(jobs);
+        PeepholeOptimizer opt(program);
+        opt.optimize(&pool);
+
+        X86Generator x86gen;
+        x86gen.set_regalloc_strategy(RegAllocStrategy::LinearScan);
+        x86gen.set_dwarf(dwarf);
+        x86gen.set_thread_pool(&pool);
+        return x86gen.generate(program) + x86gen.statistics() + opt.get_optimization_report();
+    };
+    CHECK(build(1, false) == build(4, false));
+    CHECK(build(1, true) == build(3, true));
+}
+
+// ---- Compilation cache (--cache-dir) ----
+
+// compile pipeline of cmd_compile; cache == nullptr — without cache
+static std::string cached_compile(const std::string& source, CompileCache* cache,
+                                  RegAllocStrategy strategy = RegAllocStrategy::StackOnly) {
+    FrontEndOptions options;
+    options.cache = cache;
+    IRProgram program = compile_to_ir(source, options);
+
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    destruct_ssa(program);
+    if (cache) cache->complete_program(program);
+
+    X86Generator x86gen;
+    x86gen.set_regalloc_strategy(strategy);
+    x86gen.set_dwarf(true);
+    if (cache) x86gen.set_unit_cache(&cache->unit_cache());
+    return x86gen.generate(program);
+}
+
+static std::string cache_stats(const std::string& dir, const std::string& source,
+                               RegAllocStrategy strategy = RegAllocStrategy::StackOnly) {
+    CompileCache cache(dir, "test", std::to_string(static_cast<int>(strategy)));
+    CHECK(cached_compile(source, &cache, strategy) == cached_compile(source, nullptr, strategy));
+    CHECK(cache.errors().empty());
+    return cache.statistics();
+}
+
+TEST_CASE("Cache: only edited functions are rebuilt, output unchanged", "[codegen][cache]") {
+    const std::string dir = (std::filesystem::temp_directory_path() / "minicompiler_cache_test").string();
+    std::filesystem::remove_all(dir);
+    const std::string src = R"(
+        extern fn printf(string format, ...) -> int;
+        fn square(int x) -> int { return x * x; }
+        fn scale(float x) -> float { printf("scale\n"); return x * 1.5; }
+        fn main() -> int { printf("%d\n", square(7)); float f = scale(2.0); return square(3); }
+    )";
+    CHECK(cache_stats(dir, src).find("IR misses:       3") != std::string::npos);
+    CHECK(cache_stats(dir, src).find("Code hits:       3") != std::string::npos);
+
+    // Functions moved down two lines: still hits, line numbers follow
+    std::string edited = "\n\n" + src;
+    edited.replace(edited.find("x * 1.5"), 7, "x * 2.5");
+    auto stats = cache_stats(dir, edited);
+    CHECK(stats.find("IR hits:         2") != std::string::npos);
+    CHECK(stats.find("IR misses:       1") != std::string::npos);
+
+    // A new signature invalidates the function and its callers
+    std::string resigned = edited;
+    resigned.replace(resigned.find("square(int x) -> int { return x * x; }"), 38,
+                     "square(int n) -> int { return n * n; }");
+    stats = cache_stats(dir, resigned);
+    CHECK(stats.find("IR hits:         1") != std::string::npos);
+
+    // Another register allocator reuses the IR, but not the code
+    stats = cache_stats(dir, resigned, RegAllocStrategy::LinearScan);
+    CHECK(stats.find("IR hits:         3") != std::string::npos);
+    CHECK(stats.find("Code misses:     3") != std::string::npos);
+    std::filesystem::remove_all(dir);
+}
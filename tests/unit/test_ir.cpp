@@ -7,8 +7,14 @@
 #include "semantic/analyzer.h"
 #include "ir/ir_generator.h"
 #include "ir/ir_printer.h"
+#include "ir/dominators.h"
+#include "ir/loops.h"
+#include "ir/ssa.h"
+#include "ir/interpreter.h"
+#include "ir/optimizer.h"
 
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -136,3 +142,420 @@ TEST_CASE("IR: binary operations", "[ir]") {
     CHECK(has_sub);
     CHECK(has_mul);
 }
+
+// ---- Operand interning ----
+
+TEST_CASE("IR: operands with equal names share a symbol id", "[ir]") {
+    Operand a = Operand::temp(7);
+    Operand b = Operand::temp(7, IRType::Int);
+    Operand v = Operand::var("t7");
+    CHECK(a.id == b.id);
+    CHECK(a.id == v.id);
+    CHECK(a.name() == "t7");
+    CHECK(operand_to_string(v) == "[t7]");
+    CHECK(Operand::temp(8).id != a.id);
+
+    Operand l = Operand::label("L_end");
+    l.rename(l.name() + "_inl1");
+    CHECK(l.name() == "L_end_inl1");
+    CHECK(l.id == SymbolInterner::instance().lookup("L_end_inl1"));
+}
+
+TEST_CASE("IR: type names map to IRType", "[ir]") {
+    CHECK(ir_type_from_name("int") == IRType::Int);
+    CHECK(ir_type_from_name("bool") == IRType::Bool);
+    CHECK(ir_type_from_name("int[16]") == IRType::Array);
+    CHECK(ir_type_from_name("Point") == IRType::Struct);
+    CHECK(ir_type_from_name("") == IRType::None);
+    CHECK(Operand::temp(0, "float").type == IRType::Float);
+}
+
+// ---- SSA ----
+
+static int count_opcode(const IRFunction& func, IROpcode op) {
+    int n = 0;
+    for (const auto& bb : func.blocks)
+        for (const auto& instr : bb.instructions)
+            if (instr.opcode == op) ++n;
+    return n;
+}
+
+TEST_CASE("IR: loop variable gets a header phi used after the loop", "[ir][ssa]") {
+    auto program = generate_ir(R"(
+        fn main() -> int {
+            int i = 0;
+            while (i < 10) { i = i + 1; }
+            return i;
+        }
+    )");
+    const auto& func = program.functions[0];
+    REQUIRE(count_opcode(func, IROpcode::PHI) == 1);
+
+    Operand phi_dest;
+    Operand ret_value;
+    for (const auto& bb : func.blocks) {
+        for (const auto& instr : bb.instructions) {
+            if (instr.opcode == IROpcode::PHI) phi_dest = instr.dest;
+            if (instr.opcode == IROpcode::RETURN) ret_value = instr.srcs[0];
+            // No source variable survives renaming
+            CHECK(instr.dest.kind != OperandKind::Variable);
+        }
+    }
+    CHECK(ret_value.kind == OperandKind::Temp);
+    CHECK(ret_value.id == phi_dest.id);
+}
+
+TEST_CASE("IR: shadowed variables stay distinct", "[ir][ssa]") {
+    auto program = generate_ir(R"(
+        fn main() -> int {
+            int x = 1;
+            { int x = 2; x = x + 5; }
+            return x;
+        }
+    )");
+    const auto& func = program.functions[0];
+    CHECK(count_opcode(func, IROpcode::PHI) == 0);
+    const auto& last = func.blocks.back().instructions.back();
+    REQUIRE(last.opcode == IROpcode::RETURN);
+    // The outer x is still the constant 1, or the temp that holds it
+    if (last.srcs[0].kind == OperandKind::IntLiteral) {
+        CHECK(last.srcs[0].int_val == 1);
+    } else {
+        bool found = false;
+        for (const auto& instr : func.blocks[0].instructions) {
+            if (instr.opcode == IROpcode::MOVE && instr.dest.id == last.srcs[0].id) {
+                CHECK(instr.srcs[0].int_val == 1);
+                found = true;
+            }
+        }
+        CHECK(found);
+    }
+}
+
+// Diamond: entry -> then / else -> join
+static IRFunction make_diamond() {
+    IRFunction func;
+    func.name = "f";
+    func.params.push_back({"c", "bool"});
+    auto& entry = func.add_block("entry");
+    entry.instructions.push_back(IRInstruction::make_jump_if(Operand::var("c"), "then"));
+    entry.instructions.push_back(IRInstruction::make_jump("else"));
+    auto& then_bb = func.add_block("then");
+    then_bb.instructions.push_back(IRInstruction::make_move(Operand::var("x"), Operand::int_lit(1)));
+    then_bb.instructions.push_back(IRInstruction::make_jump("join"));
+    auto& else_bb = func.add_block("else");
+    else_bb.instructions.push_back(IRInstruction::make_move(Operand::var("x"), Operand::int_lit(2)));
+    else_bb.instructions.push_back(IRInstruction::make_jump("join"));
+    auto& join = func.add_block("join");
+    join.instructions.push_back(IRInstruction::make_return(Operand::var("x")));
+    return func;
+}
+
+TEST_CASE("IR: dominator tree and frontiers of a diamond", "[ir][ssa]") {
+    IRFunction func = make_diamond();
+    DominatorTree dom(func);
+    CHECK(dom.idom(0) == -1);
+    CHECK(dom.idom(1) == 0);
+    CHECK(dom.idom(2) == 0);
+    CHECK(dom.idom(3) == 0);
+    CHECK(dom.dominates(0, 3));
+    CHECK(!dom.dominates(1, 3));
+    CHECK(dom.frontier(1) == std::vector<int>{3});
+    CHECK(dom.frontier(2) == std::vector<int>{3});
+    CHECK(dom.frontier(0).empty());
+}
+
+TEST_CASE("IR: construct_ssa merges a diamond with one phi", "[ir][ssa]") {
+    IRFunction func = make_diamond();
+    construct_ssa(func);
+    REQUIRE(count_opcode(func, IROpcode::PHI) == 1);
+    const auto& phi = func.blocks[3].instructions.front();
+    REQUIRE(phi.opcode == IROpcode::PHI);
+    CHECK(phi.srcs.size() == 4);                    // (value, label) x 2
+    CHECK(func.blocks[3].instructions.back().srcs[0].id == phi.dest.id);
+
+    destruct_ssa(func);
+    CHECK(count_opcode(func, IROpcode::PHI) == 0);
+    CHECK(count_opcode(func, IROpcode::MOVE) == 4);
+}
+
+TEST_CASE("IR: destruct_ssa breaks a swap cycle through a temp", "[ir][ssa]") {
+    // loop: a, b = b, a until the counter runs out
+    IRFunction func;
+    func.name = "swap";
+    func.temp_counter = 10;
+    auto& entry = func.add_block("entry");
+    entry.instructions.push_back(IRInstruction::make_jump("loop"));
+    auto& loop = func.add_block("loop");
+    auto phi_a = IRInstruction::make_phi(Operand::temp(0));
+    phi_a.srcs = {Operand::int_lit(1), Operand::label("entry"),
+                  Operand::temp(1), Operand::label("loop")};
+    auto phi_b = IRInstruction::make_phi(Operand::temp(1));
+    phi_b.srcs = {Operand::int_lit(2), Operand::label("entry"),
+                  Operand::temp(0), Operand::label("loop")};
+    auto phi_n = IRInstruction::make_phi(Operand::temp(2));
+    phi_n.srcs = {Operand::int_lit(3), Operand::label("entry"),
+                  Operand::temp(3), Operand::label("loop")};
+    loop.instructions.push_back(phi_a);
+    loop.instructions.push_back(phi_b);
+    loop.instructions.push_back(phi_n);
+    loop.instructions.push_back(IRInstruction::make_binary(
+        IROpcode::SUB, Operand::temp(3), Operand::temp(2), Operand::int_lit(1)));
+    loop.instructions.push_back(IRInstruction::make_jump_if(Operand::temp(3), "loop"));
+    loop.instructions.push_back(IRInstruction::make_jump("exit"));
+    auto& exit_bb = func.add_block("exit");
+    exit_bb.instructions.push_back(IRInstruction::make_return(Operand::temp(0)));
+
+    destruct_ssa(func);
+    CHECK(count_opcode(func, IROpcode::PHI) == 0);
+
+    // t0 <- t1 and t1 <- t0 form a cycle: one value is saved in t10
+    bool uses_fresh_temp = false;
+    for (const auto& bb : func.blocks)
+        for (const auto& instr : bb.instructions)
+            if (instr.opcode == IROpcode::MOVE && instr.dest.kind == OperandKind::Temp &&
+                instr.dest.id == Operand::temp(10).id)
+                uses_fresh_temp = true;
+    CHECK(uses_fresh_temp);
+    CHECK(func.temp_counter == 11);
+}
+
+// ---- Loops ----
+
+TEST_CASE("IR: loop info builds the nesting tree", "[ir][loops]") {
+    auto program = generate_ir(R"(
+        fn main() -> int {
+            int s = 0;
+            for (int i = 0; i < 4; i = i + 1) {
+                for (int j = 0; j < i; j = j + 1) { s = s + j; }
+            }
+            while (s > 10) { s = s - 3; }
+            return s;
+        }
+    )");
+    const auto& func = program.functions[0];
+    DominatorTree dom(func);
+    LoopInfo info(dom);
+    const auto& loops = info.loops();
+    REQUIRE(loops.size() == 3);
+
+    // Reverse post-order of headers: the outer for comes first, the
+    // inner for and the while follow in traversal order.
+    CHECK(loops[0].parent == -1);
+    REQUIRE(loops[0].children.size() == 1);
+    const int inner = loops[0].children[0];
+    const int other = 3 - inner;
+    CHECK(loops[inner].parent == 0);
+    CHECK(loops[inner].depth == 2);
+    CHECK(loops[other].parent == -1);
+    CHECK(loops[other].depth == 1);
+
+    // Every block of the inner loop belongs to the outer one
+    for (int b : loops[inner].blocks) {
+        CHECK(loops[0].contains(b));
+        CHECK(info.loop_of(b) == inner);
+    }
+    CHECK(info.loop_of(0) == -1);
+    CHECK(info.exiting_blocks(inner) == std::vector<int>{loops[inner].header});
+}
+
+TEST_CASE("IR: insert_preheader merges the entering edges", "[ir][loops]") {
+    // entry -> a | b, both -> loop (back edge from itself)
+    IRFunction func;
+    func.name = "f";
+    func.params.push_back({"c", "bool"});
+    func.temp_counter = 5;
+    auto& entry = func.add_block("entry");
+    entry.instructions.push_back(IRInstruction::make_jump_if(Operand::var("c"), "a"));
+    entry.instructions.push_back(IRInstruction::make_jump("b"));
+    func.add_block("a").instructions.push_back(IRInstruction::make_jump("loop"));
+    func.add_block("b").instructions.push_back(IRInstruction::make_jump("loop"));
+    auto& loop = func.add_block("loop");
+    auto phi = IRInstruction::make_phi(Operand::temp(0, IRType::Int));
+    phi.srcs = {Operand::int_lit(1), Operand::label("a"),
+                Operand::int_lit(2), Operand::label("b"),
+                Operand::temp(1), Operand::label("loop")};
+    loop.instructions.push_back(phi);
+    loop.instructions.push_back(IRInstruction::make_binary(
+        IROpcode::ADD, Operand::temp(1), Operand::temp(0), Operand::int_lit(1)));
+    loop.instructions.push_back(IRInstruction::make_jump_if(Operand::var("c"), "loop"));
+    loop.instructions.push_back(IRInstruction::make_return(Operand::temp(1)));
+
+    std::string pre = insert_preheader(func, "loop");
+    REQUIRE(func.find_block(pre) != nullptr);
+    CHECK(func.blocks[3].label == pre);             // placed before the header
+    CHECK(func.find_block("a")->instructions.back().dest.name() == pre);
+    CHECK(func.find_block("b")->instructions.back().dest.name() == pre);
+
+    const auto& merged = func.find_block(pre)->instructions.front();
+    REQUIRE(merged.opcode == IROpcode::PHI);
+    CHECK(merged.srcs.size() == 4);
+    const auto& header_phi = func.find_block("loop")->instructions.front();
+    REQUIRE(header_phi.srcs.size() == 4);
+    CHECK(header_phi.srcs[2].id == merged.dest.id);
+    CHECK(header_phi.srcs[3].name() == pre);
+
+    // A single entering block with one successor is already a preheader
+    CHECK(insert_preheader(func, "loop") == pre);
+}
+
+TEST_CASE("IR: implicit int/float conversions", "[ir]") {
+    auto program = generate_ir(R"(
+        fn f(int n, float x) -> float {
+            int k = n;
+            k += x;
+            return n * x + 2;
+        }
+    )");
+    const auto& func = program.functions[0];
+    // n * x converts n once; the literal 2 becomes 2.0 without code
+    CHECK(count_opcode(func, IROpcode::INT_TO_FLOAT) == 2);      // k += x, n * x
+    CHECK(count_opcode(func, IROpcode::FLOAT_TO_INT) == 1);      // result back into k
+    for (const auto& bb : func.blocks) {
+        for (const auto& instr : bb.instructions) {
+            if (instr.opcode == IROpcode::RETURN) CHECK(instr.srcs[0].type == IRType::Float);
+            if (instr.opcode == IROpcode::ADD && instr.srcs[1].is_literal()) {
+                CHECK(instr.srcs[1].kind == OperandKind::FloatLiteral);
+                CHECK(instr.srcs[1].float_val == 2.0);
+            }
+        }
+    }
+}
+
+// ---- Interpreter ----
+
+TEST_CASE("IR: interpreter runs SSA and destructed IR alike", "[ir][interp]") {
+    const std::string src = R"(
+        extern fn printf(string format, ...) -> int;
+        fn fact(int n) -> int { if (n <= 1) { return 1; } return n * fact(n - 1); }
+        fn main() -> int {
+            int a[8];
+            for (int i = 0; i < 8; i = i + 1) { a[i] = i * i; }
+            int x = 1; int y = 2;
+            for (int k = 0; k < 3; k = k + 1) { int t = x; x = y; y = t; }
+            float f = 1.5;
+            printf("%d %s %.2f\n", a[7], "ok", f * 3);
+            return fact(5) + x * 10 + y;
+        }
+    )";
+    auto program = generate_ir(src);
+    IRInterpreter ssa(program);
+    ssa.set_capture_output(true);
+    REQUIRE(ssa.run());
+    CHECK(ssa.exit_code() == 120 + 21);
+    CHECK(ssa.output() == "49 ok 4.50\n");
+
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    destruct_ssa(program);
+    IRInterpreter lowered(program);
+    lowered.set_capture_output(true);
+    REQUIRE(lowered.run());
+    CHECK(lowered.exit_code() == ssa.exit_code());
+    CHECK(lowered.output() == ssa.output());
+}
+
+TEST_CASE("IR: interpreter runs vectorized loops like scalar ones", "[ir][interp]") {
+    auto program = generate_ir(R"(
+        fn kern(int a[], int b[], int n, int k) -> void {
+            for (int i = 0; i < n; i = i + 1) { a[i] = a[i] * k - b[i]; }
+        }
+        fn main() -> int {
+            int a[24];
+            int b[24];
+            int s = 0;
+            for (int n = 0; n < 20; n = n + 1) {
+                for (int i = 0; i < 24; i = i + 1) { a[i] = i + n; b[i] = 3 - i; }
+                kern(a, b, n, 5);
+                kern(a, a, n, 2);
+                for (int i = 0; i < 24; i = i + 1) { s = s + a[i] * (i + 1); }
+            }
+            return s % 251;
+        }
+    )");
+    IRInterpreter scalar(program);
+    REQUIRE(scalar.run());
+
+    for (int lanes : {4, 8}) {
+        IRProgram copy = program;
+        PeepholeOptimizer opt(copy);
+        opt.set_vector_lanes(lanes);
+        opt.optimize();
+        CHECK(opt.get_metrics().loops_vectorized >= 1);
+        IRInterpreter ssa(copy);
+        REQUIRE(ssa.run());
+        CHECK(ssa.exit_code() == scalar.exit_code());
+
+        destruct_ssa(copy);
+        IRInterpreter lowered(copy);
+        REQUIRE(lowered.run());
+        CHECK(lowered.exit_code() == scalar.exit_code());
+    }
+}
+
+TEST_CASE("IR: interpreter pass hook sees every changing pass", "[ir][interp]") {
+    auto program = generate_ir(R"(
+        extern fn read_int() -> int;
+        fn main() -> int {
+            int n = read_int();
+            int s = 0;
+            for (int i = 0; i < n; i = i + 1) { s = s + i * 4 + (2 + 3); }
+            return s;
+        }
+    )");
+    int runs = 0;
+    PeepholeOptimizer opt(program);
+    opt.set_pass_hook([&](const char*, const IRFunction&) {
+        IRInterpreter interp(program);
+        interp.set_input("10");
+        interp.set_capture_output(true);
+        CHECK(interp.run());
+        CHECK(interp.exit_code() == 230);
+        ++runs;
+    });
+    opt.optimize();
+    CHECK(runs > 0);
+}
+
+TEST_CASE("IR: interpreter reads shared input lazily", "[ir][interp]") {
+    auto program = generate_ir(R"(
+        extern fn read_int() -> int;
+        fn main() -> int { int a = read_int(); return a * 2; }
+    )");
+    std::istringstream in("21 5 6");
+    std::string buffer;
+    for (int run = 0; run < 2; ++run) {
+        IRInterpreter interp(program);
+        interp.set_input(&buffer, &in);
+        REQUIRE(interp.run());
+        CHECK(interp.exit_code() == 42);
+    }
+    // Both runs replay one word; the rest of the stream stays unread
+    CHECK(buffer == " 21");
+    int next = 0;
+    CHECK((in >> next && next == 5));
+
+    // A program without read_int never touches the stream
+    auto silent = generate_ir("fn main() -> int { return 3; }");
+    std::istringstream untouched("1 2");
+    IRInterpreter interp(silent);
+    interp.set_input(&buffer, &untouched);
+    REQUIRE(interp.run());
+    CHECK(untouched.tellg() == 0);
+}
+
+TEST_CASE("IR: interpreter reports runtime faults", "[ir][interp]") {
+    auto program = generate_ir(R"(
+        fn div(int a, int b) -> int { return a / b; }
+        fn spin() -> int { int k = 0; while (k >= 0) { k = k + 1; } return k; }
+        fn main() -> int { return div(7, 0); }
+    )");
+    IRInterpreter interp(program);
+    CHECK_FALSE(interp.run());
+    REQUIRE(interp.errors().size() == 1);
+    CHECK(interp.errors()[0].find("division by zero") != std::string::npos);
+
+    interp.set_branch_limit(1000);
+    CHECK_FALSE(interp.run("spin"));
+    CHECK(interp.errors()[0].find("branch limit") != std::string::npos);
+}
@@ -1,11 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
+#include "lexer/char_scan.h"
 #include "lexer/scanner.h"
 #include "lexer/token.h"
 #include "preprocessor/preprocessor.h"
 
 #include <vector>
-#include "utils/file_utils.h"
-#include <cstdio>
+#include <cstdint>
 
 // Helper: tokenize source string
 static std::vector<Token> tokenize(const std::string& source) {
@@ -227,17 +227,143 @@ TEST_CASE("Preprocessor: macro definition and expansion", "[preprocessor]") {
     }
 }
 
-TEST_CASE("Utils: file utils read and write", "[utils]") {
-    // Write success
-    CHECK(utils::write_file("temp_test.txt", "hello"));
-    // Read success
-    CHECK(utils::read_file("temp_test.txt") == "hello");
-    // Read failure (non-existent file)
-    CHECK(utils::read_file("non_existent_file_12345.txt").empty());
-    // Write failure (invalid directory path)
-    CHECK(!utils::write_file("invalid_dir_123/file.txt", "hello"));
-    
-    // Cleanup
-    std::remove("temp_test.txt");
+// ---- Zero-copy path: no preprocessor, lexemes point into the buffer ----
+
+TEST_CASE("Lexer: skipping the preprocessor gives the same tokens", "[lexer]") {
+    const std::string source =
+        "fn f(int x) -> int { /* block\n comment */ return x + 1.5; } // tail\n"
+        "\"str\" 42 // trailing comment";
+    REQUIRE(!Preprocessor::needs_processing(source));
+    CHECK(Preprocessor::needs_processing("#define X 1\nint a = X;"));
+
+    auto expected = tokenize(source);
+    Scanner scanner(source);
+    std::vector<Token> direct;
+    while (true) {
+        Token tok = scanner.next_token();
+        direct.push_back(tok);
+        if (tok.type == TokenType::END_OF_FILE) break;
+    }
+    CHECK(scanner.errors().empty());
+    REQUIRE(direct.size() == expected.size());
+    for (std::size_t i = 0; i < direct.size(); ++i) {
+        CHECK(format_token(direct[i]) == format_token(expected[i]));
+    }
+    // EOF — сразу после последнего токена, не после комментария
+    CHECK(direct.back().line == 3);
+    CHECK(direct.back().column == 9);
+
+    // Литералы указывают в буфер, идентификаторы интернированы
+    const Token& number = direct[direct.size() - 2];
+    CHECK(number.lexeme.data() >= source.data());
+    CHECK(number.lexeme.data() < source.data() + source.size());
+    CHECK(direct[4].lexeme == "x");
+    CHECK(direct[4].lexeme.data() == direct[10].lexeme.data());
+}
+
+TEST_CASE("Lexer: unterminated comment is reported without the preprocessor", "[lexer]") {
+    const std::string source = "int a;\n  /* open";
+    Scanner scanner(source);
+    while (scanner.next_token().type != TokenType::END_OF_FILE) {
+    }
+    REQUIRE(scanner.errors().size() == 1);
+    CHECK(scanner.errors()[0].line == 2);
+    CHECK(scanner.errors()[0].column == 3);
+    CHECK(scanner.errors()[0].message == "Unterminated multi-line comment");
+}
+
+// ---- Vectorized fast paths: every level must match the scalar one ----
+
+namespace {
+std::vector<std::string> scan_all(const std::string& source) {
+    Scanner scanner(source);
+    std::vector<std::string> out;
+    while (true) {
+        Token tok = scanner.next_token();
+        out.push_back(format_token(tok));
+        if (tok.type == TokenType::END_OF_FILE) break;
+    }
+    for (const auto& err : scanner.errors()) {
+        out.push_back(std::to_string(err.line) + ":" + std::to_string(err.column) + " " + err.message);
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("Lexer: char_scan kernels agree with the scalar level", "[lexer]") {
+    const char alphabet[] = {' ', '\t', '\r', '\n', '*', '/', 'a', '_', 'Z', '9', '0', '.', '#', '\0', '\xC3'};
+    std::uint32_t seed = 12345;
+    auto next = [&seed] {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 16;
+    };
+    REQUIRE(char_scan::set_level(char_scan::Level::Scalar));
+    const char_scan::Kernels& scalar = char_scan::kernels();
+
+    for (char_scan::Level level : {char_scan::Level::SSE42, char_scan::Level::AVX2}) {
+        if (!char_scan::set_level(level)) continue;
+        const char_scan::Kernels& simd = char_scan::kernels();
+        for (int round = 0; round < 2000; ++round) {
+            // Серии одного класса длиннее блока и стыки на его границах
+            std::string text;
+            std::size_t len = next() % 100;
+            while (text.size() < len) {
+                char c = alphabet[next() % sizeof alphabet];
+                text.append(1 + next() % 40, c);
+            }
+            const char* b = text.data();
+            const char* e = b + text.size();
+            for (std::size_t from = 0; from < text.size(); from += 1 + next() % 7) {
+                const char* p = b + from;
+                char_scan::Newlines n1, n2;
+                CHECK(simd.skip_whitespace(p, e, n1) == scalar.skip_whitespace(p, e, n2));
+                CHECK(n1.count == n2.count);
+                CHECK(n1.line_start == n2.line_start);
+                char_scan::Newlines c1, c2;
+                CHECK(simd.find_comment_end(p, e, c1) == scalar.find_comment_end(p, e, c2));
+                CHECK(c1.count == c2.count);
+                CHECK(c1.line_start == c2.line_start);
+                CHECK(simd.find_line_end(p, e) == scalar.find_line_end(p, e));
+                CHECK(simd.skip_ident(p, e) == scalar.skip_ident(p, e));
+                CHECK(simd.skip_digits(p, e) == scalar.skip_digits(p, e));
+            }
+        }
+    }
+    char_scan::set_level(char_scan::best_level());
 }
 
+TEST_CASE("Lexer: token stream does not depend on the scanner level", "[lexer]") {
+    std::string body =
+        "fn long_function_name_that_crosses_blocks_123(int x) -> int {\r\n"
+        "    /* comment with * and / and\r newlines\n\n ** */ return 123456789012 + x;\n"
+        "}\r"
+        "// line comment that is longer than thirty-two bytes\n"
+        "float f = 3.14159265358979; bool b = true; \"str\\\"ing\" ident_ + 00042;\n"
+        "                                                     /* unterminated";
+    for (int shift = 0; shift < 40; ++shift) {
+        std::string source = std::string(shift, ' ') + body;
+        char_scan::set_level(char_scan::Level::Scalar);
+        auto expected = scan_all(source);
+        for (char_scan::Level level : {char_scan::Level::SSE42, char_scan::Level::AVX2}) {
+            if (!char_scan::set_level(level)) continue;
+            CHECK(scan_all(source) == expected);
+        }
+    }
+    char_scan::set_level(char_scan::best_level());
+}
+
+TEST_CASE("Lexer: keyword perfect hash", "[lexer]") {
+    auto tokens = tokenize("true false fn fnx ifelse els returnx extern_ struct import imports");
+    REQUIRE(tokens.size() == 12);
+    CHECK(tokens[0].type == TokenType::BOOL_LITERAL);
+    CHECK(std::get<bool>(tokens[0].literal));
+    CHECK(tokens[1].type == TokenType::BOOL_LITERAL);
+    CHECK(!std::get<bool>(tokens[1].literal));
+    CHECK(tokens[2].type == TokenType::KW_FN);
+    for (int i = 3; i < 8; ++i) {
+        CHECK(tokens[i].type == TokenType::IDENTIFIER);
+    }
+    CHECK(tokens[8].type == TokenType::KW_STRUCT);
+    CHECK(tokens[9].type == TokenType::KW_IMPORT);
+    CHECK(tokens[10].type == TokenType::IDENTIFIER);
+}
@@ -9,7 +9,9 @@
 #include "ir/optimizer.h"
 #include "ir/optimization_passes.h"
 #include "ir/ir_printer.h"
+#include "ir/profile.h"
 
+#include <cstdio>
 #include <string>
 #include <vector>
 
@@ -158,6 +160,69 @@ TEST_CASE("Optimizer: inliner reports count", "[optimizer]") {
     CHECK(inliner.get_functions_inlined() >= 0);
 }
 
+TEST_CASE("Optimizer: profile steers inlining decisions", "[optimizer][profile]") {
+    const std::string src = R"(
+        fn small(int x) -> int { return x + 1; }
+        fn medium(int x) -> int {
+            int a = x * x;
+            int b = a + x * 3;
+            int c = b * a - x;
+            int d = c + a * b;
+            return d - c + b;
+        }
+        fn main() -> int { return small(41) + medium(2); }
+    )";
+    auto count_inlined = [&](const std::string& profile_text) {
+        auto program = generate_ir(src);
+        ProfileData profile;
+        std::string error;
+        REQUIRE(profile.parse(profile_text, error));
+        FunctionInliner inliner(program);
+        if (!profile.empty()) inliner.set_profile(&profile);
+        inliner.run();
+        return inliner.get_functions_inlined();
+    };
+
+    // Without a profile only the small callee fits the budget
+    CHECK(count_inlined("") == 1);
+    // A call that never ran is left alone, a hot one may be larger
+    CHECK(count_inlined("call main small 0\ncall main medium 0\n") == 0);
+    CHECK(count_inlined("call main small 1\ncall main medium 1000\n") == 2);
+}
+
+TEST_CASE("Optimizer: profile parsing and stale CFG detection", "[optimizer][profile]") {
+    auto program = generate_ir(R"(
+        fn main() -> int { int s = 0; if (s == 0) { s = 1; } return s; }
+    )");
+    const IRFunction& func = program.functions.back();
+
+    std::string text = profile_function_header(func);
+    char line[128];
+    std::snprintf(line, sizeof line, profile_block_format("main", func.blocks[0].label).c_str(), 7UL);
+    text += line;
+    text += "call main helper 3\ncall main helper 4\n";
+
+    ProfileData profile;
+    std::string error;
+    REQUIRE(profile.parse(text, error));
+    auto counts = profile.block_counts(func);
+    REQUIRE(counts.size() == func.blocks.size());
+    CHECK(counts[0] == 7);
+    std::uint64_t calls = 0;
+    CHECK(profile.call_count("main", "helper", calls));
+    CHECK(calls == 7);
+    CHECK_FALSE(profile.call_count("main", "other", calls));
+
+    // A different CFG under the same name is not matched
+    IRFunction edited = func;
+    edited.blocks.pop_back();
+    CHECK(profile.block_counts(edited).empty());
+
+    ProfileData bad;
+    CHECK_FALSE(bad.parse("block main entry many\n", error));
+    CHECK(error.find("line 1") != std::string::npos);
+}
+
 // ---- Multiple optimization passes ----
 
 TEST_CASE("Optimizer: multiple passes converge", "[optimizer]") {
@@ -173,3 +238,269 @@ TEST_CASE("Optimizer: multiple passes converge", "[optimizer]") {
     opt.optimize(); // Should converge and not loop forever
     CHECK(true);
 }
+
+// ---- SCCP / GVN ----
+
+static const IRInstruction* find_return(const IRFunction& func) {
+    for (const auto& block : func.blocks)
+        for (const auto& instr : block.instructions)
+            if (instr.opcode == IROpcode::RETURN) return &instr;
+    return nullptr;
+}
+
+TEST_CASE("Optimizer: constants propagate through a folded branch", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn main() -> int {
+            int k = 4;
+            int r = 0;
+            if (k > 3) { r = k * 2; } else { r = 100; }
+            return r + 1;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().branches_folded == 1);
+
+    const auto& func = program.functions[0];
+    for (const auto& block : func.blocks) {
+        CHECK(block.label.find("else") == std::string::npos);
+        for (const auto& instr : block.instructions)
+            CHECK(instr.opcode != IROpcode::JUMP_IF);
+    }
+    const IRInstruction* ret = find_return(func);
+    REQUIRE(ret != nullptr);
+    REQUIRE(ret->srcs[0].kind == OperandKind::IntLiteral);
+    CHECK(ret->srcs[0].int_val == 9);
+}
+
+TEST_CASE("Optimizer: loop-invariant constant is found through the header phi", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn main() -> int {
+            int c = 7;
+            int i = 0;
+            while (i < 10) {
+                if (c != 7) { c = c + 1; }
+                i = i + 1;
+            }
+            return c;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    const IRInstruction* ret = find_return(program.functions[0]);
+    REQUIRE(ret != nullptr);
+    REQUIRE(ret->srcs[0].kind == OperandKind::IntLiteral);
+    CHECK(ret->srcs[0].int_val == 7);
+}
+
+TEST_CASE("Optimizer: value numbering reuses a dominating expression", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn f(int a, int b) -> int {
+            int x = a * b;
+            int y = 0;
+            if (a > 0) { y = b * a; } else { y = 1; }
+            return x + y;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().common_subexpressions_eliminated >= 1);
+
+    int muls = 0;
+    for (const auto& block : program.functions[0].blocks)
+        for (const auto& instr : block.instructions)
+            if (instr.opcode == IROpcode::MUL) ++muls;
+    CHECK(muls == 1);
+}
+
+TEST_CASE("Optimizer: value numbering does not cross sibling branches", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn f(int a, int b) -> int {
+            int y = 0;
+            if (a > 0) { y = a + b; } else { y = b + a + 1; }
+            return y;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    int adds = 0;
+    for (const auto& block : program.functions[0].blocks)
+        for (const auto& instr : block.instructions)
+            if (instr.opcode == IROpcode::ADD) ++adds;
+    CHECK(adds == 3);
+}
+
+// ---- LICM ----
+
+TEST_CASE("Optimizer: loop-invariant arithmetic moves out of the loop", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn f(int n, int k, int m) -> int {
+            int s = 0;
+            for (int i = 0; i < n; i = i + 1) {
+                s = s + k * m + i / 4;
+            }
+            return s;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().instructions_hoisted >= 1);
+
+    const auto& entry = program.functions[0].blocks.front();
+    bool mul_in_entry = false;
+    for (const auto& instr : entry.instructions)
+        if (instr.opcode == IROpcode::MUL) mul_in_entry = true;
+    CHECK(mul_in_entry);
+}
+
+TEST_CASE("Optimizer: division by a variable stays in the loop", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn f(int n, int k) -> int {
+            int s = 0;
+            for (int i = 0; i < n; i = i + 1) { s = s + 100 / k; }
+            return s;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().instructions_hoisted == 0);
+}
+
+TEST_CASE("Optimizer: array index becomes a pointer increment", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn sum(int a[], int n) -> int {
+            int s = 0;
+            for (int i = 0; i < n; i = i + 1) { s = s + a[i]; }
+            return s;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().induction_variables_reduced >= 2);
+
+    // The load uses the pointer at offset 0 and the index PHI is gone
+    int phis = 0;
+    bool load_at_zero = false;
+    for (const auto& block : program.functions[0].blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::PHI) phis++;
+            if (instr.opcode == IROpcode::LOAD_ELEM)
+                load_at_zero = instr.srcs[0].type == IRType::Array &&
+                               instr.srcs[1].kind == OperandKind::IntLiteral &&
+                               instr.srcs[1].int_val == 0;
+        }
+    }
+    CHECK(load_at_zero);
+    CHECK(phis == 2);       // s and the pointer
+}
+
+TEST_CASE("Optimizer: multiple of the loop counter is strength-reduced", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn f(int n) -> int {
+            int s = 0;
+            for (int i = 0; i < n; i = i + 1) { s = s + i * 7; }
+            return s;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().induction_variables_reduced == 1);
+    for (const auto& block : program.functions[0].blocks)
+        for (const auto& instr : block.instructions)
+            CHECK(instr.opcode != IROpcode::MUL);
+}
+
+TEST_CASE("Optimizer: counter indexing a loop-local array is widened", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn f(int n) -> int {
+            int s = 0;
+            for (int i = 0; i < n; i = i + 1) {
+                int c[8];
+                c[i] = n;
+                s = s + c[i];
+            }
+            return s;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().induction_variables_widened == 1);
+
+    bool wide_index = false;
+    for (const auto& block : program.functions[0].blocks)
+        for (const auto& instr : block.instructions)
+            if (instr.opcode == IROpcode::LOAD_ELEM) wide_index = instr.srcs[1].type == IRType::Long;
+    CHECK(wide_index);
+}
+
+TEST_CASE("Optimizer: float array pointer advances by 8 bytes", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn sum(float a[], int n) -> float {
+            float s = 0.0;
+            for (int i = 0; i < n; i = i + 1) { s = s + a[i]; }
+            return s;
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.optimize();
+    CHECK(opt.get_metrics().induction_variables_reduced >= 2);
+
+    bool step_8 = false;
+    for (const auto& block : program.functions[0].blocks)
+        for (const auto& instr : block.instructions)
+            if (instr.opcode == IROpcode::ADD && instr.dest.type == IRType::Array)
+                step_8 = step_8 || (instr.srcs[1].kind == OperandKind::IntLiteral &&
+                                    instr.srcs[1].int_val == 8);
+    CHECK(step_8);
+}
+
+TEST_CASE("Optimizer: counted int loop is vectorized with a scalar epilogue", "[optimizer]") {
+    const std::string src = R"(
+        fn kern(int a[], int b[], int n, int k) -> void {
+            for (int i = 0; i < n; i = i + 1) { a[i] = b[i] * k + 1; }
+        }
+    )";
+    auto scalar = generate_ir(src);
+    PeepholeOptimizer plain(scalar);
+    plain.optimize();
+    CHECK(plain.get_metrics().loops_vectorized == 0);
+
+    auto program = generate_ir(src);
+    PeepholeOptimizer opt(program);
+    opt.set_vector_lanes(8);
+    opt.optimize();
+    CHECK(opt.get_metrics().loops_vectorized == 1);
+
+    int vec_loads = 0, vec_stores = 0, splats = 0, scalar_stores = 0;
+    for (const auto& block : program.functions[0].blocks) {
+        for (const auto& instr : block.instructions) {
+            if (instr.opcode == IROpcode::VEC_LOAD) {
+                vec_loads++;
+                CHECK(instr.dest.type == IRType::IntX8);
+            }
+            if (instr.opcode == IROpcode::VEC_STORE) vec_stores++;
+            if (instr.opcode == IROpcode::VEC_SPLAT) splats++;
+            if (instr.opcode == IROpcode::STORE_ELEM) scalar_stores++;
+        }
+    }
+    CHECK(vec_loads == 1);
+    CHECK(vec_stores == 1);
+    CHECK(splats == 2);         // k and 1
+    CHECK(scalar_stores == 1);  // the epilogue keeps the original loop
+}
+
+TEST_CASE("Optimizer: loop-carried dependence blocks vectorization", "[optimizer]") {
+    auto program = generate_ir(R"(
+        fn shift(int a[], int n) -> void {
+            for (int i = 0; i < n; i = i + 1) { a[i + 1] = a[i] + 1; }
+        }
+        fn copy(int a[], int b[], int n) -> void {
+            for (int i = 0; i < n; i = i + 1) { a[i + 2] = b[i]; }
+        }
+    )");
+    PeepholeOptimizer opt(program);
+    opt.set_vector_lanes(4);
+    opt.optimize();
+    // a and b may be the same array: a[i + 2] is stored two lanes before it is read
+    CHECK(opt.get_metrics().loops_vectorized == 0);
+}
@@ -3,14 +3,16 @@
 #include "lexer/token.h"
 #include "parser/parser.h"
 #include "parser/ast.h"
+#include "parser/ast_printer.h"
 #include "preprocessor/preprocessor.h"
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 // Helper: parse source string
 static std::pair<std::unique_ptr<ProgramNode>, std::vector<ParseError>>
-parse_source(const std::string& source) {
+parse_source(const std::string& source, bool use_arena = true) {
     Preprocessor pp(source);
     std::string processed = pp.process();
     Scanner scanner(processed);
@@ -21,6 +23,7 @@ parse_source(const std::string& source) {
         if (tok.type == TokenType::END_OF_FILE) break;
     }
     Parser parser(tokens);
+    parser.set_use_arena(use_arena);
     auto ast = parser.parse();
     return {std::move(ast), parser.errors()};
 }
@@ -173,3 +176,92 @@ TEST_CASE("Parser: boolean operators", "[parser]") {
     )");
     CHECK(errors.empty());
 }
+
+// ---- AST arena ----
+
+TEST_CASE("Parser: arena and heap trees print identically", "[parser]") {
+    const std::string src = R"(
+        struct P { int x; int y; }
+        fn f(int a, int b[]) -> int {
+            int s = 0;
+            for (int i = 0; i < a; i = i + 1) { s = s + b[i] * 2; }
+            while (s > 10) { s--; }
+            if (s == 3 || !(a < 2)) { return -s; } else { return s % 4; }
+        }
+    )";
+    auto [arena_ast, arena_errors] = parse_source(src, true);
+    auto [heap_ast, heap_errors] = parse_source(src, false);
+    CHECK(arena_errors.empty());
+    CHECK(heap_errors.empty());
+    REQUIRE(arena_ast->arena != nullptr);
+    CHECK(heap_ast->arena == nullptr);
+    CHECK(arena_ast->arena->object_count() > 20);
+    CHECK(arena_ast->declarations[0]->arena_owned);
+
+    ASTPrettyPrinter arena_pp, heap_pp;
+    arena_ast->accept(arena_pp);
+    heap_ast->accept(heap_pp);
+    CHECK(arena_pp.result() == heap_pp.result());
+}
+
+TEST_CASE("Parser: arena serves oversized and aligned requests", "[parser]") {
+    ASTArena arena(64);
+    void* small = arena.allocate(24, 8);
+    void* big = arena.allocate(1000, 16);
+    CHECK(reinterpret_cast<std::uintptr_t>(small) % 8 == 0);
+    CHECK(reinterpret_cast<std::uintptr_t>(big) % 16 == 0);
+    CHECK(arena.block_count() == 2);
+    CHECK(arena.bytes_used() == 1024);
+}
+
+// ---- Token window ----
+
+TEST_CASE("Parser: streaming from Scanner matches the token vector", "[parser]") {
+    const std::string src = R"(
+        struct Point { int x; int y; }
+        fn f(int n) -> int {
+            int s = 0;
+            for (Point p = make(); s < n; s = s + 1) { s = s + p.x; }
+            for (s = 0; s < n; s = s + 1) { g(s); }
+            return s +;
+        }
+    )";
+    auto [vector_ast, vector_errors] = parse_source(src);
+
+    Scanner scanner(src);
+    std::vector<Token> tokens;
+    for (Scanner counter(src);;) {
+        tokens.push_back(counter.next_token());
+        if (tokens.back().type == TokenType::END_OF_FILE) break;
+    }
+    Parser parser(scanner);
+    auto stream_ast = parser.parse();
+    const auto& stream_errors = parser.errors();
+
+    REQUIRE(stream_errors.size() == vector_errors.size());
+    CHECK(!stream_errors.empty());
+    for (std::size_t i = 0; i < stream_errors.size(); ++i) {
+        CHECK(stream_errors[i].message == vector_errors[i].message);
+        CHECK(stream_errors[i].line == vector_errors[i].line);
+    }
+    CHECK(parser.tokens_read() <= tokens.size());
+
+    ASTPrettyPrinter vector_pp, stream_pp;
+    vector_ast->accept(vector_pp);
+    stream_ast->accept(stream_pp);
+    CHECK(stream_pp.result() == vector_pp.result());
+}
+
+TEST_CASE("Parser: import declarations", "[parser]") {
+    auto [ast, errors] = parse_source("import geom;\nfn main() -> int { return 0; }\nimport io;");
+    REQUIRE(errors.empty());
+    REQUIRE(ast->imports.size() == 2);
+    CHECK(ast->imports[0].module == "geom");
+    CHECK(ast->imports[0].line == 1);
+    CHECK(ast->imports[1].module == "io");
+    CHECK(ast->declarations.size() == 1);
+
+    auto [bad_ast, bad_errors] = parse_source("import 42;\nimport geom\nfn main() -> int { return 0; }");
+    REQUIRE(bad_errors.size() == 2);
+    CHECK(bad_ast->declarations.size() == 1);
+}
@@ -6,6 +6,7 @@
 #include "preprocessor/preprocessor.h"
 #include "semantic/analyzer.h"
 #include "semantic/errors.h"
+#include "semantic/module_interface.h"
 #include "semantic/type_system.h"
 
 #include <memory>
@@ -254,3 +255,110 @@ TEST_CASE("TypeSystem: TypeRegistry edge cases", "[semantic]") {
     CHECK(reg.common_numeric_type(reg.type_int(), reg.type_bool()) == reg.type_error());
 }
 
+
+TEST_CASE("TypeSystem: a reused TypeRegistry forgets earlier programs", "[semantic]") {
+    auto parse = [](const std::string& src) {
+        Scanner scanner(src);
+        Parser parser(scanner);
+        auto ast = parser.parse();
+        REQUIRE(parser.errors().empty());
+        return ast;
+    };
+    TypeRegistry reg;
+    const std::size_t builtins = reg.type_count();
+    Type* int_type = reg.type_int();
+
+    auto first = parse("struct Point { int x; int y; }; fn f(Point p, int a[]) -> int { return a[0]; }");
+    {
+        SemanticAnalyzer analyzer(reg);
+        analyzer.analyze(*first);
+        CHECK(analyzer.get_errors().empty());
+    }
+    CHECK(reg.resolve("Point") != nullptr);
+    CHECK(reg.type_count() > builtins);
+
+    // Вторая программа не видит Point из первой
+    auto second = parse("fn g(Point p) -> int { return 0; }");
+    SemanticAnalyzer analyzer(reg);
+    CHECK(reg.type_count() == builtins);
+    CHECK(reg.resolve("Point") == nullptr);
+    CHECK(reg.resolve("int") == int_type);
+    analyzer.analyze(*second);
+    CHECK(!analyzer.get_errors().empty());
+}
+
+TEST_CASE("Modules: interfaces round-trip and declare imported symbols", "[semantic]") {
+    auto parse = [](const std::string& src) {
+        Scanner scanner(src);
+        Parser parser(scanner);
+        auto ast = parser.parse();
+        REQUIRE(parser.errors().empty());
+        return ast;
+    };
+    auto lib = parse(R"(
+        struct Inner { int a; };
+        struct Outer { Inner i; float f; };
+        struct Unused { int z; };
+        extern fn puts_int(int x) -> void;
+        fn area(Outer o, int xs[]) -> int { return xs[0]; }
+        fn twice(int x) -> int { return x * 2; }
+    )");
+    TypeRegistry lib_types;
+    SemanticAnalyzer lib_analyzer(lib_types);
+    lib_analyzer.analyze(*lib);
+    REQUIRE(lib_analyzer.get_errors().empty());
+
+    ModuleInterface built = build_module_interface("geom", *lib, lib_types);
+    CHECK(built.name == "geom");
+    REQUIRE(built.functions.size() == 2);      // extern-объявления не экспортируются
+    CHECK(built.functions[0].name == "area");
+    REQUIRE(built.functions[0].params.size() == 2);
+    CHECK(built.functions[0].params[1].is_array);
+    CHECK(built.functions[0].params[1].type_name == "int");
+    REQUIRE(built.structs.size() == 3);        // зависимости раньше тех, кто их использует
+    CHECK(built.structs[0].name == "Inner");
+    CHECK(built.structs[1].name == "Outer");
+
+    const std::string data = write_module_interface(built);
+    ModuleInterface module;
+    REQUIRE(read_module_interface(data, module));
+    CHECK(write_module_interface(module) == data);
+    ModuleInterface broken;
+    CHECK(!read_module_interface(data.substr(0, data.size() - 3), broken));
+    CHECK(!read_module_interface("not an interface", broken));
+
+    auto user = parse(R"(
+        import geom;
+        fn f(Outer o) -> int { int xs[2]; xs[0] = twice(3); return area(o, xs); }
+    )");
+    SemanticAnalyzer analyzer;
+    analyzer.add_import(module, 2, 9);
+    analyzer.analyze(*user);
+    CHECK(analyzer.get_errors().empty());
+    CHECK(analyzer.get_symbol_table().lookup("twice") != nullptr);
+
+    // Несовпадающая сигнатура — ошибка вызова
+    auto wrong = parse("import geom; fn f() -> int { return twice(1, 2); }");
+    SemanticAnalyzer wrong_analyzer;
+    wrong_analyzer.add_import(module, 1, 1);
+    wrong_analyzer.analyze(*wrong);
+    CHECK(!wrong_analyzer.get_errors().empty());
+
+    // Один модуль, импортированный дважды, и другой модуль с той же
+    // структурой — без ошибок; структура с другой раскладкой — конфликт
+    ModuleInterface same = module;
+    same.name = "shapes";
+    same.functions.clear();
+    ModuleInterface clash;
+    clash.name = "other";
+    clash.structs.push_back({"Inner", {StructField{"b", "float", 0, 0}}, 4});
+    auto empty = parse("fn g() -> int { return 0; }");
+    SemanticAnalyzer clash_analyzer;
+    clash_analyzer.add_import(module, 1, 1);
+    clash_analyzer.add_import(same, 2, 1);
+    clash_analyzer.add_import(clash, 3, 1);
+    clash_analyzer.analyze(*empty);
+    REQUIRE(clash_analyzer.get_errors().size() == 1);
+    CHECK(clash_analyzer.get_errors()[0].kind == SemanticErrorKind::ImportConflict);
+    CHECK(clash_analyzer.get_errors()[0].line == 3);
+}
@@ -0,0 +1,36 @@
+#include <catch2/catch_test_macros.hpp>
+#include "utils/json.h"
+
+#include <string>
+
+// ---- Протокол compiler serve ----
+
+TEST_CASE("Serve: JSON requests parse and ids round-trip", "[serve]") {
+    utils::JsonValue request;
+    std::string error;
+    REQUIRE(utils::parse_json(
+        R"( {"id": -12.5e3, "command": "compile", "flags": ["--emit", "obj"], "input": "a\\b \u00e9\ud83d\ude00",
+             "nested": {"ok": true, "none": null, "list": []}} )",
+        request, error));
+    CHECK(utils::to_json(*request.get("id")) == "-12.5e3");
+    CHECK(request.get("command")->text == "compile");
+    REQUIRE(request.get("flags")->items.size() == 2);
+    CHECK(request.get("flags")->items[1].text == "obj");
+    CHECK(request.get("input")->text == "a\\b \xc3\xa9\xf0\x9f\x98\x80");
+    CHECK(request.get("nested")->get("ok")->boolean);
+    CHECK(request.get("missing") == nullptr);
+
+    CHECK(utils::json_quote("say \"hi\"\n\x01") == "\"say \\\"hi\\\"\\n\\u0001\"");
+    utils::JsonValue again;
+    REQUIRE(utils::parse_json(utils::to_json(request), again, error));
+    CHECK(utils::to_json(again) == utils::to_json(request));
+
+    for (const char* bad : {"", "{", "{\"a\" 1}", "[1,]", "\"\\x\"", "01x", "{} {}", "tru"}) {
+        utils::JsonValue value;
+        std::string message;
+        CHECK_FALSE(utils::parse_json(bad, value, message));
+        CHECK(!message.empty());
+    }
+    std::string deep(1000, '[');
+    CHECK_FALSE(utils::parse_json(deep, request, error));
+}
@@ -0,0 +1,39 @@
+#include <catch2/catch_test_macros.hpp>
+#include "utils/file_utils.h"
+
+#include <cstdio>
+
+TEST_CASE("Utils: file utils read and write", "[utils]") {
+    // Write success
+    CHECK(utils::write_file("temp_test.txt", "hello"));
+    // Read success
+    CHECK(utils::read_file("temp_test.txt") == "hello");
+    // Read failure (non-existent file)
+    CHECK(utils::read_file("non_existent_file_12345.txt").empty());
+    // Write failure (invalid directory path)
+    CHECK(!utils::write_file("invalid_dir_123/file.txt", "hello"));
+    
+    // Cleanup
+    std::remove("temp_test.txt");
+}
+
+TEST_CASE("Utils: mapped file", "[utils]") {
+    CHECK(utils::write_file("temp_mapped.txt", "fn main() -> int { return 0; }"));
+    {
+        utils::MappedFile file;
+        REQUIRE(file.open("temp_mapped.txt"));
+        CHECK(file.mapped());
+        CHECK(file.text() == "fn main() -> int { return 0; }");
+    }
+    // Пустой файл не отображается, но читается
+    CHECK(utils::write_file("temp_mapped.txt", ""));
+    {
+        utils::MappedFile file;
+        REQUIRE(file.open("temp_mapped.txt"));
+        CHECK(file.text().empty());
+    }
+    utils::MappedFile missing;
+    CHECK(!missing.open("non_existent_file_12345.txt"));
+
+    std::remove("temp_mapped.txt");
+}